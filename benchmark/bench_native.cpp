@@ -0,0 +1,557 @@
+// PixFoundry native benchmark：直接呼叫 C++ kernel（不經過 Python / numpy），
+// 量各個 kernel 在不同大小、通道數、border、thread 數下的時間，
+// 報 MPix/s、有效 GB/s（跟同樣大小、同樣 thread 數的 memcpy 比）和平行效率。
+//
+//   cmake -S . -B build -DPF_BUILD_BENCHMARK=ON -DCMAKE_BUILD_TYPE=Release
+//   cmake --build build --target pf_bench
+//   ./build/pf_bench --outdir benchmark_output/native --sizes 512x512,2048x2048 --threads 1,4,8 --pin
+//
+// 輸出（--outdir）：
+//   results.csv  前幾欄跟 run_bench.py 的 results.csv 一樣（backend, case, group, mean_s, median_s, stdev_s），
+//                後面多 threads / MPix/s / GB/s / 效率等欄；同一個 (case, backend) 每個 thread 數一列
+//   results.json 同樣的資料
+//   meta.json    機器、參數
+
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/ops.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace pf;
+
+namespace {
+
+// ======================
+//  參數
+// ======================
+
+struct Options {
+    std::string              outdir   = "benchmark_output/native";
+    std::vector<ImageShape>  sizes;          // h, w（c 另外掃）
+    std::vector<int>         channels = {3, 1};
+    std::vector<Border>      borders  = {Border::Reflect, Border::Replicate, Border::Wrap, Border::Constant};
+    std::vector<int>         threads;        // 空：1, 2, 4, ... 加上 available_cpus()
+    std::vector<std::string> backends = {"single", "openmp", "threadpool"};
+    std::vector<std::string> only;           // case 名稱含其中一個字串才跑（空：全部）
+    int    warmup   = 2;
+    int    repeat   = 10;
+    double min_time = 0.005;  // 每個 sample 至少這麼久（太快的 kernel 一個 sample 連跑幾次取平均）
+    bool   pin      = false;
+};
+
+static std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static Border parse_border(const std::string& s) {
+    if (s == "reflect")   return Border::Reflect;
+    if (s == "replicate") return Border::Replicate;
+    if (s == "wrap")      return Border::Wrap;
+    if (s == "constant")  return Border::Constant;
+    throw std::invalid_argument("unknown border: " + s);
+}
+
+static const char* border_name(Border b) {
+    switch (b) {
+    case Border::Reflect:   return "reflect";
+    case Border::Replicate: return "replicate";
+    case Border::Wrap:      return "wrap";
+    default:                return "constant";
+    }
+}
+
+static void usage() {
+    std::puts(
+        "usage: pf_bench [--outdir DIR] [--sizes 256x256,512x512,1024x768] [--channels 3,1]\n"
+        "                [--borders reflect,replicate,wrap,constant] [--threads 1,2,4]\n"
+        "                [--backends single,openmp,threadpool] [--only gaussian,resize]\n"
+        "                [--warmup 2] [--repeat 10] [--min-time 0.005] [--pin]");
+}
+
+static Options parse_args(int argc, char** argv) {
+    Options o;
+    std::string sizes = "256x256,512x512,1024x768";
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument(a + " needs a value");
+            return argv[++i];
+        };
+        if (a == "--outdir")        o.outdir = value();
+        else if (a == "--sizes")    sizes = value();
+        else if (a == "--warmup")   o.warmup = std::stoi(value());
+        else if (a == "--repeat")   o.repeat = std::max(1, std::stoi(value()));
+        else if (a == "--min-time") o.min_time = std::stod(value());
+        else if (a == "--pin")      o.pin = true;
+        else if (a == "--only")     o.only = split(value(), ',');
+        else if (a == "--backends") o.backends = split(value(), ',');
+        else if (a == "--channels") {
+            o.channels.clear();
+            for (const auto& s : split(value(), ',')) o.channels.push_back(std::stoi(s));
+        } else if (a == "--borders") {
+            o.borders.clear();
+            for (const auto& s : split(value(), ',')) o.borders.push_back(parse_border(s));
+        } else if (a == "--threads") {
+            o.threads.clear();
+            for (const auto& s : split(value(), ',')) o.threads.push_back(std::max(1, std::stoi(s)));
+        } else if (a == "-h" || a == "--help") {
+            usage();
+            std::exit(0);
+        } else {
+            usage();
+            throw std::invalid_argument("unknown argument: " + a);
+        }
+    }
+    for (const auto& s : split(sizes, ',')) {
+        const std::size_t x = s.find('x');
+        if (x == std::string::npos) throw std::invalid_argument("bad size: " + s);
+        o.sizes.push_back({std::stoi(s.substr(0, x)), std::stoi(s.substr(x + 1)), 0});
+    }
+    if (o.threads.empty()) {
+        const int cpus = available_cpus();
+        for (int t = 1; t < cpus; t *= 2) o.threads.push_back(t);
+        o.threads.push_back(cpus);
+    }
+    std::sort(o.threads.begin(), o.threads.end());
+    o.threads.erase(std::unique(o.threads.begin(), o.threads.end()), o.threads.end());
+    return o;
+}
+
+// ======================
+//  要量的 kernel
+// ======================
+
+// 名稱、群組跟 run_bench.py 的 case 對得上（同一組參數）
+struct Kernel {
+    std::string group;
+    std::string name;
+    bool        uses_border;
+    std::function<ImageOp(const ImageShape& in, Border border)> make;
+};
+
+static std::vector<Kernel> kernels() {
+    auto fixed = [](ImageOp (*f)()) {
+        return [f](const ImageShape&, Border) { return f(); };
+    };
+    return {
+        {"color", "to_grayscale", false, fixed(to_grayscale_op)},
+        {"color", "invert", false, fixed(invert_op)},
+        {"color", "sepia", false, fixed(sepia_op)},
+        {"color", "brightness_contrast", false,
+         [](const ImageShape&, Border) { return adjust_brightness_contrast_op(1.2f, 15.0f); }},
+        {"color", "gamma_correct", false, [](const ImageShape&, Border) { return gamma_correct_op(1.8f); }},
+
+        {"filters", "mean_filter_k5", true, [](const ImageShape&, Border b) { return mean_filter_op(5, b); }},
+        {"filters", "gaussian_sigma1.2", true,
+         [](const ImageShape&, Border b) { return gaussian_filter_op(1.2f, b); }},
+        {"filters", "median_filter_k5", true, [](const ImageShape&, Border b) { return median_filter_op(5, b); }},
+        {"filters", "bilateral_k7", true,
+         [](const ImageShape&, Border b) { return bilateral_filter_op(7, 25.0f, 7.0f, b); }},
+
+        {"effects", "sharpen", false, [](const ImageShape&, Border) { return sharpen_op(); }},
+        {"effects", "emboss", false, [](const ImageShape&, Border) { return emboss_op(); }},
+        {"effects", "cartoonize", false, [](const ImageShape&, Border) { return cartoonize_op(); }},
+
+        {"geometry", "resize_x2", false,
+         [](const ImageShape& in, Border) { return resize_op(in.h * 2, in.w * 2); }},
+        {"geometry", "flip_horizontal", false, fixed(flip_horizontal_op)},
+        {"geometry", "flip_vertical", false, fixed(flip_vertical_op)},
+        {"geometry", "rotate_15deg", false, [](const ImageShape&, Border) { return rotate_op(15.0f); }},
+        {"geometry", "rotate90", false, fixed(rotate90_op)},
+        {"geometry", "transpose", false, fixed(transpose_op)},
+
+        {"pyramid", "pyr_down", false, fixed(pyr_down_op)},
+        {"pyramid", "downscale_box_2", false, [](const ImageShape&, Border) { return downscale_box_op(2); }},
+    };
+}
+
+// ======================
+//  計時與統計
+// ======================
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+struct Stats {
+    double mean = 0, median = 0, stdev = 0, min = 0, mad = 0;
+    int    samples = 0, iters = 1;
+};
+
+static double median_of(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    const std::size_t n = v.size();
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+// warmup 之後先量一次決定每個 sample 連跑幾次（讓一個 sample 至少 min_time），
+// 再量 repeat 個 sample。median / MAD 不受偶發的中斷、page fault 影響；mean / stdev 照 run_bench.py 的定義
+static Stats measure(const std::function<void()>& fn, const Options& o) {
+    for (int i = 0; i < o.warmup; ++i) fn();
+
+    Clock::time_point t0 = Clock::now();
+    fn();
+    const double once = std::max(seconds_since(t0), 1e-9);
+    Stats s;
+    s.iters = std::max(1, static_cast<int>(std::ceil(o.min_time / once)));
+
+    std::vector<double> t;
+    t.reserve(static_cast<std::size_t>(o.repeat));
+    for (int r = 0; r < o.repeat; ++r) {
+        t0 = Clock::now();
+        for (int k = 0; k < s.iters; ++k) fn();
+        t.push_back(seconds_since(t0) / s.iters);
+    }
+
+    s.samples = static_cast<int>(t.size());
+    s.median  = median_of(t);
+    s.min     = *std::min_element(t.begin(), t.end());
+    double sum = 0;
+    for (double v : t) sum += v;
+    s.mean = sum / t.size();
+    double var = 0;
+    for (double v : t) var += (v - s.mean) * (v - s.mean);
+    s.stdev = t.size() >= 2 ? std::sqrt(var / t.size()) : 0.0;  // pstdev
+    std::vector<double> dev;
+    for (double v : t) dev.push_back(std::fabs(v - s.median));
+    s.mad = median_of(dev);
+    return s;
+}
+
+// ======================
+//  thread 數 / backend
+// ======================
+
+static Backend backend_of(const std::string& name) {
+    if (name == "single")     return Backend::Single;
+    if (name == "openmp")     return Backend::OpenMP;
+    if (name == "threadpool") return Backend::ThreadPool;
+    throw std::invalid_argument("unknown backend: " + name);
+}
+
+static bool backend_available(const std::string& name) {
+#ifndef PF_HAS_OPENMP
+    if (name == "openmp") return false;
+#endif
+    return name == "single" || name == "openmp" || name == "threadpool";
+}
+
+// 全行程的 thread 預算（governor、ThreadPool）跟 OpenMP team 大小都設成 threads
+static void use_threads(int threads) {
+    set_max_threads(threads);
+#ifdef PF_HAS_OPENMP
+    omp_set_num_threads(threads);
+#endif
+}
+
+// 呼叫端自己也綁到第一顆可用的 CPU（set_thread_pinning 只綁 OpenMP team 的 worker）
+static void pin_main_thread() {
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            sched_setaffinity(0, sizeof(one), &one);
+            return;
+        }
+    }
+#endif
+}
+
+// ======================
+//  memcpy 基準：同樣的 bytes、同樣的 backend 跟 thread 數能搬多快
+// ======================
+
+static void parallel_memcpy(uint8_t* dst, const uint8_t* src, std::size_t bytes, Backend be, int threads) {
+    const long parts = be == Backend::Single ? 1 : threads;
+    auto part = [&](long k) {
+        const std::size_t b = bytes / parts * k;
+        const std::size_t e = k + 1 == parts ? bytes : bytes / parts * (k + 1);
+        std::memcpy(dst + b, src + b, e - b);
+    };
+    if (be == Backend::ThreadPool) {
+        ThreadPool::instance().parallel_for(0, parts, 1, [&](long k0, long k1) {
+            for (long k = k0; k < k1; ++k) part(k);
+        });
+        return;
+    }
+#ifdef PF_HAS_OPENMP
+    if (be == Backend::OpenMP) {
+#pragma omp parallel for schedule(static) num_threads(threads)
+        for (long k = 0; k < parts; ++k) part(k);
+        return;
+    }
+#endif
+    part(0);
+}
+
+// ======================
+//  結果
+// ======================
+
+struct Row {
+    std::string backend, name, group, border;
+    int         threads = 1, channels = 3;
+    Stats       st;
+    double      mpix_per_s = 0, gb_per_s = 0, memcpy_gb_per_s = 0;
+    double      speedup = 1, efficiency = 1;
+};
+
+static std::string fmt(double v) {
+    if (!std::isfinite(v)) return "nan";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+static const char* kCsvHeader =
+    "backend,case,group,mean_s,median_s,stdev_s,min_s,mad_s,samples,iters,threads,channels,border,"
+    "mpix_per_s,gb_per_s,memcpy_gb_per_s,bw_fraction,speedup,efficiency";
+
+static void write_csv(const std::string& path, const std::vector<Row>& rows) {
+    std::ofstream f(path);
+    if (!f) throw std::runtime_error("cannot write " + path);
+    f << kCsvHeader << "\n";
+    for (const Row& r : rows) {
+        f << r.backend << ',' << r.name << ',' << r.group << ',' << fmt(r.st.mean) << ',' << fmt(r.st.median)
+          << ',' << fmt(r.st.stdev) << ',' << fmt(r.st.min) << ',' << fmt(r.st.mad) << ',' << r.st.samples << ','
+          << r.st.iters << ',' << r.threads << ',' << r.channels << ',' << r.border << ','
+          << fmt(r.mpix_per_s) << ',' << fmt(r.gb_per_s) << ',' << fmt(r.memcpy_gb_per_s) << ','
+          << fmt(r.memcpy_gb_per_s > 0 ? r.gb_per_s / r.memcpy_gb_per_s : NAN) << ','
+          << fmt(r.speedup) << ',' << fmt(r.efficiency) << "\n";
+    }
+}
+
+static std::string json_num(double v) {
+    return std::isfinite(v) ? fmt(v) : "null";
+}
+
+static void write_json(const std::string& path, const std::vector<Row>& rows) {
+    std::ofstream f(path);
+    if (!f) throw std::runtime_error("cannot write " + path);
+    f << "[\n";
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const Row& r = rows[i];
+        f << "  {\"backend\": \"" << r.backend << "\", \"case\": \"" << r.name << "\", \"group\": \"" << r.group
+          << "\", \"mean_s\": " << json_num(r.st.mean) << ", \"median_s\": " << json_num(r.st.median)
+          << ", \"stdev_s\": " << json_num(r.st.stdev) << ", \"min_s\": " << json_num(r.st.min)
+          << ", \"mad_s\": " << json_num(r.st.mad) << ", \"samples\": " << r.st.samples
+          << ", \"iters\": " << r.st.iters << ", \"threads\": " << r.threads << ", \"channels\": " << r.channels
+          << ", \"border\": \"" << r.border << "\", \"mpix_per_s\": " << json_num(r.mpix_per_s)
+          << ", \"gb_per_s\": " << json_num(r.gb_per_s)
+          << ", \"memcpy_gb_per_s\": " << json_num(r.memcpy_gb_per_s)
+          << ", \"bw_fraction\": "
+          << json_num(r.memcpy_gb_per_s > 0 ? r.gb_per_s / r.memcpy_gb_per_s : NAN)
+          << ", \"speedup\": " << json_num(r.speedup) << ", \"efficiency\": " << json_num(r.efficiency) << "}"
+          << (i + 1 < rows.size() ? ",\n" : "\n");
+    }
+    f << "]\n";
+}
+
+static void write_meta(const std::string& path, const Options& o, std::size_t n_rows) {
+    std::ofstream f(path);
+    if (!f) throw std::runtime_error("cannot write " + path);
+    char ts[64];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    const NumaInfo numa = numa_info();
+
+    auto list = [](const auto& v, auto&& item) {
+        std::string s = "[";
+        for (std::size_t i = 0; i < v.size(); ++i) s += (i ? ", " : "") + item(v[i]);
+        return s + "]";
+    };
+    f << "{\n"
+      << "  \"timestamp\": \"" << ts << "\",\n"
+      << "  \"harness\": \"pf_bench (native C++)\",\n"
+#if defined(__VERSION__)
+      << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+#endif
+#ifdef PF_HAS_OPENMP
+      << "  \"openmp\": true,\n"
+#else
+      << "  \"openmp\": false,\n"
+#endif
+      << "  \"available_cpus\": " << available_cpus() << ",\n"
+      << "  \"cpus_per_node\": " << list(numa.cpus_per_node, [](int n) { return std::to_string(n); }) << ",\n"
+      << "  \"pinned\": " << (o.pin ? "true" : "false") << ",\n"
+      << "  \"cases\": " << n_rows << ",\n"
+      << "  \"warmup\": " << o.warmup << ",\n"
+      << "  \"repeat\": " << o.repeat << ",\n"
+      << "  \"min_time\": " << fmt(o.min_time) << ",\n"
+      << "  \"sizes\": "
+      << list(o.sizes, [](const ImageShape& s) { return "[" + std::to_string(s.h) + ", " + std::to_string(s.w) + "]"; })
+      << ",\n"
+      << "  \"channels\": " << list(o.channels, [](int c) { return std::to_string(c); }) << ",\n"
+      << "  \"threads\": " << list(o.threads, [](int t) { return std::to_string(t); }) << "\n"
+      << "}\n";
+}
+
+static bool selected(const Options& o, const std::string& name) {
+    if (o.only.empty()) return true;
+    for (const auto& s : o.only) {
+        if (name.find(s) != std::string::npos) return true;
+    }
+    return false;
+}
+
+// 確定性的雜訊影像（median / bilateral 的速度跟內容有關，全 0 不準）
+static void fill_noise(ImageU8& img) {
+    uint32_t x = 0x9E3779B9u;
+    const std::size_t row = static_cast<std::size_t>(img.w()) * img.c();
+    for (int y = 0; y < img.h(); ++y) {
+        uint8_t* p = img.row(y);
+        for (std::size_t i = 0; i < row; ++i) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            p[i] = static_cast<uint8_t>(((y + i) & 0xC0) | (x >> 26));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    try {
+        o = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "pf_bench: %s\n", e.what());
+        return 2;
+    }
+
+    if (o.pin) {
+        set_thread_pinning(true);
+        pin_main_thread();
+    }
+
+    std::vector<Row> rows;
+    // memcpy 基準：(bytes, backend, threads) → GB/s（讀 + 寫）
+    std::map<std::tuple<std::size_t, std::string, int>, double> memcpy_gbps;
+    auto baseline = [&](std::size_t bytes, const std::string& be, int threads, const std::string& tag, int c,
+                        double mpix) {
+        const auto key = std::make_tuple(bytes, be, threads);
+        auto it = memcpy_gbps.find(key);
+        if (it != memcpy_gbps.end()) return it->second;
+        std::vector<uint8_t> a(bytes, 1), b(bytes, 0);
+        const Backend bk = backend_of(be);
+        Row r;
+        r.backend = be;
+        r.name    = "memcpy_" + tag;
+        r.group   = "baseline";
+        r.threads = threads;
+        r.channels = c;
+        r.st = measure([&] { parallel_memcpy(b.data(), a.data(), bytes, bk, threads); }, o);
+        r.mpix_per_s = mpix / r.st.median;
+        r.gb_per_s = 2.0 * bytes / r.st.median / 1e9;
+        r.memcpy_gb_per_s = r.gb_per_s;
+        rows.push_back(r);
+        return memcpy_gbps[key] = r.gb_per_s;
+    };
+
+    const std::vector<Kernel> ks = kernels();
+    for (const ImageShape& size : o.sizes) {
+        for (int c : o.channels) {
+            ImageU8 src(size.h, size.w, c, Init::None);
+            fill_noise(src);
+            const ImageShape in = shape_of(src);
+            const std::string tag = std::to_string(size.h) + "x" + std::to_string(size.w) + (c == 1 ? "_gray" : "");
+
+            for (const Kernel& k : ks) {
+                const std::vector<Border> borders = k.uses_border ? o.borders : std::vector<Border>{Border::Reflect};
+                for (Border border : borders) {
+                    const std::string name =
+                        k.name + (k.uses_border ? std::string("_") + border_name(border) : "") + "_" + tag;
+                    if (!selected(o, name)) continue;
+
+                    ImageOp op;
+                    ImageShape out;
+                    try {
+                        op  = k.make(in, border);
+                        out = op.output_shape(in);  // 這個通道數不支援（例如灰階的 sepia）就跳過
+                    } catch (const std::exception&) {
+                        continue;
+                    }
+                    ImageU8 dst(out.h, out.w, out.c, Init::None);
+                    const double mpix  = static_cast<double>(in.h) * in.w / 1e6;
+                    const double bytes = static_cast<double>(in.elems() + out.elems());  // 讀一次 + 寫一次
+
+                    double single_median = NAN;
+                    for (int threads : o.threads) {
+                        for (const std::string& be : o.backends) {
+                            if (!backend_available(be) || (be == "single") != (threads == 1)) continue;
+                            use_threads(threads);
+                            const Backend bk = backend_of(be);
+                            Row r;
+                            r.backend  = be;
+                            r.name     = name;
+                            r.group    = k.group;
+                            r.border   = k.uses_border ? border_name(border) : "";
+                            r.threads  = threads;
+                            r.channels = c;
+                            r.st = measure([&] { op.run(src, dst, bk); }, o);
+                            r.mpix_per_s = mpix / r.st.median;
+                            r.gb_per_s   = bytes / r.st.median / 1e9;
+                            r.memcpy_gb_per_s = baseline(in.elems(), be, threads, tag, c, mpix);
+                            if (be == "single") single_median = r.st.median;
+                            r.speedup    = single_median / r.st.median;
+                            r.efficiency = r.speedup / threads;
+                            std::printf("%-10s %2dT %-44s %10.3f ms %9.1f MPix/s %7.2f GB/s (%3.0f%% of memcpy)  eff %.2f\n",
+                                        be.c_str(), threads, name.c_str(), r.st.median * 1e3, r.mpix_per_s,
+                                        r.gb_per_s, 100.0 * r.gb_per_s / r.memcpy_gb_per_s, r.efficiency);
+                            std::fflush(stdout);
+                            rows.push_back(r);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    set_max_threads(0);
+    set_thread_pinning(false);
+
+    try {
+        const std::string dir = o.outdir.empty() ? "." : o.outdir;
+        std::filesystem::create_directories(dir);
+        write_csv(dir + "/results.csv", rows);
+        write_json(dir + "/results.json", rows);
+        write_meta(dir + "/meta.json", o, rows.size());
+        std::printf("[OK] wrote: %s/results.csv, results.json, meta.json (%zu rows)\n", dir.c_str(), rows.size());
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "pf_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -153,6 +153,137 @@ def _build_cases(pf, rng: np.random.Generator, sizes: List[Tuple[int, int]]):
     return cases
 
 
+def _large_image(size: Tuple[int, int]) -> np.ndarray:
+    # 一次一段 row 填：不要為了 50k x 50k 再配一份同樣大的亂數暫存
+    h, w = size
+    img = np.empty((h, w), dtype=np.uint8)
+    pattern = np.random.default_rng(1).integers(0, 256, size=(64, w), dtype=np.uint8)
+    for y in range(0, h, 64):
+        n = min(64, h - y)
+        img[y:y + n] = pattern[:n]
+    return img
+
+
+def _build_large_cases(pf, img: np.ndarray) -> List[BenchCase]:
+    """幾 GB 的灰階全景圖：總大小超過 2^31 bytes，看 64-bit 定址 + 平行配置 / 清 0 的路徑。"""
+    h, w = img.shape
+    tag = f"{h}x{w}_gray"
+    return [
+        BenchCase("large", f"invert_{tag}", pf.invert, (img,), {}, "gray"),
+        BenchCase("large", f"gaussian_sigma1.2_{tag}", pf.gaussian_filter, (img, 1.2), {}, "gray"),
+        BenchCase("large", f"mean_filter_k5_{tag}", pf.mean_filter, (img, 5), {}, "gray"),
+        BenchCase("large", f"resize_{tag}_to_half", pf.resize, (img,),
+                  {"height": h // 2, "width": w // 2}, "gray"),
+        BenchCase("large", f"flip_horizontal_{tag}", pf.flip_horizontal, (img,), {}, "gray"),
+    ]
+
+
+def _thread_steps(cpus_per_node: List[int]) -> List[int]:
+    """1, 2, 4, ... 加上「剛好一個 node」與「全部」，跨 node 的那一步才看得出來。"""
+    total = sum(cpus_per_node)
+    steps = set()
+    n = 1
+    while n < total:
+        steps.add(n)
+        n *= 2
+    steps.add(total)
+    steps.add(cpus_per_node[0])
+    if len(cpus_per_node) > 1:
+        steps.add(cpus_per_node[0] + 1)
+    return sorted(s for s in steps if 1 <= s <= total)
+
+
+def _nodes_spanned(threads: int, cpus_per_node: List[int]) -> int:
+    # pinning 依 node 排 CPU：排滿一個 node 才換下一個
+    used = 0
+    for i, n in enumerate(cpus_per_node):
+        used += n
+        if threads <= used:
+            return i + 1
+    return len(cpus_per_node)
+
+
+def _run_scaling(pf, rng: np.random.Generator, size: Tuple[int, int],
+                 warmup: int, repeat: int, pin_modes: List[bool]) -> List[dict]:
+    h, w = size
+    img = rng.integers(0, 256, size=(h, w, 3), dtype=np.uint8)
+    cases = [
+        ("gaussian_sigma1.2", pf.gaussian_filter, (img, 1.2), {}),
+        ("cartoonize", pf.cartoonize, (img,), {}),
+        ("resize_x2", pf.resize, (img,), {"height": h * 2, "width": w * 2}),
+    ]
+    cpus_per_node = pf.numa_info()["cpus_per_node"]
+    rows = []
+    try:
+        for pinned in pin_modes:
+            pf.set_thread_pinning(pinned)
+            for name, fn, fargs, fkw in cases:
+                base = None
+                for threads in _thread_steps(cpus_per_node):
+                    pf.set_max_threads(threads)
+                    kw = dict(fkw, backend="openmp" if threads > 1 else "single")
+                    med, _, _ = _time_one(fn, fargs, kw, warmup, repeat)
+                    base = med if base is None else base
+                    rows.append({
+                        "case": f"{name}_{h}x{w}",
+                        "threads": threads,
+                        "nodes": _nodes_spanned(threads, cpus_per_node),
+                        "pinned": pinned,
+                        "median_s": med,
+                        "speedup": base / med if med else float("nan"),
+                        "efficiency": base / med / threads if med else float("nan"),
+                    })
+    finally:
+        pf.set_max_threads(0)
+        pf.set_thread_pinning(False)
+    return rows
+
+
+def _encode_configs() -> List[Tuple[str, str, Dict[str, Any]]]:
+    # (名稱, 格式, save_image_to_bytes 的參數)
+    configs: List[Tuple[str, str, Dict[str, Any]]] = [("qoi", "qoi", {})]
+    for level in (0, 1, 3, 6, 9):
+        configs.append((f"png_l{level}_adaptive", "png", {"compression": level, "png_filter": "adaptive"}))
+    for level in (1, 6):
+        for flt in ("none", "up", "paeth", "fast"):
+            configs.append((f"png_l{level}_{flt}", "png", {"compression": level, "png_filter": flt}))
+    for quality in (75, 90, 95):
+        for sub in ("444", "422", "420"):
+            configs.append((f"jpg_q{quality}_{sub}", "jpg", {"quality": quality, "subsampling": sub}))
+    return configs
+
+
+def _run_encode(pf, image_dir: str, max_size: int, warmup: int, repeat: int) -> List[dict]:
+    exts = (".jpg", ".jpeg", ".png", ".qoi")
+    paths = sorted(os.path.join(image_dir, n) for n in os.listdir(image_dir) if n.lower().endswith(exts))
+    if not paths:
+        raise SystemExit(f"--encode: no images in {image_dir}")
+    imgs = pf.load_images(paths, max_size=max_size or None)
+    raw = sum(im.nbytes for im in imgs)
+
+    rows = []
+    for name, fmt, kw in _encode_configs():
+        sizes: List[int] = []
+
+        def encode_all():
+            sizes[:] = [len(pf.save_image_to_bytes(im, fmt, **kw)) for im in imgs]
+
+        med, mean, stdev = _time_one(encode_all, (), {}, warmup, repeat)
+        rows.append({
+            "case": name,
+            "format": fmt,
+            "images": len(imgs),
+            "raw_bytes": raw,
+            "encoded_bytes": sum(sizes),
+            "ratio": sum(sizes) / raw,
+            "median_s": med,
+            "mean_s": mean,
+            "stdev_s": stdev,
+            "mb_per_s": raw / med / 1e6 if med else float("nan"),
+        })
+    return rows
+
+
 def main():
     ap = argparse.ArgumentParser()
     ap.add_argument("--outdir", default="benchmark_output")
@@ -162,6 +293,19 @@ def main():
     ap.add_argument("--seed", type=int, default=0)
     ap.add_argument("--omp-threads", type=int, default=0,
                     help="set OMP_NUM_THREADS (0 means don't override)")
+    ap.add_argument("--scaling", action="store_true",
+                    help="also sweep thread counts across NUMA nodes (largest size only)")
+    ap.add_argument("--pin", action="store_true",
+                    help="with --scaling, repeat the sweep with pixfoundry thread pinning on")
+    ap.add_argument("--encode", action="store_true",
+                    help="also measure encode MB/s of every png/jpg/qoi option on --encode-dir")
+    ap.add_argument("--encode-dir", default="images_example/input")
+    ap.add_argument("--encode-max-size", type=int, default=1024,
+                    help="shrink the longer side of the encode images to this (0 = full size)")
+    ap.add_argument("--large", default="",
+                    help="also time a gigapixel gray tier of this size, e.g. 50000x50000 "
+                         "(needs ~3x its size in free memory; runs --large-repeat times, no warmup)")
+    ap.add_argument("--large-repeat", type=int, default=3)
     args = ap.parse_args()
 
     sizes: List[Tuple[int,int]] = []
@@ -184,6 +328,11 @@ def main():
     rng = np.random.default_rng(args.seed)
     cases = _build_cases(pf, rng, sizes)
 
+    large_size = None
+    if args.large:
+        lh, lw = args.large.strip().lower().split("x", 1)
+        large_size = (int(lh), int(lw))
+
     meta = {
         "timestamp": _now_iso(),
         "python": sys.version.replace("\n", " "),
@@ -193,18 +342,23 @@ def main():
         "warmup": args.warmup,
         "repeat": args.repeat,
         "sizes": sizes,
+        "large": list(large_size) if large_size else None,
     }
     import json
     with open(os.path.join(outdir, "meta.json"), "w", encoding="utf-8") as f:
         json.dump(meta, f, indent=2)
 
     rows = []
-    for case in cases:
+    timed = [(case, args.warmup, args.repeat) for case in cases]
+    if large_size:
+        large_img = _large_image(large_size)
+        timed += [(case, 0, args.large_repeat) for case in _build_large_cases(pf, large_img)]
+    for case, warmup, repeat in timed:
         for backend in backends:
             kwargs = dict(case.kwargs)
             kwargs["backend"] = backend
             try:
-                med, mean, stdev = _time_one(case.fn, case.args, kwargs, args.warmup, args.repeat)
+                med, mean, stdev = _time_one(case.fn, case.args, kwargs, warmup, repeat)
                 rows.append({
                     "group": case.group,
                     "case": case.name,
@@ -243,6 +397,9 @@ def main():
     report_lines.append(f"- OMP_NUM_THREADS: `{meta['omp_threads']}`")
     report_lines.append(f"- Warmup: `{meta['warmup']}`  Repeat: `{meta['repeat']}`")
     report_lines.append(f"- Sizes: `{', '.join([f'{h}x{w}' for h,w in sizes])}`\n")
+    if large_size:
+        report_lines.append(f"- Large tier: `{large_size[0]}x{large_size[1]}` gray "
+                            f"({large_size[0] * large_size[1] / 1e9:.2f} GB), repeat `{args.large_repeat}`\n")
 
     report_lines.append("## Summary (median time per call)\n")
     report_lines.append("| Group | Case | Single (ms) | OpenMP (ms) | Speedup | Notes |")
@@ -263,8 +420,52 @@ def main():
         spd = s["median_s"] / o["median_s"] if o["median_s"] else float("nan")
         report_lines.append(f"| {group} | {name} | {s_ms:.3f} | {o_ms:.3f} | {spd:.2f}× |  |")
 
+    scaling_rows: List[dict] = []
+    if args.scaling and hasattr(pf, "numa_info"):
+        numa = pf.numa_info()
+        largest = max(sizes, key=lambda hw: hw[0] * hw[1])
+        scaling_rows = _run_scaling(pf, rng, largest, args.warmup, args.repeat,
+                                    [False, True] if args.pin else [False])
+        scaling_path = os.path.join(outdir, "scaling.csv")
+        with open(scaling_path, "w", newline="", encoding="utf-8") as f:
+            w = csv.DictWriter(f, fieldnames=list(scaling_rows[0].keys()))
+            w.writeheader()
+            w.writerows(scaling_rows)
+
+        report_lines.append("\n## Thread scaling (OpenMP, across NUMA nodes)\n")
+        report_lines.append(f"- NUMA nodes: `{numa['nodes']}`  CPUs per node: `{numa['cpus_per_node']}`"
+                            f"  NUMA-aware: `{numa['numa_aware']}`\n")
+        report_lines.append("| Case | Threads | Nodes | Pinned | Median (ms) | Speedup | Efficiency |")
+        report_lines.append("|---|---:|---:|---|---:|---:|---:|")
+        for r in scaling_rows:
+            report_lines.append(f"| {r['case']} | {r['threads']} | {r['nodes']} | {r['pinned']} | "
+                                f"{r['median_s'] * 1e3:.3f} | {r['speedup']:.2f}× | {r['efficiency']:.2f} |")
+
+    encode_rows: List[dict] = []
+    if args.encode:
+        encode_rows = _run_encode(pf, args.encode_dir, args.encode_max_size, args.warmup, args.repeat)
+        encode_path = os.path.join(outdir, "encode.csv")
+        with open(encode_path, "w", newline="", encoding="utf-8") as f:
+            w = csv.DictWriter(f, fieldnames=list(encode_rows[0].keys()))
+            w.writeheader()
+            w.writerows(encode_rows)
+
+        report_lines.append("\n## Encode throughput\n")
+        report_lines.append(f"- Images: `{args.encode_dir}` ({encode_rows[0]['images']} files, "
+                            f"max size `{args.encode_max_size or 'full'}`, "
+                            f"{encode_rows[0]['raw_bytes'] / 1e6:.1f} MB raw)\n")
+        report_lines.append("| Option | Format | MB/s | Size / raw | Median (ms) |")
+        report_lines.append("|---|---|---:|---:|---:|")
+        for r in encode_rows:
+            report_lines.append(f"| {r['case']} | {r['format']} | {r['mb_per_s']:.1f} | "
+                                f"{r['ratio']:.3f} | {r['median_s'] * 1e3:.1f} |")
+
     report_lines.append("\n## Raw data\n")
     report_lines.append("- `results.csv`")
+    if scaling_rows:
+        report_lines.append("- `scaling.csv`")
+    if encode_rows:
+        report_lines.append("- `encode.csv`")
     report_lines.append("- `meta.json`\n")
 
     md_path = os.path.join(outdir, "report.md")
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/filters.hpp"  // 拿 Backend 定義
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 每個操作的成本描述（以「每個 pixel-channel」計）
+//   bytes_per_elem: 讀 + 寫 觸碰的 byte 數
+//   ops_per_elem  : 大約的算術運算數
+//   regions       : 平行區段數（每段各有一次 fork/join）
+// ------------------------------------------------------------
+struct OpCost {
+    float bytes_per_elem = 2.0f;
+    float ops_per_elem   = 1.0f;
+    int   regions        = 1;
+};
+
+// ------------------------------------------------------------
+// 機器參數（由 calibrate_auto() 量測，或從 cache 檔讀回）
+// ------------------------------------------------------------
+struct TuneParams {
+    double ns_per_byte        = 0.05;    // 單執行緒掃記憶體
+    double ns_per_op          = 0.25;    // 單執行緒算術
+    double fork_ns            = 2000.0;  // 一次 parallel region 的固定成本
+    double fork_ns_per_thread = 300.0;   // 每多一條 thread 的額外成本
+    double mem_scaling        = 4.0;     // 記憶體頻寬最多能放大幾倍
+    int    max_threads        = 1;
+    bool   calibrated         = false;
+};
+
+// Auto 的決策結果：threads == 0 代表沿用 OpenMP 預設 team 大小
+struct ExecPlan {
+    Backend backend = Backend::Single;
+    int     threads = 0;
+};
+
+// 依成本模型決定 Single / OpenMP 以及 thread 數
+// requested 不是 Auto 時只做 normalize，不改使用者的選擇
+ExecPlan plan_execution(Backend requested, const OpCost& cost, std::size_t elems);
+ExecPlan plan_execution(Backend requested, const OpCost& cost, const ImageU8& img);
+
+// 目前使用中的參數（第一次呼叫時會先讀 cache 或做校正）
+TuneParams autotune_params();
+void       set_autotune_params(const TuneParams& p);
+
+// 跑一次內建的小型 tuner；cache_path 非空時順便寫檔
+TuneParams calibrate_auto(const std::string& cache_path = "");
+
+// cache 檔：簡單的 "key value" 文字格式
+bool load_autotune_cache(const std::string& path);
+void save_autotune_cache(const std::string& path);
+
+// ------------------------------------------------------------
+// RAII：一次運算的執行範圍
+//   - 向 concurrency governor 報到（見 parallel.hpp），依全行程的 thread 預算
+//     調整 plan：可能減少 thread 數，或整個降成 Single
+//   - 在這個 scope 內把 OpenMP team 大小設成 plan.threads（<= 0 不動）
+// 之後的 kernel 一律看調整過的 plan
+// ------------------------------------------------------------
+class ThreadScope {
+public:
+    explicit ThreadScope(ExecPlan& plan);
+    ~ThreadScope();
+
+    ThreadScope(const ThreadScope&)            = delete;
+    ThreadScope& operator=(const ThreadScope&) = delete;
+
+private:
+    int  saved_     = 0;
+    bool top_level_ = false;
+};
+
+} // namespace pf
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/ops.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 批次處理：同一個運算套到很多張影像
+//
+// 一張只有幾萬個 pixel 的小圖，影像「內部」平行的 fork/join 比計算本身還貴；
+// 批次改成在影像「之間」平行：一條 thread 一次做完一整張（內部用 Single），
+// 影像依大小由大到小排好，thread 做完手上這張就去拿下一張（dynamic 排程），
+// 大小不一的 list 不會有 thread 閒著等最後那張大圖。
+// 張數比 thread 少時退回一張一張做、每張內部平行。
+// Backend::ThreadPool 則是影像之間、影像內部都丟進同一個 work-stealing pool。
+// ------------------------------------------------------------
+
+// dsts 由呼叫端配置（例如一整塊 NxHxWxC 輸出裡的各個切片），
+// 每張都要是 op.output_shape 的大小、row 緊密排列；
+// dsts[i] 不能跟 srcs[i] 重疊（op.in_place 時可以就是 srcs[i]）
+void run_batch(const std::vector<ImageU8>& srcs,
+               std::vector<ImageU8>& dsts,
+               const ImageOp& op,
+               Backend backend = Backend::Auto);
+
+// 每張輸出各自配置，順序跟輸入一樣
+std::vector<ImageU8> run_batch(const std::vector<ImageU8>& srcs,
+                               const ImageOp& op,
+                               Backend backend = Backend::Auto);
+
+} // namespace pf
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "image.hpp"
 #include "filters.hpp"  // 為了拿到 pf::Backend 定義
+#include "autotune.hpp" // OpCost
 
 namespace pf {
 
@@ -31,4 +32,34 @@ ImageU8 gamma_correct(const ImageU8& src,
                       float gamma,
                       Backend backend = Backend::Auto);
 
+// ------------------------------------------------------------
+// 寫進呼叫端給的 dst（尺寸要相符、row 緊密排列）。
+// invert / sepia / 亮度對比 / gamma 是逐點運算，dst 可以就是 src（原地修改）；
+// 灰階輸入的 to_grayscale 也一樣，其他情況 dst 不能跟 src 重疊
+// ------------------------------------------------------------
+void to_grayscale(const ImageU8& src, ImageU8& dst,
+                  Backend backend = Backend::Auto);
+
+void invert(const ImageU8& src, ImageU8& dst,
+            Backend backend = Backend::Auto);
+
+void sepia(const ImageU8& src, ImageU8& dst,
+           Backend backend = Backend::Auto);
+
+void adjust_brightness_contrast(const ImageU8& src, ImageU8& dst,
+                                float alpha,
+                                float beta,
+                                Backend backend = Backend::Auto);
+
+void gamma_correct(const ImageU8& src, ImageU8& dst,
+                   float gamma,
+                   Backend backend = Backend::Auto);
+
+// Auto 用的成本（每個 pixel-channel），ops.hpp 的 ImageOp 也用這幾個
+OpCost to_grayscale_cost();
+OpCost invert_cost();
+OpCost sepia_cost();
+OpCost brightness_contrast_cost();
+OpCost gamma_cost();
+
 } // namespace pf
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "image.hpp"
 #include "filters.hpp"  // 拿 Backend 定義
+#include "autotune.hpp" // OpCost
 
 namespace pf {
 
@@ -24,4 +25,27 @@ ImageU8 cartoonize(const ImageU8& src,
                    uint8_t edge_threshold = 40,    // Sobel 邊緣門檻
                    Backend backend = Backend::Auto);
 
+// 寫進呼叫端給的 dst（尺寸要相符、row 緊密排列，不能跟 src 重疊；
+// amount <= 0 的 sharpen 只是複製，dst 可以就是 src）
+void sharpen(const ImageU8& src,
+             ImageU8& dst,
+             float amount = 1.0f,
+             Backend backend = Backend::Auto);
+
+void emboss(const ImageU8& src,
+            ImageU8& dst,
+            float strength = 1.0f,
+            Backend backend = Backend::Auto);
+
+void cartoonize(const ImageU8& src,
+                ImageU8& dst,
+                float sigma_space = 2.0f,
+                uint8_t edge_threshold = 40,
+                Backend backend = Backend::Auto);
+
+// Auto 用的成本（每個 pixel-channel），ops.hpp 的 ImageOp 也用這幾個
+OpCost sharpen_cost();
+OpCost emboss_cost();
+OpCost cartoonize_cost(float sigma_space);
+
 } // namespace pf
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include "pixfoundry/image.hpp"
@@ -16,13 +17,39 @@ enum class Border {
     Constant
 };
 
+// 越界的 index 依 Border 摺回 [0, n)；Constant 在影像外回傳 -1（由呼叫端填 border_value）。
+// Reflect 是對稱反射（-1 → 0），週期 2n：kernel / halo 比影像寬時可能要摺不只一次。
+// filters、warp、tiled 共用這一份
+inline int border_fold(int i, int n, Border border) {
+    if (i >= 0 && i < n) return i;
+    switch (border) {
+    case Border::Reflect: {
+        const int64_t p = 2 * static_cast<int64_t>(n);
+        int64_t m = i % p;
+        if (m < 0) m += p;
+        return static_cast<int>(m < n ? m : p - 1 - m);
+    }
+    case Border::Replicate:
+        return i < 0 ? 0 : n - 1;
+    case Border::Wrap: {
+        const int m = i % n;
+        return m < 0 ? m + n : m;
+    }
+    case Border::Constant:
+    default:
+        return -1;
+    }
+}
+
 // ------------------------------------------------------------
-// 後端（目前實作只用到 Single，但 bindings 有 "auto"）
+// 後端（Auto 交給 autotune.hpp 的成本模型決定 Single / OpenMP 與 thread 數）
+// ThreadPool 用 parallel.hpp 的常駐 pool，不需要 OpenMP，永遠可用
 // ------------------------------------------------------------
 enum class Backend {
     Auto = 0,
     Single = 1,
     OpenMP = 2,
+    ThreadPool = 3,
 };
 
 inline Backend normalize_backend(Backend b) {
@@ -73,6 +100,41 @@ ImageU8 bilateral_filter(const ImageU8& src,
                          Backend backend = Backend::Single,
                          uint8_t border_value = 0);
 
+// ------------------------------------------------------------
+// 寫進呼叫端給的 dst（尺寸要相符、row 緊密排列）。
+// mean / gaussian 先把 src 整張讀進暫存再寫出，dst 可以就是 src；
+// median / bilateral 的 dst 不能跟 src 重疊
+// ------------------------------------------------------------
+void mean_filter(const ImageU8& src,
+                 ImageU8& dst,
+                 int ksize,
+                 Border border = Border::Reflect,
+                 Backend backend = Backend::Single,
+                 uint8_t border_value = 0);
+
+void gaussian_filter(const ImageU8& src,
+                     ImageU8& dst,
+                     float sigma,
+                     Border border = Border::Reflect,
+                     Backend backend = Backend::Single,
+                     uint8_t border_value = 0);
+
+void median_filter(const ImageU8& src,
+                   ImageU8& dst,
+                   int ksize,
+                   Border border = Border::Reflect,
+                   Backend backend = Backend::Single,
+                   uint8_t border_value = 0);
+
+void bilateral_filter(const ImageU8& src,
+                      ImageU8& dst,
+                      int ksize,
+                      float sigma_color,
+                      float sigma_space,
+                      Border border = Border::Reflect,
+                      Backend backend = Backend::Single,
+                      uint8_t border_value = 0);
+
 // ------------------------------------------------------------
 // Kernel utilities
 // ------------------------------------------------------------
@@ -83,4 +145,16 @@ std::vector<float> box_kernel1d(int ksize);
 // gaussian kernel: sum = 1
 std::vector<float> gaussian_kernel1d(float sigma);
 
+// ------------------------------------------------------------
+// Auto 用的成本（每個 pixel-channel）。單張版本跟 ops.hpp 的 ImageOp 共用，
+// batch / pipeline 規劃出來的才會跟單張呼叫一樣。
+// OpCost 定義在 autotune.hpp（它會 include 這個 header，所以這裡只宣告）
+// ------------------------------------------------------------
+struct OpCost;
+
+// mean / gaussian：兩個 pass，ksize 是 1D kernel 的長度
+OpCost separable_cost(std::size_t ksize);
+OpCost median_filter_cost(int ksize);
+OpCost bilateral_filter_cost(int ksize);
+
 } // namespace pf
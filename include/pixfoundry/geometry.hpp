@@ -3,20 +3,53 @@
 #include <cstdint>
 #include "pixfoundry/image.hpp"
 #include "pixfoundry/filters.hpp"  // 為了取得 Backend enum
+#include "pixfoundry/autotune.hpp" // OpCost
 
 namespace pf {
 
+// 縮放用的插值方式
+enum class Interp {
+    Nearest,
+    Bilinear,
+    Bicubic,
+    Lanczos3,
+    Area,       // 像素面積平均（縮小時最不會 alias）
+};
+
 // resize：使用 bilinear，輸出 new_h x new_w
 ImageU8 resize(const ImageU8& src,
                int new_h,
                int new_w,
                Backend backend = Backend::Auto);
 
-// rotate：以中心為旋轉軸，輸出尺寸跟原圖一樣
+// resize：指定插值方式
+// 兩個 pass（水平 / 垂直），每個軸的 tap index 與 fixed-point 權重只算一次；
+// 縮小時 kernel 支撐範圍跟著倍率放大（antialias）
+ImageU8 resize(const ImageU8& src,
+               int new_h,
+               int new_w,
+               Interp interp,
+               Backend backend = Backend::Auto);
+
+// rotate：以中心為旋轉軸，輸出尺寸跟原圖一樣（bilinear，外面補 0；實作在 warp.cpp）
 ImageU8 rotate(const ImageU8& src,
                float angle_deg,
                Backend backend = Backend::Auto);
 
+// 無損的 90 度倍數旋轉（跟 rotate 一樣是順時針），rotate90 / rotate270 的輸出是 w x h
+ImageU8 rotate90(const ImageU8& src,
+                 Backend backend = Backend::Auto);
+
+ImageU8 rotate180(const ImageU8& src,
+                  Backend backend = Backend::Auto);
+
+ImageU8 rotate270(const ImageU8& src,
+                  Backend backend = Backend::Auto);
+
+// transpose：dst(x, y) = src(y, x)，輸出 w x h
+ImageU8 transpose(const ImageU8& src,
+                  Backend backend = Backend::Auto);
+
 // flip：水平或垂直翻轉
 ImageU8 flip_horizontal(const ImageU8& src,
                         Backend backend = Backend::Auto);
@@ -24,7 +57,8 @@ ImageU8 flip_horizontal(const ImageU8& src,
 ImageU8 flip_vertical(const ImageU8& src,
                       Backend backend = Backend::Auto);
 
-// crop：從 (y, x) 開始取 h x w 區域，超出會自動 clamp
+// crop：從 (y, x) 開始取 h x w 區域，超出會自動 clamp。
+// 回傳跟 src 共用 buffer 的 view（O(1)，不複製 pixel；寫入會反映到原圖）
 ImageU8 crop(const ImageU8& src,
              int y,
              int x,
@@ -32,4 +66,50 @@ ImageU8 crop(const ImageU8& src,
              int w,
              Backend backend = Backend::Auto);
 
+// ------------------------------------------------------------
+// 寫進呼叫端給的 dst（尺寸要相符、row 緊密排列）；dst 不能跟 src 重疊，
+// 只有 flip 允許 dst 就是 src（原地左右 / 上下交換）
+// ------------------------------------------------------------
+
+// 輸出大小取 dst 的 h x w
+void resize(const ImageU8& src,
+            ImageU8& dst,
+            Interp interp = Interp::Bilinear,
+            Backend backend = Backend::Auto);
+
+void rotate(const ImageU8& src,
+            ImageU8& dst,
+            float angle_deg,
+            Backend backend = Backend::Auto);
+
+void rotate90(const ImageU8& src,
+              ImageU8& dst,
+              Backend backend = Backend::Auto);
+
+void rotate180(const ImageU8& src,
+               ImageU8& dst,
+               Backend backend = Backend::Auto);
+
+void rotate270(const ImageU8& src,
+               ImageU8& dst,
+               Backend backend = Backend::Auto);
+
+void transpose(const ImageU8& src,
+               ImageU8& dst,
+               Backend backend = Backend::Auto);
+
+void flip_horizontal(const ImageU8& src,
+                     ImageU8& dst,
+                     Backend backend = Backend::Auto);
+
+void flip_vertical(const ImageU8& src,
+                   ImageU8& dst,
+                   Backend backend = Backend::Auto);
+
+// Auto 用的成本（每個輸出 pixel-channel），ops.hpp 的 ImageOp 也用這幾個。
+// resize 的 fy / fx 是縮小倍率（src / dst，放大時算 1）：縮得越多，每個輸出讀的 taps 越多
+OpCost resize_cost(Interp interp, double fy, double fx);
+OpCost flip_cost();
+OpCost quarter_turn_cost();  // rotate90 / 180 / 270、transpose
+
 } // namespace pf
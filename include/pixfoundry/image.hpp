@@ -1,8 +1,11 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include "pixfoundry/memory.hpp"
 
 namespace pf {
 
@@ -10,24 +13,36 @@ class ImageU8 {
 public:
     ImageU8() = default;
 
-    // 擁有新配置（自有）的影像
+    // 擁有新配置（自有）的影像：64-byte 對齊、清成 0、row 緊密排列
     ImageU8(int h, int w, int c)
+        : ImageU8(h, w, c, Init::Zero, RowPad::None) {}
+
+    // 指定配置策略：kernel 的輸出會寫滿每個 pixel，用 Init::None 省掉清 0；
+    // RowPad::CacheLine 讓每個 row 的起點都對齊（stride 可能大於 w * c）
+    ImageU8(int h, int w, int c, Init init, RowPad pad = RowPad::None)
         : h_(h), w_(w), c_(c)
     {
         if (h <= 0 || w <= 0 || (c != 1 && c != 3))
             throw std::invalid_argument("ImageU8: invalid shape");
-        const size_t n = static_cast<size_t>(h_) * w_ * c_;
+        stride_ = row_pitch(w_ * c_, pad);
+        // 最後一個 row 不需要補齊
+        const size_t n = (h_ - 1) * stride_ + w_ * c_;
         // 自己配置，shared_ptr 確保生命週期
-        data_ = std::shared_ptr<uint8_t[]>(new uint8_t[n](), std::default_delete<uint8_t[]>());
+        data_ = allocate_buffer(n, init);
     }
 
     // 共享外部緩衝區（零拷貝）
-    ImageU8(int h, int w, int c, std::shared_ptr<uint8_t[]> external)
+    // external 指向第一個 row 的第一個 pixel；stride 是相鄰兩個 row 的距離（bytes），
+    // 0 表示緊密排列（w * c）。pixel 之間一定是緊密的（c bytes）。
+    ImageU8(int h, int w, int c, std::shared_ptr<uint8_t[]> external, size_t stride = 0)
         : h_(h), w_(w), c_(c), data_(std::move(external))
     {
         if (!data_) throw std::invalid_argument("ImageU8: null external buffer");
         if (h <= 0 || w <= 0 || (c != 1 && c != 3))
             throw std::invalid_argument("ImageU8: invalid shape");
+        stride_ = stride ? stride : w_ * c_;
+        if (stride_ < w_ * c_)
+            throw std::invalid_argument("ImageU8: stride smaller than row width");
     }
 
     // 不允許複製（避免意外深拷）
@@ -43,19 +58,149 @@ public:
     int  c() const { return c_; }
     bool empty() const { return !data_; }
 
+    // row pitch（bytes）；緊密排列時等於 w * c
+    size_t stride() const { return stride_; }
+    bool   is_contiguous() const { return stride_ == w_ * c_; }
+
+    // data() 指向 (0, 0)；第 y 個 row 從 data() + y * stride() 開始
     uint8_t*       data()       { return data_.get(); }
     const uint8_t* data() const { return data_.get(); }
 
+    uint8_t*       row(int y)       { return data_.get() + static_cast<size_t>(y) * stride_; }
+    const uint8_t* row(int y) const { return data_.get() + static_cast<size_t>(y) * stride_; }
+
+    // ---- copy-on-write ----
+    // 讀的一方用 share() 共用 buffer（不複製 pixel）；
+    // 要寫的一方先呼叫 make_unique()，buffer 還有別人在用時才換成私有的複本
+
+    ImageU8 share() const {
+        if (empty()) return ImageU8();
+        return ImageU8(static_cast<int>(h_), static_cast<int>(w_), static_cast<int>(c_), data_, stride_);
+    }
+
+    // 兩張影像是否用同一塊 buffer（view 也算）
+    bool shares_buffer(const ImageU8& other) const {
+        return data_ && other.data_ &&
+               !data_.owner_before(other.data_) && !other.data_.owner_before(data_);
+    }
+
+    // 沒有其他 ImageU8 共用這塊 buffer
+    bool is_unique() const { return data_.use_count() == 1; }
+
+    // 深拷貝成新的、緊密排列的影像
+    ImageU8 clone() const {
+        if (empty()) return ImageU8();
+        ImageU8 dst(static_cast<int>(h_), static_cast<int>(w_), static_cast<int>(c_), Init::None);
+        const size_t row_len = w_ * c_;
+        copy_rows(dst.data_.get(), row_len, data_.get(), stride_, h_, row_len);
+        return dst;
+    }
+
+    void make_unique() {
+        if (!empty() && !is_unique()) *this = clone();
+    }
+
+    // 子區域 view：跟原圖共用同一塊 buffer（O(1)，不複製 pixel），
+    // 呼叫端負責確認範圍在影像內
+    ImageU8 view(int y, int x, int h, int w) const {
+        if (empty() || y < 0 || x < 0 || h <= 0 || w <= 0 ||
+            static_cast<size_t>(y) + h > h_ || static_cast<size_t>(x) + w > w_)
+            throw std::out_of_range("ImageU8::view: region out of bounds");
+        uint8_t* p = data_.get() + static_cast<size_t>(y) * stride_ + static_cast<size_t>(x) * c_;
+        // aliasing constructor：共用 refcount，指標指到子區域起點
+        return ImageU8(h, w, static_cast<int>(c_), std::shared_ptr<uint8_t[]>(data_, p), stride_);
+    }
+
     // 暴露 shared_ptr 以便 pybind11 綁定時延長生命週期
     const std::shared_ptr<uint8_t[]>& shared() const { return data_; }
 
 private:
     size_t h_ = 0, w_ = 0, c_ = 1;
+    size_t stride_ = 0;
     std::shared_ptr<uint8_t[]> data_;
 };
 
-    ImageU8 load_image_u8(const std::string& path);
+// ------------------------------------------------------------
+// 呼叫端自己提供輸出（out=）
+// ------------------------------------------------------------
+
+// dst 必須剛好是 h x w x c，而且 row 緊密排列（kernel 用連續 index 寫輸出）
+inline void check_output(const ImageU8& dst, int h, int w, int c, const char* who) {
+    if (dst.empty() || dst.h() != h || dst.w() != w || dst.c() != c) {
+        throw std::invalid_argument(std::string(who) + ": dst must be " +
+                                    std::to_string(h) + "x" + std::to_string(w) + "x" +
+                                    std::to_string(c));
+    }
+    if (!dst.is_contiguous()) {
+        throw std::invalid_argument(std::string(who) + ": dst must be contiguous");
+    }
+}
+
+// 兩張影像的 pixel 範圍（第一個 row 起點到最後一個 row 終點）是否重疊
+inline bool overlaps(const ImageU8& a, const ImageU8& b) {
+    if (a.empty() || b.empty()) return false;
+    const auto a0 = reinterpret_cast<std::uintptr_t>(a.data());
+    const auto b0 = reinterpret_cast<std::uintptr_t>(b.data());
+    const auto a1 = reinterpret_cast<std::uintptr_t>(a.row(a.h() - 1) + static_cast<size_t>(a.w()) * a.c());
+    const auto b1 = reinterpret_cast<std::uintptr_t>(b.row(b.h() - 1) + static_cast<size_t>(b.w()) * b.c());
+    return a0 < b1 && b0 < a1;
+}
+
+// 逐點運算 / 翻轉可以原地做（dst 跟 src 是同一塊、同樣排列）；
+// 其他 kernel 會讀到別的位置，dst 不能跟 src 有任何重疊
+inline bool same_pixels(const ImageU8& a, const ImageU8& b) {
+    return !a.empty() && a.data() == b.data() && a.stride() == b.stride() &&
+           a.h() == b.h() && a.w() == b.w() && a.c() == b.c();
+}
+
+inline void check_no_overlap(const ImageU8& src, const ImageU8& dst, const char* who,
+                             bool in_place_ok = false) {
+    if (in_place_ok && same_pixels(src, dst)) return;
+    if (overlaps(src, dst)) {
+        throw std::invalid_argument(std::string(who) + (in_place_ok
+            ? ": dst must be src itself or not overlap it"
+            : ": dst must not overlap src"));
+    }
+}
+
+    // ------------------------------------------------------------
+    // 編碼參數（存檔 / 編碼到記憶體）
+    // ------------------------------------------------------------
+    enum class PngFilter {
+        None, Sub, Up, Average, Paeth,  // 每個 row 都用同一種
+        Adaptive,                       // 每個 row 五種都試，挑絕對值總和最小的（libpng 的作法）
+        Fast,                           // 同上，但只在 row 裡每 8 個 byte 取一個來估
+    };
+
+    enum class ChromaSubsampling {
+        Auto,   // quality <= 90 用 4:2:0，否則 4:4:4
+        S444,
+        S422,
+        S420,
+    };
+
+    struct EncodeOptions {
+        int               png_level        = 6;  // 0：不壓縮；1 最快 ... 9 最小
+        PngFilter         png_filter       = PngFilter::Adaptive;
+        int               jpeg_quality     = 95;  // 1 ... 100
+        ChromaSubsampling jpeg_subsampling = ChromaSubsampling::Auto;
+    };
+
+    // 讀檔：整個檔 mmap（不支援時一次 read）進來再從記憶體解碼，header 只 parse 一次
+    // max_size > 0：長邊縮到 max_size 以內（比例不變、只縮不放）；
+    // JPEG 直接用 1/2、1/4、1/8 縮小解碼（見 jpeg.hpp），剩下的比例再用 Interp::Area 縮
+    ImageU8 load_image_u8(const std::string& path, int max_size = 0);
+    // 依副檔名決定格式：.png / .jpg（.jpeg）/ .qoi
     void    save_image_u8(const std::string& path,
-                        const uint8_t* data, int h, int w, int c);
+                        const uint8_t* data, int h, int w, int c,
+                        const EncodeOptions& options = EncodeOptions());
+
+    // 記憶體裡的編碼資料（png / jpg / qoi / bmp / ...）→ 影像；原圖灰階給 1 通道，其他給 3 通道
+    ImageU8 decode_image_u8(const uint8_t* data, std::size_t size, int max_size = 0);
+
+    // 影像 → 編碼後的 bytes；format: "png" / "jpg"（"jpeg"）/ "qoi"，可以帶前面的 '.'
+    std::vector<uint8_t> encode_image_u8(const std::string& format,
+                                         const uint8_t* data, int h, int w, int c,
+                                         const EncodeOptions& options = EncodeOptions());
 
 } // namespace pf
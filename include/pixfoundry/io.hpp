@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pixfoundry/image.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 批次讀寫：每個檔案一個工作丟進 ThreadPool，decode / encode 同時在多顆核心上做。
+// 結果順序跟 paths 一樣；有檔案失敗時等全部做完後丟出第一個錯誤（訊息裡有路徑）。
+// max_size 同 load_image_u8（做縮圖時 JPEG 直接縮小解碼）；options 同 save_image_u8。
+// ------------------------------------------------------------
+std::vector<ImageU8> load_images(const std::vector<std::string>& paths, int max_size = 0);
+void save_images(const std::vector<std::string>& paths, const std::vector<ImageU8>& images,
+                 const EncodeOptions& options = EncodeOptions());
+
+// ------------------------------------------------------------
+// ImageReader：預讀
+//
+// 背景 thread 依序把後面最多 prefetch 張先讀好、解好，
+// 呼叫端處理目前這張的時候下一張已經在準備了。next() 依 paths 的順序交出影像；
+// 某個檔案讀不了，輪到它的那次 next() 丟出錯誤，之後的照常。
+//
+// 用自己的 I/O thread、不佔 ThreadPool：讀網路磁碟卡住時不會拖住運算。
+// ------------------------------------------------------------
+class ImageReader {
+public:
+    // threads <= 0：min(prefetch, available_cpus())
+    explicit ImageReader(std::vector<std::string> paths, int prefetch = 4, int threads = 0,
+                         int max_size = 0);
+    ~ImageReader();
+
+    ImageReader(const ImageReader&)            = delete;
+    ImageReader& operator=(const ImageReader&) = delete;
+
+    // 拿下一張（還沒好就等）；全部拿完回傳 false
+    bool next(ImageU8& img);
+
+    std::size_t size() const { return paths_.size(); }
+    std::size_t consumed() const;
+
+private:
+    struct Slot {
+        ImageU8            img;
+        std::exception_ptr error;
+        bool               ready = false;
+    };
+
+    void worker_loop();
+
+    const std::vector<std::string> paths_;
+    const std::size_t              prefetch_;
+    const int                      max_size_;
+    std::vector<Slot>              slots_;
+
+    mutable std::mutex       mutex_;
+    std::condition_variable  cv_;
+    std::size_t              claimed_  = 0;  // 下一個要讀的
+    std::size_t              consumed_ = 0;  // 下一個要交出去的
+    bool                     stop_     = false;
+    std::vector<std::thread> threads_;
+};
+
+// ------------------------------------------------------------
+// ImageWriter：write-behind
+//
+// write() 把影像放進佇列就回來，背景 thread 負責 encode + 寫檔；
+// 佇列已經有 queue_depth 張在等時 write() 會等（記憶體不會無限長）。
+// close() 等全部寫完，有失敗就丟出第一個錯誤；解構時也會等，但不丟例外。
+// ------------------------------------------------------------
+class ImageWriter {
+public:
+    // threads <= 0：min(queue_depth, available_cpus())
+    // options：每張都用同一組編碼參數
+    explicit ImageWriter(int queue_depth = 4, int threads = 0,
+                         const EncodeOptions& options = EncodeOptions());
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&)            = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    // img 的像素必須在寫完前都有效：不確定時交一份自己的（ImageU8::clone()）
+    void write(std::string path, ImageU8 img);
+    void close();
+
+    std::size_t pending() const;  // 還沒寫完的張數（含正在寫的）
+    std::size_t written() const;
+
+private:
+    struct Job {
+        std::string path;
+        ImageU8     img;
+    };
+
+    void worker_loop();
+
+    const std::size_t   depth_;
+    const EncodeOptions options_;
+
+    mutable std::mutex       mutex_;
+    std::condition_variable  cv_;
+    std::deque<Job>          queue_;
+    std::size_t              active_  = 0;  // 正在 encode 的
+    std::size_t              written_ = 0;
+    std::exception_ptr       error_;
+    bool                     closed_  = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace pf
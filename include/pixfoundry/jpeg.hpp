@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pixfoundry/image.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// JPEG 縮小解碼（縮圖用）
+//
+// stb 只能解全尺寸；這裡的 decoder 可以直接解成 1/2、1/4、1/8：
+// 每個 8x8 block 照樣做 Huffman 解碼，但反 DCT 換成 k x 8 的矩陣（k = 8 / scale），
+// 一次算出「全尺寸結果再做 (8/k) x (8/k) 區塊平均」的值，
+// 省掉大部分的 IDCT、色彩轉換與記憶體寫入。1/8 只剩 DC 係數。
+// 結果等於全尺寸解碼後 box 縮小（差在四捨五入；取樣比例較低的色度在縮小後的格點上做 bilinear）。
+//
+// 支援 baseline / extended Huffman、8-bit、灰階或 YCbCr（任意取樣比例）、restart marker。
+// progressive、arithmetic、12-bit、CMYK、分成多個 scan 的檔案回傳 false，呼叫端改用 stb。
+// ------------------------------------------------------------
+struct JpegInfo {
+    int  w        = 0;
+    int  h        = 0;
+    int  c        = 0;      // 1 或 3（解出來的通道數）
+    bool scalable = false;  // 這個 decoder 能處理
+};
+
+// 只讀 header 到 SOF 為止；不是 JPEG 回傳 false
+bool jpeg_info(const uint8_t* data, std::size_t size, JpegInfo& info);
+
+// scale: 2 / 4 / 8；輸出 ceil(h / scale) x ceil(w / scale)
+bool decode_jpeg_scaled(const uint8_t* data, std::size_t size, int scale, ImageU8& out);
+
+// ------------------------------------------------------------
+// JPEG 編碼（baseline、JFIF、灰階或 YCbCr）
+//
+// quality 1 ... 100 照 IJG 的方式縮放 Annex K 的量化表；Huffman 用標準表（不多掃一次做最佳化）。
+// 色度取樣可以自己選；stb 的 writer 是 quality <= 90 就固定 4:2:0，這裡的 Auto 維持同樣行為。
+// 色度縮小用 box 平均，邊緣不滿一個 MCU 的部分複製最後一欄 / 列。
+// ------------------------------------------------------------
+std::vector<uint8_t> encode_jpeg(const uint8_t* data, int h, int w, int c, std::size_t stride,
+                                 int quality, ChromaSubsampling subsampling);
+
+} // namespace pf
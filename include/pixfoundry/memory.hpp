@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 影像 buffer 的配置策略
+// ------------------------------------------------------------
+
+// buffer 起點一律對齊 cache line（也夠 AVX-512 的 aligned load 用）
+constexpr std::size_t kBufferAlign = 64;
+
+// 超過這個大小的 buffer 建議 kernel 用 transparent huge pages（少 TLB miss）
+constexpr std::size_t kHugePageThreshold = std::size_t(4) << 20;
+
+// Zero：清成 0（預設，跟以前的 new uint8_t[n]() 一樣）
+// None：不初始化，給「每個 pixel 都會被寫到」的輸出用，省一次整張圖的寫入
+enum class Init { Zero, None };
+
+// None：row 緊密排列（stride = w * c）
+// CacheLine：row pitch 補到 kBufferAlign 的倍數，每個 row 的起點都對齊
+enum class RowPad { None, CacheLine };
+
+// 配置 bytes 大小、對齊 kBufferAlign 的 buffer；shared_ptr 的 deleter 負責釋放
+// （buffer pool 開著時會從 pool 拿，釋放時還回 pool）
+std::shared_ptr<uint8_t[]> allocate_buffer(std::size_t bytes, Init init = Init::Zero);
+
+// 複製 rows 個 row（每個 row_bytes）；總共幾 GB 的時候切段平行複製（parallel.hpp 的 parallel_chunks）
+void copy_rows(uint8_t* dst, std::size_t dst_stride, const uint8_t* src, std::size_t src_stride,
+               std::size_t rows, std::size_t row_bytes);
+
+// 依 RowPad 算出 row pitch
+inline std::size_t row_pitch(std::size_t row_bytes, RowPad pad) {
+    if (pad == RowPad::None) return row_bytes;
+    return (row_bytes + kBufferAlign - 1) / kBufferAlign * kBufferAlign;
+}
+
+// kernel 暫存用的 typed buffer（T 必須是 trivially copyable，不會呼叫建構子），
+// 底層跟影像一樣走 allocate_buffer，pool 開著時就會重用
+template <class T>
+class ScratchBuffer {
+public:
+    explicit ScratchBuffer(std::size_t n, Init init = Init::None)
+        : n_(n), buf_(allocate_buffer(n * sizeof(T), init)) {}
+
+    T*       data()       { return reinterpret_cast<T*>(buf_.get()); }
+    const T* data() const { return reinterpret_cast<const T*>(buf_.get()); }
+    T&       operator[](std::size_t i)       { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    std::size_t size() const { return n_; }
+
+private:
+    std::size_t n_;
+    std::shared_ptr<uint8_t[]> buf_;
+};
+
+// ------------------------------------------------------------
+// Buffer pool：依大小分桶重用 buffer，省掉反覆 malloc / page fault
+// ------------------------------------------------------------
+//
+// 大小分成 2^k * {1, 1.25, 1.5, 1.75} 的級距（浪費最多 25%），
+// 每條 thread 有自己的小 cache（<= 1 MB 的 buffer、每桶幾個），其餘放在共用的 free list。
+// 閒置（還在 pool 裡）的總量不超過 max_bytes，超過的直接還給系統。
+// 預設關閉。
+
+struct BufferPoolStats {
+    bool        enabled      = false;
+    std::size_t max_bytes    = 0;   // 閒置 buffer 的上限
+    std::size_t cached_bytes = 0;   // 目前閒置在 pool（含各 thread cache）的量
+    std::size_t in_use_bytes = 0;   // 從 pool 借出去、還沒還回來的量
+    uint64_t    hits         = 0;   // 直接重用
+    uint64_t    misses       = 0;   // pool 裡沒有，向系統要
+    uint64_t    evictions    = 0;   // 還回來時超過上限，直接釋放
+};
+
+void enable_buffer_pool(bool enabled);
+void set_buffer_pool_limit(std::size_t max_bytes);
+
+// 釋放閒置 buffer 直到剩 keep_bytes 以下，回傳釋放的 bytes。
+// keep_bytes = 0 時其他 thread 的 cache 會在它們下次用到 pool 時清掉。
+std::size_t trim_buffer_pool(std::size_t keep_bytes = 0);
+
+BufferPoolStats buffer_pool_stats();
+
+} // namespace pf
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/filters.hpp"   // Backend / Border
+#include "pixfoundry/geometry.hpp"  // Interp
+#include "pixfoundry/autotune.hpp"  // OpCost
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 把一個運算（連同參數）包成物件，給批次（batch.hpp）與 Pipeline 用。
+// 參數在建立時就檢查；之後只要知道輸入大小就能算出輸出大小，
+// 不必真的跑一次就能先規劃好 buffer
+// ------------------------------------------------------------
+
+struct ImageShape {
+    int h = 0, w = 0, c = 0;
+
+    bool operator==(const ImageShape& o) const { return h == o.h && w == o.w && c == o.c; }
+    bool operator!=(const ImageShape& o) const { return !(*this == o); }
+    std::size_t elems() const { return static_cast<std::size_t>(h) * w * c; }
+};
+
+inline ImageShape shape_of(const ImageU8& img) {
+    return {img.h(), img.w(), img.c()};
+}
+
+struct ImageOp {
+    std::string name;
+    // 輸入大小 → 輸出大小；這個輸入不能處理（例如 sepia 給灰階）時丟例外
+    std::function<ImageShape(const ImageShape& in)> output_shape;
+    // 寫進已配置好的 dst（就是各模組的 dst 版本）
+    std::function<void(const ImageU8& src, ImageU8& dst, Backend backend)> run;
+    // 每個 pixel-channel 的成本（Auto 估整批 / 整條 pipeline 用）
+    OpCost cost;
+    // dst 可以就是 src（逐點運算、flip、mean / gaussian）
+    bool in_place = false;
+    // 每個輸出 row 最多用到上下各幾個輸入 row（串流逐段做時要多帶的 row，見 stream.hpp）；
+    // -1：不能逐段做（幾何轉換、尺寸會變的、Border::Wrap 要用到另一頭的 row）
+    int halo = -1;
+};
+
+// ---- filters ----
+ImageOp mean_filter_op(int ksize, Border border = Border::Reflect, uint8_t border_value = 0);
+ImageOp gaussian_filter_op(float sigma, Border border = Border::Reflect, uint8_t border_value = 0);
+ImageOp median_filter_op(int ksize, Border border = Border::Reflect, uint8_t border_value = 0);
+ImageOp bilateral_filter_op(int ksize, float sigma_color, float sigma_space,
+                            Border border = Border::Reflect, uint8_t border_value = 0);
+
+// ---- color ----
+ImageOp to_grayscale_op();
+ImageOp invert_op();
+ImageOp sepia_op();
+ImageOp adjust_brightness_contrast_op(float alpha, float beta);
+ImageOp gamma_correct_op(float gamma);
+
+// ---- effects ----
+ImageOp sharpen_op(float amount = 1.0f);
+ImageOp emboss_op(float strength = 1.0f);
+ImageOp cartoonize_op(float sigma_space = 2.0f, uint8_t edge_threshold = 40);
+
+// ---- geometry ----
+ImageOp resize_op(int new_h, int new_w, Interp interp = Interp::Bilinear);
+ImageOp flip_horizontal_op();
+ImageOp flip_vertical_op();
+ImageOp rotate_op(float angle_deg);
+ImageOp rotate90_op();
+ImageOp rotate180_op();
+ImageOp rotate270_op();
+ImageOp transpose_op();
+// 跟 crop() 一樣會 clamp 到影像內，但結果是複製出來的（不是 view）
+ImageOp crop_op(int y, int x, int h, int w);
+
+// ---- pyramid ----
+ImageOp pyr_down_op();
+ImageOp downscale_box_op(int factor);
+
+} // namespace pf
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "pixfoundry/autotune.hpp"  // ExecPlan / Backend
+
+#ifdef PF_HAS_OPENMP
+#include <omp.h>
+#endif
+
+namespace pf {
+
+// ------------------------------------------------------------
+// ThreadPool：常駐的 work-stealing thread pool（Backend::ThreadPool 用）
+//
+// 第一次用到時開 available_cpus() - 1 條 worker，之後所有運算共用、不再開關 thread。
+// set_max_threads() 調低預算時多出來的 worker 只是睡著，調回來再叫醒。
+// 每條 worker 有自己的 deque：自己從尾端拿（剛推進去的，cache 還熱），
+// 閒著的 worker 從別人的頭端偷；不是 worker 的 thread 推到一個共用的入口 queue。
+//
+// parallel_for 把範圍切成 grain 大小的工作推進 deque，呼叫端不是乾等，
+// 而是一起下去做（自己的、或偷來的），直到這一組全部做完。
+// 所以在工作裡面再呼叫 parallel_for（例如 cartoonize 裡的 gaussian_filter）
+// 只是多推幾塊工作給同一批 thread，不會多開 thread、也不會卡死。
+// ------------------------------------------------------------
+class ThreadPool {
+public:
+    static ThreadPool& instance();
+
+    // 參與計算的 thread 數：醒著的 worker + 呼叫端自己
+    int size() const { return active_.load(std::memory_order_relaxed) + 1; }
+
+    // 這條 thread 是不是 pool 的 worker
+    static bool on_worker();
+    // 正在做 pool 的工作：worker，或在 parallel_for 裡一起做的呼叫端。
+    // 這時候開始的運算已經算在推這組工作的人帳上（governor 不再另外給 thread）
+    static bool in_pool_work();
+
+    // 已經建好的 pool 最多用 threads 條（含呼叫端）；還沒建的話建立時自己會讀預算
+    static void limit_threads(int threads);
+
+    // 對 [begin, end) 每 grain 個一塊呼叫 body(b, e)；
+    // 任何一塊丟出的例外，等全部做完後在呼叫端重新丟出（只留第一個）
+    void parallel_for(long begin, long end, long grain,
+                      const std::function<void(long, long)>& body);
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    struct Group;
+    struct Task;
+    struct Queue;
+
+    explicit ThreadPool(int workers);
+    ~ThreadPool();
+
+    void worker_loop(int id);
+    bool try_pop(int self, Task& t);
+    void execute(const Task& t);
+
+    // 開 thread 之前就定好，worker 讀它不用上鎖
+    const int workers_;
+    std::atomic<int> active_;  // 目前允許拿工作的 worker 數（編號 < active_ 的）
+
+    // queues_[0 .. workers_-1] 是各 worker 的 deque，最後一個是外部 thread 的入口
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread>            threads_;
+
+    std::atomic<long>       queued_{0};  // 還在 queue 裡、沒人拿走的工作數
+    std::mutex              sleep_mutex_;
+    std::condition_variable wake_;
+};
+
+// ------------------------------------------------------------
+// concurrency governor：全行程共用的 thread 預算
+//
+// 預算預設是 available_cpus()（affinity 與 cgroup CPU 配額取小），有 OpenMP 時
+// 再跟載入時的 omp_get_max_threads() 取小，使用者設的 OMP_NUM_THREADS 才不會被
+// ThreadScope 的 omp_set_num_threads 蓋掉；可以用環境變數 PF_MAX_THREADS 或 set_max_threads() 改。
+// 每個頂層呼叫（ThreadScope）開始時向 governor 報到，依「還沒被佔走的 thread」
+// 和「同時在跑的頂層呼叫數」分到一份 thread；分到 1 條就直接走 Single。
+// 所以多條 Python thread 同時呼叫時，總 thread 數不會超過預算太多
+// （最多再加上這些呼叫端自己），不會每個呼叫都開一整個 OpenMP team。
+// 巢狀呼叫（cartoonize 裡的 gaussian_filter、batch 裡每一張）沿用外層分到的份額。
+// ------------------------------------------------------------
+struct ConcurrencyStats {
+    int      max_threads     = 1;  // 目前的預算
+    int      available_cpus  = 1;  // affinity / cgroup 配額算出來的 CPU 數
+    int      in_flight       = 0;  // 正在跑的頂層呼叫
+    int      peak_in_flight  = 0;  // 上次 reset 之後同時在跑的最大值
+    uint64_t parallel_calls  = 0;  // 拿到想要的 thread 數平行跑
+    uint64_t throttled_calls = 0;  // 想平行但分到較少 thread（含降成單執行緒）
+    uint64_t serial_calls    = 0;  // 本來就只要一條 thread
+};
+
+int  available_cpus();
+int  max_threads();
+void set_max_threads(int n);  // n <= 0：回到預設（PF_MAX_THREADS，或 available_cpus 跟 OMP_NUM_THREADS 取小）
+
+ConcurrencyStats concurrency_stats();
+void             reset_concurrency_stats();
+
+// ThreadScope 用：一次運算開始 / 結束。
+// 頂層呼叫回傳 true；plan 會依分到的 thread 數調整（可能降成 Single）
+bool enter_call(ExecPlan& plan);
+void leave_call(bool top_level);
+
+// ------------------------------------------------------------
+// NUMA：多插槽機器上讓資料留在寫它的那顆 CPU 附近
+//
+// numa_aware 開著時（預設：偵測到一個以上的 NUMA node 就開，PF_NUMA=0/1 可以強制），
+// OpenMP 的 row band 改成固定切法：第 t 條 thread 永遠做 [rows*t/T, rows*(t+1)/T)。
+// kernel 的輸出不先清 0（Init::None），page 在第一次寫的時候才配置，
+// 所以會落在寫它的 thread 所在的 node；多 pass 的 kernel（separable 卷積、cartoonize）
+// 每個 pass 同樣的 row 都是同一條 thread 做，後面的 pass 讀的是本地記憶體。
+// 要清 0 的大 buffer 也用同樣的切法平行清。
+// ThreadPool 的工作會被偷走，不保證 locality。
+//
+// thread pinning（預設關）把 OpenMP team 的第 1.. 條 thread 綁到固定的 CPU，
+// CPU 依 node 排好（排滿一個 node 才換下一個），連續的 row 區段就會在同一個 node 上。
+// 每個頂層呼叫由 governor 分一段連續、互不重疊的 CPU（第 t 條綁到 base + t），
+// 同時在跑的呼叫不會擠在同幾顆 CPU 上；分不到完整一段時這次就不 pin。
+// 呼叫端自己的 thread 不動；pool worker 也不綁（工作會被偷，本來就不保證 locality）。
+// ------------------------------------------------------------
+struct NumaInfo {
+    std::vector<int> cpus_per_node;  // 這個行程能用的 CPU，依 node 分
+    bool             numa_aware = false;
+    bool             pinned     = false;
+};
+
+NumaInfo numa_info();
+bool     numa_aware();
+void     set_numa_aware(bool enabled);
+void     set_thread_pinning(bool enabled);
+
+// governor 分給這條 thread 目前頂層呼叫的 slot 起點（-1：這次不 pin）；進 parallel region 前取
+int team_pin_base();
+// OpenMP team 的第 t 條 thread 進 parallel region 時呼叫，綁到 slot base + t
+// （pinning 關著時幾乎不花時間）
+void pin_team_thread(int base, int t);
+
+// 把 [p, p + bytes) 清 0；numa_aware 時照固定切法由各條 thread 清自己那段，
+// 不然大的（>= kParallelFillBytes）照 parallel_chunks 切成幾段平行清
+void first_touch_zero(uint8_t* p, std::size_t bytes);
+
+// ------------------------------------------------------------
+// 幾 GB 的 buffer（30 ~ 60 GP 的全景圖）清 0 / 複製：一條 thread 光是 page fault 跟 memset
+// 就要好幾秒，切成幾 MB 一段分給各條 thread 做
+// ------------------------------------------------------------
+constexpr std::size_t kParallelFillBytes = std::size_t(64) << 20;  // 這麼大以上才切
+constexpr std::size_t kFillChunkBytes    = std::size_t(8) << 20;   // 一段大約多大
+
+// n 個單位（每個 unit_bytes）切成段呼叫 body(b, e)，各段互不相干：
+// numa_aware 時第 t 條 OpenMP thread 固定做第 t 段（跟 parallel_rows 的切法一樣）；
+// 不然總大小 >= kParallelFillBytes 時交給 ThreadPool，一段大約 kFillChunkBytes；
+// 小的、或已經在 OpenMP parallel region 裡面的，直接 body(0, n)
+void parallel_chunks(std::size_t n, std::size_t unit_bytes,
+                     const std::function<void(std::size_t, std::size_t)>& body);
+
+// ------------------------------------------------------------
+// row band：平行 kernel 的切法
+//
+// 一塊是連續的幾個 row，大小讓一塊的資料大約塞得進 L2，
+// 同時每條 thread 至少分得到幾塊，做得快的 thread 才有東西可偷。
+// ------------------------------------------------------------
+int band_rows(int rows, std::size_t bytes_per_row, int threads);
+
+// 這個後端實際會有幾條 thread 一起做
+int backend_threads(Backend exec);
+
+// 依 exec 把 [0, rows) 切成 row band 呼叫 body(y0, y1)：
+//   ThreadPool → 丟給 ThreadPool（可以巢狀）
+//   OpenMP     → 同樣的 band，dynamic 排程；numa_aware 時改成每條 thread 固定一段
+//   其他       → 呼叫端直接 body(0, rows)
+// body 對不同 band 必須互不相干（各自寫自己的 row、需要的暫存自己配）
+template <class Body>
+void parallel_rows(int rows, Backend exec, std::size_t bytes_per_row, Body&& body) {
+    if (rows <= 0) return;
+
+    if (exec == Backend::ThreadPool) {
+        ThreadPool& pool = ThreadPool::instance();
+        const int band = band_rows(rows, bytes_per_row, pool.size());
+        pool.parallel_for(0, rows, band, [&](long y0, long y1) {
+            body(static_cast<int>(y0), static_cast<int>(y1));
+        });
+        return;
+    }
+
+#ifdef PF_HAS_OPENMP
+    if (exec == Backend::OpenMP) {
+        const int band = band_rows(rows, bytes_per_row, backend_threads(exec));
+        const int pin_base = team_pin_base();
+        if (numa_aware()) {
+#pragma omp parallel
+            {
+                const int t  = omp_get_thread_num();
+                const int nt = omp_get_num_threads();
+                pin_team_thread(pin_base, t);
+                const int y0 = static_cast<int>(static_cast<long>(rows) * t / nt);
+                const int y1 = static_cast<int>(static_cast<long>(rows) * (t + 1) / nt);
+                for (int y = y0; y < y1; y += band) body(y, std::min(y1, y + band));
+            }
+            return;
+        }
+
+        const int bands = (rows + band - 1) / band;
+#pragma omp parallel
+        {
+            pin_team_thread(pin_base, omp_get_thread_num());
+#pragma omp for schedule(dynamic, 1)
+            for (int b = 0; b < bands; ++b) {
+                body(b * band, std::min(rows, (b + 1) * band));
+            }
+        }
+        return;
+    }
+#endif
+
+    body(0, rows);
+}
+
+} // namespace pf
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/ops.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// Pipeline：一串運算（ops.hpp 的 ImageOp），整條在 C++ 裡跑完
+//
+// 第一次看到某個輸入大小時檢查每一步、算出每個中間結果的大小，
+// 配置兩塊 buffer 輪流當輸入 / 輸出（ping-pong）；可以原地做的步驟直接寫回同一塊。
+// 之後同樣大小的影像再進來就不再配置中間 buffer，呼叫端給 dst 的話整個呼叫零配置。
+// 不給 dst 時輸出也留兩塊輪流用：呼叫端已經放掉的那塊（只剩 Pipeline 持有）直接重寫，
+// 所以「留著上一張的結果、算下一張」的迴圈一樣不配置；還有人持有的輸出絕對不會被改。
+//
+// 中間 buffer 屬於這個物件：同一個 Pipeline 被多條 thread 同時呼叫時會排隊，
+// 要平行處理多路影像就各自建一個。
+// ------------------------------------------------------------
+class Pipeline {
+public:
+    Pipeline() = default;
+    explicit Pipeline(std::vector<ImageOp> steps);
+
+    Pipeline(const Pipeline&)            = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    Pipeline& add(ImageOp op);
+
+    std::size_t size() const { return steps_.size(); }
+    const std::vector<ImageOp>& steps() const { return steps_; }
+
+    // 整條跑完的輸出大小；有哪一步不能處理這個輸入就丟例外
+    ImageShape output_shape(const ImageShape& in) const;
+
+    // dst 可以就是 src：超過一步時 src 在第一步就讀完了，
+    // 只有一步時看那一步能不能原地做
+    bool allows_in_place() const;
+
+    // 寫進 dst（output_shape 的大小、row 緊密排列）
+    void run(const ImageU8& src, ImageU8& dst, Backend backend = Backend::Auto);
+
+    // 回傳跟 Pipeline 共用的輸出（見上面：呼叫端放掉之後才會被重用）
+    ImageU8 run(const ImageU8& src, Backend backend = Backend::Auto);
+
+    // 目前持有的中間 buffer 總 bytes（不含輸出）
+    std::size_t buffer_bytes() const;
+
+private:
+    void plan(const ImageShape& in);
+    void run_locked(const ImageU8& src, ImageU8& dst, Backend backend);
+
+    std::vector<ImageOp> steps_;
+
+    // plan() 的結果：planned_ 大小的輸入，第 i 步寫進 stages_[i]
+    // （最後一步直接寫 dst，stages_ 只有前 size() - 1 步）
+    ImageShape               planned_;
+    std::vector<ImageU8>     stages_;
+    std::shared_ptr<uint8_t[]> buffers_[2];
+    std::size_t              capacity_[2] = {0, 0};
+    ImageU8                  outputs_[2];  // run(src) 交出去的輸出，輪流重用
+
+    mutable std::mutex mutex_;
+};
+
+} // namespace pf
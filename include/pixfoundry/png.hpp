@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "pixfoundry/image.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// PNG 編碼（8-bit 灰階 / RGB）
+//
+// 不用 stb 的 writer：它的壓縮等級、filter 都是全域變數（多條 thread 同時存檔會互相蓋掉），
+// deflate 也只有固定 Huffman 表、每個 hash bucket 用會 realloc 的陣列。這裡自己做：
+//   level 0     不壓縮（stored block），最快
+//   level 1-3   hash chain 只看 1 / 2 / 4 個候選、greedy
+//   level 4-9   候選數加倍到 256、lazy matching
+// 每個 block 用動態 Huffman 表（比固定表小的時候），跟 zlib 產出的檔案一樣可以被任何 decoder 讀。
+// ------------------------------------------------------------
+std::vector<uint8_t> encode_png(const uint8_t* data, int h, int w, int c, std::size_t stride,
+                                int level, PngFilter filter);
+
+// ------------------------------------------------------------
+// 串流（一次幾個 row）編 / 解碼：給比記憶體還大的影像用（stream.hpp）。
+// 記憶體只有這幾個 row、deflate 的 32 KB window 跟一段 1 MB 的壓縮 buffer，跟影像高度無關。
+// ------------------------------------------------------------
+
+// 由上往下寫：每湊滿 1 MB filter 過的資料就壓成一個 IDAT 寫出去
+class PngStreamWriter {
+public:
+    PngStreamWriter(const std::string& path, int h, int w, int c, int level = 6,
+                    PngFilter filter = PngFilter::Adaptive);
+    ~PngStreamWriter();
+
+    PngStreamWriter(const PngStreamWriter&)            = delete;
+    PngStreamWriter& operator=(const PngStreamWriter&) = delete;
+
+    // 接著寫 rows 個 row（stride 0：緊密排列）
+    void write_rows(const uint8_t* data, int rows, std::size_t stride);
+    // h 個 row 都寫了才能 close；少了就丟例外
+    void close();
+    int  rows_written() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> s_;
+};
+
+// 由上往下讀：一邊讀 IDAT 一邊 inflate、解 filter。
+// 任何不 interlace 的 PNG（1 / 2 / 4 / 8 / 16-bit、調色盤、alpha）；
+// 輸出跟 decode_image_u8 一樣是 8-bit：不帶 alpha 的灰階 1 通道、其他 3 通道
+class PngStreamReader {
+public:
+    explicit PngStreamReader(const std::string& path);
+    ~PngStreamReader();
+
+    PngStreamReader(const PngStreamReader&)            = delete;
+    PngStreamReader& operator=(const PngStreamReader&) = delete;
+
+    int h() const;
+    int w() const;
+    int c() const;
+
+    // 接著解最多 rows 個 row 到 dst，回傳解了幾個（讀完了是 0）
+    int read_rows(uint8_t* dst, int rows, std::size_t stride);
+
+private:
+    struct State;
+    std::unique_ptr<State> s_;
+};
+
+} // namespace pf
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/filters.hpp"  // 為了取得 Backend enum
+#include "pixfoundry/autotune.hpp" // OpCost
+
+namespace pf {
+
+// 影像金字塔
+//
+// 濾波器都是 5-tap binomial [1 4 6 4 1] / 16，邊界用 reflect-101（跟 OpenCV 一樣），
+// 模糊只在「會留下來的樣本」上計算，不會先模糊整張圖再丟掉 3/4。
+
+// pyr_down：模糊 + 隔點取樣，輸出 (h + 1) / 2 x (w + 1) / 2
+ImageU8 pyr_down(const ImageU8& src,
+                 Backend backend = Backend::Auto);
+
+// pyr_up：補零上採樣 + 模糊（權重 x4），預設輸出 2h x 2w；
+// dst_h / dst_w 可指定為 2h - 1 或 2h（還原奇數尺寸的上一層時用，
+// 2h - 1 等於 2h 的結果少最後一個 row / column）
+ImageU8 pyr_up(const ImageU8& src,
+               int dst_h = 0,
+               int dst_w = 0,
+               Backend backend = Backend::Auto);
+
+// Gaussian 金字塔：第 0 層是原圖的複本，之後每層 pyr_down，最多 levels 層
+// （縮到 1x1 就停）。所有層放在同一塊連續記憶體裡，各層 ImageU8 共用它。
+std::vector<ImageU8> gaussian_pyramid(const ImageU8& src,
+                                      int levels,
+                                      Backend backend = Backend::Auto);
+
+// Laplacian 金字塔：L[i] = G[i] - pyr_up(G[i+1]) + 128（uint8，差值超過 ±127 會被截斷），
+// 最後一層直接存 Gaussian 的最頂層。同樣只配置一塊連續記憶體。
+std::vector<ImageU8> laplacian_pyramid(const ImageU8& src,
+                                       int levels,
+                                       Backend backend = Backend::Auto);
+
+// 從 Laplacian 金字塔還原：G[i] = pyr_up(G[i+1]) + L[i] - 128
+ImageU8 collapse_laplacian_pyramid(const std::vector<ImageU8>& pyramid,
+                                   Backend backend = Backend::Auto);
+
+// 整數倍 box 縮小（factor = 2 或 4），輸出 h / factor x w / factor，
+// 每個輸出像素是 factor x factor 區塊的平均（四捨五入）；給預覽圖用
+ImageU8 downscale_box(const ImageU8& src,
+                      int factor,
+                      Backend backend = Backend::Auto);
+
+// ------------------------------------------------------------
+// 寫進呼叫端給的 dst（row 緊密排列，不能跟輸入重疊）
+// ------------------------------------------------------------
+
+// dst 必須是 (h + 1) / 2 x (w + 1) / 2
+void pyr_down(const ImageU8& src,
+              ImageU8& dst,
+              Backend backend = Backend::Auto);
+
+// 輸出大小取 dst（每一軸是 2n - 1 或 2n）
+void pyr_up(const ImageU8& src,
+            ImageU8& dst,
+            Backend backend = Backend::Auto);
+
+// dst 必須跟 pyramid[0] 一樣大
+void collapse_laplacian_pyramid(const std::vector<ImageU8>& pyramid,
+                                ImageU8& dst,
+                                Backend backend = Backend::Auto);
+
+void downscale_box(const ImageU8& src,
+                   ImageU8& dst,
+                   int factor,
+                   Backend backend = Backend::Auto);
+
+// Auto 用的成本（每個來源 pixel-channel），ops.hpp 的 ImageOp 也用這兩個
+OpCost pyr_down_cost();
+OpCost downscale_box_cost();
+
+} // namespace pf
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pixfoundry/image.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// QOI（Quite OK Image，https://qoiformat.org）
+//
+// 無損、單趟、沒有 entropy coding：每個 pixel 只看前一個 pixel 跟 64 格的 hash 表，
+// 編碼 / 解碼都比 PNG 快一個數量級，檔案大小跟快速壓縮的 PNG 差不多。
+// QOI 只有 RGB / RGBA：灰階存成 R = G = B 的 RGB，讀回來是 3 通道；alpha 讀的時候丟掉。
+// ------------------------------------------------------------
+std::vector<uint8_t> encode_qoi(const uint8_t* data, int h, int w, int c, std::size_t stride);
+
+// 開頭是 "qoif"
+bool is_qoi(const uint8_t* data, std::size_t size);
+
+// 一律輸出 3 通道；資料壞掉丟 std::runtime_error
+ImageU8 decode_qoi(const uint8_t* data, std::size_t size);
+
+} // namespace pf
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/ops.hpp"
+
+namespace pf {
+
+// ------------------------------------------------------------
+// 串流（out-of-core）：比記憶體還大的影像一段一段（strip：幾個完整的 row）處理
+//
+// 來源一次給幾個 row，一串 ops（只能是 halo >= 0 的：逐點運算跟 stencil）一段一段套上去，
+// 結果馬上交給編碼的 sink 寫出去。每一步只留下一段 row 加上下各 halo 個 row，
+// 記憶體大約是 strip 高 x 寬 x 步數，跟影像高度無關（100k x 100k 的圖也一樣）。
+//
+// 每段多帶的 halo row 讓 stencil 在段與段的交界跟整張做完全一樣（影像上下緣照 op 自己的 Border）；
+// 代價是每段多算上下 halo 個 row。
+// ------------------------------------------------------------
+
+// 由上往下給 row 的來源
+class StripSource {
+public:
+    virtual ~StripSource() = default;
+
+    virtual ImageShape shape() const = 0;
+    // 接著讀最多 dst.h() 個 row 到 dst（寬、通道數跟 shape() 一樣），回傳讀了幾個（讀完了是 0）
+    virtual int read(ImageU8& dst) = 0;
+};
+
+// 由上往下收 row 的編碼器
+class StripSink {
+public:
+    virtual ~StripSink() = default;
+
+    virtual void write(const ImageU8& rows) = 0;
+    // 所有的 row 都寫了才能 close（少了丟例外）
+    virtual void close() = 0;
+};
+
+// 依副檔名：.png（不 interlace）、.ppm / .pgm / .pnm（binary P5 / P6、8-bit）、.pft（tiled.hpp）
+std::unique_ptr<StripSource> open_strip_source(const std::string& path);
+
+// 依副檔名：.png（options 的 png_level / png_filter）、.ppm / .pgm / .pnm、.pft（256 x 256、不壓縮）。
+// JPEG / QOI 的 encoder 要整張影像，不能一段一段寫
+std::unique_ptr<StripSink> open_strip_sink(const std::string& path, const ImageShape& shape,
+                                           const EncodeOptions& options = EncodeOptions());
+
+struct StreamStats {
+    long long   rows         = 0;  // 寫出去的 row 數
+    int         strips       = 0;  // 從來源讀了幾段
+    std::size_t buffer_bytes = 0;  // 各步驟 buffer 加起來的大小（跟影像高度無關）
+};
+
+// ops 逐段套在 src 上、結果寫進 dst（結束時會 dst.close()）。
+// strip_rows：每次從來源讀幾個 row；ops 有 halo < 0 的、或 output_shape 改了高 / 寬就丟 invalid_argument
+StreamStats process_strips(StripSource& src, const std::vector<ImageOp>& ops, StripSink& dst,
+                           int strip_rows = 256, Backend backend = Backend::Auto);
+
+// 檔案 → 檔案（開 source / sink 再呼叫上面那個）
+StreamStats process_stream(const std::string& src_path, const std::string& dst_path,
+                           const std::vector<ImageOp>& ops, int strip_rows = 256,
+                           const EncodeOptions& options = EncodeOptions(),
+                           Backend backend = Backend::Auto);
+
+} // namespace pf
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/filters.hpp"  // Border
+
+namespace pf {
+
+// ------------------------------------------------------------
+// Tiled 容器（.pft）：巨大影像（病理切片、航照）的快取格式
+//
+// 影像切成固定大小的 tile 分別存，讀的時候 mmap 整個檔、只碰用到的 tile：
+// 不壓縮的 tile 直接是 mmap 上的零拷貝 view，不必先解出整張圖。
+// 適合把解好的中間結果存起來給下一個 pipeline 階段，而不是每次重解 JPEG / PNG。
+//
+// 檔案格式（little endian）：
+//   header 64 bytes   "PFTILED\0"、version、h、w、c、tile_h、tile_w、compression、
+//                     index 的位置與筆數
+//   tile 資料         各自對齊 64 bytes，順序不限（寫入的順序）
+//   index             每個 tile（row-major）一筆 {offset, size}，各 8 bytes
+// 右邊 / 下面不滿一個 tile 的就存實際大小；不壓縮的 tile 是緊密排列的 rows。
+// ------------------------------------------------------------
+enum class TileCompression {
+    None,  // 原始像素：讀的時候零拷貝
+    Qoi,   // 每個 tile 一個 QOI（灰階存成 R = G = B，讀回來還是 1 通道）
+    Png,   // 每個 tile 一個 PNG（level 1、Fast filter）
+};
+
+struct TiledInfo {
+    int h = 0, w = 0, c = 0;
+    int tile_h = 0, tile_w = 0;
+    int tiles_y = 0, tiles_x = 0;
+    TileCompression compression = TileCompression::None;
+};
+
+struct TileRect {
+    int y = 0, x = 0, h = 0, w = 0;
+};
+
+// 第 (ty, tx) 個 tile 在影像裡的範圍
+TileRect tile_rect(const TiledInfo& info, int ty, int tx);
+
+// ------------------------------------------------------------
+// TiledWriter
+//
+// write_tile() 可以任意順序、多條 thread 同時呼叫（編碼在鎖外做）；
+// append_rows() 給由上往下一段一段產生的影像（串流）：湊滿一列 tile 就寫出去。
+// close() 寫 index 與 header；還有 tile 沒寫就丟例外。解構時也會 close，但不丟例外。
+// ------------------------------------------------------------
+class TiledWriter {
+public:
+    TiledWriter(const std::string& path, int h, int w, int c,
+                int tile_h = 256, int tile_w = 256,
+                TileCompression compression = TileCompression::None);
+    ~TiledWriter();
+
+    TiledWriter(const TiledWriter&)            = delete;
+    TiledWriter& operator=(const TiledWriter&) = delete;
+
+    const TiledInfo& info() const { return info_; }
+
+    // tile 的大小要等於 tile_rect(info(), ty, tx)
+    void write_tile(int ty, int tx, const ImageU8& tile);
+    // 接在目前寫到的 row 後面（rows.w() 要等於影像寬）
+    void append_rows(const ImageU8& rows);
+    // 整張切 tile，在 ThreadPool 上平行編碼
+    void write_image(const ImageU8& img);
+    void close();
+
+    int rows_appended() const { return appended_; }
+
+private:
+    void write_band(const ImageU8& band, int ty);
+
+    TiledInfo     info_;
+    std::string   path_;
+    std::ofstream out_;
+    std::mutex    mutex_;
+    uint64_t      end_ = 0;                           // 下一個 tile 寫的位置
+    std::vector<std::pair<uint64_t, uint64_t>> index_;  // {offset, size}；offset 0：還沒寫
+    ImageU8       band_;      // append_rows 湊一列 tile 用
+    int           band_rows_ = 0;
+    int           appended_  = 0;
+    bool          closed_    = false;
+};
+
+// 整張寫成 .pft
+void save_tiled(const std::string& path, const ImageU8& img, int tile_h = 256, int tile_w = 256,
+                TileCompression compression = TileCompression::None);
+
+// ------------------------------------------------------------
+// TiledReader
+//
+// 開檔時 mmap（MAP_PRIVATE：改回傳的 view 只會改到自己的 copy-on-write 頁，檔案不變）。
+// 沒有 mmap 時整個檔讀進一塊 buffer，原本是 view 的地方改回傳複本，改了一樣不影響之後的讀取。
+// 回傳的影像都自己撐著 mapping，reader 先解構也沒關係。const 函式可以多條 thread 同時呼叫。
+// ------------------------------------------------------------
+class TiledReader {
+public:
+    explicit TiledReader(const std::string& path);
+
+    const TiledInfo& info() const { return info_; }
+
+    // 不壓縮：mmap 上的零拷貝 view（沒有 mmap 時是複本）；壓縮：解出來的新影像
+    ImageU8 tile(int ty, int tx) const;
+
+    // (y, x, h, w) 四周再多 halo 個 pixel：輸出 (h + 2 halo) x (w + 2 halo)。
+    // 超出影像的部分依 border 補（規則跟 filters 一樣），所以對半徑 <= halo 的 stencil，
+    // 在結果上跑完再切掉 halo 就等於在整張圖上跑的那一塊。
+    // 整塊（含 halo）都在同一個不壓縮 tile 裡時是零拷貝 view；跨 tile 時在 ThreadPool 上平行拼。
+    ImageU8 read_region(int y, int x, int h, int w, int halo = 0,
+                        Border border = Border::Reflect, uint8_t border_value = 0) const;
+
+    // 整張
+    ImageU8 read() const { return read_region(0, 0, info_.h, info_.w); }
+
+private:
+    struct Mapping;
+    // 不壓縮時是 mapping 上的 view；沒有 mmap 時大家共用同一塊可寫的 buffer，只給內部讀
+    ImageU8 load_tile(int ty, int tx) const;
+    ImageU8 assemble(int y, int x, int h, int w) const;
+    // 交給呼叫端之前：沒有 mmap 而且是共用 buffer 的 view 時換成複本
+    ImageU8 hand_out(ImageU8 img) const;
+
+    TiledInfo                info_;
+    std::shared_ptr<Mapping> map_;
+    std::vector<std::pair<uint64_t, uint64_t>> index_;
+};
+
+} // namespace pf
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "pixfoundry/image.hpp"
+#include "pixfoundry/filters.hpp"   // Backend / Border
+#include "pixfoundry/geometry.hpp"  // Interp
+
+namespace pf {
+
+// 一般的座標轉換（輸出 out_h x out_w）
+//
+// 座標以 pixel 中心為整數點（跟 OpenCV 一樣），
+// 矩陣預設是 src → dst；inverse_map = true 表示矩陣已經是 dst → src。
+// interp 支援 Nearest / Bilinear / Bicubic；border 決定取到影像外時的值。
+//
+// 實作：輸出切成 tile，每個 tile row 的來源座標用 fixed-point 累加，
+// 所有 taps 都在影像內的區段直接算出來（不用逐點檢查邊界），只有邊緣才走慢路徑。
+
+// M：2x3 仿射矩陣（row-major）
+ImageU8 warp_affine(const ImageU8& src,
+                    const std::array<double, 6>& M,
+                    int out_h,
+                    int out_w,
+                    Interp interp = Interp::Bilinear,
+                    Border border = Border::Constant,
+                    Backend backend = Backend::Auto,
+                    uint8_t border_value = 0,
+                    bool inverse_map = false);
+
+// M：3x3 透視矩陣（row-major）
+ImageU8 warp_perspective(const ImageU8& src,
+                         const std::array<double, 9>& M,
+                         int out_h,
+                         int out_w,
+                         Interp interp = Interp::Bilinear,
+                         Border border = Border::Constant,
+                         Backend backend = Backend::Auto,
+                         uint8_t border_value = 0,
+                         bool inverse_map = false);
+
+// 寫進呼叫端給的 dst（輸出大小取 dst 的 h x w，row 緊密排列，不能跟 src 重疊）
+void warp_affine(const ImageU8& src,
+                 ImageU8& dst,
+                 const std::array<double, 6>& M,
+                 Interp interp = Interp::Bilinear,
+                 Border border = Border::Constant,
+                 Backend backend = Backend::Auto,
+                 uint8_t border_value = 0,
+                 bool inverse_map = false);
+
+void warp_perspective(const ImageU8& src,
+                      ImageU8& dst,
+                      const std::array<double, 9>& M,
+                      Interp interp = Interp::Bilinear,
+                      Border border = Border::Constant,
+                      Backend backend = Backend::Auto,
+                      uint8_t border_value = 0,
+                      bool inverse_map = false);
+
+// ------------------------------------------------------------
+// remap：預先算好的座標表，同一張表可以套用到每一張 frame
+// ------------------------------------------------------------
+
+// 每個輸出 pixel 對應的來源座標：整數部分存 int16（x, y 交錯），
+// 小數部分量化成 1/256 pixel，兩軸合成一個 index：(fy << 8) | fx
+struct RemapMap {
+    int h = 0, w = 0;
+    std::vector<int16_t>  xy;    // h * w * 2
+    std::vector<uint16_t> frac;  // h * w
+};
+
+// 從 float 座標表（跟 cv2.remap 的 map_x / map_y 一樣）轉成緊湊格式
+RemapMap make_remap_map(const float* map_x,
+                        const float* map_y,
+                        int h,
+                        int w);
+
+// remap：輸出大小 = map 大小；src 的寬高必須 < 32767（int16 放得下）
+ImageU8 remap(const ImageU8& src,
+              const RemapMap& map,
+              Interp interp = Interp::Bilinear,
+              Border border = Border::Constant,
+              Backend backend = Backend::Auto,
+              uint8_t border_value = 0);
+
+// dst 版本：dst 必須是 map.h x map.w
+void remap(const ImageU8& src,
+           ImageU8& dst,
+           const RemapMap& map,
+           Interp interp = Interp::Bilinear,
+           Border border = Border::Constant,
+           Backend backend = Backend::Auto,
+           uint8_t border_value = 0);
+
+// Brown–Conrady 鏡頭模型（跟 OpenCV 的 k1, k2, p1, p2, k3 一樣）
+struct LensModel {
+    double fx = 1.0, fy = 1.0;   // 焦距（pixel）
+    double cx = 0.0, cy = 0.0;   // 主點
+    double k1 = 0.0, k2 = 0.0, k3 = 0.0;  // 徑向
+    double p1 = 0.0, p2 = 0.0;            // 切向
+};
+
+// 去畸變用的座標表（輸出的相機矩陣跟輸入相同）。
+// 以參數 hash 快取：同樣的鏡頭 + 尺寸只會算一次。
+std::shared_ptr<const RemapMap> undistort_map(const LensModel& lens,
+                                              int h,
+                                              int w);
+
+// undistort = undistort_map（快取）+ remap
+ImageU8 undistort(const ImageU8& src,
+                  const LensModel& lens,
+                  Interp interp = Interp::Bilinear,
+                  Border border = Border::Constant,
+                  Backend backend = Backend::Auto,
+                  uint8_t border_value = 0);
+
+void undistort(const ImageU8& src,
+               ImageU8& dst,
+               const LensModel& lens,
+               Interp interp = Interp::Bilinear,
+               Border border = Border::Constant,
+               Backend backend = Backend::Auto,
+               uint8_t border_value = 0);
+
+// 清掉 undistort_map 的快取
+void clear_undistort_cache();
+
+// Auto 用的成本（每個輸出 pixel-channel），rotate 跟 ops.hpp 的 rotate_op 也用這個
+OpCost warp_cost(Interp interp, bool perspective);
+
+} // namespace pf
@@ -1 +1 @@
-from ._core import load_image, save_image, mean_filter, gaussian_filter, median_filter, bilateral_filter, to_grayscale, invert, sepia, adjust_brightness_contrast,gamma_correct, sharpen, emboss, cartoonize, resize, flip_horizontal, flip_vertical, crop, rotate, _debug_zerocopy_roundtrip_u8
\ No newline at end of file
+from ._core import load_image, save_image, load_image_from_bytes, save_image_to_bytes, load_images, save_images, ImageReader, ImageWriter, TiledWriter, TiledReader, save_tiled, process_stream, StripReader, StripWriter, mean_filter, gaussian_filter, median_filter, bilateral_filter, to_grayscale, invert, sepia, adjust_brightness_contrast,gamma_correct, sharpen, emboss, cartoonize, resize, flip_horizontal, flip_vertical, crop, rotate, rotate90, rotate180, rotate270, transpose, warp_affine, warp_perspective, RemapMap, make_remap_map, remap, undistort_map, undistort, clear_undistort_cache, pyr_down, pyr_up, gaussian_pyramid, laplacian_pyramid, collapse_laplacian_pyramid, downscale_box, calibrate_auto, get_auto_params, load_auto_cache, save_auto_cache, enable_buffer_pool, set_buffer_pool_limit, trim_buffer_pool, buffer_pool_stats, resize_batch, mean_filter_batch, gaussian_filter_batch, median_filter_batch, to_grayscale_batch, flip_horizontal_batch, Pipeline, set_max_threads, get_max_threads, concurrency_stats, reset_concurrency_stats, numa_info, set_numa_aware, set_thread_pinning, _debug_zerocopy_roundtrip_u8
\ No newline at end of file
@@ -6,12 +6,32 @@
 #include "pixfoundry/color.hpp"
 #include "pixfoundry/effects.hpp"
 #include "pixfoundry/geometry.hpp"
+#include "pixfoundry/pyramid.hpp"
+#include "pixfoundry/warp.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/memory.hpp"
+#include "pixfoundry/batch.hpp"
+#include "pixfoundry/pipeline.hpp"
+#include "pixfoundry/parallel.hpp"
+#include "pixfoundry/io.hpp"
+#include "pixfoundry/tiled.hpp"
+#include "pixfoundry/stream.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 namespace py = pybind11;
 
 namespace pfpy {
@@ -21,14 +41,25 @@ using pf::Border;
 using pf::Backend;
 
 // ------------------------------------------------------------
-// 共用：檢查 numpy array (uint8, C-contiguous, HxW or HxWxC)
+// 共用：檢查 numpy array (uint8, HxW or HxWxC)
+// pixel 之間必須緊密（channel stride 1、pixel stride C），
+// row 之間可以有間隔：slicing 出來的 view 也能零拷貝傳進來
 // ------------------------------------------------------------
 struct ShapeInfo {
     int h;
     int w;
     int c;
+    size_t stride;  // row pitch（bytes）
 };
 
+// 高 / 寬是 int（總大小一律用 size_t 算），超過的維度不能默默截斷
+static int checked_dim(ssize_t n) {
+    if (n > static_cast<ssize_t>(std::numeric_limits<int>::max())) {
+        throw std::invalid_argument("array dimension too large (max 2^31 - 1 per axis)");
+    }
+    return static_cast<int>(n);
+}
+
 static ShapeInfo check_uint8_hw_or_hwc(const py::buffer_info& info) {
     if (info.ndim != 2 && info.ndim != 3) {
         throw std::runtime_error("expected HxW or HxWxC uint8 array");
@@ -37,31 +68,29 @@ static ShapeInfo check_uint8_hw_or_hwc(const py::buffer_info& info) {
         throw std::runtime_error("expected dtype=uint8");
     }
 
-    const int h = static_cast<int>(info.shape[0]);
-    const int w = static_cast<int>(info.shape[1]);
-    const int c = (info.ndim == 3) ? static_cast<int>(info.shape[2]) : 1;
+    const int h = checked_dim(info.shape[0]);
+    const int w = checked_dim(info.shape[1]);
+    const int c = (info.ndim == 3) ? checked_dim(info.shape[2]) : 1;
 
     if (c != 1 && c != 3) {
         throw std::runtime_error("expected 1 or 3 channels");
     }
 
-    // C-contiguous 檢查
-    if (info.ndim == 2) {
-        // H x W: strides = [W, 1]
-        if (!(info.strides[0] == static_cast<ssize_t>(w) &&
-              info.strides[1] == 1)) {
-            throw std::runtime_error("expected C-contiguous array (HxW)");
-        }
-    } else {
-        // H x W x C: strides = [W*C, C, 1]
-        if (!(info.strides[0] == static_cast<ssize_t>(w * c) &&
-              info.strides[1] == static_cast<ssize_t>(c) &&
-              info.strides[2] == 1)) {
-            throw std::runtime_error("expected C-contiguous array (HxWxC)");
-        }
+    // 長度 1 的維度 numpy 不保證 stride 的值，不拿來檢查
+    const bool unit_pixel =
+        (w == 1 || info.strides[1] == static_cast<ssize_t>(c)) &&
+        (info.ndim == 2 || c == 1 || info.strides[2] == 1);
+    if (!unit_pixel) {
+        throw std::runtime_error("expected unit pixel stride (pixels and channels must be packed)");
     }
 
-    return {h, w, c};
+    const size_t row_len = static_cast<size_t>(w) * c;
+    if (h == 1) return {h, w, c, row_len};
+    if (info.strides[0] < static_cast<ssize_t>(row_len)) {
+        // 負的 stride（例如 [::-1]）或 row 重疊都不支援
+        throw std::runtime_error("expected positive row stride >= width * channels");
+    }
+    return {h, w, c, static_cast<size_t>(info.strides[0])};
 }
 
 // ------------------------------------------------------------
@@ -82,7 +111,7 @@ static ImageU8 numpy_to_imageu8_zero_copy(const py::array& array) {
         // owner 的生命週期由 shared_ptr 的複本管理
     });
 
-    return ImageU8(shape.h, shape.w, shape.c, std::move(sp));
+    return ImageU8(shape.h, shape.w, shape.c, std::move(sp), shape.stride);
 }
 
 // ------------------------------------------------------------
@@ -100,12 +129,14 @@ static py::array imageu8_to_numpy(const ImageU8& img) {
     std::vector<ssize_t> shape;
     std::vector<ssize_t> strides;
 
+    // view（crop 等）的 row pitch 可能大於 w * c，照實際 stride 交給 numpy
+    const ssize_t row_stride = static_cast<ssize_t>(img.stride());
     if (c == 1) {
         shape   = {h, w};
-        strides = {static_cast<ssize_t>(w), 1};
+        strides = {row_stride, 1};
     } else {
         shape   = {h, w, c};
-        strides = {static_cast<ssize_t>(w * c),
+        strides = {row_stride,
                    static_cast<ssize_t>(c),
                    1};
     }
@@ -120,25 +151,320 @@ static py::array imageu8_to_numpy(const ImageU8& img) {
         py::dtype::of<uint8_t>(),
         shape,
         strides,
-        img.shared().get(),  // data pointer
+        img.data(),          // data pointer（view 的起點）
         base                 // base object to keep memory alive
     );
 }
 
+// ------------------------------------------------------------
+// no-op 路徑（例如灰階圖再轉灰階）的結果跟輸入共用 buffer：
+// 回傳唯讀的 numpy，需要改的人自己 .copy()（copy-on-write）
+// ------------------------------------------------------------
+static py::array result_to_numpy(const ImageU8& in, const ImageU8& out) {
+    py::array arr = imageu8_to_numpy(out);
+    if (out.shares_buffer(in)) {
+        arr.attr("setflags")(py::arg("write") = false);
+    }
+    return arr;
+}
+
+// ------------------------------------------------------------
+// out=：結果直接寫進呼叫端給的 numpy（不另外配置）
+// 尺寸 / 通道由 C++ 端的 dst 版本檢查
+// ------------------------------------------------------------
+static ImageU8 out_to_imageu8(const py::object& out) {
+    if (!py::isinstance<py::array_t<uint8_t>>(out)) {
+        throw std::runtime_error("out must be a uint8 numpy array");
+    }
+    py::array arr = out.cast<py::array>();
+    if (!arr.writeable()) {
+        throw std::runtime_error("out must be writeable");
+    }
+    if (!(arr.flags() & py::array::c_style)) {
+        throw std::runtime_error("out must be C-contiguous");
+    }
+    return numpy_to_imageu8_zero_copy(arr);
+}
+
+// 逐 row 複製（兩邊的 row pitch 可以不同）
+static void copy_pixels(const ImageU8& src, ImageU8& dst) {
+    if (pf::same_pixels(src, dst)) return;
+    const size_t row_len = static_cast<size_t>(src.w()) * src.c();
+    for (int y = 0; y < src.h(); ++y) {
+        std::copy(src.row(y), src.row(y) + row_len, dst.row(y));
+    }
+}
+
+static void check_out_size(const ImageU8& dst, int h, int w, const char* who) {
+    if (dst.h() != h || dst.w() != w) {
+        throw std::runtime_error(std::string(who) + ": out shape does not match height / width");
+    }
+}
+
+// out 是 None：回傳新配置的結果（no-op 路徑共用輸入時是唯讀的）；
+// 否則寫進 out 並回傳 out。out 跟輸入重疊、kernel 又不能原地做時，先算到暫存再複製過去
+//
+// C++ 計算的期間放掉 GIL，其他 Python thread 可以同時跑。
+// 輸入 / 輸出的 numpy 由 ImageU8 的 shared_ptr（deleter 持有 py::object）保活，
+// 這些 ImageU8 都在 GIL 拿回來之後才解構；放掉 GIL 的區段裡不碰任何 Python 物件
+template <typename AllocFunc, typename IntoFunc>
+static py::object run_op(const ImageU8& in,
+                         const py::object& out,
+                         bool in_place_ok,
+                         AllocFunc&& alloc,
+                         IntoFunc&& into)
+{
+    if (out.is_none()) {
+        ImageU8 res;
+        {
+            py::gil_scoped_release nogil;
+            res = alloc();
+        }
+        return result_to_numpy(in, res);
+    }
+
+    ImageU8 dst = out_to_imageu8(out);
+    {
+        py::gil_scoped_release nogil;
+        if (pf::overlaps(in, dst) && !(in_place_ok && pf::same_pixels(in, dst))) {
+            ImageU8 tmp(dst.h(), dst.w(), dst.c(), pf::Init::None);
+            into(tmp);
+            copy_pixels(tmp, dst);
+        } else {
+            into(dst);
+        }
+    }
+    return out;
+}
+
+// ------------------------------------------------------------
+// 批次：np.stack 起來的 NxHxW / NxHxWxC array，或大小可以不同的影像 list
+// （每張都是零拷貝 view）。array 進來就疊成一個 array 回去，list 進來就回 list
+// ------------------------------------------------------------
+// for_out：當作 out= 檢查（uint8、可寫、C-contiguous）
+static std::vector<ImageU8> batch_from_python(const py::object& images, bool& stacked,
+                                              bool for_out = false) {
+    auto convert = [for_out](const py::object& item) {
+        return for_out ? out_to_imageu8(item) : numpy_to_imageu8_zero_copy(item.cast<py::array>());
+    };
+    std::vector<ImageU8> out;
+    stacked = py::isinstance<py::array>(images);
+    if (stacked) {
+        py::array arr = images.cast<py::array>();
+        if (arr.ndim() != 3 && arr.ndim() != 4) {
+            throw std::runtime_error("expected NxHxW or NxHxWxC uint8 array, or a list of images");
+        }
+        const ssize_t n = arr.shape(0);
+        out.reserve(static_cast<size_t>(n));
+        for (ssize_t i = 0; i < n; ++i) {
+            out.push_back(convert(arr.attr("__getitem__")(i)));
+        }
+        return out;
+    }
+
+    py::sequence seq = images.cast<py::sequence>();
+    out.reserve(seq.size());
+    for (py::handle item : seq) {
+        out.push_back(convert(py::reinterpret_borrow<py::object>(item)));
+    }
+    return out;
+}
+
+// 整批輸出放在同一塊 buffer 裡，第 i 張從 i * h * w * c 開始
+static py::array stacked_to_numpy(const std::shared_ptr<uint8_t[]>& buf,
+                                  size_t n, int h, int w, int c) {
+    std::vector<ssize_t> shape   = {static_cast<ssize_t>(n), h, w};
+    std::vector<ssize_t> strides = {static_cast<ssize_t>(h) * w * c,
+                                    static_cast<ssize_t>(w) * c, c};
+    if (c != 1) {
+        shape.push_back(c);
+        strides.push_back(1);
+    }
+
+    auto* sp_copy = new std::shared_ptr<uint8_t[]>(buf);
+    py::capsule base(sp_copy, [](void* p) {
+        delete reinterpret_cast<std::shared_ptr<uint8_t[]>*>(p);
+    });
+    return py::array(py::dtype::of<uint8_t>(), shape, strides, buf.get(), base);
+}
+
+// out 是 None 時配置輸出；否則寫進 out（array 或 list，跟輸入同樣的形式）。
+// 第 i 張輸出跟第 i 張輸入重疊、又不能原地做時，那一張先算到暫存再複製過去
+static py::object run_batch_py(const py::object& images,
+                               const py::object& out,
+                               const pf::ImageOp& op,
+                               Backend be)
+{
+    bool stacked = false;
+    std::vector<ImageU8> srcs = batch_from_python(images, stacked);
+    std::vector<ImageU8> dsts;
+
+    if (out.is_none()) {
+        if (!stacked) {
+            {
+                py::gil_scoped_release nogil;
+                dsts = pf::run_batch(srcs, op, be);
+            }
+            py::list res;
+            for (size_t i = 0; i < dsts.size(); ++i) res.append(result_to_numpy(srcs[i], dsts[i]));
+            return res;
+        }
+
+        // 同一個 array 裡每張大小都一樣，輸出也一樣大
+        if (srcs.empty()) throw std::runtime_error("batch is empty");
+        const pf::ImageShape shape = op.output_shape(pf::shape_of(srcs[0]));
+        const size_t slice = shape.elems();
+        std::shared_ptr<uint8_t[]> buf = pf::allocate_buffer(slice * srcs.size(), pf::Init::None);
+        for (size_t i = 0; i < srcs.size(); ++i) {
+            dsts.emplace_back(shape.h, shape.w, shape.c,
+                              std::shared_ptr<uint8_t[]>(buf, buf.get() + i * slice));
+        }
+        {
+            py::gil_scoped_release nogil;
+            pf::run_batch(srcs, dsts, op, be);
+        }
+        return stacked_to_numpy(buf, srcs.size(), shape.h, shape.w, shape.c);
+    }
+
+    bool out_stacked = false;
+    dsts = batch_from_python(out, out_stacked, true);
+    if (out_stacked != stacked || dsts.size() != srcs.size()) {
+        throw std::runtime_error("out must be the same kind of batch (array / list) with the same length as images");
+    }
+
+    {
+        py::gil_scoped_release nogil;
+        std::vector<std::pair<size_t, ImageU8>> redirected;
+        for (size_t i = 0; i < srcs.size(); ++i) {
+            if (pf::overlaps(srcs[i], dsts[i]) && !(op.in_place && pf::same_pixels(srcs[i], dsts[i]))) {
+                ImageU8 tmp(dsts[i].h(), dsts[i].w(), dsts[i].c(), pf::Init::None);
+                redirected.emplace_back(i, std::move(dsts[i]));
+                dsts[i] = std::move(tmp);
+            }
+        }
+        pf::run_batch(srcs, dsts, op, be);
+        for (auto& r : redirected) copy_pixels(dsts[r.first], r.second);
+    }
+    return out;
+}
+
+// Pipeline 的 builder：加一步之後回傳自己，可以一路串下去
+static py::object add_step(const py::object& self, pf::ImageOp op) {
+    self.cast<pf::Pipeline&>().add(std::move(op));
+    return self;
+}
+
 // ------------------------------------------------------------
 // 檔案 I/O 包裝（load/save 本身也零拷貝）
 // ------------------------------------------------------------
-static py::array load_image_py(const std::string& path) {
-    ImageU8 im = pf::load_image_u8(path);
+// max_size=None：原尺寸；給了就要是正整數
+static int max_size_from_python(const py::object& max_size) {
+    if (max_size.is_none()) return 0;
+    const int n = max_size.cast<int>();
+    if (n <= 0) throw std::invalid_argument("max_size must be a positive integer or None");
+    return n;
+}
+
+// 解碼 / 編碼期間一樣放掉 GIL
+static py::array load_image_py(const std::string& path, const py::object& max_size) {
+    const int limit = max_size_from_python(max_size);
+    ImageU8 im;
+    {
+        py::gil_scoped_release nogil;
+        im = pf::load_image_u8(path, limit);
+    }
     return imageu8_to_numpy(im);
 }
 
-static void save_image_py(const std::string& path, const py::array& array) {
-    py::buffer_info info = array.request();
-    auto shape = check_uint8_hw_or_hwc(info);
+// 編碼參數：quality / subsampling 給 JPEG，compression / png_filter 給 PNG，QOI 沒有參數
+static pf::EncodeOptions encode_options_from_python(int quality, const std::string& subsampling,
+                                                    int compression, const std::string& png_filter) {
+    if (quality < 1 || quality > 100) throw std::invalid_argument("quality must be in 1..100");
+    if (compression < 0 || compression > 9) throw std::invalid_argument("compression must be in 0..9");
+    pf::EncodeOptions o;
+    o.jpeg_quality = quality;
+    o.png_level    = compression;
+
+    if (subsampling == "auto") o.jpeg_subsampling = pf::ChromaSubsampling::Auto;
+    else if (subsampling == "444" || subsampling == "4:4:4") o.jpeg_subsampling = pf::ChromaSubsampling::S444;
+    else if (subsampling == "422" || subsampling == "4:2:2") o.jpeg_subsampling = pf::ChromaSubsampling::S422;
+    else if (subsampling == "420" || subsampling == "4:2:0") o.jpeg_subsampling = pf::ChromaSubsampling::S420;
+    else throw std::runtime_error("subsampling must be one of: auto, 444, 422, 420");
 
-    const auto* ptr = static_cast<const uint8_t*>(info.ptr);
-    pf::save_image_u8(path, ptr, shape.h, shape.w, shape.c);
+    if (png_filter == "none") o.png_filter = pf::PngFilter::None;
+    else if (png_filter == "sub") o.png_filter = pf::PngFilter::Sub;
+    else if (png_filter == "up") o.png_filter = pf::PngFilter::Up;
+    else if (png_filter == "average") o.png_filter = pf::PngFilter::Average;
+    else if (png_filter == "paeth") o.png_filter = pf::PngFilter::Paeth;
+    else if (png_filter == "adaptive") o.png_filter = pf::PngFilter::Adaptive;
+    else if (png_filter == "fast") o.png_filter = pf::PngFilter::Fast;
+    else throw std::runtime_error("png_filter must be one of: none, sub, up, average, paeth, adaptive, fast");
+    return o;
+}
+
+static void save_image_py(const std::string& path, const py::array& array, int quality,
+                          const std::string& subsampling, int compression, const std::string& png_filter) {
+    const pf::EncodeOptions options = encode_options_from_python(quality, subsampling, compression, png_filter);
+    ImageU8 img = numpy_to_imageu8_zero_copy(array);
+    py::gil_scoped_release nogil;
+    if (img.is_contiguous()) {
+        pf::save_image_u8(path, img.data(), img.h(), img.w(), img.c(), options);
+        return;
+    }
+
+    // encoder 要緊密排列的 rows：view 先複製一份
+    ImageU8 packed(img.h(), img.w(), img.c(), pf::Init::None);
+    copy_pixels(img, packed);
+    pf::save_image_u8(path, packed.data(), packed.h(), packed.w(), packed.c(), options);
+}
+
+// 記憶體裡的編碼資料（例如從 object store 拿到的 bytes），不經過檔案系統
+static py::array load_image_from_bytes_py(const py::buffer& data, const py::object& max_size) {
+    const int limit = max_size_from_python(max_size);
+    const py::buffer_info info = data.request();
+    // 要連續的一塊：bytes / bytearray / memoryview / 一維 uint8 numpy 都可以
+    py::ssize_t expect = info.itemsize;
+    for (py::ssize_t d = info.ndim - 1; d >= 0; --d) {
+        if (info.shape[d] != 1 && info.strides[d] != expect) {
+            throw std::invalid_argument("load_image_from_bytes: data must be a contiguous buffer");
+        }
+        expect *= info.shape[d];
+    }
+    const std::size_t size = static_cast<std::size_t>(info.size * info.itemsize);
+
+    ImageU8 im;
+    {
+        // 解碼期間 data 由參數撐著，而且 buffer 被 export 時 bytearray 不能改大小
+        py::gil_scoped_release nogil;
+        im = pf::decode_image_u8(static_cast<const uint8_t*>(info.ptr), size, limit);
+    }
+    return imageu8_to_numpy(im);
+}
+
+static py::bytes save_image_to_bytes_py(const py::array& array, const std::string& format, int quality,
+                                        const std::string& subsampling, int compression,
+                                        const std::string& png_filter) {
+    const pf::EncodeOptions options = encode_options_from_python(quality, subsampling, compression, png_filter);
+    ImageU8 img = numpy_to_imageu8_zero_copy(array);
+    std::vector<uint8_t> encoded;
+    {
+        py::gil_scoped_release nogil;
+        if (img.is_contiguous()) {
+            encoded = pf::encode_image_u8(format, img.data(), img.h(), img.w(), img.c(), options);
+        } else {
+            ImageU8 packed(img.h(), img.w(), img.c(), pf::Init::None);
+            copy_pixels(img, packed);
+            encoded = pf::encode_image_u8(format, packed.data(), packed.h(), packed.w(), packed.c(), options);
+        }
+    }
+    return py::bytes(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+}
+
+// 路徑清單：任何 iterable，元素是 str 或 pathlib.Path
+static std::vector<std::string> paths_from_python(const py::object& paths) {
+    std::vector<std::string> out;
+    for (py::handle item : paths.cast<py::iterable>()) out.push_back(py::str(item).cast<std::string>());
+    return out;
 }
 
 // ------------------------------------------------------------
@@ -152,36 +478,133 @@ static Border parse_border(const std::string& s) {
     throw std::runtime_error("border must be one of: reflect, replicate, wrap, constant");
 }
 
-static Backend parse_backend(const std::string& s) {
-    if (s == "auto") {
-    #ifdef PF_HAS_OPENMP
-        return Backend::OpenMP;
-    #else
-        return Backend::Single;
-    #endif
+static pf::TileCompression parse_tile_compression(const std::string& s) {
+    if (s == "none") return pf::TileCompression::None;
+    if (s == "qoi")  return pf::TileCompression::Qoi;
+    if (s == "png")  return pf::TileCompression::Png;
+    throw std::runtime_error("compression must be one of: none, qoi, png");
+}
+
+static const char* tile_compression_name(pf::TileCompression c) {
+    switch (c) {
+    case pf::TileCompression::Qoi: return "qoi";
+    case pf::TileCompression::Png: return "png";
+    default:                       return "none";
     }
+}
+
+static Backend parse_backend(const std::string& s) {
+    // auto 交給 C++ 端的成本模型，依影像大小挑 single / openmp 與 thread 數
+    if (s == "auto")   return Backend::Auto;
     if (s == "single") return Backend::Single;
     if (s == "openmp" || s == "omp") return Backend::OpenMP;
-    throw std::runtime_error("backend must be one of: auto, single");
+    // 常駐的 work-stealing pool：不需要 OpenMP，巢狀呼叫也不會多開 thread
+    if (s == "threadpool" || s == "pool") return Backend::ThreadPool;
+    throw std::runtime_error("backend must be one of: auto, single, openmp, threadpool");
+}
+
+static pf::Interp parse_interp(const std::string& s) {
+    if (s == "nearest")  return pf::Interp::Nearest;
+    if (s == "bilinear" || s == "linear") return pf::Interp::Bilinear;
+    if (s == "bicubic" || s == "cubic")   return pf::Interp::Bicubic;
+    if (s == "lanczos3" || s == "lanczos") return pf::Interp::Lanczos3;
+    if (s == "area")     return pf::Interp::Area;
+    throw std::runtime_error("interpolation must be one of: nearest, bilinear, bicubic, lanczos3, area");
 }
 
 // ------------------------------------------------------------
 // 共用 wrap：把 numpy 轉 ImageU8 → 呼叫 C++ filter → 再轉回 numpy
+// （或寫進 out）
 // ------------------------------------------------------------
 template <typename FilterFunc, typename ParamT>
-static py::array wrap_filter(
+static py::object wrap_filter(
     const py::array& src,
     ParamT param,
     const std::string& backend_str,
     const std::string& border_str,
     uint8_t border_value,
+    const py::object& out,
+    bool in_place_ok,
     FilterFunc&& func)
 {
     ImageU8 in  = numpy_to_imageu8_zero_copy(src);  // 這裡是零拷貝
     Border  b   = parse_border(border_str);
     Backend be  = parse_backend(backend_str);
-    ImageU8 out = func(in, param, b, be, border_value);
-    return imageu8_to_numpy(out);                   // 這裡也是零拷貝
+    return run_op(in, out, in_place_ok,
+                  [&] {
+                      ImageU8 res(in.h(), in.w(), in.c(), pf::Init::None);
+                      func(in, res, param, b, be, border_value);
+                      return res;
+                  },
+                  [&](ImageU8& dst) { func(in, dst, param, b, be, border_value); });
+}
+
+// 任意形狀的 float64 陣列 → 固定長度的矩陣（例如 2x3 / 3x3）
+template <std::size_t N>
+static std::array<double, N> matrix_from_numpy(const py::array_t<double, py::array::c_style | py::array::forcecast>& a,
+                                               const char* what) {
+    if (static_cast<std::size_t>(a.size()) != N) {
+        throw std::runtime_error(std::string(what) + ": expected " + std::to_string(N) + " matrix elements");
+    }
+    std::array<double, N> m{};
+    const double* p = a.data();
+    for (std::size_t i = 0; i < N; ++i) m[i] = p[i];
+    return m;
+}
+
+static py::dict tune_params_to_dict(const pf::TuneParams& p) {
+    py::dict d;
+    d["ns_per_byte"]        = p.ns_per_byte;
+    d["ns_per_op"]          = p.ns_per_op;
+    d["fork_ns"]            = p.fork_ns;
+    d["fork_ns_per_thread"] = p.fork_ns_per_thread;
+    d["mem_scaling"]        = p.mem_scaling;
+    d["max_threads"]        = p.max_threads;
+    d["calibrated"]         = p.calibrated;
+    return d;
+}
+
+static py::dict pool_stats_to_dict(const pf::BufferPoolStats& s) {
+    py::dict d;
+    d["enabled"]      = s.enabled;
+    d["max_bytes"]    = s.max_bytes;
+    d["cached_bytes"] = s.cached_bytes;
+    d["in_use_bytes"] = s.in_use_bytes;
+    d["hits"]         = s.hits;
+    d["misses"]       = s.misses;
+    d["evictions"]    = s.evictions;
+    return d;
+}
+
+static py::dict concurrency_stats_to_dict(const pf::ConcurrencyStats& s) {
+    py::dict d;
+    d["max_threads"]     = s.max_threads;
+    d["available_cpus"]  = s.available_cpus;
+    d["in_flight"]       = s.in_flight;
+    d["peak_in_flight"]  = s.peak_in_flight;
+    d["parallel_calls"]  = s.parallel_calls;
+    d["throttled_calls"] = s.throttled_calls;
+    d["serial_calls"]    = s.serial_calls;
+    return d;
+}
+
+// StripReader：來源 + 每次讀幾個 row
+struct StripReaderPy {
+    std::unique_ptr<pf::StripSource> src;
+    int                              strip_rows = 256;
+    long long                        rows_read = 0;
+};
+
+static py::dict stream_stats_to_dict(const pf::StreamStats& s) {
+    py::dict d;
+    d["rows"]         = s.rows;
+    d["strips"]       = s.strips;
+    d["buffer_bytes"] = s.buffer_bytes;
+    return d;
+}
+
+static py::tuple shape_to_python(const pf::ImageShape& s) {
+    return s.c == 1 ? py::make_tuple(s.h, s.w) : py::make_tuple(s.h, s.w, s.c);
 }
 
 } // namespace pfpy
@@ -196,12 +619,238 @@ PYBIND11_MODULE(_core, m) {
 
     // Image IO
     m.def("load_image", &load_image_py,
-          py::arg("path"),
-          "Load image as numpy.ndarray (uint8, HxW or HxWx3) with zero-copy.");
+          py::arg("path"), py::arg("max_size") = py::none(),
+          "Load image as numpy.ndarray (uint8, HxW or HxWx3) with zero-copy. "
+          "max_size shrinks the longer side to at most that many pixels (JPEGs are decoded at "
+          "1/2, 1/4 or 1/8 scale directly).");
 
+    // 編碼參數（save_image / save_image_to_bytes / save_images / ImageWriter 共用）
     m.def("save_image", &save_image_py,
-          py::arg("path"), py::arg("img"),
-          "Save numpy.ndarray (uint8, HxW or HxWx3) to file (.png/.jpg).");
+          py::arg("path"), py::arg("img"), py::kw_only(),
+          py::arg("quality") = 95, py::arg("subsampling") = "auto",
+          py::arg("compression") = 6, py::arg("png_filter") = "adaptive",
+          "Save numpy.ndarray (uint8, HxW or HxWx3) to file (.png/.jpg/.qoi). "
+          "JPEG: quality 1..100, subsampling 'auto' (4:2:0 when quality <= 90) / '444' / '422' / '420'. "
+          "PNG: compression 0 (stored) .. 9, png_filter 'none' / 'sub' / 'up' / 'average' / 'paeth' / "
+          "'adaptive' / 'fast' (adaptive estimated from every 8th byte).");
+
+    // ---- 批次 / 串流 I/O：decode / encode 都在 C++ thread 上做，期間不拿 GIL ----
+    m.def(
+        "load_images",
+        [](const py::object& paths, const py::object& max_size) {
+            const std::vector<std::string> ps = paths_from_python(paths);
+            const int limit = max_size_from_python(max_size);
+            std::vector<ImageU8> imgs;
+            {
+                py::gil_scoped_release nogil;
+                imgs = pf::load_images(ps, limit);
+            }
+            py::list res;
+            for (const ImageU8& im : imgs) res.append(imageu8_to_numpy(im));
+            return res;
+        },
+        py::arg("paths"), py::arg("max_size") = py::none(),
+        "Decode many files in parallel on the thread pool; returns a list in the same order."
+    );
+
+    m.def(
+        "save_images",
+        [](const py::object& paths, const py::object& images, int quality, const std::string& subsampling,
+           int compression, const std::string& png_filter) {
+            const std::vector<std::string> ps = paths_from_python(paths);
+            const pf::EncodeOptions options = encode_options_from_python(quality, subsampling, compression, png_filter);
+            bool stacked = false;
+            const std::vector<ImageU8> imgs = batch_from_python(images, stacked);
+            py::gil_scoped_release nogil;
+            pf::save_images(ps, imgs, options);
+        },
+        py::arg("paths"),
+        py::arg("images"),
+        py::kw_only(),
+        py::arg("quality") = 95, py::arg("subsampling") = "auto",
+        py::arg("compression") = 6, py::arg("png_filter") = "adaptive",
+        "Encode and write many images in parallel (list of arrays or an NxHxW[xC] array)."
+    );
+
+    py::class_<pf::ImageReader>(m, "ImageReader",
+                                "Iterate decoded images in order while the next `prefetch` files are "
+                                "read and decoded on background threads.")
+        .def(py::init([](const py::object& paths, int prefetch, int threads, const py::object& max_size) {
+                 return std::make_unique<pf::ImageReader>(paths_from_python(paths), prefetch, threads,
+                                                          max_size_from_python(max_size));
+             }),
+             py::arg("paths"), py::arg("prefetch") = 4, py::arg("threads") = 0,
+             py::arg("max_size") = py::none())
+        .def("__iter__", [](const py::object& self) { return self; })
+        .def("__next__",
+             [](pf::ImageReader& r) {
+                 ImageU8 img;
+                 bool ok = false;
+                 {
+                     py::gil_scoped_release nogil;
+                     ok = r.next(img);
+                 }
+                 if (!ok) throw py::stop_iteration();
+                 return imageu8_to_numpy(img);
+             })
+        .def("__len__", &pf::ImageReader::size)
+        .def_property_readonly("consumed", &pf::ImageReader::consumed);
+
+    py::class_<pf::ImageWriter>(m, "ImageWriter",
+                                "Write-behind encoder: write() queues a copy of the image and returns; "
+                                "background threads encode and write. close() waits and raises the first error.")
+        .def(py::init([](int queue, int threads, int quality, const std::string& subsampling, int compression,
+                         const std::string& png_filter) {
+                 return std::make_unique<pf::ImageWriter>(
+                     queue, threads, encode_options_from_python(quality, subsampling, compression, png_filter));
+             }),
+             py::arg("queue") = 4, py::arg("threads") = 0, py::kw_only(),
+             py::arg("quality") = 95, py::arg("subsampling") = "auto",
+             py::arg("compression") = 6, py::arg("png_filter") = "adaptive")
+        .def("write",
+             [](pf::ImageWriter& w, const std::string& path, const py::array& img) {
+                 // 先複製：呼叫端回來之後可以馬上重用自己的 array
+                 ImageU8 copy = numpy_to_imageu8_zero_copy(img).clone();
+                 py::gil_scoped_release nogil;
+                 w.write(path, std::move(copy));
+             },
+             py::arg("path"), py::arg("img"))
+        .def("close", &pf::ImageWriter::close, py::call_guard<py::gil_scoped_release>())
+        .def("__enter__", [](const py::object& self) { return self; })
+        .def("__exit__",
+             [](pf::ImageWriter& w, const py::object&, const py::object&, const py::object&) {
+                 py::gil_scoped_release nogil;
+                 w.close();
+             })
+        .def_property_readonly("pending", &pf::ImageWriter::pending)
+        .def_property_readonly("written", &pf::ImageWriter::written);
+
+    m.def("load_image_from_bytes", &load_image_from_bytes_py,
+          py::arg("data"), py::arg("max_size") = py::none(),
+          "Decode an encoded image (png/jpg/qoi/bmp/...) from bytes, bytearray, memoryview or a uint8 array.");
+
+    m.def("save_image_to_bytes", &save_image_to_bytes_py,
+          py::arg("img"), py::arg("format") = "png", py::kw_only(),
+          py::arg("quality") = 95, py::arg("subsampling") = "auto",
+          py::arg("compression") = 6, py::arg("png_filter") = "adaptive",
+          "Encode numpy.ndarray (uint8, HxW or HxWx3) as 'png', 'jpg' or 'qoi' and return the bytes "
+          "(encode options as in save_image).");
+
+    // ---- Tiled 容器（.pft）：大圖切 tile 存，mmap 讀、只碰用到的 tile ----
+    py::class_<pf::TiledWriter>(m, "TiledWriter",
+                                "Write a tiled .pft container: write_tile() in any order (thread-safe), "
+                                "append_rows() for images produced top to bottom, or write_image().")
+        .def(py::init([](const std::string& path, int height, int width, int channels, int tile_height,
+                         int tile_width, const std::string& compression) {
+                 return std::make_unique<pf::TiledWriter>(path, height, width, channels, tile_height, tile_width,
+                                                          parse_tile_compression(compression));
+             }),
+             py::arg("path"), py::arg("height"), py::arg("width"), py::arg("channels") = 3,
+             py::arg("tile_height") = 256, py::arg("tile_width") = 256, py::arg("compression") = "none")
+        .def("write_tile",
+             [](pf::TiledWriter& w, int ty, int tx, const py::array& tile) {
+                 ImageU8 t = numpy_to_imageu8_zero_copy(tile);
+                 py::gil_scoped_release nogil;
+                 w.write_tile(ty, tx, t);
+             },
+             py::arg("ty"), py::arg("tx"), py::arg("tile"))
+        .def("append_rows",
+             [](pf::TiledWriter& w, const py::array& rows) {
+                 ImageU8 r = numpy_to_imageu8_zero_copy(rows);
+                 py::gil_scoped_release nogil;
+                 w.append_rows(r);
+             },
+             py::arg("rows"))
+        .def("write_image",
+             [](pf::TiledWriter& w, const py::array& img) {
+                 ImageU8 in = numpy_to_imageu8_zero_copy(img);
+                 py::gil_scoped_release nogil;
+                 w.write_image(in);
+             },
+             py::arg("img"))
+        .def("close", &pf::TiledWriter::close, py::call_guard<py::gil_scoped_release>())
+        .def("__enter__", [](const py::object& self) { return self; })
+        .def("__exit__",
+             [](pf::TiledWriter& w, const py::object& exc_type, const py::object&, const py::object&) {
+                 // with 區塊裡已經丟了例外：還是要關檔，但不要用「缺 tile」蓋掉原本的錯誤
+                 const bool failing = !exc_type.is_none();
+                 py::gil_scoped_release nogil;
+                 try {
+                     w.close();
+                 } catch (...) {
+                     if (!failing) throw;
+                 }
+             })
+        .def_property_readonly("rows_appended", &pf::TiledWriter::rows_appended);
+
+    m.def(
+        "save_tiled",
+        [](const std::string& path, const py::array& img, int tile_height, int tile_width,
+           const std::string& compression) {
+            ImageU8 in = numpy_to_imageu8_zero_copy(img);
+            const pf::TileCompression comp = parse_tile_compression(compression);
+            py::gil_scoped_release nogil;
+            pf::save_tiled(path, in, tile_height, tile_width, comp);
+        },
+        py::arg("path"), py::arg("img"), py::arg("tile_height") = 256, py::arg("tile_width") = 256,
+        py::arg("compression") = "none",
+        "Write numpy.ndarray as a tiled .pft container; compression 'none' (zero-copy reads), 'qoi' or 'png'.");
+
+    py::class_<pf::TiledReader>(m, "TiledReader",
+                                "Memory-mapped .pft reader. Uncompressed tiles and regions inside one tile "
+                                "are zero-copy views of the mapping (copy-on-write: writing to them never "
+                                "changes the file or later reads; platforms without mmap return copies); "
+                                "arrays stay valid after the reader is gone.")
+        .def(py::init<const std::string&>(), py::arg("path"), py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("shape",
+                               [](const pf::TiledReader& r) {
+                                   const pf::TiledInfo& i = r.info();
+                                   return i.c == 1 ? py::make_tuple(i.h, i.w) : py::make_tuple(i.h, i.w, i.c);
+                               })
+        .def_property_readonly("tile_shape",
+                               [](const pf::TiledReader& r) { return py::make_tuple(r.info().tile_h, r.info().tile_w); })
+        .def_property_readonly("grid",
+                               [](const pf::TiledReader& r) { return py::make_tuple(r.info().tiles_y, r.info().tiles_x); })
+        .def_property_readonly("compression",
+                               [](const pf::TiledReader& r) { return tile_compression_name(r.info().compression); })
+        .def("tile",
+             [](const pf::TiledReader& r, int ty, int tx) {
+                 ImageU8 t;
+                 {
+                     py::gil_scoped_release nogil;
+                     t = r.tile(ty, tx);
+                 }
+                 return imageu8_to_numpy(t);
+             },
+             py::arg("ty"), py::arg("tx"))
+        .def("read_region",
+             [](const pf::TiledReader& r, int y, int x, int height, int width, int halo, const std::string& border,
+                uint8_t border_value) {
+                 const Border b = parse_border(border);
+                 ImageU8 out;
+                 {
+                     py::gil_scoped_release nogil;
+                     out = r.read_region(y, x, height, width, halo, b, border_value);
+                 }
+                 return imageu8_to_numpy(out);
+             },
+             py::arg("y"), py::arg("x"), py::arg("height"), py::arg("width"), py::arg("halo") = 0,
+             py::arg("border") = "reflect", py::arg("border_value") = 0,
+             "Region (y, x, height, width) plus `halo` pixels on every side, filled past the image edge "
+             "by `border` like the filters: run a stencil of radius <= halo on it and crop the halo to get "
+             "exactly the full-image result for that region.")
+        .def("read",
+             [](const pf::TiledReader& r) {
+                 ImageU8 out;
+                 {
+                     py::gil_scoped_release nogil;
+                     out = r.read();
+                 }
+                 return imageu8_to_numpy(out);
+             });
+
+    // 每個影像運算都可以給 out=：結果直接寫進這個 numpy（C-contiguous、可寫、尺寸相符），
+    // 回傳的就是 out；逐點運算 / flip 給 out=img 就是原地修改
 
     // mean_filter
     m.def("mean_filter",
@@ -209,13 +858,14 @@ PYBIND11_MODULE(_core, m) {
              int ksize,
              const std::string& backend,
              const std::string& border,
-             uint8_t border_value)
+             uint8_t border_value,
+             const py::object& out)
           {
               return wrap_filter(
-                  src, ksize, backend, border, border_value,
-                  [](const ImageU8& in, int k,
+                  src, ksize, backend, border, border_value, out, true,
+                  [](const ImageU8& in, ImageU8& dst, int k,
                      Border b, Backend be, uint8_t bv) {
-                      return pf::mean_filter(in, k, b, be, bv);
+                      pf::mean_filter(in, dst, k, b, be, bv);
                   });
           },
           py::arg("img"),
@@ -223,6 +873,7 @@ PYBIND11_MODULE(_core, m) {
           py::arg("backend") = "auto",
           py::arg("border") = "reflect",
           py::arg("border_value") = 0,
+          py::arg("out") = py::none(),
           "Mean (box) filter with selectable backend/border.");
 
     // gaussian_filter
@@ -231,13 +882,14 @@ PYBIND11_MODULE(_core, m) {
              float sigma,
              const std::string& backend,
              const std::string& border,
-             uint8_t border_value)
+             uint8_t border_value,
+             const py::object& out)
           {
               return wrap_filter(
-                  src, sigma, backend, border, border_value,
-                  [](const ImageU8& in, float s,
+                  src, sigma, backend, border, border_value, out, true,
+                  [](const ImageU8& in, ImageU8& dst, float s,
                      Border b, Backend be, uint8_t bv) {
-                      return pf::gaussian_filter(in, s, b, be, bv);
+                      pf::gaussian_filter(in, dst, s, b, be, bv);
                   });
           },
           py::arg("img"),
@@ -245,6 +897,7 @@ PYBIND11_MODULE(_core, m) {
           py::arg("backend") = "auto",
           py::arg("border")  = "reflect",
           py::arg("border_value") = 0,
+          py::arg("out") = py::none(),
           "Gaussian filter with selectable backend/border.");
 
     // median_filter
@@ -253,13 +906,14 @@ PYBIND11_MODULE(_core, m) {
              int ksize,
              const std::string& backend,
              const std::string& border,
-             uint8_t border_value)
+             uint8_t border_value,
+             const py::object& out)
           {
               return wrap_filter(
-                  src, ksize, backend, border, border_value,
-                  [](const ImageU8& in, int k,
+                  src, ksize, backend, border, border_value, out, false,
+                  [](const ImageU8& in, ImageU8& dst, int k,
                      Border b, Backend be, uint8_t bv) {
-                      return pf::median_filter(in, k, b, be, bv);
+                      pf::median_filter(in, dst, k, b, be, bv);
                   });
           },
           py::arg("img"),
@@ -267,6 +921,7 @@ PYBIND11_MODULE(_core, m) {
           py::arg("backend") = "auto",
           py::arg("border")  = "reflect",
           py::arg("border_value") = 0,
+          py::arg("out") = py::none(),
           "Median filter with selectable backend/border.");
 
     // bilateral_filter（參數比較多，就不套 wrap_filter 模板了）
@@ -277,15 +932,21 @@ PYBIND11_MODULE(_core, m) {
              float sigma_space,
              const std::string& backend,
              const std::string& border,
-             uint8_t border_value)
+             uint8_t border_value,
+             const py::object& out)
           {
               ImageU8 in  = numpy_to_imageu8_zero_copy(src);  // zero-copy in
               Border  b   = parse_border(border);
               Backend be  = parse_backend(backend);
-              ImageU8 out = pf::bilateral_filter(in, ksize,
-                                                 sigma_color, sigma_space,
-                                                 b, be, border_value);
-              return imageu8_to_numpy(out);                   // zero-copy out
+              return run_op(in, out, false,
+                            [&] {
+                                return pf::bilateral_filter(in, ksize, sigma_color, sigma_space,
+                                                            b, be, border_value);
+                            },
+                            [&](ImageU8& dst) {
+                                pf::bilateral_filter(in, dst, ksize, sigma_color, sigma_space,
+                                                     b, be, border_value);
+                            });
           },
           py::arg("img"),
           py::arg("ksize"),
@@ -294,6 +955,7 @@ PYBIND11_MODULE(_core, m) {
           py::arg("backend") = "auto",
           py::arg("border")  = "reflect",
           py::arg("border_value") = 0,
+          py::arg("out") = py::none(),
           "Bilateral filter with selectable backend/border.");
 
 
@@ -301,43 +963,52 @@ PYBIND11_MODULE(_core, m) {
     m.def(
         "to_grayscale",
         [](const py::array& src,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::to_grayscale(in, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, in.c() == 1,
+                          [&] { return pf::to_grayscale(in, be); },
+                          [&](ImageU8& dst) { pf::to_grayscale(in, dst, be); });
         },
         py::arg("img"),
         py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
         "Convert RGB image to grayscale (returns HxW array)."
     );
 
     m.def(
         "invert",
         [](const py::array& src,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::invert(in, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::invert(in, be); },
+                          [&](ImageU8& dst) { pf::invert(in, dst, be); });
         },
         py::arg("img"),
         py::arg("backend") = "auto",
-        "Invert pixel values: v -> 255 - v."
+        py::arg("out") = py::none(),
+        "Invert pixel values: v -> 255 - v. out=img inverts in place."
     );
 
     m.def(
         "sepia",
         [](const py::array& src,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::sepia(in, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::sepia(in, be); },
+                          [&](ImageU8& dst) { pf::sepia(in, dst, be); });
         },
         py::arg("img"),
         py::arg("backend") = "auto",
-        "Apply sepia tone effect (RGB only)."
+        py::arg("out") = py::none(),
+        "Apply sepia tone effect (RGB only). out=img works in place."
     );
 
     m.def(
@@ -345,33 +1016,39 @@ PYBIND11_MODULE(_core, m) {
         [](const py::array& src,
            float alpha,
            float beta,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::adjust_brightness_contrast(in, alpha, beta, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::adjust_brightness_contrast(in, alpha, beta, be); },
+                          [&](ImageU8& dst) { pf::adjust_brightness_contrast(in, dst, alpha, beta, be); });
         },
         py::arg("img"),
         py::arg("alpha"),
         py::arg("beta"),
         py::arg("backend") = "auto",
-        "Adjust brightness and contrast: new = alpha * old + beta."
+        py::arg("out") = py::none(),
+        "Adjust brightness and contrast: new = alpha * old + beta. out=img works in place."
     );
 
     m.def(
         "gamma_correct",
         [](const py::array& src,
            float gamma,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::gamma_correct(in, gamma, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::gamma_correct(in, gamma, be); },
+                          [&](ImageU8& dst) { pf::gamma_correct(in, dst, gamma, be); });
         },
         py::arg("img"),
         py::arg("gamma"),
         py::arg("backend") = "auto",
-        "Gamma correction: new = 255 * (old/255)^gamma."
+        py::arg("out") = py::none(),
+        "Gamma correction: new = 255 * (old/255)^gamma. out=img works in place."
     );
 
     // -------------------- Effects (Week5) --------------------
@@ -379,16 +1056,19 @@ PYBIND11_MODULE(_core, m) {
         "sharpen",
         [](const py::array& src,
            float amount,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::sharpen(in, amount, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, amount <= 0.0f,
+                          [&] { return pf::sharpen(in, amount, be); },
+                          [&](ImageU8& dst) { pf::sharpen(in, dst, amount, be); });
         },
         py::arg("img"),
         py::arg("amount") = 1.0f,
         py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
         "Sharpen the image with a simple 3x3 kernel."
     );
 
@@ -396,16 +1076,19 @@ PYBIND11_MODULE(_core, m) {
         "emboss",
         [](const py::array& src,
            float strength,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::emboss(in, strength, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, false,
+                          [&] { return pf::emboss(in, strength, be); },
+                          [&](ImageU8& dst) { pf::emboss(in, dst, strength, be); });
         },
         py::arg("img"),
         py::arg("strength") = 1.0f,
         py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
         "Emboss effect to give a relief-style shading."
     );
 
@@ -414,22 +1097,21 @@ PYBIND11_MODULE(_core, m) {
         [](const py::array& src,
            float sigma_space,
            int edge_threshold,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::cartoonize(
-                in,
-                sigma_space,
-                static_cast<std::uint8_t>(edge_threshold),
-                be
-            );
-            return imageu8_to_numpy(out);
+            const auto th = static_cast<std::uint8_t>(edge_threshold);
+            return run_op(in, out, false,
+                          [&] { return pf::cartoonize(in, sigma_space, th, be); },
+                          [&](ImageU8& dst) { pf::cartoonize(in, dst, sigma_space, th, be); });
         },
         py::arg("img"),
         py::arg("sigma_space") = 2.0f,
         py::arg("edge_threshold") = 40,
         py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
         "Simple cartoon effect: smooth + edge lines + color quantization."
     );
 
@@ -441,48 +1123,64 @@ PYBIND11_MODULE(_core, m) {
         [](const py::array& src,
            int new_h,
            int new_w,
-           const std::string& backend) {
+           const std::string& backend,
+           const std::string& interpolation,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::resize(in, new_h, new_w, be);
-            return imageu8_to_numpy(out);
+            pf::Interp it = parse_interp(interpolation);
+            return run_op(in, out, false,
+                          [&] { return pf::resize(in, new_h, new_w, it, be); },
+                          [&](ImageU8& dst) {
+                              check_out_size(dst, new_h, new_w, "resize");
+                              pf::resize(in, dst, it, be);
+                          });
         },
         py::arg("img"),
         py::arg("height"),
         py::arg("width"),
         py::arg("backend") = "auto",
-        "Resize image to (height, width) using bilinear interpolation."
+        py::arg("interpolation") = "bilinear",
+        py::arg("out") = py::none(),
+        "Resize image to (height, width). interpolation: nearest, bilinear, bicubic, "
+        "lanczos3 or area; downscaling widens the kernel to avoid aliasing."
     );
 
     m.def(
         "flip_horizontal",
         [](const py::array& src,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::flip_horizontal(in, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::flip_horizontal(in, be); },
+                          [&](ImageU8& dst) { pf::flip_horizontal(in, dst, be); });
         },
         py::arg("img"),
         py::arg("backend") = "auto",
-        "Flip image horizontally."
+        py::arg("out") = py::none(),
+        "Flip image horizontally. out=img flips in place."
     );
 
     m.def(
         "flip_vertical",
         [](const py::array& src,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::flip_vertical(in, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, true,
+                          [&] { return pf::flip_vertical(in, be); },
+                          [&](ImageU8& dst) { pf::flip_vertical(in, dst, be); });
         },
         py::arg("img"),
         py::arg("backend") = "auto",
-        "Flip image vertically."
+        py::arg("out") = py::none(),
+        "Flip image vertically. out=img flips in place."
     );
 
     m.def(
@@ -492,12 +1190,24 @@ PYBIND11_MODULE(_core, m) {
            int x,
            int h,
            int w,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) -> py::object {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::crop(in, y, x, h, w, be);
-            return imageu8_to_numpy(out);
+            ImageU8 region = pf::crop(in, y, x, h, w, be);
+            // 沒給 out：回傳 view（改它會反映到原圖）；原圖唯讀時 view 也唯讀
+            if (out.is_none()) {
+                py::array arr = imageu8_to_numpy(region);
+                if (!src.writeable()) arr.attr("setflags")(py::arg("write") = false);
+                return arr;
+            }
+            return run_op(region, out, true,
+                          [&] { return region.share(); },
+                          [&](ImageU8& dst) {
+                              pf::check_output(dst, region.h(), region.w(), region.c(), "crop");
+                              copy_pixels(region, dst);
+                          });
         },
         py::arg("img"),
         py::arg("y"),
@@ -505,25 +1215,925 @@ PYBIND11_MODULE(_core, m) {
         py::arg("height"),
         py::arg("width"),
         py::arg("backend") = "auto",
-        "Crop a (height, width) region starting from (y, x)."
+        py::arg("out") = py::none(),
+        "Crop a (height, width) region starting from (y, x); returns a view unless out is given."
     );
 
     m.def(
         "rotate",
         [](const py::array& src,
            float angle_deg,
-           const std::string& backend) {
+           const std::string& backend,
+           const py::object& out) {
             using namespace pfpy;
             ImageU8 in  = numpy_to_imageu8_zero_copy(src);
             Backend be  = parse_backend(backend);
-            ImageU8 out = pf::rotate(in, angle_deg, be);
-            return imageu8_to_numpy(out);
+            return run_op(in, out, false,
+                          [&] { return pf::rotate(in, angle_deg, be); },
+                          [&](ImageU8& dst) { pf::rotate(in, dst, angle_deg, be); });
         },
         py::arg("img"),
         py::arg("angle_deg"),
         py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
         "Rotate image by angle_deg (center-based), output size same as input."
     );
+
+    m.def(
+        "rotate90",
+        [](const py::array& src,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::rotate90(in, be); },
+                          [&](ImageU8& dst) { pf::rotate90(in, dst, be); });
+        },
+        py::arg("img"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Rotate 90 degrees clockwise (lossless); output shape is (w, h)."
+    );
+
+    m.def(
+        "rotate180",
+        [](const py::array& src,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::rotate180(in, be); },
+                          [&](ImageU8& dst) { pf::rotate180(in, dst, be); });
+        },
+        py::arg("img"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Rotate 180 degrees (lossless)."
+    );
+
+    m.def(
+        "rotate270",
+        [](const py::array& src,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::rotate270(in, be); },
+                          [&](ImageU8& dst) { pf::rotate270(in, dst, be); });
+        },
+        py::arg("img"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Rotate 270 degrees clockwise / 90 counter-clockwise (lossless); output shape is (w, h)."
+    );
+
+    m.def(
+        "transpose",
+        [](const py::array& src,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::transpose(in, be); },
+                          [&](ImageU8& dst) { pf::transpose(in, dst, be); });
+        },
+        py::arg("img"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Swap rows and columns (lossless); output shape is (w, h)."
+    );
+
+    m.def(
+        "warp_affine",
+        [](const py::array& src,
+           const py::array_t<double, py::array::c_style | py::array::forcecast>& matrix,
+           int height,
+           int width,
+           const std::string& interpolation,
+           const std::string& border,
+           uint8_t border_value,
+           bool inverse_map,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            auto M      = matrix_from_numpy<6>(matrix, "warp_affine");
+            const pf::Interp it = parse_interp(interpolation);
+            const Border     b  = parse_border(border);
+            const Backend    be = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] {
+                              return pf::warp_affine(in, M, height, width, it, b, be,
+                                                     border_value, inverse_map);
+                          },
+                          [&](ImageU8& dst) {
+                              check_out_size(dst, height, width, "warp_affine");
+                              pf::warp_affine(in, dst, M, it, b, be, border_value, inverse_map);
+                          });
+        },
+        py::arg("img"),
+        py::arg("matrix"),
+        py::arg("height"),
+        py::arg("width"),
+        py::arg("interpolation") = "bilinear",
+        py::arg("border") = "constant",
+        py::arg("border_value") = 0,
+        py::arg("inverse_map") = false,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Affine warp with a 2x3 matrix (src -> dst, or dst -> src when inverse_map=True). "
+        "interpolation: nearest, bilinear or bicubic."
+    );
+
+    m.def(
+        "warp_perspective",
+        [](const py::array& src,
+           const py::array_t<double, py::array::c_style | py::array::forcecast>& matrix,
+           int height,
+           int width,
+           const std::string& interpolation,
+           const std::string& border,
+           uint8_t border_value,
+           bool inverse_map,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            auto M      = matrix_from_numpy<9>(matrix, "warp_perspective");
+            const pf::Interp it = parse_interp(interpolation);
+            const Border     b  = parse_border(border);
+            const Backend    be = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] {
+                              return pf::warp_perspective(in, M, height, width, it, b, be,
+                                                          border_value, inverse_map);
+                          },
+                          [&](ImageU8& dst) {
+                              check_out_size(dst, height, width, "warp_perspective");
+                              pf::warp_perspective(in, dst, M, it, b, be, border_value, inverse_map);
+                          });
+        },
+        py::arg("img"),
+        py::arg("matrix"),
+        py::arg("height"),
+        py::arg("width"),
+        py::arg("interpolation") = "bilinear",
+        py::arg("border") = "constant",
+        py::arg("border_value") = 0,
+        py::arg("inverse_map") = false,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Perspective warp with a 3x3 homography (src -> dst, or dst -> src when inverse_map=True). "
+        "interpolation: nearest, bilinear or bicubic."
+    );
+
+    // ------------------------------------------------------------
+    // remap / 鏡頭去畸變
+    // ------------------------------------------------------------
+    py::class_<pf::RemapMap, std::shared_ptr<pf::RemapMap>>(m, "RemapMap",
+        "Precomputed source-coordinate map (int16 integer part + 1/256 fractional index).")
+        .def_readonly("height", &pf::RemapMap::h)
+        .def_readonly("width", &pf::RemapMap::w);
+
+    m.def(
+        "make_remap_map",
+        [](const py::array_t<float, py::array::c_style | py::array::forcecast>& map_x,
+           const py::array_t<float, py::array::c_style | py::array::forcecast>& map_y) {
+            if (map_x.ndim() != 2 || map_y.ndim() != 2 ||
+                map_x.shape(0) != map_y.shape(0) || map_x.shape(1) != map_y.shape(1)) {
+                throw std::runtime_error("make_remap_map: map_x and map_y must be HxW arrays of the same shape");
+            }
+            const int h = checked_dim(map_x.shape(0));
+            const int w = checked_dim(map_x.shape(1));
+            // map_x / map_y 是參數，呼叫期間一定活著
+            py::gil_scoped_release nogil;
+            return std::make_shared<pf::RemapMap>(pf::make_remap_map(map_x.data(), map_y.data(), h, w));
+        },
+        py::arg("map_x"),
+        py::arg("map_y"),
+        "Convert float source-coordinate maps (as used by cv2.remap) into a RemapMap."
+    );
+
+    m.def(
+        "remap",
+        [](const py::array& src,
+           const pf::RemapMap& map,
+           const std::string& interpolation,
+           const std::string& border,
+           uint8_t border_value,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            const pf::Interp it = parse_interp(interpolation);
+            const Border     b  = parse_border(border);
+            const Backend    be = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::remap(in, map, it, b, be, border_value); },
+                          [&](ImageU8& dst) { pf::remap(in, dst, map, it, b, be, border_value); });
+        },
+        py::arg("img"),
+        py::arg("map"),
+        py::arg("interpolation") = "bilinear",
+        py::arg("border") = "constant",
+        py::arg("border_value") = 0,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Sample img at the coordinates stored in map; output has the map's shape."
+    );
+
+    m.def(
+        "undistort_map",
+        [](int height, int width,
+           double fx, double fy, double cx, double cy,
+           double k1, double k2, double p1, double p2, double k3) {
+            pf::LensModel lens;
+            lens.fx = fx; lens.fy = fy; lens.cx = cx; lens.cy = cy;
+            lens.k1 = k1; lens.k2 = k2; lens.k3 = k3; lens.p1 = p1; lens.p2 = p2;
+            py::gil_scoped_release nogil;
+            return std::const_pointer_cast<pf::RemapMap>(pf::undistort_map(lens, height, width));
+        },
+        py::arg("height"),
+        py::arg("width"),
+        py::arg("fx"),
+        py::arg("fy"),
+        py::arg("cx"),
+        py::arg("cy"),
+        py::arg("k1") = 0.0,
+        py::arg("k2") = 0.0,
+        py::arg("p1") = 0.0,
+        py::arg("p2") = 0.0,
+        py::arg("k3") = 0.0,
+        "Brown-Conrady undistortion map (same camera matrix for output); cached by parameters."
+    );
+
+    m.def(
+        "undistort",
+        [](const py::array& src,
+           double fx, double fy, double cx, double cy,
+           double k1, double k2, double p1, double p2, double k3,
+           const std::string& interpolation,
+           const std::string& border,
+           uint8_t border_value,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            pf::LensModel lens;
+            lens.fx = fx; lens.fy = fy; lens.cx = cx; lens.cy = cy;
+            lens.k1 = k1; lens.k2 = k2; lens.k3 = k3; lens.p1 = p1; lens.p2 = p2;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            const pf::Interp it = parse_interp(interpolation);
+            const Border     b  = parse_border(border);
+            const Backend    be = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::undistort(in, lens, it, b, be, border_value); },
+                          [&](ImageU8& dst) { pf::undistort(in, dst, lens, it, b, be, border_value); });
+        },
+        py::arg("img"),
+        py::arg("fx"),
+        py::arg("fy"),
+        py::arg("cx"),
+        py::arg("cy"),
+        py::arg("k1") = 0.0,
+        py::arg("k2") = 0.0,
+        py::arg("p1") = 0.0,
+        py::arg("p2") = 0.0,
+        py::arg("k3") = 0.0,
+        py::arg("interpolation") = "bilinear",
+        py::arg("border") = "constant",
+        py::arg("border_value") = 0,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Remove Brown-Conrady lens distortion (k1, k2, p1, p2, k3 as in OpenCV); the map is cached."
+    );
+
+    m.def("clear_undistort_cache", &pf::clear_undistort_cache,
+          py::call_guard<py::gil_scoped_release>(),
+          "Drop all cached undistortion maps.");
+
+    // ------------------------------------------------------------
+    // 影像金字塔
+    // ------------------------------------------------------------
+    m.def(
+        "pyr_down",
+        [](const py::array& src,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::pyr_down(in, be); },
+                          [&](ImageU8& dst) { pf::pyr_down(in, dst, be); });
+        },
+        py::arg("img"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "5-tap Gaussian blur + 2x decimation; output ((h+1)//2, (w+1)//2)."
+    );
+
+    m.def(
+        "pyr_up",
+        [](const py::array& src,
+           int height,
+           int width,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::pyr_up(in, height, width, be); },
+                          [&](ImageU8& dst) {
+                              // 沒指定的軸用預設的 2n
+                              check_out_size(dst, height > 0 ? height : 2 * in.h(),
+                                             width > 0 ? width : 2 * in.w(), "pyr_up");
+                              pf::pyr_up(in, dst, be);
+                          });
+        },
+        py::arg("img"),
+        py::arg("height") = 0,
+        py::arg("width") = 0,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "2x upsample + 5-tap Gaussian blur; height/width may be 2h-1 or 2h (default 2h, 2w)."
+    );
+
+    m.def(
+        "gaussian_pyramid",
+        [](const py::array& src,
+           int levels,
+           const std::string& backend) {
+            using namespace pfpy;
+            ImageU8 in = numpy_to_imageu8_zero_copy(src);
+            Backend be = parse_backend(backend);
+            std::vector<ImageU8> pyr;
+            {
+                py::gil_scoped_release nogil;
+                pyr = pf::gaussian_pyramid(in, levels, be);
+            }
+            py::list out;
+            for (const auto& level : pyr) out.append(imageu8_to_numpy(level));
+            return out;
+        },
+        py::arg("img"),
+        py::arg("levels"),
+        py::arg("backend") = "auto",
+        "Gaussian pyramid (level 0 = copy of img); all levels share one contiguous buffer."
+    );
+
+    m.def(
+        "laplacian_pyramid",
+        [](const py::array& src,
+           int levels,
+           const std::string& backend) {
+            using namespace pfpy;
+            ImageU8 in = numpy_to_imageu8_zero_copy(src);
+            Backend be = parse_backend(backend);
+            std::vector<ImageU8> pyr;
+            {
+                py::gil_scoped_release nogil;
+                pyr = pf::laplacian_pyramid(in, levels, be);
+            }
+            py::list out;
+            for (const auto& level : pyr) out.append(imageu8_to_numpy(level));
+            return out;
+        },
+        py::arg("img"),
+        py::arg("levels"),
+        py::arg("backend") = "auto",
+        "Laplacian pyramid: band levels are G[i] - pyr_up(G[i+1]) + 128 (uint8), "
+        "the last level is the coarsest Gaussian level."
+    );
+
+    m.def(
+        "collapse_laplacian_pyramid",
+        [](const py::sequence& levels,
+           const std::string& backend,
+           const py::object& out) -> py::object {
+            using namespace pfpy;
+            std::vector<ImageU8> pyr;
+            pyr.reserve(levels.size());
+            for (const auto& item : levels) {
+                pyr.push_back(numpy_to_imageu8_zero_copy(item.cast<py::array>()));
+            }
+            Backend be  = parse_backend(backend);
+            if (out.is_none()) {
+                ImageU8 res;
+                {
+                    py::gil_scoped_release nogil;
+                    res = pf::collapse_laplacian_pyramid(pyr, be);
+                }
+                return imageu8_to_numpy(res);
+            }
+
+            // out 跟任何一層重疊就先算到暫存
+            ImageU8 dst = out_to_imageu8(out);
+            {
+                py::gil_scoped_release nogil;
+                const bool overlap = std::any_of(pyr.begin(), pyr.end(),
+                                                 [&](const ImageU8& l) { return pf::overlaps(l, dst); });
+                if (overlap) {
+                    ImageU8 tmp(dst.h(), dst.w(), dst.c(), pf::Init::None);
+                    pf::collapse_laplacian_pyramid(pyr, tmp, be);
+                    copy_pixels(tmp, dst);
+                } else {
+                    pf::collapse_laplacian_pyramid(pyr, dst, be);
+                }
+            }
+            return out;
+        },
+        py::arg("pyramid"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Reconstruct an image from laplacian_pyramid() output."
+    );
+
+    m.def(
+        "downscale_box",
+        [](const py::array& src,
+           int factor,
+           const std::string& backend,
+           const py::object& out) {
+            using namespace pfpy;
+            ImageU8 in  = numpy_to_imageu8_zero_copy(src);
+            Backend be  = parse_backend(backend);
+            return run_op(in, out, false,
+                          [&] { return pf::downscale_box(in, factor, be); },
+                          [&](ImageU8& dst) { pf::downscale_box(in, dst, factor, be); });
+        },
+        py::arg("img"),
+        py::arg("factor") = 2,
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "Integer box downscale by 2 or 4 (block average), output (h//factor, w//factor)."
+    );
+
+    // ------------------------------------------------------------
+    // 批次版本：images 是 NxHxW / NxHxWxC array（回傳疊好的 array），
+    // 或大小可以不同的影像 list（回傳 list）；平行是在影像之間
+    // ------------------------------------------------------------
+    m.def(
+        "resize_batch",
+        [](const py::object& images,
+           int new_h,
+           int new_w,
+           const std::string& backend,
+           const std::string& interpolation,
+           const py::object& out) {
+            return run_batch_py(images, out,
+                                pf::resize_op(new_h, new_w, parse_interp(interpolation)),
+                                parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("height"),
+        py::arg("width"),
+        py::arg("backend") = "auto",
+        py::arg("interpolation") = "bilinear",
+        py::arg("out") = py::none(),
+        "Resize every image of a batch (NxHxWxC array or list of images) to (height, width)."
+    );
+
+    m.def(
+        "mean_filter_batch",
+        [](const py::object& images,
+           int ksize,
+           const std::string& backend,
+           const std::string& border,
+           uint8_t border_value,
+           const py::object& out) {
+            return run_batch_py(images, out,
+                                pf::mean_filter_op(ksize, parse_border(border), border_value),
+                                parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("ksize"),
+        py::arg("backend") = "auto",
+        py::arg("border") = "reflect",
+        py::arg("border_value") = 0,
+        py::arg("out") = py::none(),
+        "mean_filter over a batch (NxHxWxC array or list of images)."
+    );
+
+    m.def(
+        "gaussian_filter_batch",
+        [](const py::object& images,
+           float sigma,
+           const std::string& backend,
+           const std::string& border,
+           uint8_t border_value,
+           const py::object& out) {
+            return run_batch_py(images, out,
+                                pf::gaussian_filter_op(sigma, parse_border(border), border_value),
+                                parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("sigma"),
+        py::arg("backend") = "auto",
+        py::arg("border") = "reflect",
+        py::arg("border_value") = 0,
+        py::arg("out") = py::none(),
+        "gaussian_filter over a batch (NxHxWxC array or list of images)."
+    );
+
+    m.def(
+        "median_filter_batch",
+        [](const py::object& images,
+           int ksize,
+           const std::string& backend,
+           const std::string& border,
+           uint8_t border_value,
+           const py::object& out) {
+            return run_batch_py(images, out,
+                                pf::median_filter_op(ksize, parse_border(border), border_value),
+                                parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("ksize"),
+        py::arg("backend") = "auto",
+        py::arg("border") = "reflect",
+        py::arg("border_value") = 0,
+        py::arg("out") = py::none(),
+        "median_filter over a batch (NxHxWxC array or list of images)."
+    );
+
+    m.def(
+        "to_grayscale_batch",
+        [](const py::object& images,
+           const std::string& backend,
+           const py::object& out) {
+            return run_batch_py(images, out, pf::to_grayscale_op(), parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "to_grayscale over a batch; an NxHxWx3 array gives an NxHxW array."
+    );
+
+    m.def(
+        "flip_horizontal_batch",
+        [](const py::object& images,
+           const std::string& backend,
+           const py::object& out) {
+            return run_batch_py(images, out, pf::flip_horizontal_op(), parse_backend(backend));
+        },
+        py::arg("images"),
+        py::arg("backend") = "auto",
+        py::arg("out") = py::none(),
+        "flip_horizontal over a batch (NxHxWxC array or list of images)."
+    );
+
+    // ------------------------------------------------------------
+    // Pipeline：一串運算整條在 C++ 裡跑（一次放掉 GIL），中間結果用兩塊 buffer 輪流放。
+    // 每個 builder 方法的參數跟同名的函式一樣（少了 img / backend / out）
+    // ------------------------------------------------------------
+    py::class_<pf::Pipeline>(m, "Pipeline",
+                             "Chain of ops run entirely in C++ with reused intermediate buffers.\n"
+                             "Build with chained calls, e.g. Pipeline().gaussian_filter(1.5).resize(240, 320);\n"
+                             "call it like a function: p(img, backend='auto', out=None).")
+        .def(py::init<>())
+        .def("mean_filter",
+             [](const py::object& self, int ksize, const std::string& border, uint8_t border_value) {
+                 return add_step(self, pf::mean_filter_op(ksize, parse_border(border), border_value));
+             },
+             py::arg("ksize"), py::arg("border") = "reflect", py::arg("border_value") = 0)
+        .def("gaussian_filter",
+             [](const py::object& self, float sigma, const std::string& border, uint8_t border_value) {
+                 return add_step(self, pf::gaussian_filter_op(sigma, parse_border(border), border_value));
+             },
+             py::arg("sigma"), py::arg("border") = "reflect", py::arg("border_value") = 0)
+        .def("median_filter",
+             [](const py::object& self, int ksize, const std::string& border, uint8_t border_value) {
+                 return add_step(self, pf::median_filter_op(ksize, parse_border(border), border_value));
+             },
+             py::arg("ksize"), py::arg("border") = "reflect", py::arg("border_value") = 0)
+        .def("bilateral_filter",
+             [](const py::object& self, int ksize, float sigma_color, float sigma_space,
+                const std::string& border, uint8_t border_value) {
+                 return add_step(self, pf::bilateral_filter_op(ksize, sigma_color, sigma_space,
+                                                               parse_border(border), border_value));
+             },
+             py::arg("ksize"), py::arg("sigma_color"), py::arg("sigma_space"),
+             py::arg("border") = "reflect", py::arg("border_value") = 0)
+        .def("to_grayscale",
+             [](const py::object& self) { return add_step(self, pf::to_grayscale_op()); })
+        .def("invert",
+             [](const py::object& self) { return add_step(self, pf::invert_op()); })
+        .def("sepia",
+             [](const py::object& self) { return add_step(self, pf::sepia_op()); })
+        .def("adjust_brightness_contrast",
+             [](const py::object& self, float alpha, float beta) {
+                 return add_step(self, pf::adjust_brightness_contrast_op(alpha, beta));
+             },
+             py::arg("alpha"), py::arg("beta"))
+        .def("gamma_correct",
+             [](const py::object& self, float gamma) {
+                 return add_step(self, pf::gamma_correct_op(gamma));
+             },
+             py::arg("gamma"))
+        .def("sharpen",
+             [](const py::object& self, float amount) { return add_step(self, pf::sharpen_op(amount)); },
+             py::arg("amount") = 1.0f)
+        .def("emboss",
+             [](const py::object& self, float strength) { return add_step(self, pf::emboss_op(strength)); },
+             py::arg("strength") = 1.0f)
+        .def("cartoonize",
+             [](const py::object& self, float sigma_space, uint8_t edge_threshold) {
+                 return add_step(self, pf::cartoonize_op(sigma_space, edge_threshold));
+             },
+             py::arg("sigma_space") = 2.0f, py::arg("edge_threshold") = 40)
+        .def("resize",
+             [](const py::object& self, int new_h, int new_w, const std::string& interpolation) {
+                 return add_step(self, pf::resize_op(new_h, new_w, parse_interp(interpolation)));
+             },
+             py::arg("height"), py::arg("width"), py::arg("interpolation") = "bilinear")
+        .def("flip_horizontal",
+             [](const py::object& self) { return add_step(self, pf::flip_horizontal_op()); })
+        .def("flip_vertical",
+             [](const py::object& self) { return add_step(self, pf::flip_vertical_op()); })
+        .def("rotate",
+             [](const py::object& self, float angle_deg) { return add_step(self, pf::rotate_op(angle_deg)); },
+             py::arg("angle_deg"))
+        .def("rotate90",
+             [](const py::object& self) { return add_step(self, pf::rotate90_op()); })
+        .def("rotate180",
+             [](const py::object& self) { return add_step(self, pf::rotate180_op()); })
+        .def("rotate270",
+             [](const py::object& self) { return add_step(self, pf::rotate270_op()); })
+        .def("transpose",
+             [](const py::object& self) { return add_step(self, pf::transpose_op()); })
+        .def("crop",
+             [](const py::object& self, int y, int x, int h, int w) {
+                 return add_step(self, pf::crop_op(y, x, h, w));
+             },
+             py::arg("y"), py::arg("x"), py::arg("height"), py::arg("width"))
+        .def("pyr_down",
+             [](const py::object& self) { return add_step(self, pf::pyr_down_op()); })
+        .def("downscale_box",
+             [](const py::object& self, int factor) { return add_step(self, pf::downscale_box_op(factor)); },
+             py::arg("factor") = 2)
+        .def("__call__",
+             [](pf::Pipeline& p, const py::array& src, const std::string& backend, const py::object& out) {
+                 ImageU8 in = numpy_to_imageu8_zero_copy(src);
+                 Backend be = parse_backend(backend);
+                 return run_op(in, out, p.allows_in_place(),
+                               [&] { return p.run(in, be); },
+                               [&](ImageU8& dst) { p.run(in, dst, be); });
+             },
+             py::arg("img"),
+             py::arg("backend") = "auto",
+             py::arg("out") = py::none(),
+             "Run every step on img. Once the input size has been seen no buffers are allocated: with out= "
+             "the result goes there; otherwise the pipeline keeps two output buffers and reuses one after the "
+             "caller has dropped every reference to it (a result you still hold is never overwritten).")
+        .def("output_shape",
+             [](const pf::Pipeline& p, int h, int w, int c) {
+                 const pf::ImageShape s = p.output_shape({h, w, c});
+                 return py::make_tuple(s.h, s.w, s.c);
+             },
+             py::arg("height"), py::arg("width"), py::arg("channels") = 3,
+             "Output (height, width, channels) for an input of the given size; raises if a step cannot handle it.")
+        .def_property_readonly("steps",
+             [](const pf::Pipeline& p) {
+                 py::list names;
+                 for (const pf::ImageOp& op : p.steps()) names.append(py::str(op.name));
+                 return names;
+             })
+        .def_property_readonly("buffer_bytes", &pf::Pipeline::buffer_bytes)
+        .def("__len__", &pf::Pipeline::size);
+
+    // ---- 串流（out-of-core）：影像一段一段讀、處理、寫，不必整張放進記憶體 ----
+    m.def(
+        "process_stream",
+        [](const std::string& src, const std::string& dst, const py::object& pipeline, int strip_rows,
+           const std::string& backend, int compression, const std::string& png_filter) {
+            std::vector<pf::ImageOp> ops;
+            if (!pipeline.is_none()) ops = pipeline.cast<const pf::Pipeline&>().steps();
+            const Backend be = parse_backend(backend);
+            const pf::EncodeOptions options = encode_options_from_python(95, "auto", compression, png_filter);
+            pf::StreamStats stats;
+            {
+                py::gil_scoped_release nogil;
+                stats = pf::process_stream(src, dst, ops, strip_rows, options, be);
+            }
+            return stream_stats_to_dict(stats);
+        },
+        py::arg("src"), py::arg("dst"), py::arg("pipeline") = py::none(), py::arg("strip_rows") = 256,
+        py::arg("backend") = "auto", py::kw_only(),
+        py::arg("compression") = 6, py::arg("png_filter") = "adaptive",
+        "Run a Pipeline of pointwise / stencil steps over src strip by strip and encode the result into dst "
+        "as it is produced (.png, .ppm / .pgm or .pft in and out). Memory is about strip_rows x width x steps "
+        "regardless of the image height; results equal running the pipeline on the whole image. "
+        "Returns {'rows', 'strips', 'buffer_bytes'}.");
+
+    py::class_<StripReaderPy>(m, "StripReader",
+                              "Iterate an image (.png, .ppm / .pgm or .pft) from top to bottom as arrays "
+                              "of up to strip_rows rows without decoding the whole image.")
+        .def(py::init([](const std::string& path, int strip_rows) {
+                 if (strip_rows <= 0) throw std::invalid_argument("StripReader: strip_rows must be > 0");
+                 auto r = std::make_unique<StripReaderPy>();
+                 r->src = pf::open_strip_source(path);
+                 r->strip_rows = strip_rows;
+                 return r;
+             }),
+             py::arg("path"), py::arg("strip_rows") = 256)
+        .def_property_readonly("shape", [](const StripReaderPy& r) { return shape_to_python(r.src->shape()); })
+        .def_property_readonly("rows_read", [](const StripReaderPy& r) { return r.rows_read; })
+        .def("__iter__", [](const py::object& self) { return self; })
+        .def("__next__",
+             [](StripReaderPy& r) {
+                 const pf::ImageShape s = r.src->shape();
+                 const long long left = s.h - r.rows_read;
+                 if (left <= 0) throw py::stop_iteration();
+                 // 每段一塊新的 buffer：交出去的 array 之後不會被下一段蓋掉
+                 ImageU8 strip(static_cast<int>(std::min<long long>(r.strip_rows, left)), s.w, s.c, pf::Init::None);
+                 int n = 0;
+                 {
+                     py::gil_scoped_release nogil;
+                     n = r.src->read(strip);
+                 }
+                 if (n <= 0) throw std::runtime_error("StripReader: source ended early");
+                 r.rows_read += n;
+                 return imageu8_to_numpy(strip.view(0, 0, n, s.w));
+             });
+
+    py::class_<pf::StripSink>(m, "StripWriter",
+                              "Encode an image from top to bottom: write() arrays of whole rows "
+                              "(.png, .ppm / .pgm or .pft); close() checks that every row was written.")
+        .def(py::init([](const std::string& path, int height, int width, int channels, int compression,
+                         const std::string& png_filter) {
+                 return pf::open_strip_sink(path, {height, width, channels},
+                                            encode_options_from_python(95, "auto", compression, png_filter));
+             }),
+             py::arg("path"), py::arg("height"), py::arg("width"), py::arg("channels") = 3, py::kw_only(),
+             py::arg("compression") = 6, py::arg("png_filter") = "adaptive")
+        .def("write",
+             [](pf::StripSink& w, const py::array& rows) {
+                 ImageU8 r = numpy_to_imageu8_zero_copy(rows);
+                 py::gil_scoped_release nogil;
+                 w.write(r);
+             },
+             py::arg("rows"))
+        .def("close", &pf::StripSink::close, py::call_guard<py::gil_scoped_release>())
+        .def("__enter__", [](const py::object& self) { return self; })
+        .def("__exit__",
+             [](pf::StripSink& w, const py::object& exc_type, const py::object&, const py::object&) {
+                 // with 區塊裡已經丟了例外：不要用「row 不夠」蓋掉原本的錯誤
+                 const bool failing = !exc_type.is_none();
+                 py::gil_scoped_release nogil;
+                 try {
+                     w.close();
+                 } catch (...) {
+                     if (!failing) throw;
+                 }
+             });
+
+    // ------------------------------------------------------------
+    // Auto backend 成本模型
+    // ------------------------------------------------------------
+    m.def(
+        "calibrate_auto",
+        [](const std::string& cache_path) {
+            pf::TuneParams p;
+            {
+                // 校正要跑上百毫秒，期間不擋其他 Python thread
+                py::gil_scoped_release nogil;
+                p = pf::calibrate_auto(cache_path);
+            }
+            return tune_params_to_dict(p);
+        },
+        py::arg("cache_path") = "",
+        "Run the built-in tuner for backend='auto'; optionally save the result to cache_path."
+    );
+
+    m.def(
+        "get_auto_params",
+        []() { return tune_params_to_dict(pf::autotune_params()); },
+        "Return the cost-model parameters currently used by backend='auto'."
+    );
+
+    m.def("load_auto_cache", &pf::load_autotune_cache,
+          py::arg("path"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Load cost-model parameters from a cache file; returns False if missing/invalid.");
+
+    m.def("save_auto_cache", &pf::save_autotune_cache,
+          py::arg("path"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Save the current cost-model parameters to a cache file.");
+
+    // ---- buffer pool ----
+    m.def(
+        "enable_buffer_pool",
+        [](bool enabled, const py::object& max_bytes) {
+            if (!max_bytes.is_none()) pf::set_buffer_pool_limit(max_bytes.cast<std::size_t>());
+            pf::enable_buffer_pool(enabled);
+        },
+        py::arg("enabled") = true,
+        py::arg("max_bytes") = py::none(),
+        "Reuse image / scratch buffers through a size-bucketed pool; max_bytes caps the idle memory kept."
+    );
+
+    m.def("set_buffer_pool_limit", &pf::set_buffer_pool_limit,
+          py::arg("max_bytes"),
+          "Set the cap on idle bytes kept by the buffer pool (trims immediately if above).");
+
+    m.def("trim_buffer_pool", &pf::trim_buffer_pool,
+          py::arg("keep_bytes") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Release idle pooled buffers down to keep_bytes; returns the number of bytes freed.");
+
+    m.def(
+        "buffer_pool_stats",
+        []() { return pool_stats_to_dict(pf::buffer_pool_stats()); },
+        "Return buffer pool counters (hits, misses, evictions, cached / in-use bytes)."
+    );
+
+    // ---- concurrency governor ----
+    m.def(
+        "set_max_threads",
+        [](const py::object& n) { pf::set_max_threads(n.is_none() ? 0 : n.cast<int>()); },
+        py::arg("n"),
+        "Cap the threads all PixFoundry calls share process-wide; None or <= 0 restores the default "
+        "(PF_MAX_THREADS, else CPUs allowed by affinity and cgroup quota)."
+    );
+
+    m.def("get_max_threads", &pf::max_threads,
+          "Return the current process-wide thread budget.");
+
+    m.def(
+        "concurrency_stats",
+        []() { return concurrency_stats_to_dict(pf::concurrency_stats()); },
+        "Return governor counters: budget, in-flight calls, and how many calls ran parallel / throttled / serial."
+    );
+
+    m.def("reset_concurrency_stats", &pf::reset_concurrency_stats,
+          "Reset the call counters returned by concurrency_stats().");
+
+    // ---- NUMA ----
+    m.def(
+        "numa_info",
+        []() {
+            const pf::NumaInfo info = pf::numa_info();
+            py::list per_node;
+            for (int n : info.cpus_per_node) per_node.append(py::int_(n));
+            py::dict d;
+            d["nodes"]         = info.cpus_per_node.size();
+            d["cpus_per_node"] = per_node;
+            d["numa_aware"]    = info.numa_aware;
+            d["pinned"]        = info.pinned;
+            return d;
+        },
+        "Return the NUMA layout seen by this process and whether NUMA-aware scheduling / pinning are on."
+    );
+
+    m.def("set_numa_aware", &pf::set_numa_aware,
+          py::arg("enabled"),
+          "Give each OpenMP thread a fixed contiguous row range (and zero large buffers the same way) "
+          "so pages are first-touched by the thread that writes them; default on when >1 NUMA node.");
+
+    m.def("set_thread_pinning", &pf::set_thread_pinning,
+          py::arg("enabled"),
+          "Pin OpenMP worker threads to CPUs ordered node by node. Each concurrent top-level call "
+          "gets its own disjoint range of CPUs (the calling thread and ThreadPool workers are left alone).");
+
+#if defined(PF_HAS_OPENMP) && defined(__linux__)
+    // 測 pinning 用：跑一個 threads 條的 OpenMP 頂層呼叫（每塊停 hold_ms，讓同時的呼叫重疊），
+    // 回傳 team 裡被綁到單一 CPU 的 thread 用的 CPU
+    m.def("_debug_pinned_cpus", [](int threads, int hold_ms) {
+        std::vector<int> cpus;
+        std::mutex mutex;
+        {
+            py::gil_scoped_release release;
+            pf::ExecPlan plan{Backend::OpenMP, threads};
+            pf::ThreadScope scope(plan);
+            pf::parallel_rows(4 * std::max(1, threads), plan.backend, 1, [&](int, int) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) == 1) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (int c = 0; c < CPU_SETSIZE; ++c)
+                        if (CPU_ISSET(c, &set)) cpus.push_back(c);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(hold_ms));
+            });
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        py::list out;
+        for (int c : cpus) out.append(py::int_(c));
+        return out;
+    }, py::arg("threads"), py::arg("hold_ms") = 20);
+#endif
+
     // arr (numpy) -> ImageU8 (zero-copy) -> numpy (zero-copy)
     m.def("_debug_zerocopy_roundtrip_u8", [](py::array arr) {
         // 你已經有這兩個 helper：numpy_to_imageu8_zero_copy / imageu8_to_numpy
@@ -0,0 +1,299 @@
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef PF_HAS_OPENMP
+#include <omp.h>
+#endif
+
+namespace pf {
+
+// ============================================================
+// 全域參數（第一次使用 Auto 時初始化）
+// ============================================================
+
+static std::mutex      g_tune_mutex;
+static TuneParams      g_tune;
+static std::once_flag  g_tune_once;
+
+// Auto 最多用幾條：governor 的預算（已考慮 cgroup 配額與 set_max_threads）
+static int hw_max_threads() {
+#ifdef PF_HAS_OPENMP
+    return max_threads();
+#else
+    return 1;
+#endif
+}
+
+// 取 reps 次中最快的一次（ns）
+template <typename F>
+static double best_time_ns(F&& f, int reps) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        best = std::min(best, ns);
+    }
+    return best;
+}
+
+// ============================================================
+// 內建 tuner
+// ============================================================
+
+static TuneParams run_calibration() {
+    TuneParams p;
+    p.max_threads = hw_max_threads();
+
+    // 1) 記憶體：4 MB 的 invert（讀 1 byte + 寫 1 byte）
+    const std::size_t n_mem = std::size_t(4) << 20;
+    std::vector<uint8_t> a(n_mem, 1), b(n_mem);
+    volatile uint8_t sink = 0;
+
+    auto mem_pass = [&]() {
+        const uint8_t* in = a.data();
+        uint8_t* out = b.data();
+        for (std::size_t i = 0; i < n_mem; ++i) out[i] = static_cast<uint8_t>(255 - in[i]);
+        sink = sink + out[n_mem / 2];
+    };
+    const double t_mem = best_time_ns(mem_pass, 5);
+    p.ns_per_byte = std::max(1e-4, t_mem / (2.0 * static_cast<double>(n_mem)));
+
+    // 2) 算術：跟 kernel 同樣寫法的 alpha * v + beta → round → clamp（算 4 ops）
+    //    buffer 放得進 L1，量到的是純運算成本
+    const std::size_t n_op = 16384;
+    auto op_pass = [&]() {
+        const uint8_t* in = a.data();
+        uint8_t* out = b.data();
+        for (std::size_t i = 0; i < n_op; ++i) {
+            float v = 1.2f * static_cast<float>(in[i]) + 3.0f;
+            v = std::clamp(std::round(v), 0.0f, 255.0f);
+            out[i] = static_cast<uint8_t>(v);
+        }
+        sink = sink + out[n_op / 3];
+    };
+    const double t_op = best_time_ns(op_pass, 9);
+    p.ns_per_op = std::max(1e-4, t_op / (4.0 * static_cast<double>(n_op)));
+
+#ifdef PF_HAS_OPENMP
+    const int T = p.max_threads;
+    if (T >= 2) {
+        // 3) fork/join：空的 parallel region，擬合 a + b*T
+        auto fork_cost = [&](int nt) {
+            const int loops = 64;
+            double t = best_time_ns([&]() {
+                for (int i = 0; i < loops; ++i) {
+                    #pragma omp parallel num_threads(nt)
+                    {
+                        if (omp_get_thread_num() == nt) sink = 0;
+                    }
+                }
+            }, 3);
+            return t / loops;
+        };
+        (void)fork_cost(T);  // 先把 thread team 叫醒
+        const double f2 = fork_cost(2);
+        const double fT = fork_cost(T);
+        if (T > 2) {
+            p.fork_ns_per_thread = std::max(0.0, (fT - f2) / (T - 2));
+            p.fork_ns = std::max(0.0, f2 - 2.0 * p.fork_ns_per_thread);
+        } else {
+            p.fork_ns_per_thread = 0.0;
+            p.fork_ns = f2;
+        }
+
+        // 4) 記憶體頻寬可放大幾倍：同一個 4 MB invert 用整個 team 跑
+        const std::int64_t n64 = static_cast<std::int64_t>(n_mem);
+        const double t_par = best_time_ns([&]() {
+            const uint8_t* in = a.data();
+            uint8_t* out = b.data();
+            #pragma omp parallel for num_threads(T) schedule(static)
+            for (std::int64_t i = 0; i < n64; ++i) out[i] = static_cast<uint8_t>(255 - in[i]);
+        }, 5);
+        const double work = std::max(1.0, t_par - (p.fork_ns + p.fork_ns_per_thread * T));
+        p.mem_scaling = std::clamp(t_mem / work, 1.0, static_cast<double>(T));
+    }
+#endif
+
+    p.calibrated = true;
+    return p;
+}
+
+// cache 檔：簡單的 "key value" 文字格式
+static bool read_cache_file(const std::string& path, TuneParams& p) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    int fields = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string key;
+        double v = 0.0;
+        if (!(ss >> key >> v)) continue;
+        if      (key == "ns_per_byte")        { p.ns_per_byte = v;        ++fields; }
+        else if (key == "ns_per_op")          { p.ns_per_op = v;          ++fields; }
+        else if (key == "fork_ns")            { p.fork_ns = v;            ++fields; }
+        else if (key == "fork_ns_per_thread") { p.fork_ns_per_thread = v; ++fields; }
+        else if (key == "mem_scaling")        { p.mem_scaling = v;        ++fields; }
+        else if (key == "max_threads")        { p.max_threads = static_cast<int>(v); ++fields; }
+    }
+    p.calibrated = true;
+    return fields >= 6;
+}
+
+static void write_cache_file(const std::string& path, const TuneParams& p) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("autotune: failed to write cache " + path);
+    out << "ns_per_byte "        << p.ns_per_byte        << "\n"
+        << "ns_per_op "          << p.ns_per_op          << "\n"
+        << "fork_ns "            << p.fork_ns            << "\n"
+        << "fork_ns_per_thread " << p.fork_ns_per_thread << "\n"
+        << "mem_scaling "        << p.mem_scaling        << "\n"
+        << "max_threads "        << p.max_threads        << "\n";
+}
+
+static void store_params(const TuneParams& p) {
+    std::lock_guard<std::mutex> lock(g_tune_mutex);
+    g_tune = p;
+    g_tune.max_threads = std::clamp(g_tune.max_threads, 1, hw_max_threads());
+}
+
+static void ensure_initialized() {
+    std::call_once(g_tune_once, []() {
+        // 有設定 PF_AUTOTUNE_CACHE 就先試著讀，讀不到才校正並寫回
+        const char* env = std::getenv("PF_AUTOTUNE_CACHE");
+        const std::string path = env ? env : "";
+
+        TuneParams p;
+        if (!path.empty() && read_cache_file(path, p)) {
+            store_params(p);
+            return;
+        }
+
+        p = run_calibration();
+        store_params(p);
+        if (!path.empty()) {
+            try { write_cache_file(path, p); } catch (const std::exception&) {}
+        }
+    });
+}
+
+TuneParams autotune_params() {
+    ensure_initialized();
+    std::lock_guard<std::mutex> lock(g_tune_mutex);
+    return g_tune;
+}
+
+void set_autotune_params(const TuneParams& p) {
+    std::call_once(g_tune_once, []() {});  // 使用者自己給就不必再校正
+    store_params(p);
+}
+
+TuneParams calibrate_auto(const std::string& cache_path) {
+    set_autotune_params(run_calibration());
+    if (!cache_path.empty()) save_autotune_cache(cache_path);
+    return autotune_params();
+}
+
+bool load_autotune_cache(const std::string& path) {
+    TuneParams p;
+    if (!read_cache_file(path, p)) return false;
+    set_autotune_params(p);
+    return true;
+}
+
+void save_autotune_cache(const std::string& path) {
+    write_cache_file(path, autotune_params());
+}
+
+// ============================================================
+// 成本模型
+// ============================================================
+
+ExecPlan plan_execution(Backend requested, const OpCost& cost, std::size_t elems) {
+    requested = normalize_backend(requested);
+
+    if (requested != Backend::Auto) {
+        return {requested, 0};
+    }
+
+#ifndef PF_HAS_OPENMP
+    (void)cost;
+    (void)elems;
+    return {Backend::Single, 0};
+#else
+    TuneParams p = autotune_params();
+    p.max_threads = std::min(p.max_threads, hw_max_threads());  // 預算可能在校正後被調低
+    if (p.max_threads < 2) return {Backend::Single, 0};
+
+    const double n   = static_cast<double>(elems);
+    const double mem = n * cost.bytes_per_elem * p.ns_per_byte;
+    const double cpu = n * cost.ops_per_elem * p.ns_per_op;
+    const double serial = mem + cpu;
+
+    double best_t = serial;
+    int    best_n = 1;
+
+    // 候選：2, 4, 8, ... 以及 max_threads
+    std::vector<int> cands;
+    for (int t = 2; t < p.max_threads; t *= 2) cands.push_back(t);
+    cands.push_back(p.max_threads);
+
+    for (int t : cands) {
+        const double fork = cost.regions * (p.fork_ns + p.fork_ns_per_thread * t);
+        const double par = fork
+                         + cpu / t
+                         + mem / std::min(static_cast<double>(t), p.mem_scaling);
+        // 要明顯比較快才換（避免量測雜訊造成抖動）
+        if (par < best_t * 0.9) {
+            best_t = par;
+            best_n = t;
+        }
+    }
+
+    if (best_n == 1) return {Backend::Single, 0};
+    return {Backend::OpenMP, best_n};
+#endif
+}
+
+ExecPlan plan_execution(Backend requested, const OpCost& cost, const ImageU8& img) {
+    const std::size_t elems = img.empty()
+        ? 0
+        : static_cast<std::size_t>(img.h()) * img.w() * img.c();
+    return plan_execution(requested, cost, elems);
+}
+
+// ============================================================
+// ThreadScope
+// ============================================================
+
+ThreadScope::ThreadScope(ExecPlan& plan) : top_level_(enter_call(plan)) {
+#ifdef PF_HAS_OPENMP
+    if (plan.backend == Backend::OpenMP && plan.threads > 0) {
+        saved_ = omp_get_max_threads();
+        omp_set_num_threads(plan.threads);
+    }
+#endif
+}
+
+ThreadScope::~ThreadScope() {
+#ifdef PF_HAS_OPENMP
+    if (saved_ > 0) omp_set_num_threads(saved_);
+#endif
+    leave_call(top_level_);
+}
+
+} // namespace pf
@@ -0,0 +1,151 @@
+#include "pixfoundry/batch.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef PF_HAS_OPENMP
+#include <omp.h>
+#endif
+
+namespace pf {
+
+static std::size_t elems_of(const ImageU8& img) {
+    return static_cast<std::size_t>(img.h()) * img.w() * img.c();
+}
+
+// ======================
+//  排程
+// ======================
+
+// 由大到小的處理順序（一樣大時照原本順序）：
+// 大圖先開始，最後剩下的都是小圖，thread 之間的結束時間差不多
+static std::vector<std::size_t> largest_first(const std::vector<ImageU8>& srcs,
+                                              const std::vector<ImageU8>& dsts) {
+    std::vector<std::size_t> order(srcs.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return std::max(elems_of(srcs[a]), elems_of(dsts[a])) >
+               std::max(elems_of(srcs[b]), elems_of(dsts[b]));
+    });
+    return order;
+}
+
+// 影像之間平行：每張影像內部用 Single，不會有巢狀的 parallel region
+static void run_across_images(const std::vector<ImageU8>& srcs,
+                              std::vector<ImageU8>& dsts,
+                              const ImageOp& op,
+                              const std::vector<std::size_t>& order) {
+    const long n = static_cast<long>(order.size());
+    std::exception_ptr error;
+
+#ifdef PF_HAS_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long k = 0; k < n; ++k) {
+        const std::size_t i = order[k];
+        try {
+            op.run(srcs[i], dsts[i], Backend::Single);
+        } catch (...) {
+            // 例外不能穿出 parallel region：記下第一個，做完再丟
+#ifdef PF_HAS_OPENMP
+#pragma omp critical(pf_batch_error)
+#endif
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+// ThreadPool：一張影像是 pool 裡的一塊工作，每張內部也用 ThreadPool（巢狀）；
+// 做完小圖的 thread 會去偷大圖裡還沒做的 band，不用等最後那張大圖，也不用管張數夠不夠分
+static void run_across_images_pool(const std::vector<ImageU8>& srcs,
+                                   std::vector<ImageU8>& dsts,
+                                   const ImageOp& op,
+                                   const std::vector<std::size_t>& order) {
+    ThreadPool::instance().parallel_for(0, static_cast<long>(order.size()), 1, [&](long k0, long k1) {
+        for (long k = k0; k < k1; ++k) {
+            const std::size_t i = order[k];
+            op.run(srcs[i], dsts[i], Backend::ThreadPool);
+        }
+    });
+}
+
+void run_batch(const std::vector<ImageU8>& srcs,
+               std::vector<ImageU8>& dsts,
+               const ImageOp& op,
+               Backend backend) {
+    if (srcs.size() != dsts.size()) {
+        throw std::invalid_argument("run_batch: srcs and dsts must have the same length");
+    }
+
+    // 先在呼叫端的 thread 把每張都檢查完，平行的部分只剩計算
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < srcs.size(); ++i) {
+        const ImageU8& src = srcs[i];
+        if (src.empty()) {
+            throw std::invalid_argument("run_batch: image " + std::to_string(i) + " is empty");
+        }
+        const ImageShape shape = op.output_shape(shape_of(src));
+        check_output(dsts[i], shape.h, shape.w, shape.c, "run_batch");
+        total += std::max(elems_of(src), elems_of(dsts[i]));
+    }
+    if (srcs.empty()) return;
+
+    // 整批當成一個 region 的工作量來估
+    const OpCost cost{op.cost.bytes_per_elem, op.cost.ops_per_elem, 1};
+    ExecPlan plan = plan_execution(backend, cost, total);
+    // 整批算一次頂層呼叫：每張各自的運算沿用這裡分到的 thread，不再另外報到
+    ThreadScope threads(plan);
+
+    if (plan.backend == Backend::ThreadPool && srcs.size() > 1) {
+        run_across_images_pool(srcs, dsts, op, largest_first(srcs, dsts));
+        return;
+    }
+
+    if (plan.backend != Backend::OpenMP || srcs.size() == 1) {
+        // 只有一張：交給單張版本自己決定要不要平行
+        const Backend per_image = (srcs.size() == 1) ? backend : Backend::Single;
+        for (std::size_t i = 0; i < srcs.size(); ++i) op.run(srcs[i], dsts[i], per_image);
+        return;
+    }
+
+#ifdef PF_HAS_OPENMP
+    const int team = plan.threads > 0 ? plan.threads : omp_get_max_threads();
+#else
+    const int team = 1;
+#endif
+
+    if (srcs.size() < static_cast<std::size_t>(team)) {
+        // 張數不夠分給每條 thread：一張一張做，每張內部平行
+        const std::vector<std::size_t> order = largest_first(srcs, dsts);
+        for (std::size_t i : order) op.run(srcs[i], dsts[i], backend);
+        return;
+    }
+
+    run_across_images(srcs, dsts, op, largest_first(srcs, dsts));
+}
+
+std::vector<ImageU8> run_batch(const std::vector<ImageU8>& srcs,
+                               const ImageOp& op,
+                               Backend backend) {
+    std::vector<ImageU8> dsts;
+    dsts.reserve(srcs.size());
+    for (std::size_t i = 0; i < srcs.size(); ++i) {
+        if (srcs[i].empty()) {
+            throw std::invalid_argument("run_batch: image " + std::to_string(i) + " is empty");
+        }
+        const ImageShape shape = op.output_shape(shape_of(srcs[i]));
+        dsts.emplace_back(shape.h, shape.w, shape.c, Init::None);
+    }
+    run_batch(srcs, dsts, op, backend);
+    return dsts;
+}
+
+} // namespace pf
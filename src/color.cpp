@@ -1,7 +1,10 @@
 #include "pixfoundry/color.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
 
 namespace pf {
@@ -12,39 +15,24 @@ static inline std::size_t idx(int y, int x, int c,
 }
 
 // =========================
-//   single-thread 版本實作
+//   row band kernel：處理 [y0, y1) 這幾個 row
+//   Single 一次做整張；OpenMP / ThreadPool 由 parallel_rows 切 band 分給各 thread
 // =========================
 
-static ImageU8 to_grayscale_single(const ImageU8& src) {
-    if (src.empty()) {
-        throw std::invalid_argument("to_grayscale: empty image");
-    }
-
-    const int H = src.h();
+static void to_grayscale_rows(const ImageU8& src, ImageU8& dst, int y0, int y1) {
     const int W = src.w();
     const int C = src.c();
 
-    const uint8_t* in = src.data();
-
-    if (C == 1) {
-        // 已經是灰階，手動複製一份（避免呼叫被 delete 的 copy ctor）
-        ImageU8 dst(H, W, 1);
-        uint8_t* out = dst.data();
-        const std::size_t total = static_cast<std::size_t>(H) * W;
-        std::copy(in, in + total, out);
-        return dst;
-    }
-
-    ImageU8 dst(H, W, 1);
     uint8_t* out = dst.data();
 
     constexpr float wr = 0.299f;
     constexpr float wg = 0.587f;
     constexpr float wb = 0.114f;
 
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* in = src.row(y);
         for (int x = 0; x < W; ++x) {
-            std::size_t base = idx(y, x, 0, W, C);
+            std::size_t base = static_cast<std::size_t>(x) * C;
             uint8_t r = in[base + 0];
             uint8_t g = in[base + 1];
             uint8_t b = in[base + 2];
@@ -52,94 +40,36 @@ static ImageU8 to_grayscale_single(const ImageU8& src) {
             float v = wr * r + wg * g + wb * b;
             v = std::round(v);
             v = std::clamp(v, 0.0f, 255.0f);
-            out[y * W + x] = static_cast<uint8_t>(v);
+            out[static_cast<std::size_t>(y) * W + x] = static_cast<uint8_t>(v);
         }
     }
-
-    return dst;
 }
 
-static ImageU8 to_grayscale_openmp(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("to_grayscale: empty image");
-
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-
-    if (C == 1) {
-        ImageU8 dst(H, W, 1);
-        std::copy(in, in + static_cast<std::size_t>(H) * W, dst.data());
-        return dst;
-    }
-
-    ImageU8 dst(H, W, 1);
-    uint8_t* out = dst.data();
-
-    constexpr float wr = 0.299f, wg = 0.587f, wb = 0.114f;
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            const std::size_t base = idx(y, x, 0, W, C);
-            const uint8_t r = in[base + 0];
-            const uint8_t g = in[base + 1];
-            const uint8_t b = in[base + 2];
-
-            float v = wr * r + wg * g + wb * b;
-            v = std::round(v);
-            v = std::clamp(v, 0.0f, 255.0f);
-            out[y * W + x] = static_cast<uint8_t>(v);
+static void invert_rows(const ImageU8& src, ImageU8& dst, int y0, int y1) {
+    const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* in = src.row(y);
+        uint8_t* out = dst.row(y);
+        for (std::size_t i = 0; i < row_len; ++i) {
+            out[i] = static_cast<uint8_t>(255 - in[i]);
         }
     }
-    return dst;
 }
 
-static ImageU8 invert_single(const ImageU8& src) {
-    if (src.empty()) {
-        throw std::invalid_argument("invert: empty image");
-    }
-
-    const int H = src.h();
+static void sepia_rows(const ImageU8& src, ImageU8& dst, int y0, int y1) {
     const int W = src.w();
-    const int C = src.c();
 
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
     uint8_t* out = dst.data();
 
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-    for (std::size_t i = 0; i < total; ++i) {
-        out[i] = static_cast<uint8_t>(255 - in[i]);
-    }
-
-    return dst;
-}
-
-static ImageU8 sepia_single(const ImageU8& src) {
-    if (src.empty()) {
-        throw std::invalid_argument("sepia: empty image");
-    }
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-
-    if (C != 3) {
-        throw std::invalid_argument("sepia: expects 3-channel RGB image");
-    }
-
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, 3);
-    uint8_t* out = dst.data();
-
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* in = src.row(y);
         for (int x = 0; x < W; ++x) {
-            std::size_t base = idx(y, x, 0, W, 3);
+            const std::size_t xb = static_cast<std::size_t>(x) * 3;
+            const std::size_t base = idx(y, x, 0, W, 3);
 
-            float r = static_cast<float>(in[base + 0]);
-            float g = static_cast<float>(in[base + 1]);
-            float b = static_cast<float>(in[base + 2]);
+            float r = static_cast<float>(in[xb + 0]);
+            float g = static_cast<float>(in[xb + 1]);
+            float b = static_cast<float>(in[xb + 2]);
 
             float tr = 0.393f * r + 0.769f * g + 0.189f * b;
             float tg = 0.349f * r + 0.686f * g + 0.168f * b;
@@ -154,255 +84,170 @@ static ImageU8 sepia_single(const ImageU8& src) {
             out[base + 2] = static_cast<uint8_t>(tb);
         }
     }
-
-    return dst;
 }
 
-static ImageU8 sepia_openmp(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("sepia: empty image");
-    if (src.c() != 3) throw std::invalid_argument("sepia: expects 3-channel RGB image");
-
-    const int H = src.h(), W = src.w();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, 3);
-    uint8_t* out = dst.data();
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            std::size_t base = idx(y, x, 0, W, 3);
-
-            float r = static_cast<float>(in[base + 0]);
-            float g = static_cast<float>(in[base + 1]);
-            float b = static_cast<float>(in[base + 2]);
-
-            float tr = 0.393f * r + 0.769f * g + 0.189f * b;
-            float tg = 0.349f * r + 0.686f * g + 0.168f * b;
-            float tb = 0.272f * r + 0.534f * g + 0.131f * b;
-
-            tr = std::clamp(std::round(tr), 0.0f, 255.0f);
-            tg = std::clamp(std::round(tg), 0.0f, 255.0f);
-            tb = std::clamp(std::round(tb), 0.0f, 255.0f);
-
-            out[base + 0] = static_cast<uint8_t>(tr);
-            out[base + 1] = static_cast<uint8_t>(tg);
-            out[base + 2] = static_cast<uint8_t>(tb);
+static void adjust_brightness_contrast_rows(const ImageU8& src, ImageU8& dst,
+                                            float alpha, float beta,
+                                            int y0, int y1) {
+    const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* in = src.row(y);
+        uint8_t* out = dst.row(y);
+        for (std::size_t i = 0; i < row_len; ++i) {
+            float v = alpha * static_cast<float>(in[i]) + beta;
+            v = std::clamp(std::round(v), 0.0f, 255.0f);
+            out[i] = static_cast<uint8_t>(v);
         }
     }
-    return dst;
 }
 
-static ImageU8 adjust_brightness_contrast_single(const ImageU8& src,
-                                                 float alpha,
-                                                 float beta) {
-    if (src.empty()) {
-        throw std::invalid_argument("adjust_brightness_contrast: empty image");
-    }
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
-
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-    for (std::size_t i = 0; i < total; ++i) {
-        float v = alpha * static_cast<float>(in[i]) + beta;
-        v = std::clamp(std::round(v), 0.0f, 255.0f);
-        out[i] = static_cast<uint8_t>(v);
+// 查表加速：LUT 在呼叫端建一次，各 band 共用
+static void build_gamma_lut(float gamma, uint8_t lut[256]) {
+    float inv = 1.0f / 255.0f;
+    for (int i = 0; i < 256; ++i) {
+        float x = static_cast<float>(i) * inv;
+        float y = std::pow(x, gamma);
+        float v = std::clamp(std::round(y * 255.0f), 0.0f, 255.0f);
+        lut[i] = static_cast<uint8_t>(v);
     }
-
-    return dst;
 }
 
-static ImageU8 invert_openmp(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("invert: empty image");
-
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
-
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for
-#endif
-    for (std::int64_t i = 0; i < static_cast<std::int64_t>(total); ++i) {
-        out[i] = static_cast<uint8_t>(255 - in[i]);
+static void apply_lut_rows(const ImageU8& src, ImageU8& dst, const uint8_t lut[256],
+                           int y0, int y1) {
+    const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* in = src.row(y);
+        uint8_t* out = dst.row(y);
+        for (std::size_t i = 0; i < row_len; ++i) {
+            out[i] = lut[in[i]];
+        }
     }
-    return dst;
 }
 
-static ImageU8 adjust_brightness_contrast_openmp(const ImageU8& src,
-                                                 float alpha, float beta) {
-    if (src.empty()) throw std::invalid_argument("adjust_brightness_contrast: empty image");
-
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+// 每個 row 讀 + 寫的 byte 數（parallel_rows 拿來決定 band 大小）
+static std::size_t row_bytes(const ImageU8& src, const ImageU8& dst) {
+    return static_cast<std::size_t>(src.w()) * src.c() + static_cast<std::size_t>(dst.w()) * dst.c();
+}
 
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
+// =========================
+//   Auto 用的成本描述（每個 pixel-channel）
+//   ops 以 calibrate_auto 的 "乘加 + round + clamp = 4 ops" 為單位，
+//   數值對照 benchmark_output/report.md 的 single 時間估出來
+// =========================
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for
-#endif
-    for (std::int64_t i = 0; i < static_cast<std::int64_t>(total); ++i) {
-        float v = alpha * static_cast<float>(in[i]) + beta;
-        v = std::clamp(std::round(v), 0.0f, 255.0f);
-        out[i] = static_cast<uint8_t>(v);
-    }
-    return dst;
-}
+static const OpCost kGrayscaleCost          {1.4f, 0.8f, 1};
+static const OpCost kInvertCost             {2.0f, 0.0f, 1};
+static const OpCost kSepiaCost              {2.0f, 2.0f, 1};
+static const OpCost kBrightnessContrastCost {2.0f, 4.0f, 1};
+static const OpCost kGammaCost              {2.0f, 0.2f, 1};
 
-static ImageU8 gamma_correct_openmp(const ImageU8& src, float gamma) {
-    if (src.empty()) throw std::invalid_argument("gamma_correct: empty image");
-    if (!(gamma > 0.0f)) throw std::invalid_argument("gamma_correct: gamma must be > 0");
+OpCost to_grayscale_cost()        { return kGrayscaleCost; }
+OpCost invert_cost()              { return kInvertCost; }
+OpCost sepia_cost()               { return kSepiaCost; }
+OpCost brightness_contrast_cost() { return kBrightnessContrastCost; }
+OpCost gamma_cost()               { return kGammaCost; }
 
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+// =========================
+//   對外 API：帶 Backend
+//   dst 版本寫進呼叫端給的影像；逐點運算的 kernel 每個位置先讀後寫，
+//   dst 可以直接是 src（in-place）
+// =========================
 
-    // LUT 一次建好（這段不用平行也沒差）
-    float inv = 1.0f / 255.0f;
-    uint8_t lut[256];
-    for (int i = 0; i < 256; ++i) {
-        float x = static_cast<float>(i) * inv;
-        float y = std::pow(x, gamma);
-        float v = std::clamp(std::round(y * 255.0f), 0.0f, 255.0f);
-        lut[i] = static_cast<uint8_t>(v);
+void to_grayscale(const ImageU8& src, ImageU8& dst, Backend backend)
+{
+    if (src.empty()) throw std::invalid_argument("to_grayscale: empty image");
+    check_output(dst, src.h(), src.w(), 1, "to_grayscale");
+
+    if (src.c() == 1) {
+        check_no_overlap(src, dst, "to_grayscale", true);
+        if (same_pixels(src, dst)) return;
+        const std::size_t row_len = static_cast<std::size_t>(src.w());
+        for (int y = 0; y < src.h(); ++y) std::memcpy(dst.row(y), src.row(y), row_len);
+        return;
     }
+    check_no_overlap(src, dst, "to_grayscale");
 
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
+    ExecPlan plan = plan_execution(backend, kGrayscaleCost, src);
+    ThreadScope threads(plan);
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for
-#endif
-    for (std::int64_t i = 0; i < static_cast<std::int64_t>(total); ++i) {
-        out[i] = lut[in[i]];
-    }
-    return dst;
+    parallel_rows(src.h(), plan.backend, row_bytes(src, dst), [&](int y0, int y1) {
+        to_grayscale_rows(src, dst, y0, y1);
+    });
 }
 
-static ImageU8 gamma_correct_single(const ImageU8& src,
-                                    float gamma) {
-    if (src.empty()) {
-        throw std::invalid_argument("gamma_correct: empty image");
-    }
-    if (!(gamma > 0.0f)) {
-        throw std::invalid_argument("gamma_correct: gamma must be > 0");
-    }
+ImageU8 to_grayscale(const ImageU8& src, Backend backend)
+{
+    // 已經是灰階：直接共用同一塊 buffer（copy-on-write），不複製
+    if (!src.empty() && src.c() == 1) return src.share();
+    if (src.empty()) throw std::invalid_argument("to_grayscale: empty image");
 
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
+    ImageU8 dst(src.h(), src.w(), 1, Init::None);
+    to_grayscale(src, dst, backend);
+    return dst;
+}
 
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+void invert(const ImageU8& src, ImageU8& dst, Backend backend)
+{
+    if (src.empty()) throw std::invalid_argument("invert: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "invert");
+    check_no_overlap(src, dst, "invert", true);
 
-    // 查表加速
-    float inv = 1.0f / 255.0f;
-    uint8_t lut[256];
-    for (int i = 0; i < 256; ++i) {
-        float x = static_cast<float>(i) * inv;
-        float y = std::pow(x, gamma);
-        float v = std::clamp(std::round(y * 255.0f), 0.0f, 255.0f);
-        lut[i] = static_cast<uint8_t>(v);
-    }
+    ExecPlan plan = plan_execution(backend, kInvertCost, src);
+    ThreadScope threads(plan);
 
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-    for (std::size_t i = 0; i < total; ++i) {
-        out[i] = lut[in[i]];
-    }
+    parallel_rows(src.h(), plan.backend, row_bytes(src, dst), [&](int y0, int y1) {
+        invert_rows(src, dst, y0, y1);
+    });
+}
 
+ImageU8 invert(const ImageU8& src, Backend backend)
+{
+    if (src.empty()) throw std::invalid_argument("invert: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    invert(src, dst, backend);
     return dst;
 }
 
-// =========================
-//   對外 API：帶 Backend
-// =========================
-
-ImageU8 to_grayscale(const ImageU8& src, Backend backend)
+void sepia(const ImageU8& src, ImageU8& dst, Backend backend)
 {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+    if (src.empty()) throw std::invalid_argument("sepia: empty image");
+    if (src.c() != 3) throw std::invalid_argument("sepia: expects 3-channel RGB image");
+    check_output(dst, src.h(), src.w(), 3, "sepia");
+    check_no_overlap(src, dst, "sepia", true);
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return to_grayscale_openmp(src);
-#else
-        // 保底：就算有人硬塞 OpenMP，但編譯期沒有支援，也不會炸
-        return to_grayscale_single(src);
-#endif
-    case Backend::Single:
-    default:
-        return to_grayscale_single(src);
-    }
+    ExecPlan plan = plan_execution(backend, kSepiaCost, src);
+    ThreadScope threads(plan);
+
+    parallel_rows(src.h(), plan.backend, row_bytes(src, dst), [&](int y0, int y1) {
+        sepia_rows(src, dst, y0, y1);
+    });
 }
 
-ImageU8 invert(const ImageU8& src, Backend backend)
+ImageU8 sepia(const ImageU8& src, Backend backend)
 {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return invert_openmp(src);
-#else
-        return invert_single(src);
-#endif
-    case Backend::Single:
-    default:
-        return invert_single(src);
-    }
+    if (src.empty()) throw std::invalid_argument("sepia: empty image");
+    if (src.c() != 3) throw std::invalid_argument("sepia: expects 3-channel RGB image");
+    ImageU8 dst(src.h(), src.w(), 3, Init::None);
+    sepia(src, dst, backend);
+    return dst;
 }
 
-ImageU8 sepia(const ImageU8& src, Backend backend)
+void adjust_brightness_contrast(const ImageU8& src,
+                                ImageU8& dst,
+                                float alpha,
+                                float beta,
+                                Backend backend)
 {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+    if (src.empty()) throw std::invalid_argument("adjust_brightness_contrast: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "adjust_brightness_contrast");
+    check_no_overlap(src, dst, "adjust_brightness_contrast", true);
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return sepia_openmp(src);
-#else
-        return sepia_single(src);
-#endif
-    case Backend::Single:
-    default:
-        return sepia_single(src);
-    }
+    ExecPlan plan = plan_execution(backend, kBrightnessContrastCost, src);
+    ThreadScope threads(plan);
+
+    parallel_rows(src.h(), plan.backend, row_bytes(src, dst), [&](int y0, int y1) {
+        adjust_brightness_contrast_rows(src, dst, alpha, beta, y0, y1);
+    });
 }
 
 ImageU8 adjust_brightness_contrast(const ImageU8& src,
@@ -410,52 +255,35 @@ ImageU8 adjust_brightness_contrast(const ImageU8& src,
                                    float beta,
                                    Backend backend)
 {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+    if (src.empty()) throw std::invalid_argument("adjust_brightness_contrast: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    adjust_brightness_contrast(src, dst, alpha, beta, backend);
+    return dst;
+}
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return adjust_brightness_contrast_openmp(src, alpha, beta);
-#else
-        return adjust_brightness_contrast_single(src, alpha, beta);
-#endif
-    case Backend::Single:
-    default:
-        return adjust_brightness_contrast_single(src, alpha, beta);
-    }
+void gamma_correct(const ImageU8& src, ImageU8& dst, float gamma, Backend backend)
+{
+    if (src.empty()) throw std::invalid_argument("gamma_correct: empty image");
+    if (!(gamma > 0.0f)) throw std::invalid_argument("gamma_correct: gamma must be > 0");
+    check_output(dst, src.h(), src.w(), src.c(), "gamma_correct");
+    check_no_overlap(src, dst, "gamma_correct", true);
+
+    ExecPlan plan = plan_execution(backend, kGammaCost, src);
+    ThreadScope threads(plan);
+
+    uint8_t lut[256];
+    build_gamma_lut(gamma, lut);
+    parallel_rows(src.h(), plan.backend, row_bytes(src, dst), [&](int y0, int y1) {
+        apply_lut_rows(src, dst, lut, y0, y1);
+    });
 }
 
 ImageU8 gamma_correct(const ImageU8& src, float gamma, Backend backend)
 {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return gamma_correct_openmp(src, gamma);
-#else
-        return gamma_correct_single(src, gamma);
-#endif
-    case Backend::Single:
-    default:
-        return gamma_correct_single(src, gamma);
-    }
+    if (src.empty()) throw std::invalid_argument("gamma_correct: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    gamma_correct(src, dst, gamma, backend);
+    return dst;
 }
 
 
@@ -1,74 +1,270 @@
 #include "pixfoundry/image.hpp"
+#include "pixfoundry/geometry.hpp"
+#include "pixfoundry/jpeg.hpp"
+#include "pixfoundry/png.hpp"
+#include "pixfoundry/qoi.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
-// stb
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// stb（只用來解碼；編碼在 png.cpp / jpeg.cpp / qoi.cpp）
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image.h"
-#include "stb_image_write.h"
 
 namespace pf {
 
-// 低階：回傳 ImageU8（內含 shared_ptr 指向 stb 的 buffer）
-// 零拷貝：不再做 std::copy，直接共享 stb 配置的像素
-ImageU8 load_image_u8(const std::string& path)
-{
-    int w = 0, h = 0, ch_in = 0;
+// ------------------------------------------------------------
+// 讀檔：整個檔案映射進記憶體（或一次讀完），之後都從記憶體解碼
+// ------------------------------------------------------------
+namespace {
+
+class FileBytes {
+public:
+    explicit FileBytes(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("load_image: cannot open " + path);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("load_image: cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map_ = p;
+                data_ = static_cast<const uint8_t*>(p);
+                ::madvise(p, size_, MADV_SEQUENTIAL);  // decoder 從頭讀到尾
+            }
+        }
+        ::close(fd);
+        if (map_ || size_ == 0) return;
+#endif
+        // 沒有 mmap（或映射失敗，例如 pipe）：一次讀完
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("load_image: cannot open " + path);
+        buf_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = reinterpret_cast<const uint8_t*>(buf_.data());
+        size_ = buf_.size();
+    }
+
+    ~FileBytes() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map_) ::munmap(map_, size_);
+#endif
+    }
 
-    // 我們要求輸出 1 或 3 通道，避免回來再轉通道造成再次配置
-    // 若原圖是 1 通道 → 要 1；否則 → 要 3
-    // 但 stbi_load 的第五參數是「要求的輸出通道數」，不會回傳原圖通道數
-    // 因此我們先用 stbi_info 得知原始通道數，再決定 desired_c。
-    int x_dummy=0,y_dummy=0,comp_dummy=0;
-    int ok = stbi_info(path.c_str(), &x_dummy, &y_dummy, &comp_dummy);
-    if (!ok) throw std::runtime_error("stb_image: failed to stbi_info " + path);
+    FileBytes(const FileBytes&)            = delete;
+    FileBytes& operator=(const FileBytes&) = delete;
 
-    const int desired_c = (comp_dummy == 1) ? 1 : 3;
+    const uint8_t* data() const { return data_; }
+    std::size_t    size() const { return size_; }
 
-    stbi_uc* raw = stbi_load(path.c_str(), &w, &h, &ch_in, desired_c);
-    if (!raw) throw std::runtime_error("stb_image: failed to load " + path);
+private:
+    void*             map_  = nullptr;
+    const uint8_t*    data_ = nullptr;
+    std::size_t       size_ = 0;
+    std::vector<char> buf_;
+};
+
+} // namespace
+
+// 零拷貝：直接共享 stb 配置的像素（或轉成 3 通道後的 buffer）
+static ImageU8 decode_full(const uint8_t* data, std::size_t size)
+{
+    if (!data || size == 0) throw std::runtime_error("stb_image: empty input");
+    if (is_qoi(data, size)) return decode_qoi(data, size);  // stb 不認得 QOI
+    if (size > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        throw std::runtime_error("stb_image: input too large");
+
+    // 用原圖的通道數解碼（req_comp = 0），一次 parse 就知道原圖是不是灰階：
+    // 灰階 → 1 通道；RGB → 3 通道；帶 alpha 的再自己轉 3 通道（跟 stb 的轉換一樣丟掉 alpha）
+    int w = 0, h = 0, ch_in = 0;
+    stbi_uc* raw = stbi_load_from_memory(data, static_cast<int>(size), &w, &h, &ch_in, 0);
+    if (!raw) throw std::runtime_error(std::string("stb_image: failed to decode: ") + stbi_failure_reason());
 
-    // 將 raw 交給 shared_ptr 管理，deleter 使用 stbi_image_free
     std::shared_ptr<uint8_t[]> sp(
         reinterpret_cast<uint8_t*>(raw),
         [](uint8_t* p){ stbi_image_free(p); }
     );
+    if (ch_in == 1 || ch_in == 3) return ImageU8(h, w, ch_in, std::move(sp));
+
+    const std::size_t n = static_cast<std::size_t>(h) * w;
+    if (ch_in == 4) {
+        // RGBA → RGB：寫的位置永遠不超過讀的位置，原地壓緊
+        uint8_t* p = sp.get();
+        for (std::size_t i = 0; i < n; ++i) {
+            p[3 * i]     = p[4 * i];
+            p[3 * i + 1] = p[4 * i + 1];
+            p[3 * i + 2] = p[4 * i + 2];
+        }
+        return ImageU8(h, w, 3, std::move(sp));
+    }
 
-    return ImageU8(h, w, desired_c, std::move(sp));
+    // 灰階 + alpha → RGB（灰階值複製到三個通道）
+    ImageU8 dst(h, w, 3, Init::None);
+    const uint8_t* src = sp.get();
+    uint8_t* out = dst.data();
+    for (std::size_t i = 0; i < n; ++i) {
+        out[3 * i] = out[3 * i + 1] = out[3 * i + 2] = src[2 * i];
+    }
+    return dst;
+}
+
+// 長邊縮到 max_size（只縮不放），比例不變
+static void fit_size(int h, int w, int max_size, int& th, int& tw)
+{
+    th = h;
+    tw = w;
+    const int longer = std::max(h, w);
+    if (max_size <= 0 || longer <= max_size) return;
+    const double f = static_cast<double>(max_size) / longer;
+    th = std::max(1, static_cast<int>(h * f + 0.5));
+    tw = std::max(1, static_cast<int>(w * f + 0.5));
 }
 
+ImageU8 decode_image_u8(const uint8_t* data, std::size_t size, int max_size)
+{
+    if (max_size <= 0) return decode_full(data, size);
+
+    // JPEG：挑「縮完還不小於目標」的最大倍率直接縮小解碼，剩下的交給 resize
+    ImageU8 img;
+    JpegInfo info;
+    int th = 0, tw = 0;
+    if (data && jpeg_info(data, size, info) && info.scalable) {
+        fit_size(info.h, info.w, max_size, th, tw);
+        for (int s = 8; s >= 2 && img.empty(); s /= 2) {
+            if ((info.w + s - 1) / s >= tw && (info.h + s - 1) / s >= th) {
+                if (!decode_jpeg_scaled(data, size, s, img)) break;  // 不支援的細節：退回 stb
+                // 最後一欄 / 列只涵蓋不到 s 個原圖 pixel：夠大的話丟掉，縮放比例才不會偏
+                const int cw = std::max(tw, info.w / s), ch = std::max(th, info.h / s);
+                if (cw < img.w() || ch < img.h()) img = img.view(0, 0, ch, cw);
+            }
+        }
+    }
+    if (img.empty()) {
+        img = decode_full(data, size);
+        fit_size(img.h(), img.w(), max_size, th, tw);
+    }
+    if (img.h() == th && img.w() == tw) return img.is_contiguous() ? std::move(img) : img.clone();
+    return resize(img, th, tw, Interp::Area);
+}
+
+// stb 的 buffer 大小都是 int：解出來（照 stb 內部最多 4 通道、16-bit 算）超過 2 GB 的 PNG 它會拒絕。
+// 這種全景圖改用逐 row 的 decoder（png.hpp）直接寫進整張 ImageU8，結果跟 stb 解的一樣
+static bool png_too_large_for_stb(const uint8_t* data, std::size_t size)
+{
+    static const uint8_t kSig[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    if (size < 33 || std::memcmp(data, kSig, 8) != 0 || std::memcmp(data + 12, "IHDR", 4) != 0) return false;
+    auto be32 = [](const uint8_t* p) {
+        return (uint64_t(p[0]) << 24) | (uint64_t(p[1]) << 16) | (uint64_t(p[2]) << 8) | p[3];
+    };
+    const uint64_t bytes = be32(data + 16) * be32(data + 20) * 4 * (data[24] == 16 ? 2 : 1);
+    return size > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+           bytes > static_cast<uint64_t>(std::numeric_limits<int>::max());
+}
 
-// 簡單存檔工具：支援 .png / .jpg
+static ImageU8 load_png_rows(const std::string& path, int max_size)
+{
+    PngStreamReader reader(path);
+    ImageU8 img(reader.h(), reader.w(), reader.c(), Init::None);
+    reader.read_rows(img.data(), img.h(), img.stride());
+    int th = 0, tw = 0;
+    fit_size(img.h(), img.w(), max_size, th, tw);
+    if (img.h() == th && img.w() == tw) return img;
+    return resize(img, th, tw, Interp::Area);
+}
+
+ImageU8 load_image_u8(const std::string& path, int max_size)
+{
+    const FileBytes file(path);
+    try {
+        if (png_too_large_for_stb(file.data(), file.size())) return load_png_rows(path, max_size);
+        return decode_image_u8(file.data(), file.size(), max_size);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(std::string(e.what()) + " (" + path + ")");
+    }
+}
+
+
+// 依格式名稱（"png" / "jpg" / "jpeg" / "qoi"，大小寫不拘、可帶 '.'）編碼
+static bool encode_as(std::string fmt, const uint8_t* data, int h, int w, int c,
+                      const EncodeOptions& options, std::vector<uint8_t>& out)
+{
+    if (!fmt.empty() && fmt[0] == '.') fmt.erase(0, 1);
+    for (char& ch : fmt) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+
+    const std::size_t stride = static_cast<std::size_t>(w) * c;
+    if (fmt == "png") out = encode_png(data, h, w, c, stride, options.png_level, options.png_filter);
+    else if (fmt == "jpg" || fmt == "jpeg") out = encode_jpeg(data, h, w, c, stride, options.jpeg_quality, options.jpeg_subsampling);
+    else if (fmt == "qoi") out = encode_qoi(data, h, w, c, stride);
+    else return false;
+    return true;
+}
+
+// 這麼大以上的 PNG 存檔走 PngStreamWriter
+static constexpr std::size_t kStreamSaveBytes = std::size_t(1) << 30;
+
+static bool is_png_ext(std::string ext)
+{
+    for (char& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return ext == "png";
+}
+
+// 簡單存檔工具：依副檔名支援 .png / .jpg / .qoi
 // 期望輸入為 HxW 或 HxWx3 的 uint8_t 緩衝區
 // alpha/2ch 不處理（若 numpy 來的是 RGBA，請在 bindings 端先轉 3ch）
 void save_image_u8(const std::string& path,
-                   const uint8_t* data, int h, int w, int c)
+                   const uint8_t* data, int h, int w, int c,
+                   const EncodeOptions& options)
 {
     if (!data || h <= 0 || w <= 0 || (c != 1 && c != 3))
         throw std::invalid_argument("save_image: invalid input");
 
-    const auto ends_with = [](const std::string& s, const char* suf){
-        const size_t n = std::char_traits<char>::length(suf);
-        return s.size() >= n && s.compare(s.size()-n, n, suf) == 0;
-    };
-
-    if (ends_with(path, ".png") || ends_with(path, ".PNG"))
-    {
-        int stride = w * c; // bytes per row
-        if (!stbi_write_png(path.c_str(), w, h, c, data, stride))
-            throw std::runtime_error("stb_image_write: failed to write png " + path);
-    }
-    else if (ends_with(path, ".jpg") || ends_with(path, ".jpeg")
-          || ends_with(path, ".JPG") || ends_with(path, ".JPEG"))
-    {
-        int quality = 95;
-        if (!stbi_write_jpg(path.c_str(), w, h, c, data, quality))
-            throw std::runtime_error("stb_image_write: failed to write jpg " + path);
-    }
-    else {
-        throw std::runtime_error("save_image: unsupported extension (use .png/.jpg): " + path);
+    const std::size_t dot = path.find_last_of("./\\");
+    if (dot != std::string::npos && path[dot] == '.' && is_png_ext(path.substr(dot + 1)) &&
+        static_cast<std::size_t>(h) * w * c >= kStreamSaveBytes) {
+        // 很大的 PNG 邊壓邊寫：不必再配一份 filter 過的整張 + 整段 zlib stream
+        PngStreamWriter writer(path, h, w, c, options.png_level, options.png_filter);
+        writer.write_rows(data, h, 0);
+        writer.close();
+        return;
     }
+    std::vector<uint8_t> bytes;
+    if (dot == std::string::npos || path[dot] != '.' || !encode_as(path.substr(dot), data, h, w, c, options, bytes))
+        throw std::runtime_error("save_image: unsupported extension (use .png/.jpg/.qoi): " + path);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("save_image: cannot open " + path);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) throw std::runtime_error("save_image: failed to write " + path);
+}
+
+std::vector<uint8_t> encode_image_u8(const std::string& format,
+                                     const uint8_t* data, int h, int w, int c,
+                                     const EncodeOptions& options)
+{
+    if (!data || h <= 0 || w <= 0 || (c != 1 && c != 3))
+        throw std::invalid_argument("save_image_to_bytes: invalid input");
+
+    std::vector<uint8_t> out;
+    if (!encode_as(format, data, h, w, c, options, out))
+        throw std::runtime_error("save_image_to_bytes: unsupported format (use png/jpg/qoi): " + format);
+    return out;
 }
 
 } // namespace pf
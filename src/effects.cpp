@@ -1,10 +1,14 @@
 #include "pixfoundry/effects.hpp"
+#include "pixfoundry/autotune.hpp"
 #include "pixfoundry/color.hpp"
 #include "pixfoundry/filters.hpp"
+#include "pixfoundry/parallel.hpp"
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <vector>
 
 namespace pf {
 
@@ -13,43 +17,36 @@ static inline std::size_t idx(int y, int x, int c,
     return (static_cast<std::size_t>(y) * W + x) * C + c;
 }
 
+// 輸入可能是 view（row pitch != W * C），讀取時用 stride 定址
+static inline std::size_t pidx(int y, int x, int c,
+                               std::size_t stride, int C) {
+    return static_cast<std::size_t>(y) * stride + static_cast<std::size_t>(x) * C + c;
+}
+
 // =========================
-//   single-thread 版本
+//   row band kernel：處理 [y0, y1) 這幾個 row
+//   Single 一次做整張；OpenMP / ThreadPool 由 parallel_rows 切 band 分給各 thread
 // =========================
 
-static ImageU8 sharpen_single(const ImageU8& src, float amount) {
-    if (src.empty()) {
-        throw std::invalid_argument("sharpen: empty image");
-    }
-    if (amount <= 0.0f) {
-        // amount <= 0 → 直接回傳 copy
-        const int H = src.h();
-        const int W = src.w();
-        const int C = src.c();
-        ImageU8 dst(H, W, C);
-        const std::size_t total = static_cast<std::size_t>(H) * W * C;
-        std::copy(src.data(), src.data() + total, dst.data());
-        return dst;
-    }
-
+static void sharpen_rows(const ImageU8& src, ImageU8& dst, float amount, int y0, int y1) {
     const int H = src.h();
     const int W = src.w();
     const int C = src.c();
 
     const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
+    const std::size_t S = src.stride();
     uint8_t* out = dst.data();
 
     // 3x3 銳化 kernel：center * (1+4*amount) - 四周 * amount
     // 等價於 base kernel [[0,-1,0],[-1,5,-1],[0,-1,0]] 的一般化
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
         for (int x = 0; x < W; ++x) {
             for (int c = 0; c < C; ++c) {
                 // 取中心與四個鄰居（簡單 handling：超出邊界用最近點 clamping）
                 auto clamp_xy = [&](int yy, int xx) {
                     yy = std::clamp(yy, 0, H - 1);
                     xx = std::clamp(xx, 0, W - 1);
-                    return in[idx(yy, xx, c, W, C)];
+                    return in[pidx(yy, xx, c, S, C)];
                 };
 
                 float center = static_cast<float>(clamp_xy(y, x));
@@ -67,35 +64,29 @@ static ImageU8 sharpen_single(const ImageU8& src, float amount) {
             }
         }
     }
-
-    return dst;
 }
 
-static ImageU8 emboss_single(const ImageU8& src, float strength) {
-    if (src.empty()) {
-        throw std::invalid_argument("emboss: empty image");
-    }
-
+static void emboss_rows(const ImageU8& src, ImageU8& dst, float strength, int y0, int y1) {
     const int H = src.h();
     const int W = src.w();
     const int C = src.c();
 
     const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
+    const std::size_t S = src.stride();
     uint8_t* out = dst.data();
 
     // 3x3 emboss kernel（左下到右上的斜向）
     // [-2 -1 0
     //  -1  1 1
     //   0  1 2] * strength
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
         for (int x = 0; x < W; ++x) {
             for (int c = 0; c < C; ++c) {
 
                 auto clamp_xy = [&](int yy, int xx) {
                     yy = std::clamp(yy, 0, H - 1);
                     xx = std::clamp(xx, 0, W - 1);
-                    return static_cast<float>(in[idx(yy, xx, c, W, C)]);
+                    return static_cast<float>(in[pidx(yy, xx, c, S, C)]);
                 };
 
                 float v =
@@ -120,49 +111,35 @@ static ImageU8 emboss_single(const ImageU8& src, float strength) {
             }
         }
     }
-
-    return dst;
 }
 
-static ImageU8 cartoonize_single(const ImageU8& src,
-                                 float sigma_space,
-                                 uint8_t edge_threshold) {
-    if (src.empty()) {
-        throw std::invalid_argument("cartoonize: empty image");
-    }
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-
-    // 1. 平滑：先用 Gaussian 讓色塊變得比較平滑
-    ImageU8 smooth = gaussian_filter(
-        src,
-        sigma_space,
-        Border::Reflect,
-        Backend::Single  // 先固定 single
-    );
+// 邊緣偵測（灰階 Sobel）+ 顏色量化 + 疊邊緣：三步都只看自己這個 row，
+// 同一個 band 裡一次做完，不再各掃一遍整張
+static void cartoonize_rows(const ImageU8& smooth, const ImageU8& gray, ImageU8& dst,
+                            uint8_t edge_threshold, int y0, int y1) {
+    const int H = gray.h();
+    const int W = gray.w();
+    const int C = dst.c();
 
-    // 2. 邊緣偵測：用灰階 + Sobel
-    ImageU8 gray = to_grayscale(src, Backend::Single);
+    // 輸入已經是灰階時 gray 跟 src 共用 buffer（可能是 view），用 stride 定址
     const uint8_t* g_in = gray.data();
+    const std::size_t GS = gray.stride();
 
-    ImageU8 edge_mask(H, W, 1);
-    uint8_t* e_out = edge_mask.data();
+    std::vector<uint8_t> edge(static_cast<std::size_t>(W));
 
-    auto g_idx = [&](int y, int x) {
-        return static_cast<std::size_t>(y) * W + x;
+    const int levels = 16;                 // 16 階
+    const float step = 255.0f / (levels - 1);
+    const uint8_t edge_color = 20;         // 調整這個值來控制邊緣亮度
+
+    auto clamp_g = [&](int yy, int xx) -> float {
+        yy = std::clamp(yy, 0, H - 1);
+        xx = std::clamp(xx, 0, W - 1);
+        return static_cast<float>(g_in[pidx(yy, xx, 0, GS, 1)]);
     };
 
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
+        // 1. 邊緣：這個 row 的 Sobel
         for (int x = 0; x < W; ++x) {
-
-            auto clamp_g = [&](int yy, int xx) -> float {
-                yy = std::clamp(yy, 0, H - 1);
-                xx = std::clamp(xx, 0, W - 1);
-                return static_cast<float>(g_in[g_idx(yy, xx)]);
-            };
-
             float gx =
                 -1.f * clamp_g(y - 1, x - 1) +
                  0.f * clamp_g(y - 1, x    ) +
@@ -185,313 +162,141 @@ static ImageU8 cartoonize_single(const ImageU8& src,
             float mag = std::fabs(gx) + std::fabs(gy);
 
             // 邊緣 → 0 (黑)，非邊緣 → 255 (白)
-            e_out[g_idx(y, x)] =
-                (mag > static_cast<float>(edge_threshold)) ? 0 : 255;
+            edge[x] = (mag > static_cast<float>(edge_threshold)) ? 0 : 255;
         }
-    }
-
-    // 3. 顏色量化：讓色塊看起來更「卡通」
-    uint8_t* s_data = smooth.data();
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-    const int levels = 16;                 // 16 階
-    const float step = 255.0f / (levels - 1);
-
-    for (std::size_t i = 0; i < total; ++i) {
-        float v = static_cast<float>(s_data[i]);
-        int idx_level = static_cast<int>(std::round(v / step));
-        v = std::clamp(idx_level * step, 0.0f, 255.0f);
-        s_data[i] = static_cast<uint8_t>(v);
-    }
-
-    // 4. 把邊緣畫成黑色線條疊在平滑過的色塊上
-    ImageU8 out_img(H, W, C);
-    uint8_t* out = out_img.data();
 
-    for (int y = 0; y < H; ++y) {
+        // 2. 量化平滑過的顏色，邊緣像素畫成黑色線條
+        const uint8_t* s_row = smooth.row(y);
+        uint8_t* out = dst.row(y);
         for (int x = 0; x < W; ++x) {
-            uint8_t e = e_out[g_idx(y, x)];
             for (int c = 0; c < C; ++c) {
-                uint8_t base = s_data[idx(y, x, c, W, C)];
-                // 邊緣像素 -> 黑色，否則用量化後的平滑顏色
-                const uint8_t edge_color = 20; // 調整這個值來控制邊緣亮度
-                out[idx(y, x, c, W, C)] = (e == 0) ? edge_color : base;
+                const std::size_t i = static_cast<std::size_t>(x) * C + c;
+                float v = static_cast<float>(s_row[i]);
+                int idx_level = static_cast<int>(std::round(v / step));
+                v = std::clamp(idx_level * step, 0.0f, 255.0f);
+                out[i] = (edge[x] == 0) ? edge_color : static_cast<uint8_t>(v);
             }
         }
     }
+}
+
+static void cartoonize_impl(const ImageU8& src,
+                            ImageU8& dst,
+                            float sigma_space,
+                            uint8_t edge_threshold,
+                            Backend exec) {
+    // 平滑：先用 Gaussian 讓色塊變得比較平滑；跟外層用同一個後端，
+    // ThreadPool 時是巢狀的 parallel_for，工作丟進同一個 pool，不會多開 thread
+    ImageU8 smooth = gaussian_filter(src, sigma_space, Border::Reflect, exec);
+    ImageU8 gray   = to_grayscale(src, exec);
+
+    const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+    parallel_rows(src.h(), exec, 2 * row_len + 3 * static_cast<std::size_t>(src.w()),
+                  [&](int y0, int y1) {
+        cartoonize_rows(smooth, gray, dst, edge_threshold, y0, y1);
+    });
+}
 
-    return out_img;
+// 每個 row 讀 + 寫的 byte 數（3x3 kernel 會讀到上下各一個 row）
+static std::size_t stencil_row_bytes(const ImageU8& src) {
+    return static_cast<std::size_t>(src.w()) * src.c() * 4;
 }
 
 // =========================
-//   OpenMP 版本（若 PF_HAS_OPENMP）
+//   Auto 用的成本描述（每個 pixel-channel）
 // =========================
 
-static ImageU8 sharpen_openmp(const ImageU8& src, float amount) {
+static const OpCost kSharpenCost {2.0f, 6.0f, 1};
+static const OpCost kEmbossCost  {2.0f, 7.0f, 1};
+
+OpCost sharpen_cost() { return kSharpenCost; }
+OpCost emboss_cost()  { return kEmbossCost; }
+
+// cartoonize = gaussian（兩個 pass）+ 灰階 + Sobel + 量化 + 疊邊緣
+OpCost cartoonize_cost(float sigma_space) {
+    const int k = std::max(3, (static_cast<int>(std::ceil(6.f * sigma_space)) | 1));
+    return OpCost{16.0f, 1.5f * k + 4.0f, 6};
+}
+
+// =========================
+//   對外 API：帶 Backend
+// =========================
+
+void sharpen(const ImageU8& src, ImageU8& dst, float amount, Backend backend) {
     if (src.empty()) throw std::invalid_argument("sharpen: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "sharpen");
 
+    // amount <= 0 等於原圖：只要把 src 搬過去
     if (amount <= 0.0f) {
-        const int H = src.h(), W = src.w(), C = src.c();
-        ImageU8 dst(H, W, C);
-        const std::size_t total = static_cast<std::size_t>(H) * W * C;
-        std::copy(src.data(), src.data() + total, dst.data());
-        return dst;
+        check_no_overlap(src, dst, "sharpen", true);
+        if (same_pixels(src, dst)) return;
+        const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+        for (int y = 0; y < src.h(); ++y) std::memcpy(dst.row(y), src.row(y), row_len);
+        return;
     }
+    check_no_overlap(src, dst, "sharpen");
 
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+    ExecPlan plan = plan_execution(backend, kSharpenCost, src);
+    ThreadScope threads(plan);
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                auto clamp_xy = [&](int yy, int xx) {
-                    yy = std::clamp(yy, 0, H - 1);
-                    xx = std::clamp(xx, 0, W - 1);
-                    return in[idx(yy, xx, c, W, C)];
-                };
-
-                float center = static_cast<float>(clamp_xy(y, x));
-                float up     = static_cast<float>(clamp_xy(y - 1, x));
-                float down   = static_cast<float>(clamp_xy(y + 1, x));
-                float left   = static_cast<float>(clamp_xy(y, x - 1));
-                float right  = static_cast<float>(clamp_xy(y, x + 1));
+    parallel_rows(src.h(), plan.backend, stencil_row_bytes(src), [&](int y0, int y1) {
+        sharpen_rows(src, dst, amount, y0, y1);
+    });
+}
 
-                float v = (1.0f + 4.0f * amount) * center
-                        - amount * (up + down + left + right);
+ImageU8 sharpen(const ImageU8& src, float amount, Backend backend) {
+    // amount <= 0 等於原圖：共用同一塊 buffer（copy-on-write），不複製
+    if (!src.empty() && amount <= 0.0f) return src.share();
+    if (src.empty()) throw std::invalid_argument("sharpen: empty image");
 
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
-                out[idx(y, x, c, W, C)] = static_cast<uint8_t>(v);
-            }
-        }
-    }
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    sharpen(src, dst, amount, backend);
     return dst;
 }
 
-static ImageU8 emboss_openmp(const ImageU8& src, float strength) {
+void emboss(const ImageU8& src, ImageU8& dst, float strength, Backend backend) {
     if (src.empty()) throw std::invalid_argument("emboss: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "emboss");
+    check_no_overlap(src, dst, "emboss");
 
-    const int H = src.h(), W = src.w(), C = src.c();
-    const uint8_t* in = src.data();
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+    ExecPlan plan = plan_execution(backend, kEmbossCost, src);
+    ThreadScope threads(plan);
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                auto clamp_xy = [&](int yy, int xx) -> float {
-                    yy = std::clamp(yy, 0, H - 1);
-                    xx = std::clamp(xx, 0, W - 1);
-                    return static_cast<float>(in[idx(yy, xx, c, W, C)]);
-                };
-
-                float v =
-                    -2.f * clamp_xy(y - 1, x - 1) +
-                    -1.f * clamp_xy(y - 1, x    ) +
-                     0.f * clamp_xy(y - 1, x + 1) +
-                    -1.f * clamp_xy(y,     x - 1) +
-                     1.f * clamp_xy(y,     x    ) +
-                     1.f * clamp_xy(y,     x + 1) +
-                     0.f * clamp_xy(y + 1, x - 1) +
-                     1.f * clamp_xy(y + 1, x    ) +
-                     2.f * clamp_xy(y + 1, x + 1);
-
-                v *= strength;
-                v = v + 128.0f;
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
+    parallel_rows(src.h(), plan.backend, stencil_row_bytes(src), [&](int y0, int y1) {
+        emboss_rows(src, dst, strength, y0, y1);
+    });
+}
 
-                out[idx(y, x, c, W, C)] = static_cast<uint8_t>(v);
-            }
-        }
-    }
+ImageU8 emboss(const ImageU8& src, float strength, Backend backend) {
+    if (src.empty()) throw std::invalid_argument("emboss: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    emboss(src, dst, strength, backend);
     return dst;
 }
 
-static ImageU8 cartoonize_openmp(const ImageU8& src,
-                                 float sigma_space,
-                                 uint8_t edge_threshold) {
+void cartoonize(const ImageU8& src,
+                ImageU8& dst,
+                float sigma_space,
+                uint8_t edge_threshold,
+                Backend backend) {
     if (src.empty()) throw std::invalid_argument("cartoonize: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "cartoonize");
+    check_no_overlap(src, dst, "cartoonize");
 
-    const int H = src.h(), W = src.w(), C = src.c();
-
-    // 1) 平滑：這裡不要硬鎖 single，讓它跟著 OpenMP 走
-    ImageU8 smooth = gaussian_filter(
-        src,
-        sigma_space,
-        Border::Reflect,
-        Backend::OpenMP
-    );
-
-    // 2) 邊緣偵測：灰階 + Sobel
-    ImageU8 gray = to_grayscale(src, Backend::OpenMP);
-    const uint8_t* g_in = gray.data();
-
-    ImageU8 edge_mask(H, W, 1);
-    uint8_t* e_out = edge_mask.data();
-
-    auto g_idx = [&](int y, int x) {
-        return static_cast<std::size_t>(y) * W + x;
-    };
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            auto clamp_g = [&](int yy, int xx) -> float {
-                yy = std::clamp(yy, 0, H - 1);
-                xx = std::clamp(xx, 0, W - 1);
-                return static_cast<float>(g_in[g_idx(yy, xx)]);
-            };
-
-            float gx =
-                -1.f * clamp_g(y - 1, x - 1) +
-                 0.f * clamp_g(y - 1, x    ) +
-                 1.f * clamp_g(y - 1, x + 1) +
-                -2.f * clamp_g(y,     x - 1) +
-                 0.f * clamp_g(y,     x    ) +
-                 2.f * clamp_g(y,     x + 1) +
-                -1.f * clamp_g(y + 1, x - 1) +
-                 0.f * clamp_g(y + 1, x    ) +
-                 1.f * clamp_g(y + 1, x + 1);
-
-            float gy =
-                -1.f * clamp_g(y - 1, x - 1) +
-                -2.f * clamp_g(y - 1, x    ) +
-                -1.f * clamp_g(y - 1, x + 1) +
-                 1.f * clamp_g(y + 1, x - 1) +
-                 2.f * clamp_g(y + 1, x    ) +
-                 1.f * clamp_g(y + 1, x + 1);
-
-            float mag = std::fabs(gx) + std::fabs(gy);
-            e_out[g_idx(y, x)] =
-                (mag > static_cast<float>(edge_threshold)) ? 0 : 255;
-        }
-    }
-
-    // 3) 顏色量化
-    uint8_t* s_data = smooth.data();
-    const std::size_t total = static_cast<std::size_t>(H) * W * C;
-    const int levels = 16;
-    const float step = 255.0f / (levels - 1);
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for
-#endif
-    for (std::int64_t i = 0; i < static_cast<std::int64_t>(total); ++i) {
-        float v = static_cast<float>(s_data[i]);
-        int idx_level = static_cast<int>(std::round(v / step));
-        v = std::clamp(idx_level * step, 0.0f, 255.0f);
-        s_data[i] = static_cast<uint8_t>(v);
-    }
-
-    // 4) 疊邊緣
-    ImageU8 out_img(H, W, C);
-    uint8_t* out = out_img.data();
-    const uint8_t edge_color = 20;
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            uint8_t e = e_out[g_idx(y, x)];
-            for (int c = 0; c < C; ++c) {
-                uint8_t base = s_data[idx(y, x, c, W, C)];
-                out[idx(y, x, c, W, C)] = (e == 0) ? edge_color : base;
-            }
-        }
-    }
-
-    return out_img;
-}
-
+    ExecPlan plan = plan_execution(backend, cartoonize_cost(sigma_space), src);
+    ThreadScope threads(plan);
 
-// =========================
-//   對外 API：帶 Backend
-// =========================
-
-ImageU8 sharpen(const ImageU8& src, float amount, Backend backend) {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;   // 先簡單：Auto => OpenMP
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return sharpen_openmp(src, amount);
-#else
-        return sharpen_single(src, amount);
-#endif
-    case Backend::Single:
-    default:
-        return sharpen_single(src, amount);
-    }
-}
-
-ImageU8 emboss(const ImageU8& src, float strength, Backend backend) {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return emboss_openmp(src, strength);
-#else
-        return emboss_single(src, strength);
-#endif
-    case Backend::Single:
-    default:
-        return emboss_single(src, strength);
-    }
+    cartoonize_impl(src, dst, sigma_space, edge_threshold, plan.backend);
 }
 
 ImageU8 cartoonize(const ImageU8& src,
                    float sigma_space,
                    uint8_t edge_threshold,
                    Backend backend) {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return cartoonize_openmp(src, sigma_space, edge_threshold);
-#else
-        return cartoonize_single(src, sigma_space, edge_threshold);
-#endif
-    case Backend::Single:
-    default:
-        return cartoonize_single(src, sigma_space, edge_threshold);
-    }
+    if (src.empty()) throw std::invalid_argument("cartoonize: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    cartoonize(src, dst, sigma_space, edge_threshold, backend);
+    return dst;
 }
 
 
@@ -1,13 +1,13 @@
 #include "pixfoundry/filters.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
-#ifdef PF_HAS_OPENMP
-#include <omp.h>
-#endif
 
 namespace pf {
 
@@ -19,34 +19,6 @@ inline std::size_t linear_index(int y, int x, int c, int W, int C) {
     return (static_cast<std::size_t>(y) * W + x) * C + c;
 }
 
-// 將越界的 index 依照 Border 規則映射回合法範圍 [0, N-1]
-static inline int border_index(int i, int N, Border border) {
-    if (N <= 0) return 0;
-
-    switch (border) {
-        case Border::Reflect: {
-            if (N == 1) return 0;
-            if (i < 0)      return -i - 1;
-            if (i >= N)     return 2 * N - i - 1;
-            return i;
-        }
-        case Border::Replicate: {
-            if (i < 0)      return 0;
-            if (i >= N)     return N - 1;
-            return i;
-        }
-        case Border::Wrap: {
-            int m = i % N;
-            if (m < 0) m += N;
-            return m;
-        }
-        case Border::Constant:
-        default:
-            // Constant 不應走到這裡，這裡給個 clamp，實際上 Constant 會在 sample 裡處理
-            return std::clamp(i, 0, N - 1);
-    }
-}
-
 // 從 uint8 影像取樣（支援 Constant / Reflect / Replicate / Wrap）
 static inline uint8_t sample_u8(const ImageU8& src,
                                 int y, int x, int c,
@@ -61,14 +33,14 @@ static inline uint8_t sample_u8(const ImageU8& src,
         }
     }
 
-    // 其他模式：先用 border_index 做映射
-    int yy = border_index(y, H, border);
-    int xx = border_index(x, W, border);
-    return src.data()[linear_index(yy, xx, c, W, C)];
+    // 其他模式：先用 border_fold 做映射
+    int yy = border_fold(y, H, border);
+    int xx = border_fold(x, W, border);
+    return src.row(yy)[static_cast<std::size_t>(xx) * C + c];
 }
 
 // 從 float buffer（例如暫存的 tmp）取樣
-static inline float sample_float(const std::vector<float>& buf,
+static inline float sample_float(const float* buf,
                                  int y, int x, int c,
                                  int H, int W, int C,
                                  Border border,
@@ -80,8 +52,8 @@ static inline float sample_float(const std::vector<float>& buf,
         }
     }
 
-    int yy = border_index(y, H, border);
-    int xx = border_index(x, W, border);
+    int yy = border_fold(y, H, border);
+    int xx = border_fold(x, W, border);
     return buf[linear_index(yy, xx, c, W, C)];
 }
 
@@ -126,10 +98,14 @@ std::vector<float> gaussian_kernel1d(float sigma) {
 // 可重用的 Separable Convolution（uint8 in / uint8 out）
 // ============================================================
 
-static ImageU8 convolve_separable_u8(const ImageU8& src,
-                                     const std::vector<float>& k1d,
-                                     Border border,
-                                     uint8_t border_value) {
+// 兩個 pass 中間隔著 float 暫存：src 全部讀完才開始寫 dst，所以 dst 可以就是 src
+// 每個 pass 各自切 row band 平行（兩個 pass 之間要等全部 band 做完）
+static void convolve_separable_u8(const ImageU8& src,
+                                  ImageU8& dst,
+                                  const std::vector<float>& k1d,
+                                  Border border,
+                                  uint8_t border_value,
+                                  Backend exec) {
     if (src.empty()) {
         throw std::invalid_argument("convolve_separable_u8: src empty");
     }
@@ -140,143 +116,123 @@ static ImageU8 convolve_separable_u8(const ImageU8& src,
     const int H = src.h(), W = src.w(), C = src.c();
     const int K = static_cast<int>(k1d.size());
     const int R = K / 2;
+    const std::size_t row_len = static_cast<std::size_t>(W) * C;
 
-    std::vector<float> tmp(static_cast<std::size_t>(H) * W * C, 0.f);
-    ImageU8 dst(H, W, C);
+    // 暫存的 float 影像：水平 pass 會寫滿，不用清 0
+    ScratchBuffer<float> tmp(static_cast<std::size_t>(H) * W * C);
 
     // ---- 水平 pass: src → tmp ----
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                float sum = 0.f;
-                for (int t = -R; t <= R; ++t) {
-                    uint8_t v = sample_u8(src, y, x + t, c, border, border_value);
-                    sum += k1d[t + R] * static_cast<float>(v);
+    parallel_rows(H, exec, row_len * (1 + sizeof(float)), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < W; ++x) {
+                for (int c = 0; c < C; ++c) {
+                    float sum = 0.f;
+                    for (int t = -R; t <= R; ++t) {
+                        uint8_t v = sample_u8(src, y, x + t, c, border, border_value);
+                        sum += k1d[t + R] * static_cast<float>(v);
+                    }
+                    tmp[linear_index(y, x, c, W, C)] = sum;
                 }
-                tmp[linear_index(y, x, c, W, C)] = sum;
             }
         }
-    }
+    });
 
     // ---- 垂直 pass: tmp → dst ----
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                float sum = 0.f;
-                for (int t = -R; t <= R; ++t) {
-                    float v = sample_float(tmp, y + t, x, c, H, W, C, border, border_value);
-                    sum += k1d[t + R] * v;
-                }
+    parallel_rows(H, exec, row_len * (K * sizeof(float) + 1), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < W; ++x) {
+                for (int c = 0; c < C; ++c) {
+                    float sum = 0.f;
+                    for (int t = -R; t <= R; ++t) {
+                        float v = sample_float(tmp.data(), y + t, x, c, H, W, C, border, border_value);
+                        sum += k1d[t + R] * v;
+                    }
 
-                float out = std::round(sum);
-                out = std::clamp(out, 0.f, 255.f);
-                dst.data()[linear_index(y, x, c, W, C)] = static_cast<uint8_t>(out);
+                    float out = std::round(sum);
+                    out = std::clamp(out, 0.f, 255.f);
+                    dst.data()[linear_index(y, x, c, W, C)] = static_cast<uint8_t>(out);
+                }
             }
         }
-    }
-
-    return dst;
+    });
 }
 
-#ifdef PF_HAS_OPENMP
-static ImageU8 convolve_separable_u8_openmp(const ImageU8& src,
-                                            const std::vector<float>& k1d,
-                                            Border border,
-                                            uint8_t border_value)
-{
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-    const int R = static_cast<int>(k1d.size() / 2);
-
-    std::vector<float> tmp(static_cast<std::size_t>(H) * W * C, 0.f);
-    ImageU8 dst(H, W, C);
-
-    // horizontal pass
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                float sum = 0.f;
-                for (int t = -R; t <= R; ++t) {
-                    uint8_t v = sample_u8(src, y, x + t, c, border, border_value);
-                    sum += k1d[t + R] * static_cast<float>(v);
-                }
-                tmp[linear_index(y, x, c, W, C)] = sum;
-            }
-        }
-    }
+// ============================================================
+// Auto 用的成本描述：兩個 pass，每個 tap 約 1 op，中間 float buffer 來回
+// ============================================================
 
-    // vertical pass
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                float sum = 0.f;
-                for (int t = -R; t <= R; ++t) {
-                    float v = sample_float(tmp, y + t, x, c, H, W, C, border, border_value);
-                    sum += k1d[t + R] * v;
-                }
-                float out = std::round(sum);
-                out = std::clamp(out, 0.f, 255.f);
-                dst.data()[linear_index(y, x, c, W, C)] = static_cast<uint8_t>(out);
-            }
-        }
-    }
+OpCost separable_cost(std::size_t ksize) {
+    return OpCost{10.0f, 2.0f * static_cast<float>(ksize), 2};
+}
 
-    return dst;
+OpCost median_filter_cost(int ksize) {
+    return OpCost{2.0f, 7.0f * ksize * ksize, 1};
+}
+
+OpCost bilateral_filter_cost(int ksize) {
+    return OpCost{2.0f, 3.5f * ksize * ksize, 1};
 }
-#endif
 
 // ============================================================
 // Public API
 // ============================================================
 
+static void convolve_dispatch(const ImageU8& src, ImageU8& dst,
+                              const std::vector<float>& kernel, Border border,
+                              Backend backend, uint8_t border_value, const char* name)
+{
+    if (src.empty()) {
+        throw std::invalid_argument(std::string(name) + ": src empty");
+    }
+    check_output(dst, src.h(), src.w(), src.c(), name);
+    check_no_overlap(src, dst, name, true);
+
+    ExecPlan plan = plan_execution(backend, separable_cost(kernel.size()), src);
+    ThreadScope threads(plan);
+
+    convolve_separable_u8(src, dst, kernel, border, border_value, plan.backend);
+}
+
+void mean_filter(const ImageU8& src, ImageU8& dst, int ksize, Border border,
+                 Backend backend, uint8_t border_value)
+{
+    convolve_dispatch(src, dst, box_kernel1d(ksize), border, backend, border_value, "mean_filter");
+}
+
 ImageU8 mean_filter(const ImageU8& src, int ksize, Border border,
                     Backend backend, uint8_t border_value)
 {
-    auto kernel = box_kernel1d(ksize);
-
-    backend = normalize_backend(backend);
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return convolve_separable_u8_openmp(src, kernel, border, border_value);
-#else
-        return convolve_separable_u8(src, kernel, border, border_value);
-#endif
-    case Backend::Single:
-    case Backend::Auto:
-    default:
-        return convolve_separable_u8(src, kernel, border, border_value);
+    if (src.empty()) {
+        throw std::invalid_argument("mean_filter: src empty");
     }
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    mean_filter(src, dst, ksize, border, backend, border_value);
+    return dst;
+}
+
+void gaussian_filter(const ImageU8& src, ImageU8& dst, float sigma, Border border,
+                     Backend backend, uint8_t border_value)
+{
+    convolve_dispatch(src, dst, gaussian_kernel1d(sigma), border, backend, border_value, "gaussian_filter");
 }
 
 ImageU8 gaussian_filter(const ImageU8& src, float sigma, Border border,
                         Backend backend, uint8_t border_value)
 {
-    auto kernel = gaussian_kernel1d(sigma);
-
-    backend = normalize_backend(backend);
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return convolve_separable_u8_openmp(src, kernel, border, border_value);
-#else
-        return convolve_separable_u8(src, kernel, border, border_value);
-#endif
-    case Backend::Single:
-    case Backend::Auto:
-    default:
-        return convolve_separable_u8(src, kernel, border, border_value);
+    if (src.empty()) {
+        throw std::invalid_argument("gaussian_filter: src empty");
     }
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    gaussian_filter(src, dst, sigma, border, backend, border_value);
+    return dst;
 }
 
-ImageU8 median_filter(const ImageU8& src,
-                      int ksize,
-                      Border border,
-                      Backend backend,
-                      uint8_t border_value)
+void median_filter(const ImageU8& src,
+                   ImageU8& dst,
+                   int ksize,
+                   Border border,
+                   Backend backend,
+                   uint8_t border_value)
 {
     if (src.empty()) {
         throw std::invalid_argument("median_filter: src empty");
@@ -284,91 +240,63 @@ ImageU8 median_filter(const ImageU8& src,
     if (ksize < 3 || (ksize % 2 == 0)) {
         throw std::invalid_argument("median_filter: ksize must be odd and >= 3");
     }
+    check_output(dst, src.h(), src.w(), src.c(), "median_filter");
+    check_no_overlap(src, dst, "median_filter");
 
     const int H = src.h(), W = src.w(), C = src.c();
     const int R = ksize / 2;
     const int window_size = ksize * ksize;
 
-    ImageU8 dst(H, W, C);
-
-    backend = normalize_backend(backend);
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-    {
-        // 每個 thread 各自擁有 window，避免 data race
-        #pragma omp parallel
-        {
-            std::vector<uint8_t> window;
-            window.reserve(static_cast<std::size_t>(window_size));
-
-            #pragma omp for collapse(2) schedule(static)
-            for (int y = 0; y < H; ++y) {
-                for (int x = 0; x < W; ++x) {
-                    for (int c = 0; c < C; ++c) {
-
-                        window.clear();
-                        for (int dy = -R; dy <= R; ++dy) {
-                            for (int dx = -R; dx <= R; ++dx) {
-                                uint8_t v = sample_u8(src, y + dy, x + dx, c, border, border_value);
-                                window.push_back(v);
-                            }
-                        }
+    ExecPlan plan = plan_execution(backend, median_filter_cost(ksize), src);
+    ThreadScope threads(plan);
 
-                        auto mid_it = window.begin() + window.size() / 2;
-                        std::nth_element(window.begin(), mid_it, window.end());
-                        dst.data()[linear_index(y, x, c, W, C)] = *mid_it;
-                    }
-                }
-            }
-        }
-        return dst;
-    }
-#else
-        // 沒開 OpenMP 就退回 single
-        [[fallthrough]];
-#endif
-
-    case Backend::Single:
-    case Backend::Auto:
-    default:
-        break;
-    }
-
-    // single-thread fallback
-    std::vector<uint8_t> window;
-    window.reserve(static_cast<std::size_t>(window_size));
+    // window 是每個 band 各自的暫存，band 之間不會互相干擾
+    const std::size_t row_len = static_cast<std::size_t>(W) * C;
+    parallel_rows(H, plan.backend, row_len * ksize + row_len, [&](int y0, int y1) {
+        ScratchBuffer<uint8_t> window(static_cast<std::size_t>(window_size));
 
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < W; ++x) {
+                for (int c = 0; c < C; ++c) {
 
-                window.clear();
-                for (int dy = -R; dy <= R; ++dy) {
-                    for (int dx = -R; dx <= R; ++dx) {
-                        uint8_t v = sample_u8(src, y + dy, x + dx, c, border, border_value);
-                        window.push_back(v);
+                    std::size_t n = 0;
+                    for (int dy = -R; dy <= R; ++dy) {
+                        for (int dx = -R; dx <= R; ++dx) {
+                            window[n++] = sample_u8(src, y + dy, x + dx, c, border, border_value);
+                        }
                     }
-                }
 
-                auto mid_it = window.begin() + window.size() / 2;
-                std::nth_element(window.begin(), mid_it, window.end());
-                dst.data()[linear_index(y, x, c, W, C)] = *mid_it;
+                    uint8_t* mid_it = window.data() + n / 2;
+                    std::nth_element(window.data(), mid_it, window.data() + n);
+                    dst.data()[linear_index(y, x, c, W, C)] = *mid_it;
+                }
             }
         }
-    }
+    });
+}
 
+ImageU8 median_filter(const ImageU8& src,
+                      int ksize,
+                      Border border,
+                      Backend backend,
+                      uint8_t border_value)
+{
+    if (src.empty()) {
+        throw std::invalid_argument("median_filter: src empty");
+    }
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    median_filter(src, dst, ksize, border, backend, border_value);
     return dst;
 }
 
-ImageU8 bilateral_filter(const ImageU8& src,
-                         int ksize,
-                         float sigma_color,
-                         float sigma_space,
-                         Border border,
-                         Backend backend,
-                         uint8_t border_value)
+void bilateral_filter(const ImageU8& src,
+                      ImageU8& dst,
+                      int ksize,
+                      float sigma_color,
+                      float sigma_space,
+                      Border border,
+                      Backend backend,
+                      uint8_t border_value)
 {
     if (src.empty()) {
         throw std::invalid_argument("bilateral_filter: src empty");
@@ -379,6 +307,8 @@ ImageU8 bilateral_filter(const ImageU8& src,
     if (!(sigma_color > 0.f) || !(sigma_space > 0.f)) {
         throw std::invalid_argument("bilateral_filter: sigma_color and sigma_space must be > 0");
     }
+    check_output(dst, src.h(), src.w(), src.c(), "bilateral_filter");
+    check_no_overlap(src, dst, "bilateral_filter");
 
     const int H = src.h(), W = src.w(), C = src.c();
     const int R = ksize / 2;
@@ -386,8 +316,6 @@ ImageU8 bilateral_filter(const ImageU8& src,
     const float inv2_sigma_space2 = 1.0f / (2.0f * sigma_space * sigma_space);
     const float inv2_sigma_color2 = 1.0f / (2.0f * sigma_color * sigma_color);
 
-    ImageU8 dst(H, W, C);
-
     // 空間權重可以共用（read-only）
     std::vector<float> spatial_weight(static_cast<std::size_t>(ksize) * ksize);
     for (int dy = -R; dy <= R; ++dy) {
@@ -398,7 +326,8 @@ ImageU8 bilateral_filter(const ImageU8& src,
         }
     }
 
-    backend = normalize_backend(backend);
+    ExecPlan plan = plan_execution(backend, bilateral_filter_cost(ksize), src);
+    ThreadScope threads(plan);
 
     auto body = [&](int y, int x) {
         for (int c = 0; c < C; ++c) {
@@ -429,33 +358,29 @@ ImageU8 bilateral_filter(const ImageU8& src,
         }
     };
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        #pragma omp parallel for collapse(2) schedule(static)
-        for (int y = 0; y < H; ++y) {
+    const std::size_t row_len = static_cast<std::size_t>(W) * C;
+    parallel_rows(H, plan.backend, row_len * ksize + row_len, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
             for (int x = 0; x < W; ++x) {
                 body(y, x);
             }
         }
-        return dst;
-#else
-        [[fallthrough]];
-#endif
-
-    case Backend::Single:
-    case Backend::Auto:
-    default:
-        break;
-    }
+    });
+}
 
-    // single-thread fallback
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            body(y, x);
-        }
+ImageU8 bilateral_filter(const ImageU8& src,
+                         int ksize,
+                         float sigma_color,
+                         float sigma_space,
+                         Border border,
+                         Backend backend,
+                         uint8_t border_value)
+{
+    if (src.empty()) {
+        throw std::invalid_argument("bilateral_filter: src empty");
     }
-
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    bilateral_filter(src, dst, ksize, sigma_color, sigma_space, border, backend, border_value);
     return dst;
 }
 
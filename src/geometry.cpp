@@ -1,8 +1,19 @@
 #include "pixfoundry/geometry.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
+#include "pixfoundry/warp.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace pf {
 
@@ -11,459 +22,553 @@ static inline std::size_t idx(int y, int x, int c,
     return (static_cast<std::size_t>(y) * W + x) * C + c;
 }
 
+// 輸入可能是 view（row pitch != W * C），讀取時用 stride 定址
+static inline std::size_t pidx(int y, int x, int c,
+                               std::size_t stride, int C) {
+    return static_cast<std::size_t>(y) * stride + static_cast<std::size_t>(x) * C + c;
+}
+
 // ======================
-//  Bilinear resize (single)
+//  Separable resize：係數表 + 兩個 pass
 // ======================
-static ImageU8 resize_bilinear_single(const ImageU8& src,
-                                      int new_h,
-                                      int new_w) {
-    if (src.empty()) {
-        throw std::invalid_argument("resize: empty image");
+//
+// 每個軸先算好「每個輸出位置要讀哪些來源 index、權重多少」，
+// 權重存成 Q14 fixed-point（總和剛好 1 << 14），
+// 之後水平 pass / 垂直 pass 都只剩整數乘加，不用再算 floor / clamp。
+// 縮小時 kernel 的支撐範圍會乘上縮放倍率（等於先做 low-pass，避免 aliasing）。
+
+static constexpr int kResizeShift = 14;
+static constexpr int kResizeOne   = 1 << kResizeShift;
+
+struct ResizeTaps {
+    int taps = 0;                 // 每個輸出位置固定 taps 個（不足的補權重 0）
+    std::vector<int>     start;   // out_size：連續 taps 的第一個來源 index
+    std::vector<int16_t> weight;  // out_size * taps，Q14（|w| <= 1，放得進 int16）
+};
+
+static double resize_kernel(Interp interp, double x) {
+    x = std::fabs(x);
+    switch (interp) {
+    case Interp::Bilinear:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case Interp::Bicubic: {
+        // Keys cubic, a = -0.5
+        const double a = -0.5;
+        if (x < 1.0) return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        if (x < 2.0) return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+        return 0.0;
     }
-    if (new_h <= 0 || new_w <= 0) {
-        throw std::invalid_argument("resize: invalid new size");
+    case Interp::Lanczos3: {
+        if (x < 1e-8) return 1.0;
+        if (x >= 3.0) return 0.0;
+        const double pi = std::acos(-1.0);
+        const double px = pi * x;
+        return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
     }
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-
-    const uint8_t* in = src.data();
-    ImageU8 dst(new_h, new_w, C);
-    uint8_t* out = dst.data();
-
-    const float scale_y = static_cast<float>(H) / static_cast<float>(new_h);
-    const float scale_x = static_cast<float>(W) / static_cast<float>(new_w);
-
-    for (int y = 0; y < new_h; ++y) {
-        float sy = (y + 0.5f) * scale_y - 0.5f;
-        int   y0 = static_cast<int>(std::floor(sy));
-        float fy = sy - y0;
-        int   y1 = y0 + 1;
-
-        y0 = std::clamp(y0, 0, H - 1);
-        y1 = std::clamp(y1, 0, H - 1);
-
-        for (int x = 0; x < new_w; ++x) {
-            float sx = (x + 0.5f) * scale_x - 0.5f;
-            int   x0 = static_cast<int>(std::floor(sx));
-            float fx = sx - x0;
-            int   x1 = x0 + 1;
-
-            x0 = std::clamp(x0, 0, W - 1);
-            x1 = std::clamp(x1, 0, W - 1);
-
-            for (int c = 0; c < C; ++c) {
-                float v00 = static_cast<float>(in[idx(y0, x0, c, W, C)]);
-                float v10 = static_cast<float>(in[idx(y0, x1, c, W, C)]);
-                float v01 = static_cast<float>(in[idx(y1, x0, c, W, C)]);
-                float v11 = static_cast<float>(in[idx(y1, x1, c, W, C)]);
-
-                float v0 = v00 + (v10 - v00) * fx;
-                float v1 = v01 + (v11 - v01) * fx;
-                float v  = v0  + (v1  - v0)  * fy;
-
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
-                out[idx(y, x, c, new_w, C)] = static_cast<uint8_t>(v);
-            }
-        }
+    default:
+        return 0.0;
     }
-
-    return dst;
 }
 
-// ======================
-//  Flip (single)
-// ======================
-static ImageU8 flip_horizontal_single(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("flip_horizontal: empty image");
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-    const uint8_t* in = src.data();
+static double resize_support(Interp interp) {
+    switch (interp) {
+    case Interp::Bilinear: return 1.0;
+    case Interp::Bicubic:  return 2.0;
+    case Interp::Lanczos3: return 3.0;
+    default:               return 0.5;
+    }
+}
 
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
+// 把一組 double 權重量化成 Q14，誤差補到最大的那個權重上，確保總和 = 1
+static void quantize_weights(const std::vector<double>& w, int16_t* out) {
+    double sum = 0.0;
+    for (double v : w) sum += v;
+    if (sum == 0.0) sum = 1.0;
+
+    int32_t total = 0;
+    std::size_t imax = 0;
+    for (std::size_t i = 0; i < w.size(); ++i) {
+        out[i] = static_cast<int16_t>(std::lround(w[i] / sum * kResizeOne));
+        total += out[i];
+        if (std::fabs(w[i]) > std::fabs(w[imax])) imax = i;
+    }
+    out[imax] = static_cast<int16_t>(out[imax] + (kResizeOne - total));
+}
 
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            int sx = W - 1 - x;
-            for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, W, C)] = in[idx(y, sx, c, W, C)];
+static ResizeTaps build_resize_taps(int in_size, int out_size, Interp interp) {
+    const double scale = static_cast<double>(in_size) / out_size;
+
+    // 每個輸出位置：連續的來源區間 [lo, lo + w.size()) 和對應權重
+    std::vector<int>                 lo_list(out_size);
+    std::vector<std::vector<double>> w_list(out_size);
+
+    if (interp == Interp::Area) {
+        // 輸出像素 [x*scale, (x+1)*scale) 跟每個來源像素 [i, i+1) 的重疊長度
+        for (int x = 0; x < out_size; ++x) {
+            const double a = x * scale;
+            const double b = (x + 1) * scale;
+            const int i0 = static_cast<int>(std::floor(a));
+            const int i1 = static_cast<int>(std::ceil(b));
+            lo_list[x] = i0;
+            for (int i = i0; i < i1; ++i) {
+                const double ov = std::min<double>(b, i + 1) - std::max<double>(a, i);
+                w_list[x].push_back(std::max(ov, 0.0));
+            }
+        }
+    } else {
+        const double fscale  = std::max(scale, 1.0);
+        const double support = resize_support(interp) * fscale;
+
+        for (int x = 0; x < out_size; ++x) {
+            const double center = (x + 0.5) * scale;
+            const int lo = static_cast<int>(std::floor(center - support));
+            const int hi = static_cast<int>(std::ceil(center + support));
+            lo_list[x] = lo;
+            for (int i = lo; i <= hi; ++i) {
+                w_list[x].push_back(resize_kernel(interp, (i + 0.5 - center) / fscale));
             }
         }
     }
 
-    return dst;
-}
-
-static ImageU8 flip_vertical_single(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("flip_vertical: empty image");
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-    const uint8_t* in = src.data();
-
-    ImageU8 dst(H, W, C);
-    uint8_t* out = dst.data();
-
-    for (int y = 0; y < H; ++y) {
-        int sy = H - 1 - y;
-        for (int x = 0; x < W; ++x) {
-            for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, W, C)] = in[idx(sy, x, c, W, C)];
-            }
+    // 越界的 tap 折回邊界像素（等同 replicate），再去掉頭尾權重為 0 的 tap
+    for (int x = 0; x < out_size; ++x) {
+        auto& w = w_list[x];
+        int lo = lo_list[x];
+        std::vector<double> folded;
+        int flo = std::clamp(lo, 0, in_size - 1);
+        int fhi = std::clamp(lo + static_cast<int>(w.size()) - 1, 0, in_size - 1);
+        folded.assign(static_cast<std::size_t>(fhi - flo + 1), 0.0);
+        for (std::size_t k = 0; k < w.size(); ++k) {
+            const int i = std::clamp(lo + static_cast<int>(k), 0, in_size - 1);
+            folded[static_cast<std::size_t>(i - flo)] += w[k];
         }
+        std::size_t b = 0, e = folded.size();
+        while (b + 1 < e && folded[b] == 0.0) ++b;
+        while (e > b + 1 && folded[e - 1] == 0.0) --e;
+        w.assign(folded.begin() + b, folded.begin() + e);
+        lo_list[x] = flo + static_cast<int>(b);
     }
 
-    return dst;
+    ResizeTaps t;
+    for (int x = 0; x < out_size; ++x) {
+        t.taps = std::max(t.taps, static_cast<int>(w_list[x].size()));
+    }
+    t.taps = std::min(t.taps, in_size);
+
+    t.start.assign(static_cast<std::size_t>(out_size), 0);
+    t.weight.assign(static_cast<std::size_t>(out_size) * t.taps, 0);
+
+    for (int x = 0; x < out_size; ++x) {
+        auto& w = w_list[x];
+        // 補到固定 taps 個：區間往左移，讓 [start, start + taps) 不超出來源
+        int start = std::min(lo_list[x], in_size - t.taps);
+        const int shift = lo_list[x] - start;
+        std::vector<double> padded(static_cast<std::size_t>(t.taps), 0.0);
+        for (std::size_t k = 0; k < w.size(); ++k) padded[k + shift] = w[k];
+        t.start[x] = start;
+        quantize_weights(padded, &t.weight[static_cast<std::size_t>(x) * t.taps]);
+    }
+    return t;
 }
 
-// ======================
-//  Crop (single)
-// ======================
-static ImageU8 crop_single(const ImageU8& src,
-                           int y0,
-                           int x0,
-                           int h,
-                           int w) {
-    if (src.empty()) throw std::invalid_argument("crop: empty image");
-    if (h <= 0 || w <= 0) throw std::invalid_argument("crop: invalid size");
+static inline uint8_t resize_clamp_u8(int32_t acc) {
+    acc = (acc + (kResizeOne >> 1)) >> kResizeShift;
+    return static_cast<uint8_t>(std::clamp(acc, 0, 255));
+}
 
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
+// 水平 pass：src 的 rows [row0, row0 + dst.h()) → dst（寬度 = 輸出寬）
+template <int C>
+static void resize_horizontal(const ImageU8& src, int row0, ImageU8& dst,
+                              const ResizeTaps& tx, Backend exec) {
+    const int Hd = dst.h(), Wd = dst.w(), T = tx.taps;
+    const std::size_t in_stride  = src.stride();
+    const std::size_t out_stride = dst.stride();
     const uint8_t* in = src.data();
-
-    // clamp 範圍
-    int y1 = std::clamp(y0, 0, H);
-    int x1 = std::clamp(x0, 0, W);
-    int y2 = std::clamp(y0 + h, 0, H);
-    int x2 = std::clamp(x0 + w, 0, W);
-
-    int out_h = std::max(0, y2 - y1);
-    int out_w = std::max(0, x2 - x1);
-
-    ImageU8 dst(out_h, out_w, C);
     uint8_t* out = dst.data();
-
-    for (int y = 0; y < out_h; ++y) {
-        for (int x = 0; x < out_w; ++x) {
-            int sy = y1 + y;
-            int sx = x1 + x;
-            for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, out_w, C)] = in[idx(sy, sx, c, W, C)];
+    const int16_t* tw = tx.weight.data();
+
+    parallel_rows(Hd, exec, static_cast<std::size_t>(src.w() + Wd) * C, [&](int ya, int yb) {
+        for (int y = ya; y < yb; ++y) {
+            const uint8_t* row = in + static_cast<std::size_t>(row0 + y) * in_stride;
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            for (int x = 0; x < Wd; ++x) {
+                const uint8_t* p = row + static_cast<std::size_t>(tx.start[x]) * C;
+                const int16_t* xw = tw + static_cast<std::size_t>(x) * T;
+                int32_t acc[C] = {};
+                for (int k = 0; k < T; ++k) {
+                    for (int c = 0; c < C; ++c) acc[c] += xw[k] * p[k * C + c];
+                }
+                for (int c = 0; c < C; ++c) orow[x * C + c] = resize_clamp_u8(acc[c]);
             }
         }
-    }
-
-    return dst;
+    });
 }
 
-// ======================
-//  Rotate (single, keep same size)
-// ======================
-static ImageU8 rotate_single(const ImageU8& src,
-                             float angle_deg) {
-    if (src.empty()) throw std::invalid_argument("rotate: empty image");
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
+// 垂直 pass：每個輸出 row = 幾個來源 row 的加權和；內層沿著整條 row 跑，可以向量化
+static void resize_vertical(const ImageU8& src, int row0, ImageU8& dst,
+                            const ResizeTaps& ty, Backend exec) {
+    const int Hd = dst.h(), T = ty.taps;
+    const std::size_t n = static_cast<std::size_t>(dst.w()) * dst.c();
+    const std::size_t in_stride = src.stride();
     const uint8_t* in = src.data();
-
-    ImageU8 dst(H, W, C);
     uint8_t* out = dst.data();
 
-    const float pi = std::acos(-1.0f);
-    float rad = angle_deg * pi / 180.0f;
-    float cos_t = std::cos(rad);
-    float sin_t = std::sin(rad);
-
-    float cx = (W - 1) * 0.5f;
-    float cy = (H - 1) * 0.5f;
-
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            // 目的座標 (x, y) 對應回原圖座標 (sx, sy)
-            float dx = x - cx;
-            float dy = y - cy;
-
-            float sx =  cos_t * dx + sin_t * dy + cx;
-            float sy = -sin_t * dx + cos_t * dy + cy;
-
-            int x0 = static_cast<int>(std::floor(sx));
-            int y0 = static_cast<int>(std::floor(sy));
-            float fx = sx - x0;
-            float fy = sy - y0;
-
-            // 在邊界外 → 填黑
-            if (x0 < 0 || x0 >= W ||
-                y0 < 0 || y0 >= H) {
-                for (int c = 0; c < C; ++c) {
-                    out[idx(y, x, c, W, C)] = 0;
+    // 每個 row 讀 T 條來源 row、寫一條，中間的 int32 累加器也算進去
+    const std::size_t row_bytes = n * (static_cast<std::size_t>(T) + 1 + sizeof(int32_t));
+    parallel_rows(Hd, exec, row_bytes, [&](int ya, int yb) {
+        std::vector<int32_t> acc(n);
+
+        for (int y = ya; y < yb; ++y) {
+            const int y0 = ty.start[y] - row0;
+            const int16_t* yw = ty.weight.data() + static_cast<std::size_t>(y) * T;
+
+            std::fill(acc.begin(), acc.end(), kResizeOne >> 1);
+            for (int k = 0; k < T; ++k) {
+                const int16_t w = yw[k];
+                if (w == 0) continue;
+                const uint8_t* row = in + static_cast<std::size_t>(y0 + k) * in_stride;
+                int32_t* a = acc.data();
+                // int16 x int16 → int32：SSE2 / NEON 都有對應的 widening multiply
+                for (std::size_t i = 0; i < n; ++i) {
+                    a[i] += static_cast<int32_t>(w) * static_cast<int16_t>(row[i]);
                 }
-                continue;
             }
 
-            int x1 = std::clamp(x0 + 1, 0, W - 1);
-            int y1 = std::clamp(y0 + 1, 0, H - 1);
-
-            for (int c = 0; c < C; ++c) {
-                float v00 = static_cast<float>(in[idx(y0, x0, c, W, C)]);
-                float v10 = static_cast<float>(in[idx(y0, x1, c, W, C)]);
-                float v01 = static_cast<float>(in[idx(y1, x0, c, W, C)]);
-                float v11 = static_cast<float>(in[idx(y1, x1, c, W, C)]);
-
-                float v0 = v00 + (v10 - v00) * fx;
-                float v1 = v01 + (v11 - v01) * fx;
-                float v  = v0  + (v1  - v0)  * fy;
-
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
-                out[idx(y, x, c, W, C)] = static_cast<uint8_t>(v);
+            uint8_t* orow = out + static_cast<std::size_t>(y) * dst.stride();
+            for (std::size_t i = 0; i < n; ++i) {
+                orow[i] = static_cast<uint8_t>(std::clamp(acc[i] >> kResizeShift, 0, 255));
             }
         }
-    }
-
-    return dst;
+    });
 }
 
-// ======================
-//  Bilinear resize (openmp)
-// ======================
-static ImageU8 resize_bilinear_openmp(const ImageU8& src,
-                                      int new_h,
-                                      int new_w) {
-    if (src.empty()) {
-        throw std::invalid_argument("resize: empty image");
+// nearest：只需要查表搬資料
+static void resize_nearest(const ImageU8& src, ImageU8& dst, Backend exec) {
+    const int H = src.h(), W = src.w(), C = src.c();
+    const int new_h = dst.h(), new_w = dst.w();
+    std::vector<std::size_t> xoff(new_w);
+    std::vector<int> ysrc(new_h);
+    const double sx = static_cast<double>(W) / new_w;
+    const double sy = static_cast<double>(H) / new_h;
+    for (int x = 0; x < new_w; ++x) {
+        xoff[x] = static_cast<std::size_t>(std::min(static_cast<int>((x + 0.5) * sx), W - 1)) * C;
     }
-    if (new_h <= 0 || new_w <= 0) {
-        throw std::invalid_argument("resize: invalid new size");
+    for (int y = 0; y < new_h; ++y) {
+        ysrc[y] = std::min(static_cast<int>((y + 0.5) * sy), H - 1);
     }
 
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-
     const uint8_t* in = src.data();
-    ImageU8 dst(new_h, new_w, C);
     uint8_t* out = dst.data();
-
-    const float scale_y = static_cast<float>(H) / static_cast<float>(new_h);
-    const float scale_x = static_cast<float>(W) / static_cast<float>(new_w);
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for
-#endif
-    for (int y = 0; y < new_h; ++y) {
-        float sy = (y + 0.5f) * scale_y - 0.5f;
-        int   y0 = static_cast<int>(std::floor(sy));
-        float fy = sy - y0;
-        int   y1 = y0 + 1;
-
-        y0 = std::clamp(y0, 0, H - 1);
-        y1 = std::clamp(y1, 0, H - 1);
-
-        for (int x = 0; x < new_w; ++x) {
-            float sx = (x + 0.5f) * scale_x - 0.5f;
-            int   x0 = static_cast<int>(std::floor(sx));
-            float fx = sx - x0;
-            int   x1 = x0 + 1;
-
-            x0 = std::clamp(x0, 0, W - 1);
-            x1 = std::clamp(x1, 0, W - 1);
-
-            for (int c = 0; c < C; ++c) {
-                float v00 = static_cast<float>(in[idx(y0, x0, c, W, C)]);
-                float v10 = static_cast<float>(in[idx(y0, x1, c, W, C)]);
-                float v01 = static_cast<float>(in[idx(y1, x0, c, W, C)]);
-                float v11 = static_cast<float>(in[idx(y1, x1, c, W, C)]);
-
-                float v0 = v00 + (v10 - v00) * fx;
-                float v1 = v01 + (v11 - v01) * fx;
-                float v  = v0  + (v1  - v0)  * fy;
-
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
-                out[idx(y, x, c, new_w, C)] = static_cast<uint8_t>(v);
+    const std::size_t in_stride  = src.stride();
+    const std::size_t out_stride = dst.stride();
+
+    parallel_rows(new_h, exec, static_cast<std::size_t>(new_w) * C * 2, [&](int ya, int yb) {
+        for (int y = ya; y < yb; ++y) {
+            const uint8_t* row = in + static_cast<std::size_t>(ysrc[y]) * in_stride;
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            if (C == 1) {
+                for (int x = 0; x < new_w; ++x) orow[x] = row[xoff[x]];
+            } else {
+                for (int x = 0; x < new_w; ++x) {
+                    const uint8_t* p = row + xoff[x];
+                    orow[3 * x + 0] = p[0];
+                    orow[3 * x + 1] = p[1];
+                    orow[3 * x + 2] = p[2];
+                }
             }
         }
+    });
+}
+
+static void resize_separable(const ImageU8& src, ImageU8& dst,
+                             Interp interp, Backend exec) {
+    if (interp == Interp::Nearest) {
+        resize_nearest(src, dst, exec);
+        return;
     }
 
-    return dst;
+    const int H = src.h(), W = src.w(), C = src.c();
+    const int new_h = dst.h(), new_w = dst.w();
+    const ResizeTaps tx = build_resize_taps(W, new_w, interp);
+    const ResizeTaps ty = build_resize_taps(H, new_h, interp);
+
+    // 垂直 taps 實際用到的來源 rows 範圍（縮小時不必水平處理全部 rows）
+    const int rlo  = ty.start.front();
+    const int rows = ty.start.back() + ty.taps - rlo;
+
+    // 兩種順序挑成本低的：先水平（rows x new_w）或先垂直（new_h x W）
+    // 垂直 pass 沿整條 row 連續乘加、可以向量化，水平 pass 要 gather，大約貴 4 倍
+    const double kH = 4.0;
+    const double cost_hv = kH * rows * new_w * tx.taps
+                         + static_cast<double>(new_h) * new_w * ty.taps;
+    const double cost_vh = static_cast<double>(new_h) * W * ty.taps
+                         + kH * new_h * new_w * tx.taps;
+
+    if (cost_hv <= cost_vh) {
+        ImageU8 tmp(rows, new_w, C, Init::None, RowPad::CacheLine);
+        if (C == 1) resize_horizontal<1>(src, rlo, tmp, tx, exec);
+        else        resize_horizontal<3>(src, rlo, tmp, tx, exec);
+        resize_vertical(tmp, rlo, dst, ty, exec);
+    } else {
+        ImageU8 tmp(new_h, W, C, Init::None, RowPad::CacheLine);
+        resize_vertical(src, 0, tmp, ty, exec);
+        if (C == 1) resize_horizontal<1>(tmp, 0, dst, tx, exec);
+        else        resize_horizontal<3>(tmp, 0, dst, tx, exec);
+    }
 }
 
 // ======================
-//  Flip (openmp)
+//  Flip：處理 [y0, y1) 這幾個輸出 row
 // ======================
-static ImageU8 flip_horizontal_openmp(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("flip_horizontal: empty image");
-
-    const int H = src.h();
+static void flip_horizontal_rows(const ImageU8& src, ImageU8& dst, int y0, int y1) {
     const int W = src.w();
     const int C = src.c();
     const uint8_t* in = src.data();
+    const std::size_t S = src.stride();
 
-    ImageU8 dst(H, W, C);
     uint8_t* out = dst.data();
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
         for (int x = 0; x < W; ++x) {
             int sx = W - 1 - x;
             for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, W, C)] = in[idx(y, sx, c, W, C)];
+                out[idx(y, x, c, W, C)] = in[pidx(y, sx, c, S, C)];
             }
         }
     }
-    return dst;
 }
 
-static ImageU8 flip_vertical_openmp(const ImageU8& src) {
-    if (src.empty()) throw std::invalid_argument("flip_vertical: empty image");
-
+static void flip_vertical_rows(const ImageU8& src, ImageU8& dst, int y0, int y1) {
     const int H = src.h();
     const int W = src.w();
     const int C = src.c();
     const uint8_t* in = src.data();
+    const std::size_t S = src.stride();
 
-    ImageU8 dst(H, W, C);
     uint8_t* out = dst.data();
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
-#endif
-    for (int y = 0; y < H; ++y) {
+    for (int y = y0; y < y1; ++y) {
+        int sy = H - 1 - y;
         for (int x = 0; x < W; ++x) {
-            int sy = H - 1 - y;   // ✅ 移到這裡
             for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, W, C)] =
-                    in[idx(sy, x, c, W, C)];
+                out[idx(y, x, c, W, C)] = in[pidx(sy, x, c, S, C)];
             }
         }
     }
-
-    return dst;
 }
 
 // ======================
-//  Crop (openmp)
+//  Flip (in-place)：成對交換，每一對只會被一個 thread 碰到
 // ======================
-static ImageU8 crop_openmp(const ImageU8& src,
-                           int y0,
-                           int x0,
-                           int h,
-                           int w) {
-    if (src.empty()) throw std::invalid_argument("crop: empty image");
-    if (h <= 0 || w <= 0) throw std::invalid_argument("crop: invalid size");
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
-    const uint8_t* in = src.data();
+static void flip_horizontal_inplace(ImageU8& img, Backend exec) {
+    const int H = img.h(), W = img.w(), C = img.c();
+
+    parallel_rows(H, exec, static_cast<std::size_t>(W) * C * 2, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            uint8_t* row = img.row(y);
+            for (int x = 0; x < W / 2; ++x) {
+                uint8_t* a = row + static_cast<std::size_t>(x) * C;
+                uint8_t* b = row + static_cast<std::size_t>(W - 1 - x) * C;
+                for (int c = 0; c < C; ++c) std::swap(a[c], b[c]);
+            }
+        }
+    });
+}
 
-    int y1 = std::clamp(y0, 0, H);
-    int x1 = std::clamp(x0, 0, W);
-    int y2 = std::clamp(y1 + h, 0, H);
-    int x2 = std::clamp(x1 + w, 0, W);
+// 切的是「上半部的 row」：每個 band 連同下半部對應的 row 一起交換
+static void flip_vertical_inplace(ImageU8& img, Backend exec) {
+    const int H = img.h();
+    const std::size_t row_len = static_cast<std::size_t>(img.w()) * img.c();
 
-    int out_h = y2 - y1;
-    int out_w = x2 - x1;
+    parallel_rows(H / 2, exec, row_len * 4, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            std::swap_ranges(img.row(y), img.row(y) + row_len, img.row(H - 1 - y));
+        }
+    });
+}
 
-    ImageU8 dst(out_h, out_w, C);
-    uint8_t* out = dst.data();
+// ======================
+//  90 度倍數旋轉 / transpose（無損，輸出尺寸對調）
+// ======================
+//
+// dst 是 W x H，src 的 (y, x) 搬到 dst 的 (i, j)：
+//   Transpose: i = x,         j = y
+//   Cw90:      i = x,         j = H - 1 - y
+//   Ccw90:     i = W - 1 - x, j = y
+// 以 64x64 pixel 的 tile 為單位（tile 內的讀寫都留在 L1），一整排 tile 是一個平行單位；
+// 單通道的完整 16x16 block 用 SSE2 unpack 做 byte transpose。
+
+enum class QuarterTurn { Transpose, Cw90, Ccw90 };
+
+static constexpr int kQuarterTile = 64;
+
+#if defined(__SSE2__)
+// 16 條 row 各 16 bytes → 16 條 column；同樣的 unpack 做 4 輪就是 16x16 transpose
+static inline void transpose16x16_u8(const uint8_t* const rows[16], uint8_t* const cols[16]) {
+    __m128i x[16], y[16];
+    for (int k = 0; k < 16; ++k) x[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k]));
+    for (int round = 0; round < 4; ++round) {
+        for (int k = 0; k < 8; ++k) {
+            y[2 * k]     = _mm_unpacklo_epi8(x[k], x[k + 8]);
+            y[2 * k + 1] = _mm_unpackhi_epi8(x[k], x[k + 8]);
+        }
+        for (int k = 0; k < 16; ++k) x[k] = y[k];
+    }
+    for (int k = 0; k < 16; ++k) _mm_storeu_si128(reinterpret_cast<__m128i*>(cols[k]), x[k]);
+}
+#endif
 
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
+template <int C>
+static void quarter_tile(const uint8_t* in, std::size_t in_stride, int H, int W,
+                         uint8_t* out, std::size_t out_stride,
+                         QuarterTurn turn, int y0, int y1, int x0, int x1) {
+
+    auto dst_row = [&](int x) { return turn == QuarterTurn::Ccw90 ? W - 1 - x : x; };
+    auto dst_col = [&](int y) { return turn == QuarterTurn::Cw90  ? H - 1 - y : y; };
+
+    int xs = x0, ys = y0;
+#if defined(__SSE2__)
+    if (C == 1) {
+        // tile 裡完整的 16x16 block 走 SIMD，剩下的邊條交給下面的 scalar
+        const int ybe = y0 + ((y1 - y0) / 16) * 16;
+        const int xbe = x0 + ((x1 - x0) / 16) * 16;
+        for (int by = y0; by < ybe; by += 16) {
+            // Cw90 的 dst column 跟 y 反向：倒著載入 row，transpose 完剛好是遞增的 column
+            const bool rev = (turn == QuarterTurn::Cw90);
+            const int j0 = rev ? H - 1 - (by + 15) : by;
+            for (int bx = x0; bx < xbe; bx += 16) {
+                const uint8_t* rows[16];
+                uint8_t* cols[16];
+                for (int k = 0; k < 16; ++k) {
+                    const int sy = rev ? by + 15 - k : by + k;
+                    rows[k] = in + static_cast<std::size_t>(sy) * in_stride + bx;
+                    cols[k] = out + static_cast<std::size_t>(dst_row(bx + k)) * out_stride + j0;
+                }
+                transpose16x16_u8(rows, cols);
+            }
+        }
+        // 右邊 / 下面不滿 16 的部分
+        if (xbe < x1) {
+            for (int x = xbe; x < x1; ++x) {
+                uint8_t* orow = out + static_cast<std::size_t>(dst_row(x)) * out_stride;
+                for (int y = y0; y < y1; ++y) orow[dst_col(y)] = in[static_cast<std::size_t>(y) * in_stride + x];
+            }
+        }
+        xs = x0; x1 = xbe;
+        ys = ybe;
+    }
 #endif
-    for (int y = 0; y < out_h; ++y) {
-        for (int x = 0; x < out_w; ++x) {
-            int sy = y1 + y;
-            int sx = x1 + x;
-            for (int c = 0; c < C; ++c) {
-                out[idx(y, x, c, out_w, C)] = in[idx(sy, sx, c, W, C)];
+    if (ys >= y1) return;
+    // 每個 x 對應 dst 的一段連續 column；一律讓 q 往前走（Cw90 就倒著讀 src）
+    const bool rev = (turn == QuarterTurn::Cw90);
+    const std::ptrdiff_t dp = rev ? -static_cast<std::ptrdiff_t>(in_stride)
+                                  : static_cast<std::ptrdiff_t>(in_stride);
+    const int n = y1 - ys;
+    for (int x = xs; x < x1; ++x) {
+        const int yfirst = rev ? y1 - 1 : ys;
+        const uint8_t* p = in + static_cast<std::size_t>(yfirst) * in_stride + static_cast<std::size_t>(x) * C;
+        uint8_t* q = out + static_cast<std::size_t>(dst_row(x)) * out_stride
+                         + static_cast<std::size_t>(dst_col(yfirst)) * C;
+        if (C == 1) {
+            for (int k = 0; k < n; ++k, p += dp) q[k] = *p;
+        } else {
+            // 3 bytes 的 pixel 用 4 bytes 搬：多寫的那個 byte 馬上會被下一個 pixel 蓋掉。
+            // 最後一個 pixel（寫出去會碰到別的 tile）和最後一個 column（讀會超出 buffer）照常 3 bytes。
+            int k = 0;
+            if (x + 1 < W) {
+                for (; k + 1 < n; ++k, p += dp) {
+                    uint32_t v;
+                    std::memcpy(&v, p, 4);
+                    std::memcpy(q + 3 * k, &v, 4);
+                }
+            }
+            for (; k < n; ++k, p += dp) {
+                q[3 * k + 0] = p[0];
+                q[3 * k + 1] = p[1];
+                q[3 * k + 2] = p[2];
             }
         }
     }
-
-    return dst;
 }
 
-// ======================
-//  Rotate (openmp, keep same size)
-// ======================
-static ImageU8 rotate_openmp(const ImageU8& src,
-                             float angle_deg) {
-    if (src.empty()) throw std::invalid_argument("rotate: empty image");
-
-    const int H = src.h();
-    const int W = src.w();
-    const int C = src.c();
+static void quarter_turn(const ImageU8& src, ImageU8& dst, QuarterTurn turn, Backend exec) {
+    const int H = src.h(), W = src.w(), C = src.c();
     const uint8_t* in = src.data();
-
-    ImageU8 dst(H, W, C);
     uint8_t* out = dst.data();
+    const std::size_t in_stride = src.stride(), out_stride = dst.stride();
+
+    const int tiles_y = (H + kQuarterTile - 1) / kQuarterTile;
+    const int tiles_x = (W + kQuarterTile - 1) / kQuarterTile;
+    const std::size_t tile_row_bytes = static_cast<std::size_t>(kQuarterTile) * W * C * 2;
+
+    parallel_rows(tiles_y, exec, tile_row_bytes, [&](int ty0, int ty1) {
+        for (int ty = ty0; ty < ty1; ++ty) {
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                const int y0 = ty * kQuarterTile, y1 = std::min(y0 + kQuarterTile, H);
+                const int x0 = tx * kQuarterTile, x1 = std::min(x0 + kQuarterTile, W);
+                if (C == 1) quarter_tile<1>(in, in_stride, H, W, out, out_stride, turn, y0, y1, x0, x1);
+                else        quarter_tile<3>(in, in_stride, H, W, out, out_stride, turn, y0, y1, x0, x1);
+            }
+        }
+    });
+}
 
-    const float pi = std::acos(-1.0f);
-    float rad = angle_deg * pi / 180.0f;
-    float cos_t = std::cos(rad);
-    float sin_t = std::sin(rad);
-
-    float cx = (W - 1) * 0.5f;
-    float cy = (H - 1) * 0.5f;
-
-#ifdef PF_HAS_OPENMP
-#pragma omp parallel for collapse(2)
+// 180 度：dst 第 y 條 row = src 第 H-1-y 條 row 倒過來
+template <int C>
+static void reverse_row(const uint8_t* in, uint8_t* out, int W) {
+    int x = 0;
+#if defined(__SSE2__)
+    if (C == 1) {
+        // 16 bytes 倒序：16-bit 內交換 → 64-bit 內 word 倒序 → 兩個 64-bit 對調
+        for (; x + 16 <= W; x += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + W - 16 - x));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            v = _mm_shufflelo_epi16(v, 0x1B);
+            v = _mm_shufflehi_epi16(v, 0x1B);
+            v = _mm_shuffle_epi32(v, 0x4E);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), v);
+        }
+    }
 #endif
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            float dx = x - cx;
-            float dy = y - cy;
-
-            float sx =  cos_t * dx + sin_t * dy + cx;
-            float sy = -sin_t * dx + cos_t * dy + cy;
-
-            int x0 = static_cast<int>(std::floor(sx));
-            int y0 = static_cast<int>(std::floor(sy));
-            float fx = sx - x0;
-            float fy = sy - y0;
-
-            if (x0 < 0 || x0 >= W || y0 < 0 || y0 >= H) {
-                for (int c = 0; c < C; ++c) {
-                    out[idx(y, x, c, W, C)] = 0;
-                }
-                continue;
-            }
+    for (; x < W; ++x) {
+        const uint8_t* p = in + static_cast<std::size_t>(W - 1 - x) * C;
+        for (int c = 0; c < C; ++c) out[static_cast<std::size_t>(x) * C + c] = p[c];
+    }
+}
 
-            int x1 = std::clamp(x0 + 1, 0, W - 1);
-            int y1 = std::clamp(y0 + 1, 0, H - 1);
+static void rotate180_impl(const ImageU8& src, ImageU8& dst, Backend exec) {
+    const int H = src.h(), W = src.w(), C = src.c();
+    const std::size_t in_stride = src.stride(), out_stride = dst.stride();
+    const uint8_t* in = src.data();
+    uint8_t* out = dst.data();
 
-            for (int c = 0; c < C; ++c) {
-                float v00 = static_cast<float>(in[idx(y0, x0, c, W, C)]);
-                float v10 = static_cast<float>(in[idx(y0, x1, c, W, C)]);
-                float v01 = static_cast<float>(in[idx(y1, x0, c, W, C)]);
-                float v11 = static_cast<float>(in[idx(y1, x1, c, W, C)]);
-
-                float v0 = v00 + (v10 - v00) * fx;
-                float v1 = v01 + (v11 - v01) * fx;
-                float v  = v0  + (v1  - v0)  * fy;
-
-                v = std::round(v);
-                v = std::clamp(v, 0.0f, 255.0f);
-                out[idx(y, x, c, W, C)] = static_cast<uint8_t>(v);
-            }
+    parallel_rows(H, exec, static_cast<std::size_t>(W) * C * 2, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* irow = in + static_cast<std::size_t>(H - 1 - y) * in_stride;
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            if (C == 1) reverse_row<1>(irow, orow, W);
+            else        reverse_row<3>(irow, orow, W);
         }
-    }
+    });
+}
 
-    return dst;
+// ======================
+//  Auto 用的成本描述（每個輸出 pixel-channel）
+// ======================
+static const OpCost kResizeCost {2.0f, 1.0f,  2};
+static const OpCost kFlipCost   {2.0f, 0.2f,  1};
+static const OpCost kQuarterCost{2.0f, 0.1f,  1};
+
+// 每個輸出 pixel-channel 約 taps_x + taps_y 次整數乘加
+OpCost resize_cost(Interp interp, double fy, double fx) {
+    const double support = (interp == Interp::Nearest) ? 0.0 : 2.0 * resize_support(interp);
+    return OpCost{kResizeCost.bytes_per_elem,
+                  static_cast<float>(0.25 * support * (fy + fx)) + kResizeCost.ops_per_elem,
+                  kResizeCost.regions};
 }
 
+OpCost flip_cost()         { return kFlipCost; }
+OpCost quarter_turn_cost() { return kQuarterCost; }
 
 // ======================
 //  Public APIs with Backend
@@ -473,77 +578,105 @@ ImageU8 resize(const ImageU8& src,
                int new_h,
                int new_w,
                Backend backend) {
-    backend = normalize_backend(backend);
+    return resize(src, new_h, new_w, Interp::Bilinear, backend);
+}
 
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
+void resize(const ImageU8& src,
+            ImageU8& dst,
+            Interp interp,
+            Backend backend) {
+    if (src.empty()) {
+        throw std::invalid_argument("resize: empty image");
     }
+    if (dst.empty()) {
+        throw std::invalid_argument("resize: invalid new size");
+    }
+    check_output(dst, dst.h(), dst.w(), src.c(), "resize");
+    check_no_overlap(src, dst, "resize");
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return resize_bilinear_openmp(src, new_h, new_w);
-#else
-        return resize_bilinear_single(src, new_h, new_w);
-#endif
-    case Backend::Single:
-    default:
-        return resize_bilinear_single(src, new_h, new_w);
+    const int new_h = dst.h(), new_w = dst.w();
+    const double fy = std::max(1.0, static_cast<double>(src.h()) / new_h);
+    const double fx = std::max(1.0, static_cast<double>(src.w()) / new_w);
+    ExecPlan plan = plan_execution(backend, resize_cost(interp, fy, fx),
+                                   static_cast<std::size_t>(new_h) * new_w * src.c());
+    ThreadScope threads(plan);
+
+    resize_separable(src, dst, interp, plan.backend);
+}
+
+ImageU8 resize(const ImageU8& src,
+               int new_h,
+               int new_w,
+               Interp interp,
+               Backend backend) {
+    if (src.empty()) {
+        throw std::invalid_argument("resize: empty image");
     }
+    if (new_h <= 0 || new_w <= 0) {
+        throw std::invalid_argument("resize: invalid new size");
+    }
+    ImageU8 dst(new_h, new_w, src.c(), Init::None);
+    resize(src, dst, interp, backend);
+    return dst;
+}
+
+// dst 就是 src 時改走成對交換的 in-place 版本
+void flip_horizontal(const ImageU8& src,
+                     ImageU8& dst,
+                     Backend backend) {
+    if (src.empty()) throw std::invalid_argument("flip_horizontal: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "flip_horizontal");
+    check_no_overlap(src, dst, "flip_horizontal", true);
+
+    ExecPlan plan = plan_execution(backend, kFlipCost, src);
+    ThreadScope threads(plan);
+
+    if (same_pixels(src, dst)) {
+        flip_horizontal_inplace(dst, plan.backend);
+        return;
+    }
+
+    parallel_rows(src.h(), plan.backend, static_cast<std::size_t>(src.w()) * src.c() * 2,
+                  [&](int y0, int y1) {
+        flip_horizontal_rows(src, dst, y0, y1);
+    });
 }
 
 ImageU8 flip_horizontal(const ImageU8& src,
                         Backend backend) {
-    backend = normalize_backend(backend);
+    if (src.empty()) throw std::invalid_argument("flip_horizontal: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    flip_horizontal(src, dst, backend);
+    return dst;
+}
 
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+void flip_vertical(const ImageU8& src,
+                   ImageU8& dst,
+                   Backend backend) {
+    if (src.empty()) throw std::invalid_argument("flip_vertical: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "flip_vertical");
+    check_no_overlap(src, dst, "flip_vertical", true);
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return flip_horizontal_openmp(src);
-#else
-        return flip_horizontal_single(src);
-#endif
-    case Backend::Single:
-    default:
-        return flip_horizontal_single(src);
+    ExecPlan plan = plan_execution(backend, kFlipCost, src);
+    ThreadScope threads(plan);
+
+    if (same_pixels(src, dst)) {
+        flip_vertical_inplace(dst, plan.backend);
+        return;
     }
+
+    parallel_rows(src.h(), plan.backend, static_cast<std::size_t>(src.w()) * src.c() * 2,
+                  [&](int y0, int y1) {
+        flip_vertical_rows(src, dst, y0, y1);
+    });
 }
 
 ImageU8 flip_vertical(const ImageU8& src,
                       Backend backend) {
-    backend = normalize_backend(backend);
-
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
-
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return flip_vertical_openmp(src);
-#else
-        return flip_vertical_single(src);
-#endif
-    case Backend::Single:
-    default:
-        return flip_vertical_single(src);
-    }
+    if (src.empty()) throw std::invalid_argument("flip_vertical: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    flip_vertical(src, dst, backend);
+    return dst;
 }
 
 ImageU8 crop(const ImageU8& src,
@@ -552,53 +685,129 @@ ImageU8 crop(const ImageU8& src,
              int h,
              int w,
              Backend backend) {
-    backend = normalize_backend(backend);
+    // crop 不搬 pixel，只回傳共用 buffer 的 view，所以 backend 用不到（保留參數維持 API）
+    (void)backend;
+    if (src.empty()) throw std::invalid_argument("crop: empty image");
+    if (h <= 0 || w <= 0) throw std::invalid_argument("crop: invalid size");
 
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+    // clamp 範圍（用 int64 避免 y + h 溢位）
+    const int64_t H = src.h(), W = src.w();
+    const int64_t y1 = std::clamp<int64_t>(y, 0, H);
+    const int64_t x1 = std::clamp<int64_t>(x, 0, W);
+    const int64_t y2 = std::clamp<int64_t>(static_cast<int64_t>(y) + h, 0, H);
+    const int64_t x2 = std::clamp<int64_t>(static_cast<int64_t>(x) + w, 0, W);
+    if (y2 <= y1 || x2 <= x1) throw std::invalid_argument("crop: region outside image");
+    if (y1 == 0 && x1 == 0 && y2 == H && x2 == W) return src.share();  // 整張圖
+
+    return src.view(static_cast<int>(y1), static_cast<int>(x1),
+                    static_cast<int>(y2 - y1), static_cast<int>(x2 - x1));
+}
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return crop_openmp(src, y, x, h, w);
-#else
-        return crop_single(src, y, x, h, w);
-#endif
-    case Backend::Single:
-    default:
-        return crop_single(src, y, x, h, w);
-    }
+
+// 90 / 270 度與 transpose 共用：dst 是 w x h
+static void quarter_turn_into(const ImageU8& src, ImageU8& dst, QuarterTurn turn,
+                              Backend backend, const char* name) {
+    if (src.empty()) throw std::invalid_argument(std::string(name) + ": empty image");
+    check_output(dst, src.w(), src.h(), src.c(), name);
+    check_no_overlap(src, dst, name);
+
+    ExecPlan plan = plan_execution(backend, kQuarterCost, src);
+    ThreadScope threads(plan);
+    quarter_turn(src, dst, turn, plan.backend);
 }
 
-ImageU8 rotate(const ImageU8& src,
-               float angle_deg,
+static ImageU8 quarter_turn_alloc(const ImageU8& src, QuarterTurn turn,
+                                  Backend backend, const char* name) {
+    if (src.empty()) throw std::invalid_argument(std::string(name) + ": empty image");
+    ImageU8 dst(src.w(), src.h(), src.c(), Init::None);
+    quarter_turn_into(src, dst, turn, backend, name);
+    return dst;
+}
+
+void transpose(const ImageU8& src,
+               ImageU8& dst,
                Backend backend) {
-    backend = normalize_backend(backend);
+    quarter_turn_into(src, dst, QuarterTurn::Transpose, backend, "transpose");
+}
 
-    if (backend == Backend::Auto) {
-#ifdef PF_HAS_OPENMP
-        backend = Backend::OpenMP;
-#else
-        backend = Backend::Single;
-#endif
-    }
+ImageU8 transpose(const ImageU8& src,
+                  Backend backend) {
+    return quarter_turn_alloc(src, QuarterTurn::Transpose, backend, "transpose");
+}
 
-    switch (backend) {
-    case Backend::OpenMP:
-#ifdef PF_HAS_OPENMP
-        return rotate_openmp(src, angle_deg);
-#else
-        return rotate_single(src, angle_deg);
-#endif
-    case Backend::Single:
-    default:
-        return rotate_single(src, angle_deg);
-    }
+void rotate90(const ImageU8& src,
+              ImageU8& dst,
+              Backend backend) {
+    quarter_turn_into(src, dst, QuarterTurn::Cw90, backend, "rotate90");
+}
+
+ImageU8 rotate90(const ImageU8& src,
+                 Backend backend) {
+    return quarter_turn_alloc(src, QuarterTurn::Cw90, backend, "rotate90");
+}
+
+void rotate180(const ImageU8& src,
+               ImageU8& dst,
+               Backend backend) {
+    if (src.empty()) throw std::invalid_argument("rotate180: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "rotate180");
+    check_no_overlap(src, dst, "rotate180");
+
+    ExecPlan plan = plan_execution(backend, kQuarterCost, src);
+    ThreadScope threads(plan);
+    rotate180_impl(src, dst, plan.backend);
+}
+
+ImageU8 rotate180(const ImageU8& src,
+                  Backend backend) {
+    if (src.empty()) throw std::invalid_argument("rotate180: empty image");
+    ImageU8 dst(src.h(), src.w(), src.c(), Init::None);
+    rotate180(src, dst, backend);
+    return dst;
+}
+
+void rotate270(const ImageU8& src,
+               ImageU8& dst,
+               Backend backend) {
+    quarter_turn_into(src, dst, QuarterTurn::Ccw90, backend, "rotate270");
+}
+
+ImageU8 rotate270(const ImageU8& src,
+                  Backend backend) {
+    return quarter_turn_alloc(src, QuarterTurn::Ccw90, backend, "rotate270");
+}
+
+// 以 ((W-1)/2, (H-1)/2) 為中心，直接給 dst → src 的矩陣交給 warp_affine
+static std::array<double, 6> rotate_matrix(const ImageU8& src, float angle_deg) {
+    const double pi  = std::acos(-1.0);
+    const double rad = static_cast<double>(angle_deg) * pi / 180.0;
+    const double cos_t = std::cos(rad);
+    const double sin_t = std::sin(rad);
+    const double cx = (src.w() - 1) * 0.5;
+    const double cy = (src.h() - 1) * 0.5;
+
+    return {
+         cos_t, sin_t, cx - cos_t * cx - sin_t * cy,
+        -sin_t, cos_t, cy + sin_t * cx - cos_t * cy,
+    };
+}
+
+void rotate(const ImageU8& src,
+            ImageU8& dst,
+            float angle_deg,
+            Backend backend) {
+    if (src.empty()) throw std::invalid_argument("rotate: empty image");
+    check_output(dst, src.h(), src.w(), src.c(), "rotate");
+    warp_affine(src, dst, rotate_matrix(src, angle_deg), Interp::Bilinear,
+                Border::Constant, backend, 0, /*inverse_map=*/true);
+}
+
+ImageU8 rotate(const ImageU8& src,
+               float angle_deg,
+               Backend backend) {
+    if (src.empty()) throw std::invalid_argument("rotate: empty image");
+    return warp_affine(src, rotate_matrix(src, angle_deg), src.h(), src.w(), Interp::Bilinear,
+                       Border::Constant, backend, 0, /*inverse_map=*/true);
 }
 
 } // namespace pf
@@ -0,0 +1,208 @@
+#include "pixfoundry/io.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace pf {
+
+// 寫檔要緊密排列的 rows：view 先複製一份
+static void save_one(const std::string& path, const ImageU8& img, const EncodeOptions& options) {
+    if (img.empty()) throw std::invalid_argument("save_image: empty image for " + path);
+    if (img.is_contiguous()) {
+        save_image_u8(path, img.data(), img.h(), img.w(), img.c(), options);
+    } else {
+        const ImageU8 packed = img.clone();
+        save_image_u8(path, packed.data(), packed.h(), packed.w(), packed.c(), options);
+    }
+}
+
+static int io_threads(int requested, std::size_t depth) {
+    if (requested > 0) return requested;
+    return std::max(1, std::min(static_cast<int>(depth), available_cpus()));
+}
+
+// ======================
+//  批次
+// ======================
+
+// 呼叫端在 parallel_for 裡一起做的那幾張跟 worker 一樣算 pool 的工作（ThreadPool::in_pool_work）：
+// 裡面的 Auto 運算（max_size 的 resize）不會再當成新的頂層呼叫多要一份 thread
+std::vector<ImageU8> load_images(const std::vector<std::string>& paths, int max_size) {
+    std::vector<ImageU8> out(paths.size());
+    ThreadPool::instance().parallel_for(0, static_cast<long>(paths.size()), 1, [&](long b, long e) {
+        for (long i = b; i < e; ++i) out[i] = load_image_u8(paths[i], max_size);
+    });
+    return out;
+}
+
+void save_images(const std::vector<std::string>& paths, const std::vector<ImageU8>& images,
+                 const EncodeOptions& options) {
+    if (paths.size() != images.size()) {
+        throw std::invalid_argument("save_images: got " + std::to_string(paths.size()) + " paths but " +
+                                    std::to_string(images.size()) + " images");
+    }
+    ThreadPool::instance().parallel_for(0, static_cast<long>(paths.size()), 1, [&](long b, long e) {
+        for (long i = b; i < e; ++i) save_one(paths[i], images[i], options);
+    });
+}
+
+// ======================
+//  ImageReader
+// ======================
+
+ImageReader::ImageReader(std::vector<std::string> paths, int prefetch, int threads, int max_size)
+    : paths_(std::move(paths)),
+      prefetch_(static_cast<std::size_t>(std::max(1, prefetch))),
+      max_size_(max_size),
+      slots_(paths_.size()) {
+    const int n = std::min(io_threads(threads, prefetch_), static_cast<int>(paths_.size()));
+    threads_.reserve(n);
+    for (int i = 0; i < n; ++i) threads_.emplace_back([this] { worker_loop(); });
+}
+
+ImageReader::~ImageReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : threads_) t.join();
+}
+
+void ImageReader::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // 只讀到 consumed_ + prefetch_ 為止，呼叫端沒拿走就先停
+        cv_.wait(lock, [this] {
+            return stop_ || claimed_ >= paths_.size() || claimed_ < consumed_ + prefetch_;
+        });
+        if (stop_ || claimed_ >= paths_.size()) return;
+        const std::size_t i = claimed_++;
+
+        lock.unlock();
+        Slot slot;
+        try {
+            slot.img = load_image_u8(paths_[i], max_size_);
+        } catch (...) {
+            slot.error = std::current_exception();
+        }
+        slot.ready = true;
+        lock.lock();
+
+        slots_[i] = std::move(slot);
+        cv_.notify_all();
+    }
+}
+
+bool ImageReader::next(ImageU8& img) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 可能有好幾條 thread 同時在拿：每次醒來都看「現在輪到的那一張」
+    cv_.wait(lock, [this] { return consumed_ >= paths_.size() || slots_[consumed_].ready; });
+    if (consumed_ >= paths_.size()) return false;
+
+    Slot slot = std::move(slots_[consumed_]);
+    slots_[consumed_].ready = false;
+    ++consumed_;
+    lock.unlock();
+    cv_.notify_all();  // 讓出一個預讀的名額
+
+    if (slot.error) std::rethrow_exception(slot.error);
+    img = std::move(slot.img);
+    return true;
+}
+
+std::size_t ImageReader::consumed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consumed_;
+}
+
+// ======================
+//  ImageWriter
+// ======================
+
+ImageWriter::ImageWriter(int queue_depth, int threads, const EncodeOptions& options)
+    : depth_(static_cast<std::size_t>(std::max(1, queue_depth))), options_(options) {
+    const int n = io_threads(threads, depth_);
+    threads_.reserve(n);
+    for (int i = 0; i < n; ++i) threads_.emplace_back([this] { worker_loop(); });
+}
+
+ImageWriter::~ImageWriter() {
+    try {
+        close();
+    } catch (...) {
+        // 解構不能丟：要拿錯誤的話先自己呼叫 close()
+    }
+}
+
+void ImageWriter::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) return;  // closed_ 而且都寫完了
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        ++active_;
+        lock.unlock();
+        cv_.notify_all();  // 佇列有空位了
+
+        std::exception_ptr error;
+        try {
+            save_one(job.path, job.img, options_);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        job.img = ImageU8();  // 在鎖外放掉 buffer
+
+        lock.lock();
+        --active_;
+        if (error) {
+            if (!error_) error_ = error;
+        } else {
+            ++written_;
+        }
+        cv_.notify_all();
+    }
+}
+
+void ImageWriter::write(std::string path, ImageU8 img) {
+    if (img.empty()) throw std::invalid_argument("ImageWriter: empty image for " + path);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) throw std::runtime_error("ImageWriter: write() after close()");
+    cv_.wait(lock, [this] { return queue_.size() < depth_; });
+    queue_.push_back(Job{std::move(path), std::move(img)});
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void ImageWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr e = error_;
+        error_ = nullptr;  // 同一個錯誤只丟一次
+        std::rethrow_exception(e);
+    }
+}
+
+std::size_t ImageWriter::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + active_;
+}
+
+std::size_t ImageWriter::written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+} // namespace pf
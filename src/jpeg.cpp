@@ -0,0 +1,985 @@
+#include "pixfoundry/jpeg.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace pf {
+
+namespace {
+
+// zigzag 位置 → 8x8 的 natural order（row * 8 + col）
+constexpr uint8_t kZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+inline int be16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+
+inline uint8_t clamp_u8(int v) { return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+// ======================
+//  Huffman 表
+// ======================
+
+constexpr int kFastBits = 9;
+
+struct Huffman {
+    bool    defined = false;
+    uint8_t fast_len[1 << kFastBits];  // 0：碼長超過 kFastBits，走慢路
+    uint8_t fast_sym[1 << kFastBits];
+    int     maxcode[18];               // 長度 l 的最大碼；沒有這個長度時比最小可能值還小
+    int     delta[17];                 // 長度 l 的碼 → vals 的 index：code + delta[l]
+    uint8_t vals[256];
+    // AC 用：碼加上後面的數值一共不超過 kFastBits 時，一次查出
+    // (value << 8) | (run << 4) | 總 bit 數；0 表示要走一般路徑
+    int32_t fast_ac[1 << kFastBits];
+};
+
+// counts[l-1] 是長度 l 的碼數，symbols 依 canonical 順序排
+bool build_huffman(Huffman& h, const uint8_t* counts, const uint8_t* symbols, int total)
+{
+    std::memset(h.fast_len, 0, sizeof(h.fast_len));
+    std::memcpy(h.vals, symbols, static_cast<std::size_t>(total));
+    int code = 0, k = 0;
+    for (int len = 1; len <= 16; ++len) {
+        h.delta[len] = k - code;
+        for (int i = 0; i < counts[len - 1]; ++i, ++code, ++k) {
+            if (code >= (1 << len)) return false;  // 碼不夠分：壞表
+            if (len <= kFastBits) {
+                const int shift = kFastBits - len;
+                const int base  = code << shift;
+                for (int j = 0; j < (1 << shift); ++j) {
+                    h.fast_len[base + j] = static_cast<uint8_t>(len);
+                    h.fast_sym[base + j] = symbols[k];
+                }
+            }
+        }
+        h.maxcode[len] = code - 1;
+        code <<= 1;
+    }
+    h.maxcode[17] = INT_MAX;
+
+    for (int look = 0; look < (1 << kFastBits); ++look) {
+        h.fast_ac[look] = 0;
+        const int len = h.fast_len[look];
+        if (!len) continue;
+        const int rs = h.fast_sym[look];
+        const int run = rs >> 4, size = rs & 15;
+        if (size == 0 || len + size > kFastBits) continue;
+        int v = (look >> (kFastBits - len - size)) & ((1 << size) - 1);
+        if (v < (1 << (size - 1))) v -= (1 << size) - 1;
+        h.fast_ac[look] = static_cast<int32_t>(v * 256 + (run << 4) + len + size);
+    }
+    h.defined = true;
+    return true;
+}
+
+// ======================
+//  entropy-coded 資料的 bit reader
+// ======================
+
+// 一次補滿 64-bit buffer；FF 00 還原成 FF，碰到 marker 之後都補 0
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t       buf    = 0;
+    int            bits   = 0;
+    bool           marker = false;
+
+    void fill() {
+        while (bits <= 56) {
+            unsigned b = 0;
+            if (!marker && p < end) {
+                b = *p;
+                if (b == 0xFF) {
+                    if (p + 1 < end && p[1] == 0x00) {
+                        p += 2;
+                    } else {
+                        marker = true;
+                        b = 0;
+                    }
+                } else {
+                    ++p;
+                }
+            }
+            buf |= static_cast<uint64_t>(b) << (56 - bits);
+            bits += 8;
+        }
+    }
+
+    unsigned peek(int n) {
+        if (bits < n) fill();
+        return static_cast<unsigned>(buf >> (64 - n));
+    }
+    void skip(int n) { buf <<= n; bits -= n; }
+
+    // n 個 bits 的值，照 JPEG 的規則延伸成有號數
+    int receive_extend(int n) {
+        if (n == 0) return 0;
+        const int v = static_cast<int>(peek(n));
+        skip(n);
+        return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+    }
+
+    int decode(const Huffman& h) {
+        const unsigned look = peek(kFastBits);
+        const int len = h.fast_len[look];
+        if (len) {
+            skip(len);
+            return h.fast_sym[look];
+        }
+        const unsigned code16 = peek(16);
+        for (int l = kFastBits + 1; l <= 16; ++l) {
+            const int code = static_cast<int>(code16 >> (16 - l));
+            if (code <= h.maxcode[l]) {
+                skip(l);
+                return h.vals[code + h.delta[l]];
+            }
+        }
+        return -1;
+    }
+
+    // restart interval 結束：丟掉剩下的 bits，跳過下一個 RSTn
+    bool restart() {
+        buf = 0;
+        bits = 0;
+        marker = false;
+        while (p + 1 < end && !(p[0] == 0xFF && p[1] >= 0xD0 && p[1] <= 0xD7)) ++p;
+        if (p + 1 >= end) return false;
+        p += 2;
+        return true;
+    }
+};
+
+// ======================
+//  縮小 IDCT
+// ======================
+
+// 8x8 IDCT 是可分離的：f(i, j) = sum F(u, v) a(i, u) a(j, v)，a(i, u) = C(u) / 2 * cos((2i+1)uπ/16)。
+// 輸出 k 點時，把 a 在每段 8/k 個 sample 上先平均，得到 k x 8 的矩陣：
+// 結果就是全尺寸 IDCT 的區塊平均，一列只要 8k 次乘加。k = 8 就是一般的 IDCT。
+// 水平 / 垂直可以用不同的 k（色度取樣比例跟亮度不同時）。
+struct ScaledIdct {
+    float m[4][8][8];  // [log2 k][out][freq]
+
+    ScaledIdct() {
+        const double pi = 3.14159265358979323846;
+        for (int lk = 0; lk < 4; ++lk) {
+            const int k = 1 << lk, n = 8 / k;
+            for (int o = 0; o < k; ++o) {
+                for (int u = 0; u < 8; ++u) {
+                    const double cu = (u == 0) ? std::sqrt(0.5) : 1.0;
+                    double s = 0.0;
+                    for (int i = o * n; i < (o + 1) * n; ++i) s += 0.5 * cu * std::cos((2 * i + 1) * u * pi / 16.0);
+                    m[lk][o][u] = static_cast<float>(s / n);
+                }
+            }
+        }
+    }
+
+    // coef：反量化後的係數（natural order）；rows / cols：哪些 row / column 有非零係數
+    // 輸出 ky x kx（lx / ly 是 log2）
+    void run(const int* coef, unsigned rows, unsigned cols, int lx, int ly,
+             uint8_t* out, std::size_t stride) const {
+        const int kx = 1 << lx, ky = 1 << ly;
+        const float (*mx)[8] = m[lx];
+        const float (*my)[8] = m[ly];
+        int ncols = 8;
+        while (!(cols & (1u << (ncols - 1)))) --ncols;
+
+        int   used[8];
+        float tmp[8][8];
+        int   n = 0;
+        for (int v = 0; v < 8; ++v) {
+            if (!(rows & (1u << v))) continue;
+            const int* c = coef + v * 8;
+            for (int o = 0; o < kx; ++o) {
+                float s = 0.f;
+                for (int u = 0; u < ncols; ++u) s += mx[o][u] * static_cast<float>(c[u]);
+                tmp[n][o] = s;
+            }
+            used[n++] = v;
+        }
+        for (int oy = 0; oy < ky; ++oy) {
+            float acc[8];
+            for (int ox = 0; ox < kx; ++ox) acc[ox] = 128.5f;  // level shift + 四捨五入
+            for (int i = 0; i < n; ++i) {
+                const float w = my[oy][used[i]];
+                for (int ox = 0; ox < kx; ++ox) acc[ox] += w * tmp[i][ox];
+            }
+            // 負數截斷成 0 以下，clamp 之後一樣是 0：不必 floor
+            uint8_t* dst = out + oy * stride;
+            for (int ox = 0; ox < kx; ++ox) dst[ox] = clamp_u8(static_cast<int>(acc[ox]));
+        }
+    }
+};
+
+// ======================
+//  decoder
+// ======================
+
+struct Component {
+    int id = 0, h = 1, v = 1, tq = 0;
+    int td = 0, ta = 0;
+    int pred = 0;                   // DC 預測值
+    int lx = 0, ly = 0;             // 每個 block 輸出 (1 << ly) x (1 << lx)
+    std::size_t stride = 0;         // plane 的 row 長度（縮小後）
+    std::vector<uint8_t> plane;
+};
+
+class Decoder {
+public:
+    Decoder(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+    // header_only：讀到 SOF 就停
+    bool run(bool header_only, int scale, JpegInfo& info, ImageU8* out)
+    {
+        if (size_ < 4 || data_[0] != 0xFF || data_[1] != 0xD8) return false;
+        std::size_t pos = 2;
+        bool have_frame = false;
+        for (;;) {
+            if (pos + 1 >= size_ || data_[pos] != 0xFF) return false;
+            const int marker = data_[pos + 1];
+            pos += 2;
+            if (marker == 0xFF) { --pos; continue; }  // 填充用的 FF
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) continue;
+            if (marker == 0xD9) return false;         // 還沒看到 scan 就結束了
+
+            if (pos + 2 > size_) return false;
+            const int len = be16(data_ + pos);
+            if (len < 2 || pos + len > size_) return false;
+            const uint8_t* seg = data_ + pos + 2;
+            const int n = len - 2;
+            pos += len;
+
+            switch (marker) {
+            case 0xC0: case 0xC1:
+                if (!read_sof(seg, n, info)) return false;
+                have_frame = true;
+                if (header_only) return true;
+                if (!info.scalable) return false;
+                break;
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                // progressive / lossless / arithmetic：只回報尺寸
+                if (!read_sof(seg, n, info)) return false;
+                info.scalable = false;
+                return header_only;
+            case 0xC4:
+                if (!read_dht(seg, n)) return false;
+                break;
+            case 0xDB:
+                if (!read_dqt(seg, n)) return false;
+                break;
+            case 0xDD:
+                if (n < 2) return false;
+                restart_interval_ = be16(seg);
+                break;
+            case 0xEE:
+                if (n >= 12 && std::memcmp(seg, "Adobe", 5) == 0) adobe_transform_ = seg[11];
+                break;
+            case 0xDA:
+                if (!have_frame || !out) return false;
+                return read_sos(seg, n) && decode_scan(pos, scale, *out);
+            default:
+                break;  // APPn、COM 等等
+            }
+        }
+    }
+
+private:
+    bool read_sof(const uint8_t* seg, int n, JpegInfo& info)
+    {
+        if (n < 6) return false;
+        const int precision = seg[0];
+        height_ = be16(seg + 1);
+        width_  = be16(seg + 3);
+        const int nf = seg[5];
+        if (width_ <= 0 || n < 6 + 3 * nf || nf <= 0) return false;
+
+        info.w = width_;
+        info.h = height_;
+        info.c = (nf == 1) ? 1 : 3;
+        // 高度寫在 DNL 裡（height 0）的檔案交給 stb
+        info.scalable = precision == 8 && height_ > 0 && (nf == 1 || nf == 3);
+        if (!info.scalable) return true;
+
+        comps_.assign(nf, Component());
+        for (int i = 0; i < nf; ++i) {
+            Component& c = comps_[i];
+            c.id = seg[6 + 3 * i];
+            c.h  = seg[7 + 3 * i] >> 4;
+            c.v  = seg[7 + 3 * i] & 15;
+            c.tq = seg[8 + 3 * i];
+            if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.tq > 3) return false;
+            hmax_ = std::max(hmax_, c.h);
+            vmax_ = std::max(vmax_, c.v);
+        }
+        return true;
+    }
+
+    bool read_dht(const uint8_t* seg, int n)
+    {
+        int i = 0;
+        while (i < n) {
+            if (i + 17 > n) return false;
+            const int tc = seg[i] >> 4, th = seg[i] & 15;
+            if (tc > 1 || th > 3) return false;
+            const uint8_t* counts = seg + i + 1;
+            int total = 0;
+            for (int l = 0; l < 16; ++l) total += counts[l];
+            if (total > 256 || i + 17 + total > n) return false;
+            if (!build_huffman(huff_[tc][th], counts, seg + i + 17, total)) return false;
+            i += 17 + total;
+        }
+        return true;
+    }
+
+    bool read_dqt(const uint8_t* seg, int n)
+    {
+        int i = 0;
+        while (i < n) {
+            const int pq = seg[i] >> 4, tq = seg[i] & 15;
+            if (pq > 1 || tq > 3) return false;
+            const int bytes = pq ? 128 : 64;
+            if (i + 1 + bytes > n) return false;
+            for (int z = 0; z < 64; ++z) {
+                const uint8_t* p = seg + i + 1 + (pq ? 2 * z : z);
+                qt_[tq][kZigzag[z]] = static_cast<uint16_t>(pq ? be16(p) : *p);
+            }
+            qt_defined_[tq] = true;
+            i += 1 + bytes;
+        }
+        return true;
+    }
+
+    bool read_sos(const uint8_t* seg, int n)
+    {
+        if (n < 1) return false;
+        const int ns = seg[0];
+        // 只處理「一個 scan 就包含所有 component」的檔案
+        if (ns != static_cast<int>(comps_.size()) || n < 1 + 2 * ns + 3) return false;
+        for (int i = 0; i < ns; ++i) {
+            const int id = seg[1 + 2 * i];
+            auto it = std::find_if(comps_.begin(), comps_.end(), [id](const Component& c) { return c.id == id; });
+            if (it == comps_.end()) return false;
+            it->td = seg[2 + 2 * i] >> 4;
+            it->ta = seg[2 + 2 * i] & 15;
+            if (it->td > 3 || it->ta > 3) return false;
+            if (!huff_[0][it->td].defined || !huff_[1][it->ta].defined || !qt_defined_[it->tq]) return false;
+        }
+        const uint8_t* tail = seg + 1 + 2 * ns;
+        return tail[0] == 0 && tail[1] == 63 && tail[2] == 0;  // Ss, Se, Ah/Al：baseline
+    }
+
+    // 解一個 block 的係數（反量化、natural order）；rows / cols 記錄哪些 row / column 有非零值
+    // （都只有 bit 0 表示只有 DC）
+    bool decode_block(BitReader& br, Component& c, int* coef, unsigned& rows, unsigned& cols)
+    {
+        std::memset(coef, 0, 64 * sizeof(int));
+        const uint16_t* q = qt_[c.tq];
+
+        const int t = br.decode(huff_[0][c.td]);
+        if (t < 0 || t > 16) return false;
+        c.pred += br.receive_extend(t);
+        coef[0] = c.pred * q[0];
+        rows = cols = 1u;
+
+        const Huffman& table = huff_[1][c.ta];
+        for (int k = 1; k < 64;) {
+            const int32_t fast = table.fast_ac[br.peek(kFastBits)];
+            if (fast) {
+                br.skip(fast & 15);
+                k += (fast >> 4) & 15;
+                if (k > 63) return false;
+                const int nat = kZigzag[k++];
+                coef[nat] = (fast >> 8) * q[nat];
+                rows |= 1u << (nat >> 3);
+                cols |= 1u << (nat & 7);
+                continue;
+            }
+            const int rs = br.decode(table);
+            if (rs < 0) return false;
+            const int r = rs >> 4, s = rs & 15;
+            if (s == 0) {
+                if (r != 15) break;  // EOB
+                k += 16;
+                continue;
+            }
+            k += r;
+            if (k > 63) return false;
+            const int nat = kZigzag[k++];
+            coef[nat] = br.receive_extend(s) * q[nat];
+            rows |= 1u << (nat >> 3);
+            cols |= 1u << (nat & 7);
+        }
+        return true;
+    }
+
+    bool decode_scan(std::size_t pos, int scale, ImageU8& out)
+    {
+        const ScaledIdct idct;
+        const int mcux = (width_  + 8 * hmax_ - 1) / (8 * hmax_);
+        const int mcuy = (height_ + 8 * vmax_ - 1) / (8 * vmax_);
+        for (Component& c : comps_) {
+            // 取樣比例低的 component 用比較大的 IDCT，直接解到跟輸出一樣的解析度
+            // （4:2:0 的色度在 1/8 時還是 2x2）；除不盡或超過 8 的才在 emit 補 upsampling
+            c.lx = block_log2(8 * hmax_, c.h * scale);
+            c.ly = block_log2(8 * vmax_, c.v * scale);
+            c.stride = static_cast<std::size_t>(mcux) * c.h << c.lx;
+            c.plane.assign((c.stride * static_cast<std::size_t>(mcuy) * c.v) << c.ly, 0);
+            c.pred = 0;
+        }
+
+        BitReader br{data_ + pos, data_ + size_};
+        int  coef[64];
+        unsigned rows = 0, cols = 0;
+        auto block = [&](Component& c, int bx, int by) {
+            if (!decode_block(br, c, coef, rows, cols)) return false;
+            uint8_t* dst = c.plane.data() + ((static_cast<std::size_t>(by) * c.stride) << c.ly) +
+                           (static_cast<std::size_t>(bx) << c.lx);
+            if ((rows | cols) == 1u || (c.lx | c.ly) == 0) {
+                // 只有 DC（輸出 1x1 時 AC 的區塊平均都是 0）：整塊同一個值
+                const uint8_t v = clamp_u8(static_cast<int>(coef[0] * 0.125f + 128.5f));
+                for (int y = 0; y < (1 << c.ly); ++y)
+                    std::memset(dst + y * c.stride, v, static_cast<std::size_t>(1) << c.lx);
+            } else {
+                idct.run(coef, rows, cols, c.lx, c.ly, dst, c.stride);
+            }
+            return true;
+        };
+
+        int todo = restart_interval_ ? restart_interval_ : INT_MAX;
+        auto next_interval = [&]() {
+            if (--todo > 0) return true;
+            todo = restart_interval_ ? restart_interval_ : INT_MAX;
+            for (Component& c : comps_) c.pred = 0;
+            return br.restart();
+        };
+
+        if (comps_.size() == 1) {
+            // 單一 component 的 scan 不是交錯的：block 數照 component 自己的尺寸算，不補到 MCU
+            Component& c = comps_[0];
+            const int cw = ((width_  * c.h + hmax_ - 1) / hmax_ + 7) / 8;
+            const int ch = ((height_ * c.v + vmax_ - 1) / vmax_ + 7) / 8;
+            const int total = cw * ch;
+            for (int i = 0; i < total; ++i) {
+                if (!block(c, i % cw, i / cw)) return false;
+                if (i + 1 < total && !next_interval()) return false;
+            }
+        } else {
+            const int total = mcux * mcuy;
+            for (int i = 0; i < total; ++i) {
+                const int mx = i % mcux, my = i / mcux;
+                for (Component& c : comps_) {
+                    for (int v = 0; v < c.v; ++v) {
+                        for (int h = 0; h < c.h; ++h) {
+                            if (!block(c, mx * c.h + h, my * c.v + v)) return false;
+                        }
+                    }
+                }
+                if (i + 1 < total && !next_interval()) return false;
+            }
+        }
+
+        emit(scale, out);
+        return true;
+    }
+
+    // 一個 block 在輸出上要佔 num / den 點：取不超過它的 2 的次方（1..8）
+    static int block_log2(int num, int den)
+    {
+        int l = 0;
+        while (l < 3 && (den << (l + 1)) <= num) ++l;
+        return l;
+    }
+
+    // 解出來還比輸出粗的 component 在輸出格點上的 bilinear 位置：
+    // 輸出的第 o 點中心落在 plane 的 (o + 0.5) * sub / max - 0.5（sub / max 是 plane 對輸出的比例）
+    struct Taps {
+        std::vector<int> i0, i1, w;  // w：i1 的權重（0..256）
+    };
+
+    static Taps make_taps(int n_out, int sub, int max, int valid)
+    {
+        Taps t;
+        t.i0.resize(n_out);
+        t.i1.resize(n_out);
+        t.w.resize(n_out);
+        for (int o = 0; o < n_out; ++o) {
+            const double pos = std::max(0.0, (o + 0.5) * sub / static_cast<double>(max) - 0.5);
+            const int i = static_cast<int>(pos);
+            t.i0[o] = std::min(i, valid - 1);
+            t.i1[o] = std::min(i + 1, valid - 1);
+            t.w[o]  = static_cast<int>((pos - i) * 256.0 + 0.5);
+        }
+        return t;
+    }
+
+    // planes → 輸出影像
+    void emit(int scale, ImageU8& out) const
+    {
+        const int ow = (width_  + scale - 1) / scale;
+        const int oh = (height_ + scale - 1) / scale;
+        if (comps_.size() == 1) {
+            ImageU8 img(oh, ow, 1, Init::None);
+            const Component& c = comps_[0];
+            for (int y = 0; y < oh; ++y)
+                std::memcpy(img.row(y), c.plane.data() + static_cast<std::size_t>(y) * c.stride,
+                            static_cast<std::size_t>(ow));
+            out = std::move(img);
+            return;
+        }
+
+        // Adobe transform 0 或 component id 是 'R' 'G' 'B'：不是 YCbCr
+        const bool rgb = adobe_transform_ == 0 ||
+                         (comps_[0].id == 'R' && comps_[1].id == 'G' && comps_[2].id == 'B');
+
+        // 跟輸出同解析度的 component 直接讀；其他的做 bilinear upsampling
+        // plane 的解析度是原圖的 (h << lx) / (8 * hmax)，輸出是 1 / scale
+        bool  full[3];
+        Taps  tx[3], ty[3];
+        for (int i = 0; i < 3; ++i) {
+            const Component& c = comps_[i];
+            const int sx = (c.h << c.lx) * scale, sy = (c.v << c.ly) * scale;
+            full[i] = sx == 8 * hmax_ && sy == 8 * vmax_;
+            if (full[i]) continue;
+            const int vw = (width_  * (c.h << c.lx) + 8 * hmax_ - 1) / (8 * hmax_);
+            const int vh = (height_ * (c.v << c.ly) + 8 * vmax_ - 1) / (8 * vmax_);
+            tx[i] = make_taps(ow, sx, 8 * hmax_, std::max(1, vw));
+            ty[i] = make_taps(oh, sy, 8 * vmax_, std::max(1, vh));
+        }
+
+        ImageU8 img(oh, ow, 3, Init::None);
+        for (int y = 0; y < oh; ++y) {
+            const uint8_t* r0[3];
+            const uint8_t* r1[3];
+            int wy[3] = {0, 0, 0};
+            for (int i = 0; i < 3; ++i) {
+                const Component& c = comps_[i];
+                const std::size_t y0 = full[i] ? y : ty[i].i0[y];
+                const std::size_t y1 = full[i] ? y : ty[i].i1[y];
+                r0[i] = c.plane.data() + y0 * c.stride;
+                r1[i] = c.plane.data() + y1 * c.stride;
+                if (!full[i]) wy[i] = ty[i].w[y];
+            }
+            uint8_t* dst = img.row(y);
+            for (int x = 0; x < ow; ++x, dst += 3) {
+                int v[3];
+                for (int i = 0; i < 3; ++i) {
+                    if (full[i]) {
+                        v[i] = r0[i][x];
+                        continue;
+                    }
+                    const int a = tx[i].i0[x], b = tx[i].i1[x], wx = tx[i].w[x];
+                    const int top = r0[i][a] * (256 - wx) + r0[i][b] * wx;
+                    const int bot = r1[i][a] * (256 - wx) + r1[i][b] * wx;
+                    v[i] = (top * (256 - wy[i]) + bot * wy[i] + 32768) >> 16;
+                }
+                if (rgb) {
+                    dst[0] = static_cast<uint8_t>(v[0]);
+                    dst[1] = static_cast<uint8_t>(v[1]);
+                    dst[2] = static_cast<uint8_t>(v[2]);
+                    continue;
+                }
+                // JFIF 的 YCbCr → RGB（16-bit 定點）
+                const int yy = (v[0] << 16) + 32768, cb = v[1] - 128, cr = v[2] - 128;
+                dst[0] = clamp_u8((yy + 91881 * cr) >> 16);
+                dst[1] = clamp_u8((yy - 22554 * cb - 46802 * cr) >> 16);
+                dst[2] = clamp_u8((yy + 116130 * cb) >> 16);
+            }
+        }
+        out = std::move(img);
+    }
+
+    const uint8_t* data_;
+    std::size_t    size_;
+
+    int width_ = 0, height_ = 0;
+    int hmax_ = 1, vmax_ = 1;
+    int restart_interval_ = 0;
+    int adobe_transform_  = -1;
+    std::vector<Component> comps_;
+    Huffman  huff_[2][4];  // [DC / AC][table id]
+    uint16_t qt_[4][64] = {};
+    bool     qt_defined_[4] = {};
+};
+
+// ======================
+//  編碼（baseline、標準 Huffman 表）
+// ======================
+
+// ITU T.81 Annex K 的量化表（natural order），quality 50 時原樣使用
+constexpr uint8_t kStdLumaQuant[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99,
+};
+constexpr uint8_t kStdChromaQuant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// Annex K.3 的 Huffman 表：每個長度的碼數 + symbol
+constexpr uint8_t kDcLumaCounts[16]   = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcChromaCounts[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcSymbols[12]      = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcLumaCounts[16]   = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D};
+constexpr uint8_t kAcLumaSymbols[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+};
+constexpr uint8_t kAcChromaCounts[16]   = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr uint8_t kAcChromaSymbols[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+    0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+    0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+    0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+};
+
+struct HuffmanCodes {
+    uint16_t code[256] = {};
+    uint8_t  size[256] = {};
+
+    HuffmanCodes(const uint8_t* counts, const uint8_t* symbols) {
+        int next = 0, k = 0;
+        for (int len = 1; len <= 16; ++len, next <<= 1) {
+            for (int i = 0; i < counts[len - 1]; ++i, ++next, ++k) {
+                code[symbols[k]] = static_cast<uint16_t>(next);
+                size[symbols[k]] = static_cast<uint8_t>(len);
+            }
+        }
+    }
+};
+
+// entropy-coded 資料：MSB first，寫出 0xFF 後補一個 0x00
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint32_t bits, int n) {
+        acc_ = (acc_ << n) | bits;
+        count_ += n;
+        while (count_ >= 8) {
+            const uint8_t b = static_cast<uint8_t>(acc_ >> (count_ - 8));
+            out_.push_back(b);
+            if (b == 0xFF) out_.push_back(0);
+            count_ -= 8;
+        }
+    }
+
+    // 剩下的 bit 補 1 到 byte 邊界
+    void flush() {
+        if (count_ > 0) put((1u << (8 - count_)) - 1, 8 - count_);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint32_t acc_   = 0;
+    int      count_ = 0;
+};
+
+// IJG 的 quality → 量化表縮放
+void scale_quant(const uint8_t* base, int quality, uint8_t* q)
+{
+    const int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    for (int i = 0; i < 64; ++i) q[i] = static_cast<uint8_t>(std::clamp((base[i] * scale + 50) / 100, 1, 255));
+}
+
+// AAN 的浮點 forward DCT（libjpeg jfdctflt）：輸出差一個 aan_scale[u] * aan_scale[v] * 8 的比例，
+// 跟量化合併成一個乘法
+void fdct_8x8(float* d)
+{
+    for (int pass = 0; pass < 2; ++pass) {
+        const int step = pass == 0 ? 1 : 8;   // 先 row 再 column
+        const int next = pass == 0 ? 8 : 1;
+        for (int k = 0; k < 8; ++k) {
+            float* p = d + k * next;
+            const float t0 = p[0] + p[7 * step], t7 = p[0] - p[7 * step];
+            const float t1 = p[step] + p[6 * step], t6 = p[step] - p[6 * step];
+            const float t2 = p[2 * step] + p[5 * step], t5 = p[2 * step] - p[5 * step];
+            const float t3 = p[3 * step] + p[4 * step], t4 = p[3 * step] - p[4 * step];
+
+            float t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+            p[0]        = t10 + t11;
+            p[4 * step] = t10 - t11;
+            const float z1 = (t12 + t13) * 0.707106781f;
+            p[2 * step] = t13 + z1;
+            p[6 * step] = t13 - z1;
+
+            t10 = t4 + t5;
+            t11 = t5 + t6;
+            t12 = t6 + t7;
+            const float z5  = (t10 - t12) * 0.382683433f;
+            const float z2  = 0.541196100f * t10 + z5;
+            const float z4  = 1.306562965f * t12 + z5;
+            const float z3  = t11 * 0.707106781f;
+            const float z11 = t7 + z3, z13 = t7 - z3;
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[step]     = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+struct EncodeTable {
+    float               recip[64];  // natural order，含 AAN 比例
+    const HuffmanCodes* dc;
+    const HuffmanCodes* ac;
+};
+
+void make_recip(const uint8_t* q, float* recip)
+{
+    static constexpr double kAanScale[8] = {1.0, 1.387039845, 1.306562965, 1.175875602,
+                                            1.0, 0.785694958, 0.541196100, 0.275899379};
+    for (int r = 0; r < 8; ++r)
+        for (int c = 0; c < 8; ++c)
+            recip[r * 8 + c] = static_cast<float>(1.0 / (q[r * 8 + c] * kAanScale[r] * kAanScale[c] * 8.0));
+}
+
+// 數值 v 的 category（bit 數）與要寫出的 bits（負數用 v - 1 的低位）
+inline int magnitude(int v, uint32_t& bits)
+{
+    const int a = v < 0 ? -v : v;
+    int n = 0;
+    for (int t = a; t; t >>= 1) ++n;
+    bits = static_cast<uint32_t>(v < 0 ? v - 1 : v) & ((1u << n) - 1);
+    return n;
+}
+
+// blk：已經減 128 的 8x8 樣本（會被 DCT 覆寫）
+void encode_block(float* blk, const EncodeTable& t, int& pred, BitWriter& bw)
+{
+    fdct_8x8(blk);
+    int q[64];
+    for (int i = 0; i < 64; ++i) {
+        const int k = kZigzag[i];
+        const float v = blk[k] * t.recip[k];
+        q[i] = static_cast<int>(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+
+    uint32_t bits = 0;
+    int n = magnitude(q[0] - pred, bits);
+    pred = q[0];
+    bw.put(t.dc->code[n], t.dc->size[n]);
+    if (n) bw.put(bits, n);
+
+    int run = 0;
+    for (int i = 1; i < 64; ++i) {
+        if (q[i] == 0) {
+            ++run;
+            continue;
+        }
+        for (; run >= 16; run -= 16) bw.put(t.ac->code[0xF0], t.ac->size[0xF0]);  // ZRL
+        n = magnitude(q[i], bits);
+        const int sym = (run << 4) | n;
+        bw.put(t.ac->code[sym], t.ac->size[sym]);
+        bw.put(bits, n);
+        run = 0;
+    }
+    if (run > 0) bw.put(t.ac->code[0x00], t.ac->size[0x00]);  // EOB
+}
+
+void put_marker(std::vector<uint8_t>& out, uint8_t marker, int length)
+{
+    const uint8_t b[4] = {0xFF, marker, static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+    out.insert(out.end(), b, b + 4);
+}
+
+void put_dht(std::vector<uint8_t>& out, int tc_th, const uint8_t* counts, const uint8_t* symbols)
+{
+    int total = 0;
+    for (int i = 0; i < 16; ++i) total += counts[i];
+    put_marker(out, 0xC4, 2 + 1 + 16 + total);
+    out.push_back(static_cast<uint8_t>(tc_th));
+    out.insert(out.end(), counts, counts + 16);
+    out.insert(out.end(), symbols, symbols + total);
+}
+
+} // namespace
+
+bool jpeg_info(const uint8_t* data, std::size_t size, JpegInfo& info)
+{
+    info = JpegInfo();
+    if (!data) return false;
+    Decoder dec(data, size);
+    return dec.run(true, 1, info, nullptr);
+}
+
+bool decode_jpeg_scaled(const uint8_t* data, std::size_t size, int scale, ImageU8& out)
+{
+    if (!data || (scale != 2 && scale != 4 && scale != 8)) return false;
+    JpegInfo info;
+    Decoder dec(data, size);
+    return dec.run(false, scale, info, &out);
+}
+
+std::vector<uint8_t> encode_jpeg(const uint8_t* data, int h, int w, int c, std::size_t stride,
+                                 int quality, ChromaSubsampling subsampling)
+{
+    if (!data || h <= 0 || w <= 0 || (c != 1 && c != 3))
+        throw std::invalid_argument("encode_jpeg: invalid input");
+    if (h > 65535 || w > 65535) throw std::invalid_argument("encode_jpeg: image too large for JPEG (max 65535)");
+    if (quality < 1 || quality > 100) throw std::invalid_argument("encode_jpeg: quality must be 1..100");
+    if (stride == 0) stride = static_cast<std::size_t>(w) * c;
+
+    // 亮度的取樣倍率（色度固定 1x1）
+    int hs = 1, vs = 1;
+    if (c == 3) {
+        if (subsampling == ChromaSubsampling::Auto)
+            subsampling = quality <= 90 ? ChromaSubsampling::S420 : ChromaSubsampling::S444;
+        if (subsampling == ChromaSubsampling::S422) hs = 2;
+        if (subsampling == ChromaSubsampling::S420) hs = vs = 2;
+    }
+
+    uint8_t qy[64], qc[64];
+    scale_quant(kStdLumaQuant, quality, qy);
+    scale_quant(kStdChromaQuant, quality, qc);
+    static const HuffmanCodes dc_luma(kDcLumaCounts, kDcSymbols), ac_luma(kAcLumaCounts, kAcLumaSymbols);
+    static const HuffmanCodes dc_chroma(kDcChromaCounts, kDcSymbols), ac_chroma(kAcChromaCounts, kAcChromaSymbols);
+    EncodeTable ty{{}, &dc_luma, &ac_luma}, tc{{}, &dc_chroma, &ac_chroma};
+    make_recip(qy, ty.recip);
+    make_recip(qc, tc.recip);
+
+    std::vector<uint8_t> out;
+    out.reserve(static_cast<std::size_t>(h) * w * c / 6 + 1024);
+
+    // SOI + JFIF APP0
+    static const uint8_t kHead[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                    0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+    out.insert(out.end(), kHead, kHead + sizeof(kHead));
+
+    const int nt = c == 3 ? 2 : 1;
+    put_marker(out, 0xDB, 2 + 65 * nt);
+    for (int t = 0; t < nt; ++t) {
+        out.push_back(static_cast<uint8_t>(t));
+        const uint8_t* q = t == 0 ? qy : qc;
+        for (int i = 0; i < 64; ++i) out.push_back(q[kZigzag[i]]);
+    }
+
+    put_marker(out, 0xC0, 8 + 3 * c);
+    const uint8_t sof[5] = {8, static_cast<uint8_t>(h >> 8), static_cast<uint8_t>(h),
+                            static_cast<uint8_t>(w >> 8), static_cast<uint8_t>(w)};
+    out.insert(out.end(), sof, sof + 5);
+    out.push_back(static_cast<uint8_t>(c));
+    for (int i = 0; i < c; ++i) {
+        out.push_back(static_cast<uint8_t>(i + 1));
+        out.push_back(static_cast<uint8_t>(i == 0 ? (hs << 4) | vs : 0x11));
+        out.push_back(static_cast<uint8_t>(i == 0 ? 0 : 1));
+    }
+
+    put_dht(out, 0x00, kDcLumaCounts, kDcSymbols);
+    put_dht(out, 0x10, kAcLumaCounts, kAcLumaSymbols);
+    if (c == 3) {
+        put_dht(out, 0x01, kDcChromaCounts, kDcSymbols);
+        put_dht(out, 0x11, kAcChromaCounts, kAcChromaSymbols);
+    }
+
+    put_marker(out, 0xDA, 6 + 2 * c);
+    out.push_back(static_cast<uint8_t>(c));
+    for (int i = 0; i < c; ++i) {
+        out.push_back(static_cast<uint8_t>(i + 1));
+        out.push_back(static_cast<uint8_t>(i == 0 ? 0x00 : 0x11));
+    }
+    out.push_back(0);
+    out.push_back(63);
+    out.push_back(0);
+
+    // 一次轉一整列 MCU 的色彩（超出影像的部分複製最後一欄 / 列），再切 block
+    const int mw = 8 * hs, mh = 8 * vs;
+    const int mcux = (w + mw - 1) / mw, mcuy = (h + mh - 1) / mh;
+    const int sw = mcux * mw;
+    std::vector<float> strip(static_cast<std::size_t>(c) * mh * sw);
+    float* ys  = strip.data();
+    float* cbs = ys + static_cast<std::size_t>(mh) * sw;
+    float* crs = cbs + static_cast<std::size_t>(mh) * sw;
+
+    BitWriter bw(out);
+    int pred[3] = {};
+    float blk[64];
+    for (int my = 0; my < mcuy; ++my) {
+        for (int yy = 0; yy < mh; ++yy) {
+            const uint8_t* row = data + static_cast<std::size_t>(std::min(my * mh + yy, h - 1)) * stride;
+            float* yr = ys + static_cast<std::size_t>(yy) * sw;
+            if (c == 1) {
+                for (int x = 0; x < sw; ++x) yr[x] = row[std::min(x, w - 1)] - 128.0f;
+                continue;
+            }
+            float* cbr = cbs + static_cast<std::size_t>(yy) * sw;
+            float* crr = crs + static_cast<std::size_t>(yy) * sw;
+            for (int x = 0; x < sw; ++x) {
+                const uint8_t* p = row + 3 * std::min(x, w - 1);
+                const float r = p[0], g = p[1], b = p[2];
+                yr[x]  = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                cbr[x] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+                crr[x] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+            }
+        }
+
+        for (int mx = 0; mx < mcux; ++mx) {
+            for (int by = 0; by < vs; ++by) {
+                for (int bx = 0; bx < hs; ++bx) {
+                    const float* src = ys + static_cast<std::size_t>(by) * 8 * sw + mx * mw + bx * 8;
+                    for (int i = 0; i < 8; ++i) std::memcpy(blk + 8 * i, src + static_cast<std::size_t>(i) * sw, 8 * sizeof(float));
+                    encode_block(blk, ty, pred[0], bw);
+                }
+            }
+            if (c == 1) continue;
+            // 色度：hs x vs 的平均
+            const float norm = 1.0f / static_cast<float>(hs * vs);
+            for (int k = 1; k <= 2; ++k) {
+                const float* plane = k == 1 ? cbs : crs;
+                for (int i = 0; i < 8; ++i) {
+                    for (int j = 0; j < 8; ++j) {
+                        const float* src = plane + static_cast<std::size_t>(i * vs) * sw + mx * mw + j * hs;
+                        float sum = 0.0f;
+                        for (int dy = 0; dy < vs; ++dy)
+                            for (int dx = 0; dx < hs; ++dx) sum += src[static_cast<std::size_t>(dy) * sw + dx];
+                        blk[8 * i + j] = sum * norm;
+                    }
+                }
+                encode_block(blk, tc, pred[k], bw);
+            }
+        }
+    }
+    bw.flush();
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return out;
+}
+
+} // namespace pf
@@ -0,0 +1,329 @@
+#include "pixfoundry/memory.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace pf {
+
+// huge page 的大小（x86-64 / aarch64 的 THP 都是 2 MB）；
+// 大 buffer 對齊到這裡，madvise 才能整塊換成 huge pages
+static constexpr std::size_t kHugePageSize = std::size_t(2) << 20;
+
+static void* aligned_raw_alloc(std::size_t bytes, std::size_t align) {
+    // aligned_alloc 要求 size 是 align 的倍數
+    const std::size_t n = (bytes + align - 1) / align * align;
+#if defined(_MSC_VER)
+    void* p = _aligned_malloc(n, align);
+#else
+    void* p = std::aligned_alloc(align, n);
+#endif
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+static void aligned_raw_free(void* p) {
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+// 向系統要一塊新的 buffer（不初始化）
+static uint8_t* system_alloc(std::size_t bytes) {
+    const bool huge = bytes >= kHugePageThreshold;
+    void* p = aligned_raw_alloc(bytes, huge ? kHugePageSize : kBufferAlign);
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge) {
+        // 只是建議：kernel 沒開 THP 時會失敗，不影響正確性
+        const std::size_t n = (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        (void)madvise(p, n, MADV_HUGEPAGE);
+    }
+#endif
+    return static_cast<uint8_t*>(p);
+}
+
+// ============================================================
+//  大小分桶
+// ============================================================
+
+static constexpr int kMinClassShift = 6;    // 最小 64 bytes
+static constexpr int kMaxClassShift = 34;   // 超過 16 GB 不進 pool
+static constexpr int kSubClasses    = 4;    // 每個 2 的次方再切 4 級
+static constexpr int kBuckets       = (kMaxClassShift - kMinClassShift + 1) * kSubClasses;
+
+static constexpr std::size_t kMaxPooledBytes = std::size_t(1) << kMaxClassShift;
+
+// thread cache 只放小 buffer；大的一律走共用 list，trim 才拿得回來
+static constexpr std::size_t kThreadCacheMaxBlock = std::size_t(1) << 20;
+static constexpr int         kThreadCacheSlots    = 4;
+
+static int floor_log2(std::size_t v) {
+    int k = 0;
+    while (v >>= 1) ++k;
+    return k;
+}
+
+static int bucket_of(std::size_t bytes) {
+    if (bytes <= (std::size_t(1) << kMinClassShift)) return 0;
+    int k = floor_log2(bytes);
+    const std::size_t step = std::size_t(1) << (k - 2);
+    std::size_t sub = (bytes - (std::size_t(1) << k) + step - 1) / step;
+    if (sub == kSubClasses) { ++k; sub = 0; }
+    return (k - kMinClassShift) * kSubClasses + static_cast<int>(sub);
+}
+
+static std::size_t bucket_bytes(int b) {
+    const int k = kMinClassShift + b / kSubClasses;
+    const std::size_t sub = static_cast<std::size_t>(b % kSubClasses);
+    return (std::size_t(1) << k) + sub * (std::size_t(1) << (k - 2));
+}
+
+// ============================================================
+//  共用 pool
+// ============================================================
+
+struct Pool {
+    std::mutex mu;
+    std::vector<uint8_t*> free_list[kBuckets];
+
+    std::atomic<bool>        enabled{false};
+    std::atomic<std::size_t> max_bytes{std::size_t(256) << 20};
+    std::atomic<std::size_t> cached{0};
+    std::atomic<std::size_t> in_use{0};
+    std::atomic<uint64_t>    hits{0};
+    std::atomic<uint64_t>    misses{0};
+    std::atomic<uint64_t>    evictions{0};
+    std::atomic<uint64_t>    epoch{0};   // trim 到 0 時 +1，各 thread cache 看到就清空
+};
+
+// 故意不釋放：程式結束時，static 物件解構的過程中還可能有 buffer 還回來
+static Pool& pool() {
+    static Pool* p = new Pool;
+    return *p;
+}
+
+// 放進閒置量（不超過上限才成功）
+static bool reserve_cached(Pool& P, std::size_t n) {
+    std::size_t cur = P.cached.load(std::memory_order_relaxed);
+    const std::size_t cap = P.max_bytes.load(std::memory_order_relaxed);
+    do {
+        if (cur + n > cap) return false;
+    } while (!P.cached.compare_exchange_weak(cur, cur + n, std::memory_order_relaxed));
+    return true;
+}
+
+static void global_put(Pool& P, int b, uint8_t* p) {
+    const std::size_t n = bucket_bytes(b);
+    if (P.enabled.load(std::memory_order_relaxed) && reserve_cached(P, n)) {
+        std::lock_guard<std::mutex> lock(P.mu);
+        P.free_list[b].push_back(p);
+        return;
+    }
+    P.evictions.fetch_add(1, std::memory_order_relaxed);
+    aligned_raw_free(p);
+}
+
+static uint8_t* global_take(Pool& P, int b) {
+    std::lock_guard<std::mutex> lock(P.mu);
+    auto& list = P.free_list[b];
+    if (list.empty()) return nullptr;
+    uint8_t* p = list.back();
+    list.pop_back();
+    P.cached.fetch_sub(bucket_bytes(b), std::memory_order_relaxed);
+    return p;
+}
+
+// ============================================================
+//  per-thread cache：不用上鎖
+// ============================================================
+
+struct ThreadCache {
+    uint8_t* slot[kBuckets][kThreadCacheSlots] = {};
+    int      count[kBuckets] = {};
+    uint64_t epoch = 0;
+
+    // 全部還給共用 pool（to_global）或直接還給系統；回傳清掉的 bytes
+    std::size_t flush(bool to_global) {
+        Pool& P = pool();
+        std::size_t n = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            for (int i = 0; i < count[b]; ++i) {
+                P.cached.fetch_sub(bucket_bytes(b), std::memory_order_relaxed);
+                n += bucket_bytes(b);
+                if (to_global) global_put(P, b, slot[b][i]);
+                else           aligned_raw_free(slot[b][i]);
+            }
+            count[b] = 0;
+        }
+        return n;
+    }
+
+    // trim 過之後先把自己手上的清掉
+    std::size_t sync_epoch(Pool& P) {
+        const uint64_t e = P.epoch.load(std::memory_order_acquire);
+        if (e == epoch) return 0;
+        epoch = e;
+        return flush(false);
+    }
+
+    ~ThreadCache();
+};
+
+// thread 結束時 cache 已經解構，之後才還回來的 buffer 不能再碰它
+static thread_local bool tl_cache_dead = false;
+static thread_local ThreadCache tl_cache;
+
+ThreadCache::~ThreadCache() {
+    flush(true);
+    tl_cache_dead = true;
+}
+
+static uint8_t* pooled_take(Pool& P, int b) {
+    if (bucket_bytes(b) <= kThreadCacheMaxBlock && !tl_cache_dead) {
+        ThreadCache& tc = tl_cache;
+        tc.sync_epoch(P);
+        if (tc.count[b] > 0) {
+            P.cached.fetch_sub(bucket_bytes(b), std::memory_order_relaxed);
+            return tc.slot[b][--tc.count[b]];
+        }
+    }
+    return global_take(P, b);
+}
+
+static void pooled_release(int b, uint8_t* p) {
+    Pool& P = pool();
+    const std::size_t n = bucket_bytes(b);
+    P.in_use.fetch_sub(n, std::memory_order_relaxed);
+
+    if (!P.enabled.load(std::memory_order_relaxed)) {
+        aligned_raw_free(p);
+        return;
+    }
+    if (n <= kThreadCacheMaxBlock && !tl_cache_dead) {
+        ThreadCache& tc = tl_cache;
+        tc.sync_epoch(P);
+        if (tc.count[b] < kThreadCacheSlots && reserve_cached(P, n)) {
+            tc.slot[b][tc.count[b]++] = p;
+            return;
+        }
+    }
+    global_put(P, b, p);
+}
+
+// ============================================================
+//  對外 API
+// ============================================================
+
+// 大 buffer 交給 first_touch_zero：NUMA 機器上由之後會寫那一段的 thread 來清，
+// page 就配在它們的 node 上；幾 GB 的 buffer 也是切段平行清
+static void zero_fill(uint8_t* p, std::size_t bytes) {
+    if (bytes >= kHugePageThreshold) {
+        first_touch_zero(p, bytes);
+    } else {
+        std::memset(p, 0, bytes);
+    }
+}
+
+std::shared_ptr<uint8_t[]> allocate_buffer(std::size_t bytes, Init init) {
+    if (bytes == 0) bytes = 1;
+
+    Pool& P = pool();
+    if (!P.enabled.load(std::memory_order_relaxed) || bytes > kMaxPooledBytes) {
+        uint8_t* p = system_alloc(bytes);
+        if (init == Init::Zero) zero_fill(p, bytes);
+        return std::shared_ptr<uint8_t[]>(p, [](uint8_t* q) { aligned_raw_free(q); });
+    }
+
+    // 以整個級距的大小配置，之後同一桶的請求都能重用
+    const int b = bucket_of(bytes);
+    uint8_t* p = pooled_take(P, b);
+    if (p) {
+        P.hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        P.misses.fetch_add(1, std::memory_order_relaxed);
+        p = system_alloc(bucket_bytes(b));
+    }
+    P.in_use.fetch_add(bucket_bytes(b), std::memory_order_relaxed);
+
+    if (init == Init::Zero) zero_fill(p, bytes);
+    return std::shared_ptr<uint8_t[]>(p, [b](uint8_t* q) { pooled_release(b, q); });
+}
+
+void copy_rows(uint8_t* dst, std::size_t dst_stride, const uint8_t* src, std::size_t src_stride,
+               std::size_t rows, std::size_t row_bytes) {
+    parallel_chunks(rows, row_bytes, [=](std::size_t y0, std::size_t y1) {
+        if (dst_stride == row_bytes && src_stride == row_bytes) {
+            std::memcpy(dst + y0 * row_bytes, src + y0 * row_bytes, (y1 - y0) * row_bytes);
+            return;
+        }
+        for (std::size_t y = y0; y < y1; ++y)
+            std::memcpy(dst + y * dst_stride, src + y * src_stride, row_bytes);
+    });
+}
+
+void enable_buffer_pool(bool enabled) {
+    Pool& P = pool();
+    P.enabled.store(enabled, std::memory_order_relaxed);
+    if (!enabled) trim_buffer_pool(0);
+}
+
+void set_buffer_pool_limit(std::size_t max_bytes) {
+    pool().max_bytes.store(max_bytes, std::memory_order_relaxed);
+    trim_buffer_pool(max_bytes);
+}
+
+std::size_t trim_buffer_pool(std::size_t keep_bytes) {
+    Pool& P = pool();
+    std::size_t freed = 0;
+
+    if (keep_bytes == 0) {
+        // 其他 thread 的 cache 等它們下次進來再清；自己的現在就清
+        P.epoch.fetch_add(1, std::memory_order_acq_rel);
+        if (!tl_cache_dead) freed += tl_cache.sync_epoch(P);
+    }
+
+    std::vector<uint8_t*> victims;
+    {
+        std::lock_guard<std::mutex> lock(P.mu);
+        // 先丟大的：同樣的 bytes 數，少呼叫幾次 free
+        for (int b = kBuckets - 1; b >= 0; --b) {
+            auto& list = P.free_list[b];
+            while (!list.empty() && P.cached.load(std::memory_order_relaxed) > keep_bytes) {
+                victims.push_back(list.back());
+                list.pop_back();
+                P.cached.fetch_sub(bucket_bytes(b), std::memory_order_relaxed);
+                freed += bucket_bytes(b);
+            }
+        }
+    }
+    // free 放在鎖外面
+    for (uint8_t* p : victims) aligned_raw_free(p);
+    return freed;
+}
+
+BufferPoolStats buffer_pool_stats() {
+    Pool& P = pool();
+    BufferPoolStats s;
+    s.enabled      = P.enabled.load(std::memory_order_relaxed);
+    s.max_bytes    = P.max_bytes.load(std::memory_order_relaxed);
+    s.cached_bytes = P.cached.load(std::memory_order_relaxed);
+    s.in_use_bytes = P.in_use.load(std::memory_order_relaxed);
+    s.hits         = P.hits.load(std::memory_order_relaxed);
+    s.misses       = P.misses.load(std::memory_order_relaxed);
+    s.evictions    = P.evictions.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace pf
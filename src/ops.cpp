@@ -0,0 +1,370 @@
+#include "pixfoundry/ops.hpp"
+#include "pixfoundry/color.hpp"
+#include "pixfoundry/effects.hpp"
+#include "pixfoundry/pyramid.hpp"
+#include "pixfoundry/warp.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace pf {
+
+// 參數都在建立 ImageOp 時檢查（訊息跟單張版本一樣），
+// 之後 batch / pipeline 一張都還沒開始做就能先失敗
+
+static ImageShape same_shape(const ImageShape& in) {
+    return in;
+}
+
+static ImageShape swapped_shape(const ImageShape& in) {
+    return {in.w, in.h, in.c};
+}
+
+// stencil 的 halo：Wrap 在最上面的 row 要用到最下面的，逐段做不到
+static int stencil_halo(int radius, Border border) {
+    return border == Border::Wrap ? -1 : radius;
+}
+
+// ======================
+//  filters
+// ======================
+
+ImageOp mean_filter_op(int ksize, Border border, uint8_t border_value) {
+    box_kernel1d(ksize);  // 只為了檢查 ksize
+    ImageOp op;
+    op.name = "mean_filter";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        mean_filter(src, dst, ksize, border, backend, border_value);
+    };
+    op.cost = separable_cost(static_cast<std::size_t>(ksize));
+    op.in_place = true;
+    op.halo = stencil_halo(ksize / 2, border);
+    return op;
+}
+
+ImageOp gaussian_filter_op(float sigma, Border border, uint8_t border_value) {
+    const std::size_t taps = gaussian_kernel1d(sigma).size();  // 順便檢查 sigma
+    ImageOp op;
+    op.name = "gaussian_filter";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        gaussian_filter(src, dst, sigma, border, backend, border_value);
+    };
+    op.cost = separable_cost(taps);
+    op.in_place = true;
+    op.halo = stencil_halo(static_cast<int>(taps / 2), border);
+    return op;
+}
+
+ImageOp median_filter_op(int ksize, Border border, uint8_t border_value) {
+    if (ksize < 3 || ksize % 2 == 0) {
+        throw std::invalid_argument("median_filter: ksize must be odd and >= 3");
+    }
+    ImageOp op;
+    op.name = "median_filter";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        median_filter(src, dst, ksize, border, backend, border_value);
+    };
+    op.cost = median_filter_cost(ksize);
+    op.halo = stencil_halo(ksize / 2, border);
+    return op;
+}
+
+ImageOp bilateral_filter_op(int ksize, float sigma_color, float sigma_space,
+                            Border border, uint8_t border_value) {
+    if (ksize < 3 || ksize % 2 == 0) {
+        throw std::invalid_argument("bilateral_filter: ksize must be odd and >= 3");
+    }
+    if (!(sigma_color > 0.0f) || !(sigma_space > 0.0f)) {
+        throw std::invalid_argument("bilateral_filter: sigma_color and sigma_space must be > 0");
+    }
+    ImageOp op;
+    op.name = "bilateral_filter";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        bilateral_filter(src, dst, ksize, sigma_color, sigma_space, border, backend, border_value);
+    };
+    op.cost = bilateral_filter_cost(ksize);
+    op.halo = stencil_halo(ksize / 2, border);
+    return op;
+}
+
+// ======================
+//  color
+// ======================
+
+ImageOp to_grayscale_op() {
+    ImageOp op;
+    op.name = "to_grayscale";
+    op.output_shape = [](const ImageShape& in) { return ImageShape{in.h, in.w, 1}; };
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        to_grayscale(src, dst, backend);
+    };
+    op.cost = to_grayscale_cost();
+    op.halo = 0;
+    return op;
+}
+
+ImageOp invert_op() {
+    ImageOp op;
+    op.name = "invert";
+    op.output_shape = same_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        invert(src, dst, backend);
+    };
+    op.cost = invert_cost();
+    op.in_place = true;
+    op.halo = 0;
+    return op;
+}
+
+ImageOp sepia_op() {
+    ImageOp op;
+    op.name = "sepia";
+    op.output_shape = [](const ImageShape& in) {
+        if (in.c != 3) throw std::invalid_argument("sepia: expects 3-channel RGB image");
+        return in;
+    };
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        sepia(src, dst, backend);
+    };
+    op.cost = sepia_cost();
+    op.in_place = true;
+    op.halo = 0;
+    return op;
+}
+
+ImageOp adjust_brightness_contrast_op(float alpha, float beta) {
+    ImageOp op;
+    op.name = "adjust_brightness_contrast";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        adjust_brightness_contrast(src, dst, alpha, beta, backend);
+    };
+    op.cost = brightness_contrast_cost();
+    op.in_place = true;
+    op.halo = 0;
+    return op;
+}
+
+ImageOp gamma_correct_op(float gamma) {
+    if (!(gamma > 0.0f)) throw std::invalid_argument("gamma_correct: gamma must be > 0");
+    ImageOp op;
+    op.name = "gamma_correct";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        gamma_correct(src, dst, gamma, backend);
+    };
+    op.cost = gamma_cost();
+    op.in_place = true;
+    op.halo = 0;
+    return op;
+}
+
+// ======================
+//  effects
+// ======================
+
+ImageOp sharpen_op(float amount) {
+    ImageOp op;
+    op.name = "sharpen";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        sharpen(src, dst, amount, backend);
+    };
+    op.cost = sharpen_cost();
+    op.in_place = amount <= 0.0f;  // 只是複製
+    op.halo = 1;  // 3x3
+    return op;
+}
+
+ImageOp emboss_op(float strength) {
+    ImageOp op;
+    op.name = "emboss";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        emboss(src, dst, strength, backend);
+    };
+    op.cost = emboss_cost();
+    op.halo = 1;  // 3x3
+    return op;
+}
+
+ImageOp cartoonize_op(float sigma_space, uint8_t edge_threshold) {
+    const std::size_t taps = gaussian_kernel1d(sigma_space).size();  // 順便檢查 sigma
+    ImageOp op;
+    op.name = "cartoonize";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        cartoonize(src, dst, sigma_space, edge_threshold, backend);
+    };
+    op.cost = cartoonize_cost(sigma_space);
+    // gaussian（Reflect）跟 3x3 Sobel 都是看原圖，取大的
+    op.halo = std::max(static_cast<int>(taps / 2), 1);
+    return op;
+}
+
+// ======================
+//  geometry
+// ======================
+
+ImageOp resize_op(int new_h, int new_w, Interp interp) {
+    if (new_h <= 0 || new_w <= 0) {
+        throw std::invalid_argument("resize: invalid new size");
+    }
+    ImageOp op;
+    op.name = "resize";
+    op.output_shape = [=](const ImageShape& in) { return ImageShape{new_h, new_w, in.c}; };
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        resize(src, dst, interp, backend);
+    };
+    // 建立時還不知道輸入大小：以不縮小（fy = fx = 1）估，縮小時的額外 taps 由單張版本自己算
+    op.cost = resize_cost(interp, 1.0, 1.0);
+    return op;
+}
+
+ImageOp flip_horizontal_op() {
+    ImageOp op;
+    op.name = "flip_horizontal";
+    op.output_shape = same_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        flip_horizontal(src, dst, backend);
+    };
+    op.cost = flip_cost();
+    op.in_place = true;
+    op.halo = 0;
+    return op;
+}
+
+ImageOp flip_vertical_op() {
+    ImageOp op;
+    op.name = "flip_vertical";
+    op.output_shape = same_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        flip_vertical(src, dst, backend);
+    };
+    op.cost = flip_cost();
+    op.in_place = true;
+    return op;
+}
+
+ImageOp rotate_op(float angle_deg) {
+    ImageOp op;
+    op.name = "rotate";
+    op.output_shape = same_shape;
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        rotate(src, dst, angle_deg, backend);
+    };
+    op.cost = warp_cost(Interp::Bilinear, false);  // rotate 就是 bilinear 的 warp_affine
+    return op;
+}
+
+ImageOp rotate90_op() {
+    ImageOp op;
+    op.name = "rotate90";
+    op.output_shape = swapped_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        rotate90(src, dst, backend);
+    };
+    op.cost = quarter_turn_cost();
+    return op;
+}
+
+ImageOp rotate180_op() {
+    ImageOp op;
+    op.name = "rotate180";
+    op.output_shape = same_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        rotate180(src, dst, backend);
+    };
+    op.cost = quarter_turn_cost();
+    return op;
+}
+
+ImageOp rotate270_op() {
+    ImageOp op;
+    op.name = "rotate270";
+    op.output_shape = swapped_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        rotate270(src, dst, backend);
+    };
+    op.cost = quarter_turn_cost();
+    return op;
+}
+
+ImageOp transpose_op() {
+    ImageOp op;
+    op.name = "transpose";
+    op.output_shape = swapped_shape;
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        transpose(src, dst, backend);
+    };
+    op.cost = quarter_turn_cost();
+    return op;
+}
+
+ImageOp crop_op(int y, int x, int h, int w) {
+    if (h <= 0 || w <= 0) throw std::invalid_argument("crop: invalid size");
+    ImageOp op;
+    op.name = "crop";
+    // 跟 crop() 一樣 clamp（用 int64 避免 y + h 溢位）
+    op.output_shape = [=](const ImageShape& in) {
+        const int64_t y1 = std::clamp<int64_t>(y, 0, in.h);
+        const int64_t x1 = std::clamp<int64_t>(x, 0, in.w);
+        const int64_t y2 = std::clamp<int64_t>(static_cast<int64_t>(y) + h, 0, in.h);
+        const int64_t x2 = std::clamp<int64_t>(static_cast<int64_t>(x) + w, 0, in.w);
+        if (y2 <= y1 || x2 <= x1) throw std::invalid_argument("crop: region outside image");
+        return ImageShape{static_cast<int>(y2 - y1), static_cast<int>(x2 - x1), in.c};
+    };
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        const ImageU8 region = crop(src, y, x, h, w, backend);
+        check_output(dst, region.h(), region.w(), region.c(), "crop");
+        check_no_overlap(region, dst, "crop", true);
+        if (same_pixels(region, dst)) return;
+        const std::size_t row_len = static_cast<std::size_t>(region.w()) * region.c();
+        copy_rows(dst.data(), dst.stride(), region.data(), region.stride(),
+                  static_cast<std::size_t>(region.h()), row_len);
+    };
+    // crop() 本身只回傳 view，沒有成本可用；這裡是純複製，跟 invert 一樣讀寫各一次
+    op.cost = invert_cost();
+    return op;
+}
+
+// ======================
+//  pyramid
+// ======================
+
+ImageOp pyr_down_op() {
+    ImageOp op;
+    op.name = "pyr_down";
+    op.output_shape = [](const ImageShape& in) {
+        return ImageShape{(in.h + 1) / 2, (in.w + 1) / 2, in.c};
+    };
+    op.run = [](const ImageU8& src, ImageU8& dst, Backend backend) {
+        pyr_down(src, dst, backend);
+    };
+    op.cost = pyr_down_cost();
+    return op;
+}
+
+ImageOp downscale_box_op(int factor) {
+    if (factor != 2 && factor != 4) throw std::invalid_argument("downscale_box: factor must be 2 or 4");
+    ImageOp op;
+    op.name = "downscale_box";
+    op.output_shape = [=](const ImageShape& in) {
+        if (in.h < factor || in.w < factor) {
+            throw std::invalid_argument("downscale_box: image smaller than factor");
+        }
+        return ImageShape{in.h / factor, in.w / factor, in.c};
+    };
+    op.run = [=](const ImageU8& src, ImageU8& dst, Backend backend) {
+        downscale_box(src, dst, factor, backend);
+    };
+    op.cost = downscale_box_cost();
+    return op;
+}
+
+} // namespace pf
@@ -0,0 +1,681 @@
+#include "pixfoundry/parallel.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#ifdef PF_HAS_OPENMP
+#include <omp.h>
+#endif
+
+namespace pf {
+
+// 同一個 parallel_for 呼叫切出來的工作
+struct ThreadPool::Group {
+    std::atomic<long>  pending{0};  // 還沒做完的塊數
+    std::mutex         error_mutex;
+    std::exception_ptr error;
+};
+
+struct ThreadPool::Task {
+    const std::function<void(long, long)>* body = nullptr;
+    long   begin = 0;
+    long   end   = 0;
+    Group* group = nullptr;
+};
+
+struct ThreadPool::Queue {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+};
+
+// 這條 thread 在 pool 裡的編號；-1 代表不是 worker
+static thread_local int tls_worker = -1;
+// 不是 worker 的呼叫端在 parallel_for 裡一起做的工作層數
+static thread_local int tls_helping = 0;
+
+// governor 分給 OpenMP team 的 pinning slot（實作在 NUMA 那一段）
+static bool pinning_enabled();
+static int  reserve_slots(int n);
+static void release_slots(int base, int n);
+static void reset_slots();
+
+// ======================
+//  建立
+// ======================
+
+static std::atomic<ThreadPool*> g_pool{nullptr};
+static std::mutex               g_pool_mutex;
+
+// governor 的狀態（實作在後面）；fork 之後要歸零
+static std::atomic<int> g_in_flight{0};  // 正在跑的頂層呼叫
+static std::atomic<int> g_in_use{0};     // 頂層呼叫分走的 thread 總數
+
+#if defined(__unix__) || defined(__APPLE__)
+// fork 出來的子行程只剩呼叫 fork 的那條 thread：舊的 pool 不能再用
+// （worker 不在了、queue 的 mutex 可能停在鎖住的狀態），丟掉它，下次用到時重開。
+// 其他 thread 上還沒跑完的呼叫在子行程裡也不存在了
+static void reset_after_fork() {
+    g_pool.store(nullptr, std::memory_order_relaxed);
+    g_in_flight.store(0, std::memory_order_relaxed);
+    g_in_use.store(0, std::memory_order_relaxed);
+    reset_slots();
+}
+#endif
+
+ThreadPool& ThreadPool::instance() {
+    ThreadPool* pool = g_pool.load(std::memory_order_acquire);
+    if (pool) return *pool;
+
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    pool = g_pool.load(std::memory_order_acquire);
+    if (!pool) {
+#if defined(__unix__) || defined(__APPLE__)
+        static const bool registered = (pthread_atfork(nullptr, nullptr, reset_after_fork) == 0);
+        (void)registered;
+#endif
+        // 刻意不釋放：行程結束時 worker 可能還停在 wait 裡，
+        // 在 static 解構的階段去 join 它們反而容易出事
+        pool = new ThreadPool(available_cpus() - 1);
+        pool->active_.store(std::clamp(max_threads() - 1, 0, pool->workers_), std::memory_order_relaxed);
+        g_pool.store(pool, std::memory_order_release);
+    }
+    return *pool;
+}
+
+bool ThreadPool::on_worker() {
+    return tls_worker >= 0;
+}
+
+bool ThreadPool::in_pool_work() {
+    return tls_worker >= 0 || tls_helping > 0;
+}
+
+void ThreadPool::limit_threads(int threads) {
+    ThreadPool* pool = g_pool.load(std::memory_order_acquire);
+    if (!pool) return;
+    pool->active_.store(std::clamp(threads - 1, 0, pool->workers_), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(pool->sleep_mutex_);
+    }
+    pool->wake_.notify_all();
+}
+
+ThreadPool::ThreadPool(int workers) : workers_(std::max(0, workers)), active_(workers_) {
+    for (int i = 0; i <= workers_; ++i) queues_.push_back(std::make_unique<Queue>());
+    threads_.reserve(workers_);
+    for (int i = 0; i < workers_; ++i) {
+        threads_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    // instance() 建的 pool 不會被解構；worker 沒有停止的路徑，只能放掉
+    for (std::thread& t : threads_) t.detach();
+}
+
+// ======================
+//  排程
+// ======================
+
+// 先拿自己的（尾端），再拿入口 queue 的，最後去偷別人的（頭端）
+bool ThreadPool::try_pop(int self, Task& t) {
+    const int workers = workers_;
+
+    auto take = [&](Queue& q, bool back) {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        if (back) {
+            t = q.tasks.back();
+            q.tasks.pop_back();
+        } else {
+            t = q.tasks.front();
+            q.tasks.pop_front();
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    };
+
+    if (self >= 0 && take(*queues_[self], true)) return true;
+    if (take(*queues_.back(), false)) return true;
+    for (int k = 1; k <= workers; ++k) {
+        const int victim = (self + k + workers) % workers;
+        if (victim != self && take(*queues_[victim], false)) return true;
+    }
+    return false;
+}
+
+void ThreadPool::execute(const Task& t) {
+    try {
+        (*t.body)(t.begin, t.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(t.group->error_mutex);
+        if (!t.group->error) t.group->error = std::current_exception();
+    }
+    // 這之後 group 可能已經被呼叫端收掉，不能再碰
+    t.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::worker_loop(int id) {
+    tls_worker = id;
+    Task t;
+    // 編號 >= active_ 的 worker 被預算停用：自己的 deque 一定是空的（只有在
+    // parallel_for 裡才會推，而它要等那組做完才返回），睡著就好
+    auto enabled = [this, id] { return id < active_.load(std::memory_order_relaxed); };
+    for (;;) {
+        if (enabled() && try_pop(id, t)) {
+            execute(t);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [&] { return enabled() && queued_.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void ThreadPool::parallel_for(long begin, long end, long grain,
+                              const std::function<void(long, long)>& body) {
+    if (end <= begin) return;
+    grain = std::max(1L, grain);
+    const long chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || active_.load(std::memory_order_relaxed) == 0) {
+        body(begin, end);
+        return;
+    }
+
+    Group group;
+    group.pending.store(chunks, std::memory_order_relaxed);
+
+    const int self = tls_worker;
+    Queue& q = (self >= 0) ? *queues_[self] : *queues_.back();
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        // 倒著推：自己從尾端拿到的是第一塊，別人從頭端偷走的是最後幾塊
+        for (long k = chunks - 1; k >= 0; --k) {
+            const long b = begin + k * grain;
+            q.tasks.push_back(Task{&body, b, std::min(end, b + grain), &group});
+        }
+        queued_.fetch_add(chunks, std::memory_order_release);
+    }
+    {
+        // 跟 worker 檢查 queued_ 的時間點錯開，不會漏掉叫醒
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+
+    // 呼叫端一起做，直到這一組做完；拿到別組的工作（巢狀呼叫時）也照做，一樣是進度
+    Task t;
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (try_pop(self, t)) {
+            ++tls_helping;  // 這段跟 worker 做的一樣算在這組的帳上（execute 不會丟例外）
+            execute(t);
+            --tls_helping;
+        } else {
+            std::this_thread::yield();  // 剩下的塊在別的 thread 手上
+        }
+    }
+
+    if (group.error) std::rethrow_exception(group.error);
+}
+
+// ======================
+//  concurrency governor
+// ======================
+
+// cgroup 的 CPU 配額換算成幾顆 CPU（無條件進位）；沒有限制回傳 0
+static int cgroup_cpu_limit() {
+#ifdef __linux__
+    auto to_cpus = [](double quota, double period) {
+        if (quota <= 0.0 || period <= 0.0) return 0;
+        return std::max(1, static_cast<int>(std::ceil(quota / period)));
+    };
+
+    // cgroup v2：cpu.max 是 "<quota> <period>"，沒有限制時 quota 寫 "max"
+    {
+        std::ifstream f("/sys/fs/cgroup/cpu.max");
+        std::string quota;
+        double period = 0.0;
+        if (f >> quota >> period) {
+            return quota == "max" ? 0 : to_cpus(std::atof(quota.c_str()), period);
+        }
+    }
+    // cgroup v1：cfs_quota_us = -1 代表沒有限制
+    for (const char* dir : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"}) {
+        std::ifstream q(std::string(dir) + "/cpu.cfs_quota_us");
+        std::ifstream p(std::string(dir) + "/cpu.cfs_period_us");
+        double quota = 0.0, period = 0.0;
+        if (q >> quota && p >> period) return to_cpus(quota, period);
+    }
+#endif
+    return 0;
+}
+
+int available_cpus() {
+    static const int cpus = [] {
+        int n = static_cast<int>(std::thread::hardware_concurrency());
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) n = CPU_COUNT(&set);
+#endif
+        const int quota = cgroup_cpu_limit();
+        if (quota > 0) n = std::min(n, quota);
+        return std::max(1, n);
+    }();
+    return cpus;
+}
+
+#ifdef PF_HAS_OPENMP
+// 載入時先記下使用者的 OMP_NUM_THREADS：之後 ThreadScope 會用 omp_set_num_threads 蓋掉
+static const int g_omp_max_threads = omp_get_max_threads();
+#endif
+
+static int default_max_threads() {
+    static const int n = [] {
+        const char* env = std::getenv("PF_MAX_THREADS");
+        const int v = env ? std::atoi(env) : 0;
+        if (v > 0) return v;
+        int cpus = available_cpus();
+#ifdef PF_HAS_OPENMP
+        if (g_omp_max_threads > 0) cpus = std::min(cpus, g_omp_max_threads);
+#endif
+        return cpus;
+    }();
+    return n;
+}
+
+static std::atomic<int>      g_max_threads{0};  // 0：用預設
+static std::atomic<int>      g_peak_in_flight{0};
+static std::atomic<uint64_t> g_parallel_calls{0};
+static std::atomic<uint64_t> g_throttled_calls{0};
+static std::atomic<uint64_t> g_serial_calls{0};
+
+static thread_local int tls_depth = 0;  // 這條 thread 目前在幾層 ThreadScope 裡
+static thread_local int tls_grant = 1;  // 最外層分到的 thread 數
+static thread_local int tls_pin_base  = -1;  // 最外層分到的 pinning slot 起點（-1：不 pin）
+static thread_local int tls_pin_count = 0;
+
+int max_threads() {
+    const int n = g_max_threads.load(std::memory_order_relaxed);
+    return n > 0 ? n : default_max_threads();
+}
+
+void set_max_threads(int n) {
+    g_max_threads.store(std::max(0, n), std::memory_order_relaxed);
+    ThreadPool::limit_threads(max_threads());
+}
+
+ConcurrencyStats concurrency_stats() {
+    ConcurrencyStats s;
+    s.max_threads     = max_threads();
+    s.available_cpus  = available_cpus();
+    s.in_flight       = g_in_flight.load(std::memory_order_relaxed);
+    s.peak_in_flight  = g_peak_in_flight.load(std::memory_order_relaxed);
+    s.parallel_calls  = g_parallel_calls.load(std::memory_order_relaxed);
+    s.throttled_calls = g_throttled_calls.load(std::memory_order_relaxed);
+    s.serial_calls    = g_serial_calls.load(std::memory_order_relaxed);
+    return s;
+}
+
+void reset_concurrency_stats() {
+    g_peak_in_flight.store(g_in_flight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    g_parallel_calls.store(0, std::memory_order_relaxed);
+    g_throttled_calls.store(0, std::memory_order_relaxed);
+    g_serial_calls.store(0, std::memory_order_relaxed);
+}
+
+// pool 的工作或 OpenMP team 裡：這條 thread 已經算在外層呼叫的帳上
+static bool in_parallel_work() {
+#ifdef PF_HAS_OPENMP
+    if (omp_in_parallel()) return true;
+#endif
+    return ThreadPool::in_pool_work();
+}
+
+// 把 plan 限制在 grant 條 thread 以內
+static void fit_plan(ExecPlan& plan, int grant) {
+    if (plan.backend == Backend::Single) return;
+    // 在 worker 上再推工作給同一個 pool，不會多出 thread
+    if (plan.backend == Backend::ThreadPool && ThreadPool::in_pool_work()) return;
+    if (grant < 2) {
+        plan = ExecPlan{Backend::Single, 0};
+        return;
+    }
+    if (plan.backend == Backend::OpenMP) {
+        plan.threads = plan.threads > 0 ? std::min(plan.threads, grant) : grant;
+    }
+}
+
+bool enter_call(ExecPlan& plan) {
+    if (tls_depth++ > 0) {
+        fit_plan(plan, tls_grant);
+        return false;
+    }
+    if (in_parallel_work()) {
+        tls_grant = 1;
+        fit_plan(plan, 1);
+        return false;
+    }
+
+    const int budget = max_threads();
+    int want = 1;
+    if (plan.backend == Backend::OpenMP) {
+        want = plan.threads > 0 ? std::min(plan.threads, budget) : budget;
+    } else if (plan.backend == Backend::ThreadPool) {
+        want = std::min(budget, ThreadPool::instance().size());
+    }
+
+    const int active = g_in_flight.fetch_add(1, std::memory_order_relaxed) + 1;
+    int peak = g_peak_in_flight.load(std::memory_order_relaxed);
+    while (peak < active &&
+           !g_peak_in_flight.compare_exchange_weak(peak, active, std::memory_order_relaxed)) {
+    }
+
+    // 分到的份額：不超過還沒被佔走的，也不超過平均分給同時在跑的呼叫的量；至少一條
+    int used = g_in_use.load(std::memory_order_relaxed);
+    int grant = 1;
+    do {
+        grant = std::max(1, std::min({want, budget - used, budget / active}));
+    } while (!g_in_use.compare_exchange_weak(used, used + grant, std::memory_order_relaxed));
+    tls_grant = grant;
+
+    if (want < 2) {
+        g_serial_calls.fetch_add(1, std::memory_order_relaxed);
+    } else if (grant < want) {
+        g_throttled_calls.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        g_parallel_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    fit_plan(plan, grant);
+
+    // pinning 開著時，OpenMP team 拿一段別人沒在用的 slot：同時在跑的呼叫不會擠在同幾顆 CPU
+    tls_pin_base  = -1;
+    tls_pin_count = 0;
+    if (plan.backend == Backend::OpenMP && pinning_enabled()) {
+        tls_pin_base = reserve_slots(plan.threads);
+        if (tls_pin_base >= 0) tls_pin_count = plan.threads;
+    }
+    return true;
+}
+
+int team_pin_base() {
+    return tls_depth > 0 ? tls_pin_base : -1;
+}
+
+void leave_call(bool top_level) {
+    --tls_depth;
+    if (!top_level) return;
+    release_slots(tls_pin_base, tls_pin_count);
+    tls_pin_base  = -1;
+    tls_pin_count = 0;
+    g_in_use.fetch_sub(tls_grant, std::memory_order_relaxed);
+    g_in_flight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// ======================
+//  NUMA
+// ======================
+
+// "0-3,8-11" 這種 cpulist 格式
+static std::vector<int> parse_cpulist(const std::string& text) {
+    std::vector<int> cpus;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        char* end = nullptr;
+        const long a = std::strtol(text.c_str() + i, &end, 10);
+        if (end == text.c_str() + i) break;
+        long b = a;
+        i = static_cast<std::size_t>(end - text.c_str());
+        if (i < text.size() && text[i] == '-') {
+            b = std::strtol(text.c_str() + i + 1, &end, 10);
+            i = static_cast<std::size_t>(end - text.c_str());
+        }
+        for (long c = a; c <= b; ++c) cpus.push_back(static_cast<int>(c));
+        if (i < text.size() && text[i] == ',') ++i;
+        else break;
+    }
+    return cpus;
+}
+
+struct Topology {
+    std::vector<std::vector<int>> nodes;  // 每個 node 能用的 CPU
+    std::vector<int>              order;  // pinning 用的順序：一個 node 排完才換下一個
+#ifdef __linux__
+    cpu_set_t                     allowed;  // 行程一開始的 affinity，解除 pinning 時還原
+#endif
+};
+
+static const Topology& topology() {
+    static const Topology topo = [] {
+        Topology t;
+#ifdef __linux__
+        CPU_ZERO(&t.allowed);
+        if (sched_getaffinity(0, sizeof(t.allowed), &t.allowed) != 0) {
+            for (int c = 0; c < available_cpus(); ++c) CPU_SET(c, &t.allowed);
+        }
+        std::vector<std::pair<int, std::vector<int>>> found;
+        if (DIR* dir = opendir("/sys/devices/system/node")) {
+            while (dirent* e = readdir(dir)) {
+                int id = 0;
+                if (std::sscanf(e->d_name, "node%d", &id) != 1) continue;
+                std::ifstream f(std::string("/sys/devices/system/node/") + e->d_name + "/cpulist");
+                std::string line;
+                if (!std::getline(f, line)) continue;
+                std::vector<int> cpus;
+                for (int c : parse_cpulist(line)) {
+                    if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &t.allowed)) cpus.push_back(c);
+                }
+                if (!cpus.empty()) found.emplace_back(id, std::move(cpus));
+            }
+            closedir(dir);
+        }
+        std::sort(found.begin(), found.end());
+        for (auto& n : found) t.nodes.push_back(std::move(n.second));
+        if (t.nodes.empty()) {
+            std::vector<int> cpus;
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &t.allowed)) cpus.push_back(c);
+            }
+            t.nodes.push_back(std::move(cpus));
+        }
+#else
+        std::vector<int> cpus(available_cpus());
+        for (int c = 0; c < static_cast<int>(cpus.size()); ++c) cpus[c] = c;
+        t.nodes.push_back(std::move(cpus));
+#endif
+        for (const auto& n : t.nodes) t.order.insert(t.order.end(), n.begin(), n.end());
+        return t;
+    }();
+    return topo;
+}
+
+static std::atomic<int> g_numa_aware{-1};  // -1：還沒決定（看 PF_NUMA 或 node 數）
+static std::atomic<int> g_pin_epoch{0};    // 每次切換 pinning 加一；奇數代表開著
+
+static thread_local int tls_pin_epoch = 0;  // 這條 thread 套用過的狀態
+static thread_local int tls_pin_cpu   = -1;
+
+bool numa_aware() {
+    int v = g_numa_aware.load(std::memory_order_relaxed);
+    if (v < 0) {
+        const char* env = std::getenv("PF_NUMA");
+        v = env ? (std::atoi(env) != 0) : (topology().nodes.size() > 1);
+        g_numa_aware.store(v, std::memory_order_relaxed);
+    }
+    return v != 0;
+}
+
+void set_numa_aware(bool enabled) {
+    g_numa_aware.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+void set_thread_pinning(bool enabled) {
+    int e = g_pin_epoch.load(std::memory_order_relaxed);
+    while (((e & 1) != 0) != enabled &&
+           !g_pin_epoch.compare_exchange_weak(e, e + 1, std::memory_order_relaxed)) {
+    }
+}
+
+NumaInfo numa_info() {
+    NumaInfo info;
+    for (const auto& n : topology().nodes) info.cpus_per_node.push_back(static_cast<int>(n.size()));
+    info.numa_aware = numa_aware();
+    info.pinned     = (g_pin_epoch.load(std::memory_order_relaxed) & 1) != 0;
+    return info;
+}
+
+static bool pinning_enabled() {
+    return (g_pin_epoch.load(std::memory_order_relaxed) & 1) != 0;
+}
+
+// slot i 對到 topology().order[i]。governor 給每個頂層 OpenMP 呼叫一段連續的 slot，
+// 同時在跑的呼叫互不重疊。鎖用 atomic flag：fork 之後子行程可以直接清掉
+static std::atomic_flag  g_slot_lock = ATOMIC_FLAG_INIT;
+static std::vector<char> g_slot_busy;
+
+struct SlotLock {
+    SlotLock()  { while (g_slot_lock.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+    ~SlotLock() { g_slot_lock.clear(std::memory_order_release); }
+};
+
+// 找 n 個連續的空 slot（first fit）；不夠就回傳 -1，這次不 pin，不跟別的 team 擠同幾顆 CPU
+static int reserve_slots(int n) {
+    const int total = static_cast<int>(topology().order.size());
+    if (n < 1 || n > total) return -1;
+    SlotLock lock;
+    if (g_slot_busy.size() != static_cast<std::size_t>(total)) g_slot_busy.assign(total, 0);
+    for (int base = 0; base + n <= total; ++base) {
+        int k = 0;
+        while (k < n && !g_slot_busy[base + k]) ++k;
+        if (k == n) {
+            std::fill_n(g_slot_busy.begin() + base, n, 1);
+            return base;
+        }
+        base += k;  // base + k 被占走了，從它的下一個開始找
+    }
+    return -1;
+}
+
+static void release_slots(int base, int n) {
+    if (base < 0) return;
+    SlotLock lock;
+    std::fill_n(g_slot_busy.begin() + base, n, 0);
+}
+
+static void reset_slots() {
+    g_slot_lock.clear(std::memory_order_relaxed);
+    std::fill(g_slot_busy.begin(), g_slot_busy.end(), 0);
+}
+
+// 把這條 thread 綁到 order[slot]；slot < 0 或 pinning 關著時還原成原本的 affinity
+static void pin_to_slot(int slot) {
+    const int epoch = g_pin_epoch.load(std::memory_order_relaxed);
+    const int want  = (epoch & 1) ? slot : -1;
+    if (epoch == tls_pin_epoch && tls_pin_cpu == want) return;
+    tls_pin_epoch = epoch;
+    tls_pin_cpu   = want;
+#ifdef __linux__
+    const Topology& topo = topology();
+    if (want >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(topo.order[want % topo.order.size()], &set);
+        sched_setaffinity(0, sizeof(set), &set);  // 失敗（CPU 被拿走了）就維持原狀
+    } else {
+        sched_setaffinity(0, sizeof(topo.allowed), &topo.allowed);
+    }
+#endif
+}
+
+void pin_team_thread(int base, int t) {
+    if (t > 0) pin_to_slot(base < 0 ? -1 : base + t);  // 0 號是呼叫端自己
+}
+
+void parallel_chunks(std::size_t n, std::size_t unit_bytes,
+                     const std::function<void(std::size_t, std::size_t)>& body) {
+    if (n == 0) return;
+    const std::size_t unit = std::max<std::size_t>(1, unit_bytes);
+#ifdef PF_HAS_OPENMP
+    if (omp_in_parallel()) {
+        body(0, n);
+        return;
+    }
+    if (numa_aware() && n > 1) {
+        // 跟 parallel_rows 一樣每條 thread 一段連續的範圍，之後寫這段 row 的也是同一條
+        const int threads = std::max(1, std::min(omp_get_max_threads(), max_threads()));
+        const int pin_base = team_pin_base();
+#pragma omp parallel num_threads(threads)
+        {
+            const int t  = omp_get_thread_num();
+            const int nt = omp_get_num_threads();
+            pin_team_thread(pin_base, t);
+            const std::size_t b = n / nt * t;
+            const std::size_t e = (t + 1 == nt) ? n : n / nt * (t + 1);
+            if (b < e) body(b, e);
+        }
+        return;
+    }
+#endif
+    if (n < 2 || n * unit < kParallelFillBytes || max_threads() <= 1) {
+        body(0, n);
+        return;
+    }
+    const std::size_t per = std::max<std::size_t>(1, kFillChunkBytes / unit);
+    const long chunks = static_cast<long>((n + per - 1) / per);
+    ThreadPool::instance().parallel_for(0, chunks, 1, [&](long k0, long k1) {
+        for (long k = k0; k < k1; ++k) {
+            const std::size_t b = static_cast<std::size_t>(k) * per;
+            body(b, std::min(n, b + per));
+        }
+    });
+}
+
+void first_touch_zero(uint8_t* p, std::size_t bytes) {
+    parallel_chunks(bytes, 1, [p](std::size_t b, std::size_t e) { std::memset(p + b, 0, e - b); });
+}
+
+// ======================
+//  row band
+// ======================
+
+int band_rows(int rows, std::size_t bytes_per_row, int threads) {
+    constexpr std::size_t kL2Bytes        = 256 * 1024;  // 保守估計的每核 L2
+    constexpr int         kBandsPerThread = 4;
+
+    const std::size_t row_bytes = std::max<std::size_t>(1, bytes_per_row);
+    const int by_cache   = static_cast<int>(std::max<std::size_t>(1, kL2Bytes / row_bytes));
+    const int slots      = std::max(1, threads) * kBandsPerThread;
+    const int by_balance = std::max(1, (rows + slots - 1) / slots);
+    return std::min(by_cache, by_balance);
+}
+
+int backend_threads(Backend exec) {
+    switch (exec) {
+    case Backend::ThreadPool:
+        return ThreadPool::instance().size();
+    case Backend::OpenMP:
+#ifdef PF_HAS_OPENMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    default:
+        return 1;
+    }
+}
+
+} // namespace pf
@@ -0,0 +1,133 @@
+#include "pixfoundry/pipeline.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace pf {
+
+Pipeline::Pipeline(std::vector<ImageOp> steps)
+    : steps_(std::move(steps)) {}
+
+Pipeline& Pipeline::add(ImageOp op) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    steps_.push_back(std::move(op));
+    planned_ = ImageShape{};  // 下次 run 重新規劃（buffer 夠大就沿用）
+    return *this;
+}
+
+ImageShape Pipeline::output_shape(const ImageShape& in) const {
+    ImageShape s = in;
+    for (const ImageOp& op : steps_) s = op.output_shape(s);
+    return s;
+}
+
+bool Pipeline::allows_in_place() const {
+    return steps_.size() != 1 || steps_[0].in_place;
+}
+
+std::size_t Pipeline::buffer_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_[0] + capacity_[1];
+}
+
+// 每一步（最後一步除外）的輸出放哪一塊：
+//   - 上一步的輸出就在 buffer 裡、這一步又能原地做 → 寫回同一塊
+//   - 否則寫到另一塊（第一步的輸入是呼叫端的 src，寫 buffer 0）
+// 兩塊各自取需要的最大值；比現有的大才重新配置
+void Pipeline::plan(const ImageShape& in) {
+    const std::size_t n = steps_.size();
+    std::vector<ImageShape> shapes;
+    std::vector<int> where;
+    shapes.reserve(n);
+    where.reserve(n);
+
+    std::size_t need[2] = {0, 0};
+    ImageShape s = in;
+    int cur = -1;  // -1：目前的資料在 src
+    for (std::size_t i = 0; i < n; ++i) {
+        const ImageShape next = steps_[i].output_shape(s);
+        if (i + 1 < n) {
+            const int b = (cur >= 0 && steps_[i].in_place && next == s) ? cur : (cur == 0 ? 1 : 0);
+            need[b] = std::max(need[b], next.elems());
+            where.push_back(b);
+            shapes.push_back(next);
+            cur = b;
+        }
+        s = next;
+    }
+
+    for (int b = 0; b < 2; ++b) {
+        if (need[b] > capacity_[b]) {
+            buffers_[b]  = allocate_buffer(need[b], Init::None);
+            capacity_[b] = need[b];
+        }
+    }
+
+    stages_.clear();
+    stages_.reserve(shapes.size());
+    for (std::size_t i = 0; i < shapes.size(); ++i) {
+        stages_.emplace_back(shapes[i].h, shapes[i].w, shapes[i].c, buffers_[where[i]]);
+    }
+    planned_ = in;
+}
+
+void Pipeline::run(const ImageU8& src, ImageU8& dst, Backend backend) {
+    if (src.empty()) throw std::invalid_argument("Pipeline: empty image");
+    std::lock_guard<std::mutex> lock(mutex_);
+    run_locked(src, dst, backend);
+}
+
+ImageU8 Pipeline::run(const ImageU8& src, Backend backend) {
+    if (src.empty()) throw std::invalid_argument("Pipeline: empty image");
+    std::lock_guard<std::mutex> lock(mutex_);
+    const ImageShape out = output_shape(shape_of(src));
+    // 找一塊呼叫端已經放掉、大小又一樣的；src 是上一次的輸出時它不是 unique，不會被選到
+    ImageU8* dst = nullptr;
+    for (ImageU8& o : outputs_) {
+        if (!o.empty() && o.is_unique() && shape_of(o) == out) {
+            dst = &o;
+            break;
+        }
+    }
+    if (!dst) {
+        // 換掉一塊沒人用的（或兩塊都還在用：呼叫端手上那份不受影響）
+        dst = (outputs_[0].empty() || outputs_[0].is_unique()) ? &outputs_[0] : &outputs_[1];
+        *dst = ImageU8(out.h, out.w, out.c, Init::None);
+    }
+    run_locked(src, *dst, backend);
+    return dst->share();
+}
+
+void Pipeline::run_locked(const ImageU8& src, ImageU8& dst, Backend backend) {
+    const ImageShape in = shape_of(src);
+    if (in != planned_) plan(in);  // 規劃時就把每一步的參數 / 大小檢查過了
+
+    if (steps_.empty()) {
+        // 空的 pipeline：原樣複製
+        check_output(dst, in.h, in.w, in.c, "Pipeline");
+        check_no_overlap(src, dst, "Pipeline", true);
+        if (same_pixels(src, dst)) return;
+        const std::size_t row_len = static_cast<std::size_t>(in.w) * in.c;
+        copy_rows(dst.data(), dst.stride(), src.data(), src.stride(), static_cast<std::size_t>(in.h), row_len);
+        return;
+    }
+
+    const std::size_t last = steps_.size() - 1;
+    if (steps_.size() > 1) {
+        // 中間 buffer 是自己的；dst 不能壓到它們
+        for (const ImageU8& st : stages_) {
+            if (overlaps(st, dst)) throw std::invalid_argument("Pipeline: dst overlaps an intermediate buffer");
+        }
+    }
+
+    const ImageU8* cur = &src;
+    for (std::size_t i = 0; i < last; ++i) {
+        steps_[i].run(*cur, stages_[i], backend);
+        cur = &stages_[i];
+    }
+    steps_[last].run(*cur, dst, backend);
+}
+
+} // namespace pf
@@ -0,0 +1,1200 @@
+#include "pixfoundry/png.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace pf {
+
+namespace {
+
+// ======================
+//  checksum
+// ======================
+
+struct CrcTable {
+    uint32_t t[256];
+    CrcTable() {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+    }
+};
+
+uint32_t crc32(const uint8_t* p, std::size_t n)
+{
+    static const CrcTable table;
+    uint32_t crc = ~0u;
+    for (std::size_t i = 0; i < n; ++i) crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// adler：前面資料的結果（串流時一段一段接著算）
+uint32_t adler32(const uint8_t* p, std::size_t n, uint32_t adler = 1)
+{
+    uint32_t s1 = adler & 0xFFFF, s2 = adler >> 16;
+    while (n > 0) {
+        const std::size_t block = std::min<std::size_t>(n, 5552);  // 5552：s2 不會溢位的最大段長
+        for (std::size_t i = 0; i < block; ++i) {
+            s1 += p[i];
+            s2 += s1;
+        }
+        s1 %= 65521;
+        s2 %= 65521;
+        p += block;
+        n -= block;
+    }
+    return (s2 << 16) | s1;
+}
+
+// ======================
+//  deflate
+// ======================
+
+// deflate 的 bit 是 LSB first
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint32_t bits, int n) {
+        acc_ |= static_cast<uint64_t>(bits) << count_;
+        count_ += n;
+        if (count_ >= 32) {
+            const uint32_t v = static_cast<uint32_t>(acc_);
+            const uint8_t b[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)};
+            out_.insert(out_.end(), b, b + 4);
+            acc_ >>= 32;
+            count_ -= 32;
+        }
+    }
+
+    // 補 0 到 byte 邊界，把剩下的 bits 寫出去
+    void align() {
+        while (count_ > 0) {
+            out_.push_back(static_cast<uint8_t>(acc_));
+            acc_ >>= 8;
+            count_ = std::max(0, count_ - 8);
+        }
+        acc_ = 0;
+    }
+
+    std::vector<uint8_t>& bytes() { return out_; }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t acc_   = 0;
+    int      count_ = 0;
+};
+
+constexpr int kLitCodes  = 286;
+constexpr int kDistCodes = 30;
+
+constexpr uint16_t kLenBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t  kLenExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                    6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t  kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// code length 的 code length 寫出去的順序
+constexpr uint8_t  kClOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// match 長度 / 距離 → code
+struct CodeTables {
+    uint8_t len_code[259];
+    uint8_t dist_small[512];  // 距離 - 1 < 512
+    uint8_t dist_large[256];  // 其他：(距離 - 1) >> 7（512 以上的 code 都對齊 128）
+
+    CodeTables() {
+        for (int i = 0; i < 29; ++i)
+            for (int l = kLenBase[i]; l < kLenBase[i] + (1 << kLenExtra[i]) && l <= 258; ++l) len_code[l] = static_cast<uint8_t>(i);
+        len_code[258] = 28;
+        for (int i = 0; i < 30; ++i) {
+            for (int d = kDistBase[i]; d < kDistBase[i] + (1 << kDistExtra[i]); ++d) {
+                if (d - 1 < 512) dist_small[d - 1] = static_cast<uint8_t>(i);
+                else dist_large[(d - 1) >> 7] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+
+    int dist_code(int d) const { return d <= 512 ? dist_small[d - 1] : dist_large[(d - 1) >> 7]; }
+};
+
+const CodeTables& code_tables()
+{
+    static const CodeTables t;
+    return t;
+}
+
+// literal：dist == 0、value 是 byte；match：value 是長度
+struct Token {
+    uint16_t value;
+    uint16_t dist;
+};
+
+// 長度不超過 max_len 的 Huffman 碼長。
+// 先用 Moffat-Katajainen 的 in-place 演算法算一般的 Huffman，
+// 太長的碼再照 miniz 的作法攤回 max_len 以內。
+void huffman_lengths(const uint32_t* freq, int n, int max_len, uint8_t* lens)
+{
+    struct Sym {
+        uint32_t key;
+        int      sym;
+    };
+    std::vector<Sym> a;
+    for (int i = 0; i < n; ++i) {
+        lens[i] = 0;
+        if (freq[i]) a.push_back({freq[i], i});
+    }
+    const int used = static_cast<int>(a.size());
+    if (used == 0) return;
+    if (used == 1) {
+        lens[a[0].sym] = 1;
+        return;
+    }
+    std::sort(a.begin(), a.end(), [](const Sym& x, const Sym& y) { return x.key < y.key; });
+
+    // 之後 a[i].key 變成第 i 個（依頻率由小到大）symbol 的碼長
+    a[0].key += a[1].key;
+    int root = 0, leaf = 2;
+    for (int next = 1; next < used - 1; ++next) {
+        if (leaf >= used || a[root].key < a[leaf].key) {
+            a[next].key = a[root].key;
+            a[root++].key = static_cast<uint32_t>(next);
+        } else {
+            a[next].key = a[leaf++].key;
+        }
+        if (leaf >= used || (root < next && a[root].key < a[leaf].key)) {
+            a[next].key += a[root].key;
+            a[root++].key = static_cast<uint32_t>(next);
+        } else {
+            a[next].key += a[leaf++].key;
+        }
+    }
+    a[used - 2].key = 0;
+    for (int next = used - 3; next >= 0; --next) a[next].key = a[a[next].key].key + 1;
+    int avail = 1, depth = 0, taken = 0;
+    root = used - 2;
+    int next = used - 1;
+    while (avail > 0) {
+        while (root >= 0 && static_cast<int>(a[root].key) == depth) {
+            ++taken;
+            --root;
+        }
+        while (avail > taken) {
+            a[next--].key = static_cast<uint32_t>(depth);
+            --avail;
+        }
+        avail = 2 * taken;
+        ++depth;
+        taken = 0;
+    }
+
+    int count[33] = {};
+    for (const Sym& s : a) ++count[std::min<uint32_t>(s.key, 32)];
+    for (int l = max_len + 1; l <= 32; ++l) {
+        count[max_len] += count[l];
+        count[l] = 0;
+    }
+    uint32_t total = 0;
+    for (int l = max_len; l > 0; --l) total += static_cast<uint32_t>(count[l]) << (max_len - l);
+    while (total != (1u << max_len)) {
+        --count[max_len];
+        for (int l = max_len - 1; l > 0; --l) {
+            if (count[l]) {
+                --count[l];
+                count[l + 1] += 2;
+                break;
+            }
+        }
+        --total;
+    }
+    // 頻率最高的拿最短的碼
+    int j = used;
+    for (int l = 1; l <= max_len; ++l)
+        for (int k = count[l]; k > 0; --k) lens[a[--j].sym] = static_cast<uint8_t>(l);
+}
+
+// canonical Huffman 碼（已經反轉成 LSB first）
+void huffman_codes(const uint8_t* lens, int n, uint16_t* codes)
+{
+    int bl_count[16] = {};
+    for (int i = 0; i < n; ++i) ++bl_count[lens[i]];
+    bl_count[0] = 0;
+    int next[16] = {};
+    int code = 0;
+    for (int bits = 1; bits < 16; ++bits) {
+        code = (code + bl_count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+    for (int i = 0; i < n; ++i) {
+        const int len = lens[i];
+        if (!len) continue;
+        int c = next[len]++, r = 0;
+        for (int b = 0; b < len; ++b, c >>= 1) r = (r << 1) | (c & 1);
+        codes[i] = static_cast<uint16_t>(r);
+    }
+}
+
+struct FixedTables {
+    uint8_t  lit_len[288];
+    uint16_t lit_code[288];
+    uint8_t  dist_len[30];
+    uint16_t dist_code[30];
+
+    FixedTables() {
+        for (int i = 0; i < 288; ++i) lit_len[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+        std::fill(dist_len, dist_len + 30, 5);
+        huffman_codes(lit_len, 288, lit_code);
+        huffman_codes(dist_len, 30, dist_code);
+    }
+};
+
+class Deflater {
+public:
+    Deflater(int level, std::vector<uint8_t>& out) : level_(level), bw_(out) {
+        static constexpr int kChain[10] = {0, 1, 2, 4, 8, 16, 32, 64, 128, 256};
+        static constexpr int kNice[10]  = {0, 8, 16, 32, 16, 32, 128, 128, 258, 258};
+        chain_ = kChain[level];
+        nice_  = kNice[level];
+        lazy_  = level >= 4;
+    }
+
+    void run(const uint8_t* in, std::size_t n) { run(in, 0, n, true); }
+
+    // 串流：in[0, start) 是上一段已經壓過的資料（只拿來當 window），壓 [start, n)；
+    // final 才寫最後一個 block、補齊 byte。沒寫完的 bit 留在 BitWriter 裡接下一段
+    void run(const uint8_t* in, std::size_t start, std::size_t n, bool final) {
+        in_ = in;
+        n_  = n;
+        if (level_ == 0) {
+            write_stored(start, n - start, final);
+            if (final) bw_.align();
+            return;
+        }
+
+        head_.assign(1 << kHashBits, -1);
+        prev_.assign(kWindow, -1);
+        tokens_.reserve(kBlockTokens);
+        block_start_ = start;
+        for (std::size_t p = start > kWindow ? start - kWindow : 0; p < start; ++p) insert(p);
+
+        std::size_t i = start;
+        while (i < n) {
+            int dist = 0;
+            int len = longest(i, dist);
+            insert(i);
+            if (lazy_ && len >= 3 && len < nice_ && i + 1 < n) {
+                int dist2 = 0;
+                if (longest(i + 1, dist2) > len) {
+                    // 下一個位置的 match 比較長：這個 byte 先當 literal
+                    literal(i);
+                    ++i;
+                    continue;
+                }
+            }
+            if (len >= 3) {
+                tokens_.push_back({static_cast<uint16_t>(len), static_cast<uint16_t>(dist)});
+                for (int k = 1; k < len; ++k) insert(i + k);
+                i += static_cast<std::size_t>(len);
+            } else {
+                literal(i);
+                ++i;
+            }
+            if (tokens_.size() >= kBlockTokens) flush(i, false);
+        }
+        flush(n, final);
+        if (final) bw_.align();
+    }
+
+private:
+    static constexpr int         kHashBits    = 15;
+    static constexpr int         kWindow      = 32768;
+    static constexpr std::size_t kBlockTokens = 1 << 15;
+
+    uint32_t hash(std::size_t pos) const {
+        const uint32_t v = (uint32_t(in_[pos]) << 16) | (uint32_t(in_[pos + 1]) << 8) | in_[pos + 2];
+        return (v * 0x9E3779B1u) >> (32 - kHashBits);
+    }
+
+    void insert(std::size_t pos) {
+        if (pos + 3 > n_) return;
+        const uint32_t h = hash(pos);
+        prev_[pos & (kWindow - 1)] = head_[h];
+        head_[h] = static_cast<int64_t>(pos);
+    }
+
+    // 從 hash chain 找最長的 match（只看 chain_ 個候選）；沒有 3 以上的回傳 0
+    int longest(std::size_t pos, int& dist) const {
+        if (pos + 3 > n_) return 0;
+        const int max_len = static_cast<int>(std::min<std::size_t>(258, n_ - pos));
+        const uint8_t* cur = in_ + pos;
+        int best = 2;
+        int64_t cand = head_[hash(pos)];
+        for (int chain = chain_; cand >= 0 && chain > 0; --chain) {
+            const std::size_t d = pos - static_cast<std::size_t>(cand);
+            if (d > static_cast<std::size_t>(kWindow)) break;  // 再往前都超出 window
+            const uint8_t* m = in_ + cand;
+            if (m[best] == cur[best] && m[0] == cur[0] && m[1] == cur[1]) {
+                int l = 2;
+                while (l < max_len && m[l] == cur[l]) ++l;
+                if (l > best) {
+                    best = l;
+                    dist = static_cast<int>(d);
+                    if (l >= nice_ || l == max_len) break;
+                }
+            }
+            cand = prev_[static_cast<std::size_t>(cand) & (kWindow - 1)];
+        }
+        return best >= 3 ? best : 0;
+    }
+
+    void literal(std::size_t pos) { tokens_.push_back({in_[pos], 0}); }
+
+    // 把目前的 token 寫成一個 block：動態表、固定表、不壓縮三種挑最小的
+    void flush(std::size_t end, bool final) {
+        const CodeTables& ct = code_tables();
+        static const FixedTables fixed;
+
+        uint32_t lit_freq[kLitCodes] = {}, dist_freq[kDistCodes] = {};
+        for (const Token& t : tokens_) {
+            if (t.dist == 0) {
+                ++lit_freq[t.value];
+            } else {
+                ++lit_freq[257 + ct.len_code[t.value]];
+                ++dist_freq[ct.dist_code(t.dist)];
+            }
+        }
+        lit_freq[256] = 1;
+
+        uint8_t lit_len[kLitCodes], dist_len[kDistCodes];
+        huffman_lengths(lit_freq, kLitCodes, 15, lit_len);
+        if (std::all_of(dist_freq, dist_freq + kDistCodes, [](uint32_t f) { return f == 0; })) dist_freq[0] = 1;
+        huffman_lengths(dist_freq, kDistCodes, 15, dist_len);
+
+        // 動態表的 header：literal/length 跟 distance 的碼長一起做 run-length
+        int hlit = kLitCodes, hdist = kDistCodes;
+        while (hlit > 257 && lit_len[hlit - 1] == 0) --hlit;
+        while (hdist > 1 && dist_len[hdist - 1] == 0) --hdist;
+        uint8_t all[kLitCodes + kDistCodes];
+        std::memcpy(all, lit_len, static_cast<std::size_t>(hlit));
+        std::memcpy(all + hlit, dist_len, static_cast<std::size_t>(hdist));
+        const int total = hlit + hdist;
+
+        struct Rle {
+            uint8_t sym, extra;
+        };
+        std::vector<Rle> rle;
+        uint32_t cl_freq[19] = {};
+        for (int i = 0; i < total;) {
+            const uint8_t v = all[i];
+            int run = 1;
+            while (i + run < total && all[i + run] == v) ++run;
+            i += run;
+            if (v == 0) {
+                while (run >= 11) {
+                    const int r = std::min(run, 138);
+                    rle.push_back({18, static_cast<uint8_t>(r - 11)});
+                    run -= r;
+                }
+                if (run >= 3) {
+                    rle.push_back({17, static_cast<uint8_t>(run - 3)});
+                    run = 0;
+                }
+            } else {
+                rle.push_back({v, 0});
+                --run;
+                while (run >= 3) {
+                    const int r = std::min(run, 6);
+                    rle.push_back({16, static_cast<uint8_t>(r - 3)});
+                    run -= r;
+                }
+            }
+            for (; run > 0; --run) rle.push_back({v, 0});
+        }
+        for (const Rle& r : rle) ++cl_freq[r.sym];
+        uint8_t cl_len[19];
+        huffman_lengths(cl_freq, 19, 7, cl_len);
+        int hclen = 19;
+        while (hclen > 4 && cl_len[kClOrder[hclen - 1]] == 0) --hclen;
+
+        // 三種寫法各要幾個 bit
+        uint64_t body_dyn = 0, body_fix = 0;
+        for (int s = 0; s < kLitCodes; ++s) {
+            const uint64_t extra = (s >= 257) ? kLenExtra[s - 257] : 0;
+            body_dyn += lit_freq[s] * (lit_len[s] + extra);
+            body_fix += lit_freq[s] * (fixed.lit_len[s] + extra);
+        }
+        for (int s = 0; s < kDistCodes; ++s) {
+            body_dyn += dist_freq[s] * static_cast<uint64_t>(dist_len[s] + kDistExtra[s]);
+            body_fix += dist_freq[s] * static_cast<uint64_t>(5 + kDistExtra[s]);
+        }
+        uint64_t header_dyn = 5 + 5 + 4 + 3 * static_cast<uint64_t>(hclen);
+        for (const Rle& r : rle) header_dyn += cl_len[r.sym] + (r.sym == 16 ? 2 : r.sym == 17 ? 3 : r.sym == 18 ? 7 : 0);
+        const uint64_t cost_dyn    = 3 + header_dyn + body_dyn;
+        const uint64_t cost_fix    = 3 + body_fix;
+        const std::size_t raw      = end - block_start_;
+        const uint64_t cost_stored = (raw + 5 * ((raw + 65534) / 65535 + 1)) * 8;
+
+        if (raw > 0 && cost_stored < std::min(cost_dyn, cost_fix)) {
+            write_stored(block_start_, raw, final);
+        } else if (cost_dyn < cost_fix) {
+            uint16_t lit_code[kLitCodes], dist_code[kDistCodes], cl_code[19];
+            huffman_codes(lit_len, kLitCodes, lit_code);
+            huffman_codes(dist_len, kDistCodes, dist_code);
+            huffman_codes(cl_len, 19, cl_code);
+            bw_.put(final ? 1 : 0, 1);
+            bw_.put(2, 2);
+            bw_.put(static_cast<uint32_t>(hlit - 257), 5);
+            bw_.put(static_cast<uint32_t>(hdist - 1), 5);
+            bw_.put(static_cast<uint32_t>(hclen - 4), 4);
+            for (int i = 0; i < hclen; ++i) bw_.put(cl_len[kClOrder[i]], 3);
+            for (const Rle& r : rle) {
+                bw_.put(cl_code[r.sym], cl_len[r.sym]);
+                if (r.sym == 16) bw_.put(r.extra, 2);
+                else if (r.sym == 17) bw_.put(r.extra, 3);
+                else if (r.sym == 18) bw_.put(r.extra, 7);
+            }
+            write_tokens(lit_code, lit_len, dist_code, dist_len);
+        } else {
+            bw_.put(final ? 1 : 0, 1);
+            bw_.put(1, 2);
+            write_tokens(fixed.lit_code, fixed.lit_len, fixed.dist_code, fixed.dist_len);
+        }
+        tokens_.clear();
+        block_start_ = end;
+    }
+
+    void write_tokens(const uint16_t* lit_code, const uint8_t* lit_len,
+                      const uint16_t* dist_code, const uint8_t* dist_len) {
+        const CodeTables& ct = code_tables();
+        for (const Token& t : tokens_) {
+            if (t.dist == 0) {
+                bw_.put(lit_code[t.value], lit_len[t.value]);
+                continue;
+            }
+            const int lc = ct.len_code[t.value];
+            bw_.put(lit_code[257 + lc], lit_len[257 + lc]);
+            if (kLenExtra[lc]) bw_.put(t.value - kLenBase[lc], kLenExtra[lc]);
+            const int dc = ct.dist_code(t.dist);
+            bw_.put(dist_code[dc], dist_len[dc]);
+            if (kDistExtra[dc]) bw_.put(t.dist - kDistBase[dc], kDistExtra[dc]);
+        }
+        bw_.put(lit_code[256], lit_len[256]);
+    }
+
+    // 不壓縮的 block：每個最多 65535 bytes
+    void write_stored(std::size_t start, std::size_t len, bool final) {
+        do {
+            const std::size_t chunk = std::min<std::size_t>(len, 65535);
+            len -= chunk;
+            bw_.put((final && len == 0) ? 1 : 0, 1);
+            bw_.put(0, 2);
+            bw_.align();
+            const uint8_t hdr[4] = {uint8_t(chunk), uint8_t(chunk >> 8), uint8_t(~chunk), uint8_t(~chunk >> 8)};
+            std::vector<uint8_t>& out = bw_.bytes();
+            out.insert(out.end(), hdr, hdr + 4);
+            out.insert(out.end(), in_ + start, in_ + start + chunk);
+            start += chunk;
+        } while (len > 0);
+    }
+
+    const int level_;
+    int       chain_ = 0, nice_ = 0;
+    bool      lazy_  = false;
+    BitWriter bw_;
+
+    const uint8_t*       in_ = nullptr;
+    std::size_t          n_  = 0;
+    std::vector<int64_t> head_, prev_;
+    std::vector<Token>   tokens_;
+    std::size_t          block_start_ = 0;
+};
+
+// ======================
+//  filter
+// ======================
+
+inline uint8_t paeth(int a, int b, int c)
+{
+    const int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+// 第 i 個 byte 用 filter type 之後的值；a 左、b 上、c 左上（超出影像的當 0）
+inline uint8_t filtered(int type, const uint8_t* row, const uint8_t* up, int i, int bpp)
+{
+    const int x = row[i];
+    const int a = i >= bpp ? row[i - bpp] : 0;
+    const int b = up[i];
+    const int c = i >= bpp ? up[i - bpp] : 0;
+    switch (type) {
+    case 1:  return static_cast<uint8_t>(x - a);
+    case 2:  return static_cast<uint8_t>(x - b);
+    case 3:  return static_cast<uint8_t>(x - ((a + b) >> 1));
+    case 4:  return static_cast<uint8_t>(x - paeth(a, b, c));
+    default: return static_cast<uint8_t>(x);
+    }
+}
+
+// 五種 filter 各自的 sum |(int8) 值|（step：每隔幾個 byte 取一個）
+int pick_filter(const uint8_t* row, const uint8_t* up, int len, int bpp, int step)
+{
+    long sums[5] = {};
+    for (int i = 0; i < len; i += step) {
+        const int x = row[i];
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = up[i];
+        const int c = i >= bpp ? up[i - bpp] : 0;
+        sums[0] += std::abs(static_cast<int8_t>(x));
+        sums[1] += std::abs(static_cast<int8_t>(x - a));
+        sums[2] += std::abs(static_cast<int8_t>(x - b));
+        sums[3] += std::abs(static_cast<int8_t>(x - ((a + b) >> 1)));
+        sums[4] += std::abs(static_cast<int8_t>(x - paeth(a, b, c)));
+    }
+    return static_cast<int>(std::min_element(sums, sums + 5) - sums);
+}
+
+// 每個 row 寫成 filter type + len bytes 到 out；prev 是第一個 row 上面那個 row（nullptr：影像最上面）
+void filter_rows(const uint8_t* data, int h, int w, int c, std::size_t stride, const uint8_t* prev,
+                 PngFilter filter, uint8_t* out)
+{
+    const int len = w * c;
+    const std::vector<uint8_t> zeros(static_cast<std::size_t>(len), 0);
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row = data + static_cast<std::size_t>(y) * stride;
+        const uint8_t* up  = y ? row - stride : prev ? prev : zeros.data();
+        int type = 0;
+        switch (filter) {
+        case PngFilter::None:     type = 0; break;
+        case PngFilter::Sub:      type = 1; break;
+        case PngFilter::Up:       type = 2; break;
+        case PngFilter::Average:  type = 3; break;
+        case PngFilter::Paeth:    type = 4; break;
+        case PngFilter::Adaptive: type = pick_filter(row, up, len, c, 1); break;
+        case PngFilter::Fast:     type = pick_filter(row, up, len, c, 8); break;
+        }
+        uint8_t* dst = out + static_cast<std::size_t>(y) * (len + 1);
+        dst[0] = static_cast<uint8_t>(type);
+        switch (type) {
+        case 0: std::memcpy(dst + 1, row, static_cast<std::size_t>(len)); break;
+        case 1: for (int i = 0; i < len; ++i) dst[1 + i] = filtered(1, row, up, i, c); break;
+        case 2: for (int i = 0; i < len; ++i) dst[1 + i] = filtered(2, row, up, i, c); break;
+        case 3: for (int i = 0; i < len; ++i) dst[1 + i] = filtered(3, row, up, i, c); break;
+        default: for (int i = 0; i < len; ++i) dst[1 + i] = filtered(4, row, up, i, c); break;
+        }
+    }
+}
+
+void put_be32(std::vector<uint8_t>& out, uint32_t v)
+{
+    const uint8_t b[4] = {uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v)};
+    out.insert(out.end(), b, b + 4);
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char* tag, const uint8_t* data, std::size_t n)
+{
+    put_be32(out, static_cast<uint32_t>(n));
+    const std::size_t start = out.size();
+    out.insert(out.end(), tag, tag + 4);
+    out.insert(out.end(), data, data + n);
+    put_be32(out, crc32(out.data() + start, n + 4));
+}
+
+// signature + IHDR（8-bit 灰階 / RGB、不 interlace）
+void put_head(std::vector<uint8_t>& out, int h, int w, int c)
+{
+    static const uint8_t sig[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.insert(out.end(), sig, sig + 8);
+    uint8_t ihdr[13];
+    for (int i = 0; i < 4; ++i) {
+        ihdr[i]     = static_cast<uint8_t>(static_cast<uint32_t>(w) >> (24 - 8 * i));
+        ihdr[4 + i] = static_cast<uint8_t>(static_cast<uint32_t>(h) >> (24 - 8 * i));
+    }
+    ihdr[8]  = 8;                   // bit depth
+    ihdr[9]  = c == 1 ? 0 : 2;      // 灰階 / RGB
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    put_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+}
+
+void put_zlib_header(std::vector<uint8_t>& z, int level)
+{
+    z.push_back(0x78);
+    z.push_back(level <= 1 ? 0x01 : level <= 5 ? 0x5E : level == 6 ? 0x9C : 0xDA);  // FLEVEL
+}
+
+void check_args(const char* who, int h, int w, int c, int level)
+{
+    if (h <= 0 || w <= 0 || (c != 1 && c != 3))
+        throw std::invalid_argument(std::string(who) + ": invalid input");
+    if (level < 0 || level > 9) throw std::invalid_argument(std::string(who) + ": level must be 0..9");
+}
+
+// ======================
+//  inflate（串流解碼用）
+// ======================
+
+// Huffman 解碼表：用 max_bits 個 bit（deflate 的順序，LSB 先）直接查，entry = symbol << 4 | 碼長
+struct HuffTable {
+    std::vector<uint16_t> t;
+    int max_bits = 0;
+
+    void build(const uint8_t* lens, int n) {
+        int count[16] = {};
+        for (int i = 0; i < n; ++i) ++count[lens[i]];
+        count[0] = 0;
+        max_bits = 0;
+        for (int l = 1; l < 16; ++l)
+            if (count[l]) max_bits = l;
+        if (max_bits == 0) max_bits = 1;
+        int next[16] = {};
+        for (int l = 1, code = 0; l < 16; ++l) {
+            code = (code + count[l - 1]) << 1;
+            next[l] = code;
+            if (next[l] + count[l] > (1 << l)) throw std::runtime_error("png: bad Huffman code");
+        }
+        // 沒用到的 entry 是 0（碼長 0）：解到就是壞資料
+        t.assign(std::size_t(1) << max_bits, 0);
+        for (int s = 0; s < n; ++s) {
+            const int l = lens[s];
+            if (!l) continue;
+            int code = next[l]++, rev = 0;
+            for (int b = 0; b < l; ++b) rev |= ((code >> b) & 1) << (l - 1 - b);
+            for (int k = rev; k < (1 << max_bits); k += 1 << l) t[k] = static_cast<uint16_t>(s << 4 | l);
+        }
+    }
+};
+
+class Inflater {
+public:
+    // feed(buf, cap)：放接下來的壓縮資料到 buf，回傳幾個 bytes（0：沒有了）
+    explicit Inflater(std::function<std::size_t(uint8_t*, std::size_t)> feed)
+        : feed_(std::move(feed)), in_(1 << 16), window_(kWindow) {}
+
+    void read_zlib_header() {
+        const uint32_t cmf = bits(8), flg = bits(8);
+        if ((cmf & 15) != 8 || (cmf * 256 + flg) % 31 != 0 || (flg & 0x20))
+            throw std::runtime_error("png: bad zlib header");
+    }
+
+    // 解出剛好 n bytes（不夠就丟例外）
+    void read(uint8_t* dst, std::size_t n) {
+        while (n > 0) {
+            if (copy_len_ > 0) {
+                // match 可以跟自己重疊（dist < len），一個一個 byte 抄
+                std::size_t k = std::min<std::size_t>(n, static_cast<std::size_t>(copy_len_));
+                copy_len_ -= static_cast<int>(k);
+                n -= k;
+                for (; k > 0; --k) put(window_[(pos_ - copy_dist_) & (kWindow - 1)], dst);
+                continue;
+            }
+            switch (mode_) {
+            case Mode::Header: start_block(); break;
+            case Mode::Stored: {
+                if (stored_left_ == 0) {
+                    mode_ = Mode::Header;
+                    break;
+                }
+                --stored_left_;
+                --n;
+                put(static_cast<uint8_t>(bits(8)), dst);
+                break;
+            }
+            case Mode::Codes: {
+                const int sym = decode(lit_);
+                if (sym < 256) {
+                    --n;
+                    put(static_cast<uint8_t>(sym), dst);
+                } else if (sym == 256) {
+                    mode_ = Mode::Header;
+                } else {
+                    const int lc = sym - 257;
+                    if (lc >= 29) throw std::runtime_error("png: bad length code");
+                    copy_len_ = kLenBase[lc] + static_cast<int>(bits(kLenExtra[lc]));
+                    const int dc = decode(dist_);
+                    if (dc >= 30) throw std::runtime_error("png: bad distance code");
+                    copy_dist_ = kDistBase[dc] + bits(kDistExtra[dc]);
+                    if (copy_dist_ > pos_) throw std::runtime_error("png: distance too far back");
+                }
+                break;
+            }
+            }
+        }
+    }
+
+private:
+    enum class Mode { Header, Stored, Codes };
+    static constexpr int kWindow = 32768;
+
+    void put(uint8_t b, uint8_t*& dst) {
+        window_[pos_ & (kWindow - 1)] = b;
+        ++pos_;
+        *dst++ = b;
+    }
+
+    // acc_ 補到 57 bit 以上（資料沒了就算了：查表時多看的 bit 是 0，真的用到才算截斷）
+    void refill() {
+        while (count_ <= 56) {
+            if (in_pos_ == in_len_) {
+                if (eof_) return;
+                in_len_ = feed_(in_.data(), in_.size());
+                in_pos_ = 0;
+                if (in_len_ == 0) {
+                    eof_ = true;
+                    return;
+                }
+            }
+            acc_ |= static_cast<uint64_t>(in_[in_pos_++]) << count_;
+            count_ += 8;
+        }
+    }
+
+    void drop(int n) {
+        if (n > count_) throw std::runtime_error("png: truncated image data");
+        acc_ >>= n;
+        count_ -= n;
+    }
+
+    uint32_t bits(int n) {
+        if (n == 0) return 0;
+        if (count_ < n) refill();
+        const uint32_t v = static_cast<uint32_t>(acc_ & ((uint64_t(1) << n) - 1));
+        drop(n);
+        return v;
+    }
+
+    int decode(const HuffTable& h) {
+        if (count_ < h.max_bits) refill();
+        const uint16_t e = h.t[acc_ & ((uint64_t(1) << h.max_bits) - 1)];
+        if ((e & 15) == 0) throw std::runtime_error("png: bad Huffman code");
+        drop(e & 15);
+        return e >> 4;
+    }
+
+    void start_block() {
+        if (last_) throw std::runtime_error("png: image data ended early");
+        last_ = bits(1) != 0;
+        const uint32_t type = bits(2);
+        if (type == 0) {
+            drop(count_ % 8);
+            const uint32_t len = bits(16), nlen = bits(16);
+            if ((len ^ 0xFFFF) != nlen) throw std::runtime_error("png: bad stored block");
+            stored_left_ = len;
+            mode_ = Mode::Stored;
+            return;
+        }
+        uint8_t lens[kLitCodes + 2 + 32] = {};
+        if (type == 1) {
+            for (int i = 0; i < 288; ++i) lens[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+            lit_.build(lens, 288);
+            std::fill(lens, lens + 32, uint8_t(5));
+            dist_.build(lens, 32);
+        } else if (type == 2) {
+            const int hlit = static_cast<int>(bits(5)) + 257, hdist = static_cast<int>(bits(5)) + 1;
+            const int hclen = static_cast<int>(bits(4)) + 4;
+            uint8_t cl_lens[19] = {};
+            for (int i = 0; i < hclen; ++i) cl_lens[kClOrder[i]] = static_cast<uint8_t>(bits(3));
+            HuffTable cl;
+            cl.build(cl_lens, 19);
+            for (int i = 0; i < hlit + hdist;) {
+                const int sym = decode(cl);
+                int rep = 1;
+                uint8_t v = static_cast<uint8_t>(sym);
+                if (sym == 16) {
+                    if (i == 0) throw std::runtime_error("png: bad code lengths");
+                    v = lens[i - 1];
+                    rep = 3 + static_cast<int>(bits(2));
+                } else if (sym == 17) {
+                    v = 0;
+                    rep = 3 + static_cast<int>(bits(3));
+                } else if (sym == 18) {
+                    v = 0;
+                    rep = 11 + static_cast<int>(bits(7));
+                }
+                if (i + rep > hlit + hdist) throw std::runtime_error("png: bad code lengths");
+                std::fill(lens + i, lens + i + rep, v);
+                i += rep;
+            }
+            if (lens[256] == 0) throw std::runtime_error("png: missing end-of-block code");
+            lit_.build(lens, hlit);
+            dist_.build(lens + hlit, hdist);
+        } else {
+            throw std::runtime_error("png: bad block type");
+        }
+        mode_ = Mode::Codes;
+    }
+
+    std::function<std::size_t(uint8_t*, std::size_t)> feed_;
+    std::vector<uint8_t> in_;
+    std::size_t          in_pos_ = 0, in_len_ = 0;
+    bool                 eof_ = false;
+    uint64_t             acc_ = 0;
+    int                  count_ = 0;
+
+    Mode      mode_ = Mode::Header;
+    bool      last_ = false;
+    uint32_t  stored_left_ = 0;
+    HuffTable lit_, dist_;
+    int       copy_len_ = 0;
+    uint64_t  copy_dist_ = 0;
+
+    std::vector<uint8_t> window_;
+    uint64_t             pos_ = 0;  // 到目前為止解出幾個 byte
+};
+
+inline uint32_t be32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_png(const uint8_t* data, int h, int w, int c, std::size_t stride,
+                                int level, PngFilter filter)
+{
+    if (!data) throw std::invalid_argument("encode_png: invalid input");
+    check_args("encode_png", h, w, c, level);
+    if (stride == 0) stride = static_cast<std::size_t>(w) * c;
+
+    std::vector<uint8_t> filt(static_cast<std::size_t>(h) * (static_cast<std::size_t>(w) * c + 1));
+    filter_rows(data, h, w, c, stride, nullptr, level == 0 ? PngFilter::None : filter, filt.data());
+
+    // zlib stream：header、deflate、adler32
+    std::vector<uint8_t> z;
+    z.reserve(level == 0 ? filt.size() + filt.size() / 65535 * 5 + 64 : filt.size() / 2 + 1024);
+    put_zlib_header(z, level);
+    Deflater(level, z).run(filt.data(), filt.size());
+    put_be32(z, adler32(filt.data(), filt.size()));
+
+    std::vector<uint8_t> out;
+    out.reserve(z.size() + 64);
+    put_head(out, h, w, c);
+    // chunk 長度是 31-bit：很大的影像拆成多個 IDAT
+    constexpr std::size_t kMaxChunk = std::size_t(1) << 30;
+    for (std::size_t off = 0; off < z.size(); off += kMaxChunk)
+        put_chunk(out, "IDAT", z.data() + off, std::min(kMaxChunk, z.size() - off));
+    put_chunk(out, "IEND", nullptr, 0);
+    return out;
+}
+
+// ======================
+//  PngStreamWriter
+// ======================
+
+struct PngStreamWriter::State {
+    // 累積到這麼多 filter 過的 bytes 就壓一段、寫一個 IDAT
+    static constexpr std::size_t kSegment = std::size_t(1) << 20;
+    static constexpr std::size_t kHistory = 32768;
+
+    std::ofstream out;
+    std::string   path;
+    int           h, w, c, level;
+    PngFilter     filter;
+    int           rows = 0;
+    bool          closed = false;
+
+    std::vector<uint8_t> prev_row;  // 上一個 row 的原始 pixel（filter 要看）
+    std::vector<uint8_t> buf;       // [0, hist) 是已經壓過的尾巴，當 deflate 的 window
+    std::size_t          hist = 0;
+    std::vector<uint8_t> z;
+    Deflater             deflater;
+    uint32_t             adler = 1;
+
+    State(const std::string& p, int h_, int w_, int c_, int level_, PngFilter filter_)
+        : out(p, std::ios::binary | std::ios::trunc), path(p), h(h_), w(w_), c(c_), level(level_),
+          filter(level_ == 0 ? PngFilter::None : filter_), deflater(level_, z) {}
+
+    void write(const std::vector<uint8_t>& bytes) {
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) throw std::runtime_error("png: failed to write " + path);
+    }
+
+    void compress(bool final) {
+        deflater.run(buf.data(), hist, buf.size(), final);
+        adler = adler32(buf.data() + hist, buf.size() - hist, adler);
+        if (final) put_be32(z, adler);
+        if (!z.empty()) {
+            std::vector<uint8_t> chunk;
+            chunk.reserve(z.size() + 12);
+            put_chunk(chunk, "IDAT", z.data(), z.size());
+            write(chunk);
+            z.clear();  // 還沒湊滿 byte 的 bit 留在 BitWriter 裡
+        }
+        const std::size_t keep = std::min(kHistory, buf.size());
+        std::memmove(buf.data(), buf.data() + buf.size() - keep, keep);
+        buf.resize(keep);
+        hist = keep;
+    }
+};
+
+PngStreamWriter::PngStreamWriter(const std::string& path, int h, int w, int c, int level, PngFilter filter)
+{
+    check_args("PngStreamWriter", h, w, c, level);
+    s_ = std::make_unique<State>(path, h, w, c, level, filter);
+    if (!s_->out) throw std::runtime_error("png: cannot open " + path);
+    std::vector<uint8_t> head;
+    put_head(head, h, w, c);
+    s_->write(head);
+    put_zlib_header(s_->z, level);
+}
+
+PngStreamWriter::~PngStreamWriter() = default;
+
+int PngStreamWriter::rows_written() const { return s_->rows; }
+
+void PngStreamWriter::write_rows(const uint8_t* data, int rows, std::size_t stride)
+{
+    State& s = *s_;
+    if (s.closed) throw std::runtime_error("PngStreamWriter: write after close()");
+    if (rows <= 0) return;
+    if (!data || rows > s.h - s.rows) throw std::invalid_argument("PngStreamWriter: more rows than the image height");
+    const std::size_t len = static_cast<std::size_t>(s.w) * s.c;
+    if (stride == 0) stride = len;
+
+    // 一次 filter 一批 row，湊滿一段就壓：buf 不會超過 kSegment + 一批
+    const int batch = static_cast<int>(std::max<std::size_t>(1, State::kSegment / (len + 1)));
+    for (int y = 0; y < rows; y += batch) {
+        const int n = std::min(batch, rows - y);
+        const uint8_t* p = data + static_cast<std::size_t>(y) * stride;
+        const std::size_t at = s.buf.size();
+        s.buf.resize(at + static_cast<std::size_t>(n) * (len + 1));
+        filter_rows(p, n, s.w, s.c, stride, s.rows ? s.prev_row.data() : nullptr, s.filter, s.buf.data() + at);
+        s.prev_row.assign(p + static_cast<std::size_t>(n - 1) * stride, p + static_cast<std::size_t>(n - 1) * stride + len);
+        s.rows += n;
+        if (s.buf.size() - s.hist >= State::kSegment) s.compress(false);
+    }
+}
+
+void PngStreamWriter::close()
+{
+    State& s = *s_;
+    if (s.closed) return;
+    s.closed = true;
+    if (s.rows != s.h)
+        throw std::runtime_error("PngStreamWriter: only " + std::to_string(s.rows) + " of " + std::to_string(s.h) +
+                                 " rows written (" + s.path + ")");
+    s.compress(true);
+    std::vector<uint8_t> end;
+    put_chunk(end, "IEND", nullptr, 0);
+    s.write(end);
+    s.out.close();
+    if (!s.out) throw std::runtime_error("png: failed to write " + s.path);
+}
+
+// ======================
+//  PngStreamReader
+// ======================
+
+struct PngStreamReader::State {
+    std::ifstream in;
+    std::string   path;
+    int           h = 0, w = 0, c = 0;
+    int           color_type = 0, depth = 0, src_channels = 0;
+    std::size_t   row_bytes = 0, bpp = 0;
+    uint8_t       palette[256 * 3] = {};
+    int           rows = 0;
+
+    uint32_t idat_left = 0;
+    bool     idat_done = false;
+    Inflater inflater;
+    std::vector<uint8_t> prev, cur;  // 解出來（含 filter byte）的上一個 / 這一個 row
+
+    explicit State(const std::string& p)
+        : in(p, std::ios::binary), path(p),
+          inflater([this](uint8_t* buf, std::size_t cap) { return feed(buf, cap); }) {}
+
+    [[noreturn]] void fail(const std::string& why) const { throw std::runtime_error("png: " + why + " (" + path + ")"); }
+
+    void read_exact(uint8_t* p, std::size_t n) {
+        in.read(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n));
+        if (static_cast<std::size_t>(in.gcount()) != n) fail("truncated file");
+    }
+
+    // 下一個 chunk 的 {長度, type}
+    std::pair<uint32_t, std::string> next_chunk() {
+        uint8_t hdr[8];
+        read_exact(hdr, 8);
+        const uint32_t len = be32(hdr);
+        if (len > 0x7FFFFFFFu) fail("bad chunk length");
+        return {len, std::string(reinterpret_cast<const char*>(hdr + 4), 4)};
+    }
+
+    void skip(uint64_t n) {
+        in.seekg(static_cast<std::streamoff>(n), std::ios::cur);
+        if (!in) fail("truncated file");
+    }
+
+    // IDAT 的內容接起來就是 zlib stream（中間夾的 CRC 跳過）
+    std::size_t feed(uint8_t* buf, std::size_t cap) {
+        while (idat_left == 0) {
+            if (idat_done) return 0;
+            skip(4);  // 上一個 IDAT 的 CRC
+            auto chunk = next_chunk();
+            if (chunk.second != "IDAT") {
+                idat_done = true;  // IDAT 一定是連續的
+                return 0;
+            }
+            idat_left = chunk.first;
+        }
+        const std::size_t n = std::min<std::size_t>(cap, idat_left);
+        read_exact(buf, n);
+        idat_left -= static_cast<uint32_t>(n);
+        return n;
+    }
+
+    // 帶 alpha 的灰階跟 decode_image_u8 一樣給 RGB（灰階值複製到三個通道）
+    void put_gray(uint8_t* dst, int x, uint8_t v) const {
+        if (c == 1) dst[x] = v;
+        else dst[3 * x] = dst[3 * x + 1] = dst[3 * x + 2] = v;
+    }
+
+    // 解 filter 之後的 row → 8-bit 灰階 / RGB（跟 decode_image_u8 一樣：alpha 丟掉，16-bit 取高位元組）
+    void convert(const uint8_t* raw, uint8_t* dst) const {
+        const int W = w;
+        if (depth < 8) {
+            const int per = 8 / depth, mask = (1 << depth) - 1, scale = 255 / mask;
+            for (int x = 0; x < W; ++x) {
+                const int v = (raw[x / per] >> (8 - depth * (x % per + 1))) & mask;
+                if (color_type == 3) std::memcpy(dst + 3 * x, palette + 3 * v, 3);
+                else put_gray(dst, x, static_cast<uint8_t>(v * scale));
+            }
+            return;
+        }
+        const int step = depth / 8;  // 1 或 2；16-bit 是 big endian，高位元組在前
+        const int sc = src_channels;
+        switch (color_type) {
+        case 0:
+        case 4:
+            for (int x = 0; x < W; ++x) put_gray(dst, x, raw[static_cast<std::size_t>(x) * sc * step]);
+            break;
+        case 3:
+            for (int x = 0; x < W; ++x) std::memcpy(dst + 3 * x, palette + 3 * raw[x], 3);
+            break;
+        default:
+            if (sc == 3 && step == 1) {
+                std::memcpy(dst, raw, static_cast<std::size_t>(W) * 3);
+                break;
+            }
+            for (int x = 0; x < W; ++x)
+                for (int k = 0; k < 3; ++k) dst[3 * x + k] = raw[(static_cast<std::size_t>(x) * sc + k) * step];
+            break;
+        }
+    }
+
+    void next_row() {
+        std::swap(prev, cur);
+        inflater.read(cur.data(), row_bytes + 1);
+        const int type = cur[0];
+        uint8_t* r = cur.data() + 1;
+        const uint8_t* up = prev.data() + 1;
+        const std::size_t n = row_bytes;
+        switch (type) {
+        case 0: break;
+        case 1: for (std::size_t i = bpp; i < n; ++i) r[i] = static_cast<uint8_t>(r[i] + r[i - bpp]); break;
+        case 2: for (std::size_t i = 0; i < n; ++i) r[i] = static_cast<uint8_t>(r[i] + up[i]); break;
+        case 3:
+            for (std::size_t i = 0; i < n; ++i)
+                r[i] = static_cast<uint8_t>(r[i] + (((i >= bpp ? r[i - bpp] : 0) + up[i]) >> 1));
+            break;
+        case 4:
+            for (std::size_t i = 0; i < n; ++i)
+                r[i] = static_cast<uint8_t>(r[i] + (i >= bpp ? paeth(r[i - bpp], up[i], up[i - bpp]) : up[i]));
+            break;
+        default: fail("bad filter type");
+        }
+    }
+};
+
+PngStreamReader::PngStreamReader(const std::string& path) : s_(std::make_unique<State>(path))
+{
+    State& s = *s_;
+    if (!s.in) throw std::runtime_error("png: cannot open " + path);
+    uint8_t sig[8];
+    s.read_exact(sig, 8);
+    static const uint8_t kSig[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    if (std::memcmp(sig, kSig, 8) != 0) s.fail("not a PNG file");
+
+    auto chunk = s.next_chunk();
+    if (chunk.second != "IHDR" || chunk.first != 13) s.fail("missing IHDR");
+    uint8_t ihdr[13];
+    s.read_exact(ihdr, 13);
+    s.skip(4);
+    const uint32_t w = be32(ihdr), h = be32(ihdr + 4);
+    s.depth = ihdr[8];
+    s.color_type = ihdr[9];
+    if (w == 0 || h == 0 || w > 0x7FFFFFFFu || h > 0x7FFFFFFFu) s.fail("bad size");
+    if (ihdr[10] != 0 || ihdr[11] != 0) s.fail("unknown compression / filter method");
+    if (ihdr[12] != 0) s.fail("interlaced PNG cannot be read row by row");
+    const int d = s.depth;
+    bool ok = false;
+    switch (s.color_type) {
+    case 0: s.src_channels = 1; ok = d == 1 || d == 2 || d == 4 || d == 8 || d == 16; break;
+    case 2: s.src_channels = 3; ok = d == 8 || d == 16; break;
+    case 3: s.src_channels = 1; ok = d == 1 || d == 2 || d == 4 || d == 8; break;
+    case 4: s.src_channels = 2; ok = d == 8 || d == 16; break;
+    case 6: s.src_channels = 4; ok = d == 8 || d == 16; break;
+    default: break;
+    }
+    if (!ok) s.fail("unsupported color type / bit depth");
+    s.w = static_cast<int>(w);
+    s.h = static_cast<int>(h);
+    s.row_bytes = (static_cast<uint64_t>(w) * s.src_channels * s.depth + 7) / 8;
+    s.bpp = std::max<std::size_t>(1, static_cast<std::size_t>(s.src_channels * s.depth / 8));
+
+    // 跳到第一個 IDAT（中間只要 PLTE、tRNS）
+    bool have_palette = false, have_trns = false;
+    for (;;) {
+        chunk = s.next_chunk();
+        if (chunk.second == "IDAT") {
+            s.idat_left = chunk.first;
+            break;
+        }
+        if (chunk.second == "IEND") s.fail("no image data");
+        if (chunk.second == "PLTE") {
+            if (chunk.first % 3 != 0 || chunk.first > sizeof(s.palette)) s.fail("bad palette");
+            s.read_exact(s.palette, chunk.first);
+            s.skip(4);
+            have_palette = true;
+        } else {
+            have_trns = have_trns || chunk.second == "tRNS";
+            s.skip(uint64_t(chunk.first) + 4);
+        }
+    }
+    if (s.color_type == 3 && !have_palette) s.fail("missing palette");
+    // 只有不帶 alpha 的灰階是 1 通道（stb 對灰階 + alpha / tRNS 給 2 通道，decode_image_u8 轉成 RGB）
+    s.c = (s.color_type == 0 && !have_trns) ? 1 : 3;
+    s.prev.assign(s.row_bytes + 1, 0);
+    s.cur.assign(s.row_bytes + 1, 0);
+    s.inflater.read_zlib_header();
+}
+
+PngStreamReader::~PngStreamReader() = default;
+
+int PngStreamReader::h() const { return s_->h; }
+int PngStreamReader::w() const { return s_->w; }
+int PngStreamReader::c() const { return s_->c; }
+
+int PngStreamReader::read_rows(uint8_t* dst, int rows, std::size_t stride)
+{
+    State& s = *s_;
+    rows = std::min(rows, s.h - s.rows);
+    if (rows <= 0) return 0;
+    if (stride == 0) stride = static_cast<std::size_t>(s.w) * s.c;
+    for (int y = 0; y < rows; ++y) {
+        s.next_row();
+        s.convert(s.cur.data() + 1, dst + static_cast<std::size_t>(y) * stride);
+    }
+    s.rows += rows;
+    return rows;
+}
+
+} // namespace pf
@@ -0,0 +1,491 @@
+#include "pixfoundry/pyramid.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace pf {
+
+// reflect-101：-1 → 1，n → n - 2（n == 1 時只有 index 0）
+static inline int reflect101(int i, int n) {
+    if (n == 1) return 0;
+    while (i < 0 || i >= n) {
+        if (i < 0)  i = -i;
+        if (i >= n) i = 2 * n - 2 - i;
+    }
+    return i;
+}
+
+// 每層的尺寸（不含資料）
+struct LevelShape {
+    int h = 0, w = 0;
+};
+
+static std::vector<LevelShape> pyramid_shapes(int h, int w, int levels) {
+    std::vector<LevelShape> shapes;
+    shapes.push_back({h, w});
+    while (static_cast<int>(shapes.size()) < levels && (h > 1 || w > 1)) {
+        h = (h + 1) / 2;
+        w = (w + 1) / 2;
+        shapes.push_back({h, w});
+    }
+    return shapes;
+}
+
+// ======================
+//  pyr_down：只在偶數位置算 5-tap
+// ======================
+//
+// 每個輸出 row：先把 5 條來源 row 垂直加權（整條 row 連續、可向量化），
+// 再只在偶數 column 做水平 5-tap。總和最大 255 * 16 * 16，(sum + 128) >> 8。
+
+template <int C>
+static void pyr_down_rows(const uint8_t* in, std::size_t in_stride, int H, int W,
+                          uint8_t* out, std::size_t out_stride, Backend exec) {
+    const int Ho = (H + 1) / 2;
+    const int Wo = (W + 1) / 2;
+    const std::size_t row_len = static_cast<std::size_t>(W) * C;
+
+    parallel_rows(Ho, exec, row_len * 6 + static_cast<std::size_t>(Wo) * C, [&](int ya, int yb) {
+        std::vector<uint16_t> vrow(row_len);
+
+        for (int y = ya; y < yb; ++y) {
+            const uint8_t* r0 = in + static_cast<std::size_t>(reflect101(2 * y - 2, H)) * in_stride;
+            const uint8_t* r1 = in + static_cast<std::size_t>(reflect101(2 * y - 1, H)) * in_stride;
+            const uint8_t* r2 = in + static_cast<std::size_t>(reflect101(2 * y,     H)) * in_stride;
+            const uint8_t* r3 = in + static_cast<std::size_t>(reflect101(2 * y + 1, H)) * in_stride;
+            const uint8_t* r4 = in + static_cast<std::size_t>(reflect101(2 * y + 2, H)) * in_stride;
+
+            uint16_t* v = vrow.data();
+            for (std::size_t i = 0; i < row_len; ++i) {
+                v[i] = static_cast<uint16_t>(r0[i] + 4 * (r1[i] + r3[i]) + 6 * r2[i] + r4[i]);
+            }
+
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            for (int x = 0; x < Wo; ++x) {
+                const int sx = 2 * x;
+                const uint16_t* p0;
+                const uint16_t* p1;
+                const uint16_t* p3;
+                const uint16_t* p4;
+                const uint16_t* p2 = v + static_cast<std::size_t>(sx) * C;
+                if (sx >= 2 && sx + 2 < W) {
+                    p0 = p2 - 2 * C; p1 = p2 - C; p3 = p2 + C; p4 = p2 + 2 * C;
+                } else {
+                    p0 = v + static_cast<std::size_t>(reflect101(sx - 2, W)) * C;
+                    p1 = v + static_cast<std::size_t>(reflect101(sx - 1, W)) * C;
+                    p3 = v + static_cast<std::size_t>(reflect101(sx + 1, W)) * C;
+                    p4 = v + static_cast<std::size_t>(reflect101(sx + 2, W)) * C;
+                }
+                for (int c = 0; c < C; ++c) {
+                    const uint32_t s = p0[c] + 4u * (p1[c] + p3[c]) + 6u * p2[c] + p4[c];
+                    orow[x * C + c] = static_cast<uint8_t>((s + 128) >> 8);
+                }
+            }
+        }
+    });
+}
+
+static void pyr_down_into(const ImageU8& src, ImageU8& dst, Backend exec) {
+    if (src.c() == 1) pyr_down_rows<1>(src.data(), src.stride(), src.h(), src.w(), dst.data(), dst.stride(), exec);
+    else              pyr_down_rows<3>(src.data(), src.stride(), src.h(), src.w(), dst.data(), dst.stride(), exec);
+}
+
+// ======================
+//  pyr_up：補零上採樣 + 5-tap，只算非零的 taps
+// ======================
+//
+// 在上採樣後（長度 2n）的座標上做 reflect-101，只有偶數位置有值；
+// 輸出 2n - 1 時直接少算最後一個（跟 OpenCV pyrUp 指定 dstsize 一樣）。
+// 內部：偶數輸出用到 [1 6 1]，奇數用到 [4 4]（權重已經 x4）；邊界用查表。
+// 總和最大 255 * 8 * 8，(sum + 32) >> 6。
+// Mode 決定怎麼寫回 dst：直接存、從 dst 減掉（Laplacian）、加回 dst（collapse）。
+
+enum class UpMode { Store, Subtract, Add };
+
+// 輸出位置 y 對應的來源 index / 權重（最多 3 個），權重總和 8
+static int up_taps(int y, int n_up, int* src_idx, int* weight) {
+    static const int kBinom[5] = {1, 4, 6, 4, 1};
+    int n = 0;
+    for (int k = -2; k <= 2; ++k) {
+        const int t = reflect101(y + k, n_up);
+        if (t & 1) continue;
+        int m = 0;
+        while (m < n && src_idx[m] != t / 2) ++m;
+        if (m == n) { src_idx[n] = t / 2; weight[n] = 0; ++n; }
+        weight[m] += kBinom[k + 2];
+    }
+    return n;
+}
+
+template <UpMode M>
+static inline void up_write(uint8_t& d, int v) {
+    if (M == UpMode::Store) {
+        d = static_cast<uint8_t>(v);
+    } else if (M == UpMode::Subtract) {
+        d = static_cast<uint8_t>(std::clamp(static_cast<int>(d) - v + 128, 0, 255));
+    } else {
+        d = static_cast<uint8_t>(std::clamp(static_cast<int>(d) + v - 128, 0, 255));
+    }
+}
+
+template <int C, UpMode M>
+static void pyr_up_rows(const uint8_t* in, std::size_t in_stride, int H, int W,
+                        uint8_t* out, std::size_t out_stride, int Ho, int Wo, Backend exec) {
+    const std::size_t row_len = static_cast<std::size_t>(W) * C;
+
+    parallel_rows(Ho, exec, row_len * 4 + static_cast<std::size_t>(Wo) * C * 2, [&](int ya, int yb) {
+        std::vector<uint16_t> vrow(row_len);
+
+        for (int y = ya; y < yb; ++y) {
+            int ri[3], rw[3];
+            const int nr = up_taps(y, 2 * H, ri, rw);
+            uint16_t* v = vrow.data();
+            const uint8_t* ra = in + static_cast<std::size_t>(ri[0]) * in_stride;
+            if (nr == 1) {
+                for (std::size_t k = 0; k < row_len; ++k) v[k] = static_cast<uint16_t>(8 * ra[k]);
+            } else if (nr == 2) {
+                const uint8_t* rb = in + static_cast<std::size_t>(ri[1]) * in_stride;
+                const int wa = rw[0], wb = rw[1];
+                for (std::size_t k = 0; k < row_len; ++k) {
+                    v[k] = static_cast<uint16_t>(wa * ra[k] + wb * rb[k]);
+                }
+            } else {
+                const uint8_t* rb = in + static_cast<std::size_t>(ri[1]) * in_stride;
+                const uint8_t* rc = in + static_cast<std::size_t>(ri[2]) * in_stride;
+                const int wa = rw[0], wb = rw[1], wc = rw[2];
+                for (std::size_t k = 0; k < row_len; ++k) {
+                    v[k] = static_cast<uint16_t>(wa * ra[k] + wb * rb[k] + wc * rc[k]);
+                }
+            }
+
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            for (int x = 0; x < Wo; ++x) {
+                if (x >= 2 && x + 2 < 2 * W) {
+                    const uint16_t* pb = v + static_cast<std::size_t>(x >> 1) * C;
+                    if ((x & 1) == 0) {
+                        for (int c = 0; c < C; ++c) {
+                            const int s = pb[c - C] + 6 * pb[c] + pb[c + C];
+                            up_write<M>(orow[x * C + c], (s + 32) >> 6);
+                        }
+                    } else {
+                        for (int c = 0; c < C; ++c) {
+                            const int s = 4 * (pb[c] + pb[c + C]);
+                            up_write<M>(orow[x * C + c], (s + 32) >> 6);
+                        }
+                    }
+                } else {
+                    int ci[3], cw[3];
+                    const int nc = up_taps(x, 2 * W, ci, cw);
+                    for (int c = 0; c < C; ++c) {
+                        int s = 0;
+                        for (int m = 0; m < nc; ++m) s += cw[m] * v[static_cast<std::size_t>(ci[m]) * C + c];
+                        up_write<M>(orow[x * C + c], (s + 32) >> 6);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// dst 的大小就是輸出大小
+template <UpMode M>
+static void pyr_up_into(const ImageU8& src, ImageU8& dst, Backend exec) {
+    if (src.c() == 1) pyr_up_rows<1, M>(src.data(), src.stride(), src.h(), src.w(),
+                                        dst.data(), dst.stride(), dst.h(), dst.w(), exec);
+    else              pyr_up_rows<3, M>(src.data(), src.stride(), src.h(), src.w(),
+                                        dst.data(), dst.stride(), dst.h(), dst.w(), exec);
+}
+
+static void check_up_size(int src, int dst, const char* what) {
+    if (dst != 2 * src && dst != 2 * src - 1) {
+        throw std::invalid_argument(std::string(what) + ": size must be 2*n or 2*n-1 of the coarser level");
+    }
+}
+
+// ======================
+//  Box 縮小（2x / 4x）
+// ======================
+
+template <int F, int C>
+static void downscale_box_rows(const uint8_t* in, std::size_t in_stride,
+                               uint8_t* out, std::size_t out_stride,
+                               int Ho, int Wo, Backend exec) {
+    constexpr int kShift = (F == 2) ? 2 : 4;  // log2(F * F)
+    const std::size_t row_len = static_cast<std::size_t>(Wo) * C;
+
+    parallel_rows(Ho, exec, row_len * (F * F + 1), [&](int ya, int yb) {
+        std::vector<uint16_t> acc(row_len);
+
+        for (int y = ya; y < yb; ++y) {
+            std::fill(acc.begin(), acc.end(), static_cast<uint16_t>(1 << (kShift - 1)));
+            for (int r = 0; r < F; ++r) {
+                const uint8_t* row = in + (static_cast<std::size_t>(y) * F + r) * in_stride;
+                for (int x = 0; x < Wo; ++x) {
+                    const uint8_t* p = row + static_cast<std::size_t>(x) * F * C;
+                    for (int c = 0; c < C; ++c) {
+                        uint16_t s = 0;
+                        for (int k = 0; k < F; ++k) s = static_cast<uint16_t>(s + p[k * C + c]);
+                        acc[static_cast<std::size_t>(x) * C + c] =
+                            static_cast<uint16_t>(acc[static_cast<std::size_t>(x) * C + c] + s);
+                    }
+                }
+            }
+            uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+            for (std::size_t i = 0; i < row_len; ++i) {
+                orow[i] = static_cast<uint8_t>(acc[i] >> kShift);
+            }
+        }
+    });
+}
+
+// ======================
+//  成本（給 Auto 用）
+// ======================
+
+static constexpr OpCost kPyrDownCost{1.25f, 3.75f, 1};   // 每個來源 element
+static constexpr OpCost kPyrUpCost{1.25f, 3.75f, 1};     // 每個輸出 element
+static constexpr OpCost kBoxCost{1.25f, 1.0f, 1};        // 每個來源 element
+
+OpCost pyr_down_cost()      { return kPyrDownCost; }
+OpCost downscale_box_cost() { return kBoxCost; }
+
+static std::size_t elems_of(int h, int w, int c) {
+    return static_cast<std::size_t>(h) * w * c;
+}
+
+// 逐 row 複製（src 可能是 view，row pitch 不一定等於 w * c）
+static void copy_rows(const ImageU8& src, ImageU8& dst) {
+    const std::size_t row_len = static_cast<std::size_t>(src.w()) * src.c();
+    for (int y = 0; y < src.h(); ++y) std::memcpy(dst.row(y), src.row(y), row_len);
+}
+
+// ======================
+//  對外 API
+// ======================
+
+void pyr_down(const ImageU8& src,
+              ImageU8& dst,
+              Backend backend) {
+    if (src.empty()) throw std::invalid_argument("pyr_down: empty image");
+    check_output(dst, (src.h() + 1) / 2, (src.w() + 1) / 2, src.c(), "pyr_down");
+    check_no_overlap(src, dst, "pyr_down");
+
+    ExecPlan plan = plan_execution(backend, kPyrDownCost, src);
+    ThreadScope threads(plan);
+
+    pyr_down_into(src, dst, plan.backend);
+}
+
+ImageU8 pyr_down(const ImageU8& src,
+                 Backend backend) {
+    if (src.empty()) throw std::invalid_argument("pyr_down: empty image");
+
+    ImageU8 dst((src.h() + 1) / 2, (src.w() + 1) / 2, src.c(), Init::None);
+    pyr_down(src, dst, backend);
+    return dst;
+}
+
+void pyr_up(const ImageU8& src,
+            ImageU8& dst,
+            Backend backend) {
+    if (src.empty()) throw std::invalid_argument("pyr_up: empty image");
+    if (dst.empty()) throw std::invalid_argument("pyr_up: empty dst");
+    check_up_size(src.h(), dst.h(), "pyr_up");
+    check_up_size(src.w(), dst.w(), "pyr_up");
+    check_output(dst, dst.h(), dst.w(), src.c(), "pyr_up");
+    check_no_overlap(src, dst, "pyr_up");
+
+    ExecPlan plan = plan_execution(backend, kPyrUpCost, elems_of(dst.h(), dst.w(), src.c()));
+    ThreadScope threads(plan);
+
+    pyr_up_into<UpMode::Store>(src, dst, plan.backend);
+}
+
+ImageU8 pyr_up(const ImageU8& src,
+               int dst_h,
+               int dst_w,
+               Backend backend) {
+    if (src.empty()) throw std::invalid_argument("pyr_up: empty image");
+    if (dst_h <= 0) dst_h = 2 * src.h();
+    if (dst_w <= 0) dst_w = 2 * src.w();
+    check_up_size(src.h(), dst_h, "pyr_up");
+    check_up_size(src.w(), dst_w, "pyr_up");
+
+    ImageU8 dst(dst_h, dst_w, src.c(), Init::None);
+    pyr_up(src, dst, backend);
+    return dst;
+}
+
+// 配置一塊 arena，依序切出每一層；每層的 shared_ptr 都指向同一個 control block
+static std::vector<ImageU8> allocate_pyramid(const std::vector<LevelShape>& shapes, int C) {
+    std::size_t total = 0;
+    for (const auto& s : shapes) total += elems_of(s.h, s.w, C);
+
+    // 之後每個 byte 都會被寫到，不需要先清成 0
+    std::shared_ptr<uint8_t[]> arena = allocate_buffer(total, Init::None);
+
+    std::vector<ImageU8> levels;
+    levels.reserve(shapes.size());
+    std::size_t offset = 0;
+    for (const auto& s : shapes) {
+        levels.emplace_back(s.h, s.w, C, std::shared_ptr<uint8_t[]>(arena, arena.get() + offset));
+        offset += elems_of(s.h, s.w, C);
+    }
+    return levels;
+}
+
+static std::vector<ImageU8> build_gaussian(const ImageU8& src, int levels, Backend exec) {
+    const int C = src.c();
+    std::vector<ImageU8> pyr = allocate_pyramid(pyramid_shapes(src.h(), src.w(), levels), C);
+
+    copy_rows(src, pyr[0]);
+    for (std::size_t i = 1; i < pyr.size(); ++i) {
+        pyr_down_into(pyr[i - 1], pyr[i], exec);
+    }
+    return pyr;
+}
+
+std::vector<ImageU8> gaussian_pyramid(const ImageU8& src,
+                                      int levels,
+                                      Backend backend) {
+    if (src.empty()) throw std::invalid_argument("gaussian_pyramid: empty image");
+    if (levels <= 0) throw std::invalid_argument("gaussian_pyramid: levels must be >= 1");
+
+    // 整個金字塔大約是 4/3 張原圖；每層一個 parallel region
+    const OpCost cost{kPyrDownCost.bytes_per_elem, kPyrDownCost.ops_per_elem, levels};
+    ExecPlan plan = plan_execution(backend, cost, src);
+    ThreadScope threads(plan);
+
+    return build_gaussian(src, levels, plan.backend);
+}
+
+std::vector<ImageU8> laplacian_pyramid(const ImageU8& src,
+                                       int levels,
+                                       Backend backend) {
+    if (src.empty()) throw std::invalid_argument("laplacian_pyramid: empty image");
+    if (levels <= 0) throw std::invalid_argument("laplacian_pyramid: levels must be >= 1");
+
+    const OpCost cost{2.5f, 2.0f * kPyrUpCost.ops_per_elem, 2 * levels};
+    ExecPlan plan = plan_execution(backend, cost, src);
+    ThreadScope threads(plan);
+    const Backend exec = plan.backend;
+
+    // 先在 arena 裡建好 Gaussian，再由下往上就地改成差值：
+    // 處理第 i 層時第 i+1 層還是 Gaussian，所以不需要額外的 buffer
+    std::vector<ImageU8> pyr = build_gaussian(src, levels, exec);
+    for (std::size_t i = 0; i + 1 < pyr.size(); ++i) {
+        pyr_up_into<UpMode::Subtract>(pyr[i + 1], pyr[i], exec);
+    }
+    return pyr;
+}
+
+static void check_laplacian_levels(const std::vector<ImageU8>& pyramid) {
+    if (pyramid.empty()) throw std::invalid_argument("collapse_laplacian_pyramid: empty pyramid");
+    const int C = pyramid[0].c();
+    for (std::size_t i = 0; i < pyramid.size(); ++i) {
+        if (pyramid[i].empty() || pyramid[i].c() != C) {
+            throw std::invalid_argument("collapse_laplacian_pyramid: levels must be non-empty with equal channels");
+        }
+        if (i + 1 < pyramid.size()) {
+            check_up_size(pyramid[i + 1].h(), pyramid[i].h(), "collapse_laplacian_pyramid");
+            check_up_size(pyramid[i + 1].w(), pyramid[i].w(), "collapse_laplacian_pyramid");
+        }
+    }
+}
+
+// 最底層直接寫進 dst（其他層的中間結果用完就丟）
+void collapse_laplacian_pyramid(const std::vector<ImageU8>& pyramid,
+                                ImageU8& dst,
+                                Backend backend) {
+    check_laplacian_levels(pyramid);
+    const int C = pyramid[0].c();
+    check_output(dst, pyramid[0].h(), pyramid[0].w(), C, "collapse_laplacian_pyramid");
+    for (const auto& level : pyramid) check_no_overlap(level, dst, "collapse_laplacian_pyramid");
+
+    const int levels = static_cast<int>(pyramid.size());
+    const OpCost cost{2.5f, kPyrUpCost.ops_per_elem, levels};
+    ExecPlan plan = plan_execution(backend, cost, pyramid[0]);
+    ThreadScope threads(plan);
+    const Backend exec = plan.backend;
+
+    if (levels == 1) {
+        copy_rows(pyramid[0], dst);
+        return;
+    }
+
+    const ImageU8& top = pyramid.back();
+    ImageU8 cur(top.h(), top.w(), C, Init::None);
+    copy_rows(top, cur);
+
+    for (int i = levels - 2; i >= 0; --i) {
+        const ImageU8& lap = pyramid[static_cast<std::size_t>(i)];
+        if (i == 0) {
+            copy_rows(lap, dst);
+            pyr_up_into<UpMode::Add>(cur, dst, exec);
+            break;
+        }
+        ImageU8 next(lap.h(), lap.w(), C, Init::None);
+        copy_rows(lap, next);
+        pyr_up_into<UpMode::Add>(cur, next, exec);
+        cur = std::move(next);
+    }
+}
+
+ImageU8 collapse_laplacian_pyramid(const std::vector<ImageU8>& pyramid,
+                                   Backend backend) {
+    check_laplacian_levels(pyramid);
+    ImageU8 dst(pyramid[0].h(), pyramid[0].w(), pyramid[0].c(), Init::None);
+    collapse_laplacian_pyramid(pyramid, dst, backend);
+    return dst;
+}
+
+// 檢查參數並回傳輸出大小
+static void box_output_size(const ImageU8& src, int factor, int& Ho, int& Wo) {
+    if (src.empty()) throw std::invalid_argument("downscale_box: empty image");
+    if (factor != 2 && factor != 4) throw std::invalid_argument("downscale_box: factor must be 2 or 4");
+
+    Ho = src.h() / factor;
+    Wo = src.w() / factor;
+    if (Ho <= 0 || Wo <= 0) throw std::invalid_argument("downscale_box: image smaller than factor");
+}
+
+void downscale_box(const ImageU8& src,
+                   ImageU8& dst,
+                   int factor,
+                   Backend backend) {
+    int Ho = 0, Wo = 0;
+    box_output_size(src, factor, Ho, Wo);
+    check_output(dst, Ho, Wo, src.c(), "downscale_box");
+    check_no_overlap(src, dst, "downscale_box");
+
+    ExecPlan plan = plan_execution(backend, kBoxCost, src);
+    ThreadScope threads(plan);
+    const Backend exec = plan.backend;
+
+    const uint8_t* in = src.data();
+    uint8_t* out = dst.data();
+    const std::size_t is = src.stride(), os = dst.stride();
+    if (factor == 2) {
+        if (src.c() == 1) downscale_box_rows<2, 1>(in, is, out, os, Ho, Wo, exec);
+        else              downscale_box_rows<2, 3>(in, is, out, os, Ho, Wo, exec);
+    } else {
+        if (src.c() == 1) downscale_box_rows<4, 1>(in, is, out, os, Ho, Wo, exec);
+        else              downscale_box_rows<4, 3>(in, is, out, os, Ho, Wo, exec);
+    }
+}
+
+ImageU8 downscale_box(const ImageU8& src,
+                      int factor,
+                      Backend backend) {
+    int Ho = 0, Wo = 0;
+    box_output_size(src, factor, Ho, Wo);
+    ImageU8 dst(Ho, Wo, src.c(), Init::None);
+    downscale_box(src, dst, factor, backend);
+    return dst;
+}
+
+} // namespace pf
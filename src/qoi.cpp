@@ -0,0 +1,195 @@
+#include "pixfoundry/qoi.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace pf {
+
+namespace {
+
+constexpr uint8_t kOpIndex = 0x00;
+constexpr uint8_t kOpDiff  = 0x40;
+constexpr uint8_t kOpLuma  = 0x80;
+constexpr uint8_t kOpRun   = 0xC0;
+constexpr uint8_t kOpRgb   = 0xFE;
+constexpr uint8_t kOpRgba  = 0xFF;
+constexpr uint8_t kMask2   = 0xC0;
+
+constexpr std::size_t kHeaderSize = 14;
+constexpr uint8_t     kPadding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+// 跟參考實作一樣限制 pixel 數，避免壞掉的 header 要求巨大的配置
+constexpr uint64_t kMaxPixels = 400000000ull;
+
+struct Rgba {
+    uint8_t r = 0, g = 0, b = 0, a = 0;
+};
+
+inline int qoi_hash(const Rgba& p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) & 63; }
+
+inline bool same(const Rgba& x, const Rgba& y)
+{
+    return x.r == y.r && x.g == y.g && x.b == y.b && x.a == y.a;
+}
+
+inline void put_be32(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+inline uint32_t be32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_qoi(const uint8_t* data, int h, int w, int c, std::size_t stride)
+{
+    if (!data || h <= 0 || w <= 0 || (c != 1 && c != 3))
+        throw std::invalid_argument("encode_qoi: invalid input");
+    if (static_cast<uint64_t>(h) * static_cast<uint64_t>(w) > kMaxPixels)
+        throw std::invalid_argument("encode_qoi: image too large for QOI");
+    if (stride == 0) stride = static_cast<std::size_t>(w) * c;
+
+    // 最差情況每個 pixel 4 bytes（QOI_OP_RGB）
+    const std::size_t n = static_cast<std::size_t>(h) * w;
+    std::vector<uint8_t> out(kHeaderSize + n * 4 + sizeof(kPadding));
+    uint8_t* o = out.data();
+    std::memcpy(o, "qoif", 4);
+    put_be32(o + 4, static_cast<uint32_t>(w));
+    put_be32(o + 8, static_cast<uint32_t>(h));
+    o[12] = 3;  // channels
+    o[13] = 0;  // sRGB
+    o += kHeaderSize;
+
+    Rgba index[64];
+    Rgba prev;
+    prev.a = 255;
+    int run = 0;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row = data + static_cast<std::size_t>(y) * stride;
+        for (int x = 0; x < w; ++x) {
+            Rgba px;
+            px.a = 255;
+            if (c == 3) {
+                px.r = row[3 * x];
+                px.g = row[3 * x + 1];
+                px.b = row[3 * x + 2];
+            } else {
+                px.r = px.g = px.b = row[x];
+            }
+
+            if (same(px, prev)) {
+                if (++run == 62) {
+                    *o++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *o++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                run = 0;
+            }
+
+            const int idx = qoi_hash(px);
+            if (same(index[idx], px)) {
+                *o++ = static_cast<uint8_t>(kOpIndex | idx);
+            } else {
+                index[idx] = px;
+                const int dr = static_cast<int8_t>(px.r - prev.r);
+                const int dg = static_cast<int8_t>(px.g - prev.g);
+                const int db = static_cast<int8_t>(px.b - prev.b);
+                const int dr_dg = dr - dg, db_dg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *o++ = static_cast<uint8_t>(kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    *o++ = static_cast<uint8_t>(kOpLuma | (dg + 32));
+                    *o++ = static_cast<uint8_t>(((dr_dg + 8) << 4) | (db_dg + 8));
+                } else {
+                    *o++ = kOpRgb;
+                    *o++ = px.r;
+                    *o++ = px.g;
+                    *o++ = px.b;
+                }
+            }
+            prev = px;
+        }
+    }
+    if (run > 0) *o++ = static_cast<uint8_t>(kOpRun | (run - 1));
+    std::memcpy(o, kPadding, sizeof(kPadding));
+    o += sizeof(kPadding);
+    out.resize(static_cast<std::size_t>(o - out.data()));
+    return out;
+}
+
+bool is_qoi(const uint8_t* data, std::size_t size)
+{
+    return data && size >= 4 && std::memcmp(data, "qoif", 4) == 0;
+}
+
+ImageU8 decode_qoi(const uint8_t* data, std::size_t size)
+{
+    if (!is_qoi(data, size) || size < kHeaderSize + sizeof(kPadding))
+        throw std::runtime_error("qoi: not a QOI file");
+    const uint32_t w = be32(data + 4), h = be32(data + 8);
+    const uint8_t channels = data[12];
+    if (w == 0 || h == 0 || (channels != 3 && channels != 4) || data[13] > 1)
+        throw std::runtime_error("qoi: invalid header");
+    if (static_cast<uint64_t>(w) * h > kMaxPixels || w > 0x7FFFFFFFu || h > 0x7FFFFFFFu)
+        throw std::runtime_error("qoi: image too large");
+
+    ImageU8 img(static_cast<int>(h), static_cast<int>(w), 3, Init::None);
+    uint8_t* out = img.data();
+    const std::size_t n = static_cast<std::size_t>(w) * h;
+
+    // 最後 8 bytes 是結尾標記，chunk 不會跨進去
+    const uint8_t* p   = data + kHeaderSize;
+    const uint8_t* end = data + size - sizeof(kPadding);
+    Rgba index[64];
+    Rgba px;
+    px.a = 255;
+    int run = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (p >= end) throw std::runtime_error("qoi: truncated data");
+            const uint8_t b1 = *p++;
+            if (b1 == kOpRgb || b1 == kOpRgba) {
+                const std::ptrdiff_t need = b1 == kOpRgb ? 3 : 4;
+                if (end - p < need) throw std::runtime_error("qoi: truncated data");
+                px.r = p[0];
+                px.g = p[1];
+                px.b = p[2];
+                if (b1 == kOpRgba) px.a = p[3];
+                p += need;
+            } else if ((b1 & kMask2) == kOpIndex) {
+                px = index[b1];
+            } else if ((b1 & kMask2) == kOpDiff) {
+                px.r = static_cast<uint8_t>(px.r + ((b1 >> 4) & 3) - 2);
+                px.g = static_cast<uint8_t>(px.g + ((b1 >> 2) & 3) - 2);
+                px.b = static_cast<uint8_t>(px.b + (b1 & 3) - 2);
+            } else if ((b1 & kMask2) == kOpLuma) {
+                if (p >= end) throw std::runtime_error("qoi: truncated data");
+                const uint8_t b2 = *p++;
+                const int dg = (b1 & 0x3F) - 32;
+                px.r = static_cast<uint8_t>(px.r + dg - 8 + ((b2 >> 4) & 0x0F));
+                px.g = static_cast<uint8_t>(px.g + dg);
+                px.b = static_cast<uint8_t>(px.b + dg - 8 + (b2 & 0x0F));
+            } else {
+                run = b1 & 0x3F;
+            }
+            index[qoi_hash(px)] = px;
+        }
+        out[3 * i]     = px.r;
+        out[3 * i + 1] = px.g;
+        out[3 * i + 2] = px.b;
+    }
+    return img;
+}
+
+} // namespace pf
@@ -0,0 +1,414 @@
+#include "pixfoundry/stream.hpp"
+#include "pixfoundry/png.hpp"
+#include "pixfoundry/tiled.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace pf {
+
+namespace {
+
+std::string lower_ext(const std::string& path)
+{
+    const std::size_t dot = path.find_last_of('.');
+    const std::size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return "";
+    std::string ext = path.substr(dot + 1);
+    for (char& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return ext;
+}
+
+bool is_pnm(const std::string& ext) { return ext == "ppm" || ext == "pgm" || ext == "pnm"; }
+
+void check_rows(const ImageU8& rows, const ImageShape& shape, const char* who)
+{
+    if (rows.empty() || rows.w() != shape.w || rows.c() != shape.c)
+        throw std::invalid_argument(std::string(who) + ": rows must be " + std::to_string(shape.w) +
+                                    " wide with " + std::to_string(shape.c) + " channels");
+}
+
+// ======================
+//  sources
+// ======================
+
+class PngSource final : public StripSource {
+public:
+    explicit PngSource(const std::string& path) : reader_(path) {}
+
+    ImageShape shape() const override { return {reader_.h(), reader_.w(), reader_.c()}; }
+
+    int read(ImageU8& dst) override {
+        check_rows(dst, shape(), "PngSource");
+        return reader_.read_rows(dst.data(), dst.h(), dst.stride());
+    }
+
+private:
+    PngStreamReader reader_;
+};
+
+// binary PGM（P5）/ PPM（P6），maxval <= 255
+class PnmSource final : public StripSource {
+public:
+    explicit PnmSource(const std::string& path) : in_(path, std::ios::binary), path_(path) {
+        if (!in_) throw std::runtime_error("pnm: cannot open " + path);
+        char magic[2] = {};
+        in_.read(magic, 2);
+        if (magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) fail("only binary P5 / P6 files are supported");
+        shape_.c = magic[1] == '5' ? 1 : 3;
+        shape_.w = number();
+        shape_.h = number();
+        const int maxval = number();
+        if (shape_.w <= 0 || shape_.h <= 0) fail("bad size");
+        if (maxval <= 0 || maxval > 255) fail("only 8-bit files (maxval <= 255) are supported");
+        in_.get();  // maxval 後面剛好一個空白
+    }
+
+    ImageShape shape() const override { return shape_; }
+
+    int read(ImageU8& dst) override {
+        check_rows(dst, shape_, "PnmSource");
+        const int n = std::min(dst.h(), shape_.h - rows_);
+        const std::size_t len = static_cast<std::size_t>(shape_.w) * shape_.c;
+        if (n <= 0) return 0;
+        if (dst.is_contiguous()) {
+            read_exact(dst.data(), len * n);
+        } else {
+            for (int y = 0; y < n; ++y) read_exact(dst.row(y), len);
+        }
+        rows_ += n;
+        return n;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& why) const { throw std::runtime_error("pnm: " + why + " (" + path_ + ")"); }
+
+    void read_exact(uint8_t* p, std::size_t n) {
+        in_.read(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n));
+        if (static_cast<std::size_t>(in_.gcount()) != n) fail("truncated file");
+    }
+
+    // header 的數字：中間可以有空白跟 # 開頭的註解
+    int number() {
+        int ch = in_.get();
+        while (ch != EOF && (std::isspace(ch) || ch == '#')) {
+            if (ch == '#')
+                while (ch != EOF && ch != '\n') ch = in_.get();
+            ch = in_.get();
+        }
+        if (ch == EOF || !std::isdigit(ch)) fail("bad header");
+        long long v = 0;
+        while (ch != EOF && std::isdigit(ch)) {
+            v = v * 10 + (ch - '0');
+            if (v > 0x7FFFFFFF) fail("bad header");
+            ch = in_.get();
+        }
+        in_.unget();
+        return static_cast<int>(v);
+    }
+
+    std::ifstream in_;
+    std::string   path_;
+    ImageShape    shape_;
+    int           rows_ = 0;
+};
+
+// .pft：一次拿一列 tile（band），不壓縮、只有一個 tile 寬的時候就是 mmap 上的 view
+class TiledSource final : public StripSource {
+public:
+    explicit TiledSource(const std::string& path) : reader_(path) {}
+
+    ImageShape shape() const override {
+        const TiledInfo& i = reader_.info();
+        return {i.h, i.w, i.c};
+    }
+
+    int read(ImageU8& dst) override {
+        const TiledInfo& info = reader_.info();
+        check_rows(dst, shape(), "TiledSource");
+        const std::size_t len = static_cast<std::size_t>(info.w) * info.c;
+        int n = 0;
+        while (n < dst.h() && next_ < info.h) {
+            if (band_.empty() || next_ >= band_y0_ + band_.h()) {
+                band_y0_ = next_ / info.tile_h * info.tile_h;
+                band_ = ImageU8();  // 先放掉上一列，記憶體最多一列 tile
+                band_ = reader_.read_region(band_y0_, 0, std::min(info.tile_h, info.h - band_y0_), info.w);
+            }
+            const int k = std::min(dst.h() - n, band_y0_ + band_.h() - next_);
+            for (int y = 0; y < k; ++y) std::memcpy(dst.row(n + y), band_.row(next_ - band_y0_ + y), len);
+            n += k;
+            next_ += k;
+        }
+        return n;
+    }
+
+private:
+    TiledReader reader_;
+    ImageU8     band_;
+    int         band_y0_ = 0;
+    int         next_ = 0;
+};
+
+// ======================
+//  sinks
+// ======================
+
+class PngSink final : public StripSink {
+public:
+    PngSink(const std::string& path, const ImageShape& shape, const EncodeOptions& options)
+        : shape_(shape), writer_(path, shape.h, shape.w, shape.c, options.png_level, options.png_filter) {}
+
+    void write(const ImageU8& rows) override {
+        check_rows(rows, shape_, "PngSink");
+        writer_.write_rows(rows.data(), rows.h(), rows.stride());
+    }
+
+    void close() override { writer_.close(); }
+
+private:
+    ImageShape      shape_;
+    PngStreamWriter writer_;
+};
+
+class PnmSink final : public StripSink {
+public:
+    PnmSink(const std::string& path, const ImageShape& shape)
+        : shape_(shape), out_(path, std::ios::binary | std::ios::trunc), path_(path) {
+        if (!out_) throw std::runtime_error("pnm: cannot open " + path);
+        out_ << (shape.c == 1 ? "P5" : "P6") << '\n' << shape.w << ' ' << shape.h << "\n255\n";
+    }
+
+    void write(const ImageU8& rows) override {
+        check_rows(rows, shape_, "PnmSink");
+        if (rows.h() > shape_.h - rows_) throw std::invalid_argument("PnmSink: more rows than the image height");
+        const std::size_t len = static_cast<std::size_t>(shape_.w) * shape_.c;
+        if (rows.is_contiguous()) {
+            out_.write(reinterpret_cast<const char*>(rows.data()), static_cast<std::streamsize>(len * rows.h()));
+        } else {
+            for (int y = 0; y < rows.h(); ++y)
+                out_.write(reinterpret_cast<const char*>(rows.row(y)), static_cast<std::streamsize>(len));
+        }
+        if (!out_) throw std::runtime_error("pnm: failed to write " + path_);
+        rows_ += rows.h();
+    }
+
+    void close() override {
+        if (!out_.is_open()) return;
+        out_.close();
+        if (rows_ != shape_.h)
+            throw std::runtime_error("PnmSink: only " + std::to_string(rows_) + " of " + std::to_string(shape_.h) +
+                                     " rows written (" + path_ + ")");
+        if (!out_) throw std::runtime_error("pnm: failed to write " + path_);
+    }
+
+private:
+    ImageShape    shape_;
+    std::ofstream out_;
+    std::string   path_;
+    int           rows_ = 0;
+};
+
+class TiledSink final : public StripSink {
+public:
+    TiledSink(const std::string& path, const ImageShape& shape) : writer_(path, shape.h, shape.w, shape.c) {}
+
+    void write(const ImageU8& rows) override { writer_.append_rows(rows); }
+    void close() override { writer_.close(); }
+
+private:
+    TiledWriter writer_;
+};
+
+// ======================
+//  逐段跑 ops
+// ======================
+
+// 一個 op 的狀態：in 放輸入影像 [in_y0, in_y0 + in_n) 這幾個 row，
+// 下一個要產生的輸出 row 是 next（它上面 halo 個以外的 row 都已經丟了）
+struct Stage {
+    const ImageOp* op = nullptr;
+    int            halo = 0;
+    ImageU8        in, out;
+    int            in_y0 = 0, in_n = 0, next = 0;
+};
+
+class StripRunner {
+public:
+    StripRunner(const ImageShape& shape, const std::vector<ImageOp>& ops, StripSink& sink, int strip_rows,
+                Backend backend)
+        : h_(shape.h), w_(shape.w), sink_(sink), backend_(backend) {
+        // 第 i 步一次最多收到 k_i 個 row：k_0 = strip_rows；
+        // 平常每段產生的 row 數跟收到的一樣，最後一段多 halo 個（到底了，下面不用再等）
+        int k = strip_rows;
+        ImageShape s = shape;
+        stages_.resize(ops.size());
+        for (std::size_t i = 0; i < ops.size(); ++i) {
+            Stage& st = stages_[i];
+            st.op = &ops[i];
+            st.halo = ops[i].halo;
+            const ImageShape o = ops[i].output_shape(s);
+            // 留下的上下各 halo 個 row + 新收到的
+            const int cap = static_cast<int>(std::min<long long>(h_, 2LL * st.halo + k));
+            st.in  = ImageU8(cap, w_, s.c, Init::None);
+            st.out = ImageU8(cap, w_, o.c, Init::None);
+            bytes_ += static_cast<std::size_t>(cap) * w_ * (s.c + o.c);
+            k = static_cast<int>(std::min<long long>(h_, static_cast<long long>(k) + st.halo));
+            s = o;
+        }
+    }
+
+    std::size_t buffer_bytes() const { return bytes_; }
+    long long   rows_written() const { return written_; }
+
+    // 第一步的輸入 buffer 後面還空著的地方：來源直接讀進去，不多抄一次
+    ImageU8 input_room(int max_rows) {
+        Stage& s = stages_[0];
+        const int n = std::min({max_rows, s.in.h() - s.in_n, h_ - (s.in_y0 + s.in_n)});
+        return s.in.view(s.in_n, 0, n, w_);
+    }
+
+    void input_added(int n) {
+        stages_[0].in_n += n;
+        produce(0);
+    }
+
+private:
+    void deliver(std::size_t i, const ImageU8& rows) {
+        if (i == stages_.size()) {
+            sink_.write(rows);
+            written_ += rows.h();
+            return;
+        }
+        Stage& s = stages_[i];
+        const std::size_t len = static_cast<std::size_t>(w_) * rows.c();
+        for (int y = 0; y < rows.h(); ++y) std::memcpy(s.in.row(s.in_n + y), rows.row(y), len);
+        s.in_n += rows.h();
+        produce(i);
+    }
+
+    void produce(std::size_t i) {
+        Stage& s = stages_[i];
+        const int have = s.in_y0 + s.in_n;
+        // 底下還有 row 沒來：最後 halo 個 row 還不能算
+        const int end = have == h_ ? h_ : have - s.halo;
+        if (end <= s.next) return;
+
+        // 從 next 上面 halo 個 row（最多到影像頂）算到手上最後一個 row；
+        // 窗口上下緣不是影像邊緣的話，那 halo 個 row 的結果不對，不交出去
+        const int ws = std::max(0, s.next - s.halo);
+        const int n = have - ws;
+        ImageU8 dst = s.out.view(0, 0, n, w_);
+        s.op->run(s.in.view(ws - s.in_y0, 0, n, w_), dst, backend_);
+        const int first = s.next;
+        s.next = end;
+        deliver(i + 1, dst.view(first - ws, 0, end - first, w_));
+
+        // 下一段只需要 next 上面 halo 個 row
+        const int keep_from = std::max(s.in_y0, s.next - s.halo);
+        const int keep = have - keep_from;
+        if (keep_from > s.in_y0) {
+            if (keep > 0)
+                std::memmove(s.in.data(), s.in.row(keep_from - s.in_y0),
+                             static_cast<std::size_t>(keep) * s.in.stride());
+            s.in_y0 = keep_from;
+            s.in_n = keep;
+        }
+    }
+
+    int                h_, w_;
+    StripSink&         sink_;
+    Backend            backend_;
+    std::vector<Stage> stages_;
+    std::size_t        bytes_ = 0;
+    long long          written_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<StripSource> open_strip_source(const std::string& path)
+{
+    const std::string ext = lower_ext(path);
+    if (ext == "png") return std::make_unique<PngSource>(path);
+    if (is_pnm(ext)) return std::make_unique<PnmSource>(path);
+    if (ext == "pft") return std::make_unique<TiledSource>(path);
+    throw std::invalid_argument("open_strip_source: cannot stream '" + path + "' (use .png, .ppm / .pgm or .pft)");
+}
+
+std::unique_ptr<StripSink> open_strip_sink(const std::string& path, const ImageShape& shape,
+                                           const EncodeOptions& options)
+{
+    if (shape.h <= 0 || shape.w <= 0 || (shape.c != 1 && shape.c != 3))
+        throw std::invalid_argument("open_strip_sink: invalid shape");
+    const std::string ext = lower_ext(path);
+    if (ext == "png") return std::make_unique<PngSink>(path, shape, options);
+    if (is_pnm(ext)) return std::make_unique<PnmSink>(path, shape);
+    if (ext == "pft") return std::make_unique<TiledSink>(path, shape);
+    throw std::invalid_argument("open_strip_sink: cannot stream to '" + path + "' (use .png, .ppm / .pgm or .pft)");
+}
+
+StreamStats process_strips(StripSource& src, const std::vector<ImageOp>& ops, StripSink& dst,
+                           int strip_rows, Backend backend)
+{
+    if (strip_rows <= 0) throw std::invalid_argument("process_strips: strip_rows must be > 0");
+    const ImageShape in = src.shape();
+    ImageShape s = in;
+    for (const ImageOp& op : ops) {
+        if (op.halo < 0) throw std::invalid_argument("process_strips: " + op.name + " cannot run strip by strip");
+        const ImageShape o = op.output_shape(s);
+        if (o.h != s.h || o.w != s.w)
+            throw std::invalid_argument("process_strips: " + op.name + " changes the image size");
+        s = o;
+    }
+
+    StreamStats stats;
+    long long read = 0;
+    const auto short_read = [&]() {
+        return std::runtime_error("process_strips: source ended after " + std::to_string(read) + " of " +
+                                  std::to_string(in.h) + " rows");
+    };
+
+    if (ops.empty()) {
+        // 只是換格式：一段讀進來就寫出去
+        ImageU8 buf(std::min(strip_rows, in.h), in.w, in.c, Init::None);
+        stats.buffer_bytes = static_cast<std::size_t>(buf.h()) * buf.stride();
+        while (read < in.h) {
+            ImageU8 room = buf.view(0, 0, static_cast<int>(std::min<long long>(buf.h(), in.h - read)), in.w);
+            const int n = src.read(room);
+            if (n <= 0) throw short_read();
+            ++stats.strips;
+            read += n;
+            dst.write(buf.view(0, 0, n, in.w));
+        }
+        stats.rows = read;
+    } else {
+        StripRunner runner(in, ops, dst, std::min(strip_rows, in.h), backend);
+        stats.buffer_bytes = runner.buffer_bytes();
+        while (read < in.h) {
+            ImageU8 room = runner.input_room(strip_rows);
+            const int n = src.read(room);
+            if (n <= 0) throw short_read();
+            ++stats.strips;
+            read += n;
+            runner.input_added(n);
+        }
+        stats.rows = runner.rows_written();
+    }
+    dst.close();
+    return stats;
+}
+
+StreamStats process_stream(const std::string& src_path, const std::string& dst_path,
+                           const std::vector<ImageOp>& ops, int strip_rows,
+                           const EncodeOptions& options, Backend backend)
+{
+    std::unique_ptr<StripSource> src = open_strip_source(src_path);
+    ImageShape out = src->shape();
+    for (const ImageOp& op : ops) out = op.output_shape(out);
+    std::unique_ptr<StripSink> dst = open_strip_sink(dst_path, out, options);
+    return process_strips(*src, ops, *dst, strip_rows, backend);
+}
+
+} // namespace pf
@@ -0,0 +1,454 @@
+#include "pixfoundry/tiled.hpp"
+#include "pixfoundry/parallel.hpp"
+#include "pixfoundry/png.hpp"
+#include "pixfoundry/qoi.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pf {
+
+namespace {
+
+constexpr char        kMagic[8]     = {'P', 'F', 'T', 'I', 'L', 'E', 'D', '\0'};
+constexpr uint32_t    kVersion      = 1;
+constexpr std::size_t kHeaderSize   = 64;
+constexpr uint64_t    kTileAlign    = 64;
+constexpr int         kMaxTileSide  = 1 << 16;
+
+void put_le(uint8_t* p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint64_t get_le(const uint8_t* p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+TiledInfo make_info(int h, int w, int c, int tile_h, int tile_w, TileCompression compression)
+{
+    if (h <= 0 || w <= 0 || (c != 1 && c != 3))
+        throw std::invalid_argument("tiled: image must be HxW or HxWx3 with positive size");
+    if (tile_h <= 0 || tile_w <= 0 || tile_h > kMaxTileSide || tile_w > kMaxTileSide)
+        throw std::invalid_argument("tiled: tile size must be in 1..65536");
+    TiledInfo info;
+    info.h = h;
+    info.w = w;
+    info.c = c;
+    info.tile_h = std::min(tile_h, h);
+    info.tile_w = std::min(tile_w, w);
+    info.tiles_y = (h + info.tile_h - 1) / info.tile_h;
+    info.tiles_x = (w + info.tile_w - 1) / info.tile_w;
+    info.compression = compression;
+    return info;
+}
+
+std::vector<uint8_t> encode_tile(const ImageU8& t, TileCompression compression)
+{
+    const uint8_t* p = t.data();
+    switch (compression) {
+    case TileCompression::Qoi:
+        return encode_qoi(p, t.h(), t.w(), t.c(), t.stride());
+    case TileCompression::Png:
+        return encode_png(p, t.h(), t.w(), t.c(), t.stride(), 1, PngFilter::Fast);
+    case TileCompression::None:
+    default: {
+        const std::size_t row = static_cast<std::size_t>(t.w()) * t.c();
+        std::vector<uint8_t> out(row * t.h());
+        for (int y = 0; y < t.h(); ++y) std::memcpy(out.data() + row * y, t.row(y), row);
+        return out;
+    }
+    }
+}
+
+} // namespace
+
+TileRect tile_rect(const TiledInfo& info, int ty, int tx)
+{
+    if (ty < 0 || tx < 0 || ty >= info.tiles_y || tx >= info.tiles_x)
+        throw std::out_of_range("tiled: tile index out of range");
+    TileRect r;
+    r.y = ty * info.tile_h;
+    r.x = tx * info.tile_w;
+    r.h = std::min(info.tile_h, info.h - r.y);
+    r.w = std::min(info.tile_w, info.w - r.x);
+    return r;
+}
+
+// ======================
+//  TiledWriter
+// ======================
+
+TiledWriter::TiledWriter(const std::string& path, int h, int w, int c, int tile_h, int tile_w,
+                         TileCompression compression)
+    : info_(make_info(h, w, c, tile_h, tile_w, compression)),
+      path_(path),
+      out_(path, std::ios::binary | std::ios::trunc),
+      end_(kHeaderSize),
+      index_(static_cast<std::size_t>(info_.tiles_y) * info_.tiles_x, {0, 0}) {
+    if (!out_) throw std::runtime_error("TiledWriter: cannot open " + path);
+    // header 先佔位，close() 時才寫真的（那時才知道 index 在哪）
+    const uint8_t zeros[kHeaderSize] = {};
+    out_.write(reinterpret_cast<const char*>(zeros), kHeaderSize);
+}
+
+TiledWriter::~TiledWriter() {
+    try {
+        close();
+    } catch (...) {
+        // 解構不能丟：要拿錯誤的話先自己呼叫 close()
+    }
+}
+
+void TiledWriter::write_tile(int ty, int tx, const ImageU8& tile) {
+    const TileRect r = tile_rect(info_, ty, tx);
+    if (tile.h() != r.h || tile.w() != r.w || tile.c() != info_.c)
+        throw std::invalid_argument("TiledWriter: tile (" + std::to_string(ty) + ", " + std::to_string(tx) +
+                                    ") must be " + std::to_string(r.h) + "x" + std::to_string(r.w) + "x" +
+                                    std::to_string(info_.c));
+    const std::vector<uint8_t> bytes = encode_tile(tile, info_.compression);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) throw std::runtime_error("TiledWriter: write after close()");
+    auto& entry = index_[static_cast<std::size_t>(ty) * info_.tiles_x + tx];
+    if (entry.first != 0) throw std::invalid_argument("TiledWriter: tile written twice");
+
+    // 每個 tile 從 64 bytes 的邊界開始：mmap 之後的 view 對齊 cache line
+    const uint64_t offset = (end_ + kTileAlign - 1) / kTileAlign * kTileAlign;
+    if (offset != end_) {
+        const char pad[kTileAlign] = {};
+        out_.write(pad, static_cast<std::streamsize>(offset - end_));
+    }
+    out_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out_) throw std::runtime_error("TiledWriter: failed to write " + path_);
+    entry = {offset, bytes.size()};
+    end_ = offset + bytes.size();
+}
+
+void TiledWriter::write_band(const ImageU8& band, int ty) {
+    ThreadPool::instance().parallel_for(0, info_.tiles_x, 1, [&](long b, long e) {
+        for (long tx = b; tx < e; ++tx) {
+            const TileRect r = tile_rect(info_, ty, static_cast<int>(tx));
+            write_tile(ty, static_cast<int>(tx), band.view(0, r.x, r.h, r.w));
+        }
+    });
+}
+
+void TiledWriter::append_rows(const ImageU8& rows) {
+    if (rows.empty()) return;
+    if (rows.w() != info_.w || rows.c() != info_.c)
+        throw std::invalid_argument("TiledWriter: append_rows needs rows of width " + std::to_string(info_.w) +
+                                    " with " + std::to_string(info_.c) + " channels");
+    if (appended_ + rows.h() > info_.h)
+        throw std::invalid_argument("TiledWriter: append_rows past the last row");
+
+    const std::size_t row_bytes = static_cast<std::size_t>(info_.w) * info_.c;
+    for (int y = 0; y < rows.h();) {
+        const int ty = appended_ / info_.tile_h;
+        const int band_h = tile_rect(info_, ty, 0).h;
+        // 一次就給了整列 tile：直接切，不經過 band_
+        if (band_rows_ == 0 && rows.h() - y >= band_h) {
+            write_band(rows.view(y, 0, band_h, info_.w), ty);
+            y += band_h;
+            appended_ += band_h;
+            continue;
+        }
+        if (band_.empty()) band_ = ImageU8(info_.tile_h, info_.w, info_.c, Init::None);
+        const int n = std::min(band_h - band_rows_, rows.h() - y);
+        for (int i = 0; i < n; ++i) std::memcpy(band_.row(band_rows_ + i), rows.row(y + i), row_bytes);
+        band_rows_ += n;
+        y += n;
+        appended_ += n;
+        if (band_rows_ == band_h) {
+            write_band(band_.view(0, 0, band_h, info_.w), ty);
+            band_rows_ = 0;
+        }
+    }
+    if (appended_ == info_.h) band_ = ImageU8();
+}
+
+void TiledWriter::write_image(const ImageU8& img) {
+    if (img.h() != info_.h || img.w() != info_.w || img.c() != info_.c)
+        throw std::invalid_argument("TiledWriter: write_image size does not match the container");
+    const long n = static_cast<long>(index_.size());
+    ThreadPool::instance().parallel_for(0, n, 1, [&](long b, long e) {
+        for (long i = b; i < e; ++i) {
+            const int ty = static_cast<int>(i / info_.tiles_x), tx = static_cast<int>(i % info_.tiles_x);
+            const TileRect r = tile_rect(info_, ty, tx);
+            write_tile(ty, tx, img.view(r.y, r.x, r.h, r.w));
+        }
+    });
+    appended_ = info_.h;
+}
+
+void TiledWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) return;
+    closed_ = true;
+    const std::size_t missing = static_cast<std::size_t>(
+        std::count_if(index_.begin(), index_.end(), [](const auto& e) { return e.first == 0; }));
+    if (missing) {
+        out_.close();
+        throw std::runtime_error("TiledWriter: " + std::to_string(missing) + " tiles were never written (" +
+                                 path_ + ")");
+    }
+
+    std::vector<uint8_t> index(index_.size() * 16);
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        put_le(index.data() + 16 * i, index_[i].first, 8);
+        put_le(index.data() + 16 * i + 8, index_[i].second, 8);
+    }
+    out_.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+
+    uint8_t header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    put_le(header + 8, kVersion, 4);
+    put_le(header + 12, static_cast<uint32_t>(info_.h), 4);
+    put_le(header + 16, static_cast<uint32_t>(info_.w), 4);
+    put_le(header + 20, static_cast<uint32_t>(info_.c), 4);
+    put_le(header + 24, static_cast<uint32_t>(info_.tile_h), 4);
+    put_le(header + 28, static_cast<uint32_t>(info_.tile_w), 4);
+    put_le(header + 32, static_cast<uint32_t>(info_.compression), 4);
+    put_le(header + 40, end_, 8);
+    put_le(header + 48, index_.size(), 8);
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    out_.close();
+    if (!out_) throw std::runtime_error("TiledWriter: failed to write " + path_);
+}
+
+void save_tiled(const std::string& path, const ImageU8& img, int tile_h, int tile_w,
+                TileCompression compression)
+{
+    if (img.empty()) throw std::invalid_argument("save_tiled: empty image");
+    TiledWriter writer(path, img.h(), img.w(), img.c(), tile_h, tile_w, compression);
+    writer.write_image(img);
+    writer.close();
+}
+
+// ======================
+//  TiledReader
+// ======================
+
+// mmap 整個檔（沒有 mmap 時讀進一塊 buffer）；所有回傳的 view 共用它的生命週期
+struct TiledReader::Mapping {
+    uint8_t*                   data = nullptr;
+    std::size_t                size = 0;
+    void*                      map  = nullptr;
+    std::shared_ptr<uint8_t[]> buf;
+
+    explicit Mapping(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("TiledReader: cannot open " + path);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("TiledReader: cannot stat " + path);
+        }
+        size = static_cast<std::size_t>(st.st_size);
+        if (size > 0) {
+            // MAP_PRIVATE + 可寫：view 交給呼叫端後被改也只會動到 copy-on-write 的頁
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map = p;
+                data = static_cast<uint8_t*>(p);
+                ::madvise(p, size, MADV_RANDOM);  // 隨機存取 tile：不要大量預讀
+            }
+        }
+        ::close(fd);
+        if (map || size == 0) return;
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("TiledReader: cannot open " + path);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size = bytes.size();
+        buf = std::shared_ptr<uint8_t[]>(new uint8_t[std::max<std::size_t>(size, 1)]);
+        std::memcpy(buf.get(), bytes.data(), size);
+        data = buf.get();
+    }
+
+    ~Mapping() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map) ::munmap(map, size);
+#endif
+    }
+
+    Mapping(const Mapping&)            = delete;
+    Mapping& operator=(const Mapping&) = delete;
+};
+
+TiledReader::TiledReader(const std::string& path) : map_(std::make_shared<Mapping>(path)) {
+    const uint8_t* p = map_->data;
+    const std::size_t size = map_->size;
+    const auto fail = [&](const char* why) {
+        throw std::runtime_error(std::string("TiledReader: ") + why + " (" + path + ")");
+    };
+    if (size < kHeaderSize || std::memcmp(p, kMagic, sizeof(kMagic)) != 0) fail("not a PixFoundry tiled file");
+    if (get_le(p + 8, 4) != kVersion) fail("unsupported version");
+
+    const uint64_t dims[5] = {get_le(p + 12, 4), get_le(p + 16, 4), get_le(p + 20, 4),
+                              get_le(p + 24, 4), get_le(p + 28, 4)};
+    for (uint64_t d : dims)
+        if (d == 0 || d > static_cast<uint64_t>(std::numeric_limits<int>::max())) fail("invalid header");
+    const uint64_t comp = get_le(p + 32, 4);
+    if (comp > static_cast<uint64_t>(TileCompression::Png)) fail("unknown compression");
+    try {
+        info_ = make_info(static_cast<int>(dims[0]), static_cast<int>(dims[1]), static_cast<int>(dims[2]),
+                          static_cast<int>(dims[3]), static_cast<int>(dims[4]), static_cast<TileCompression>(comp));
+    } catch (const std::invalid_argument&) {
+        fail("invalid header");
+    }
+    if (info_.tile_h != static_cast<int>(dims[3]) || info_.tile_w != static_cast<int>(dims[4])) fail("invalid header");
+
+    const uint64_t index_off = get_le(p + 40, 8), count = get_le(p + 48, 8);
+    if (count != static_cast<uint64_t>(info_.tiles_y) * info_.tiles_x) fail("tile count does not match the header");
+    if (index_off < kHeaderSize || index_off > size || (size - index_off) / 16 < count) fail("truncated file");
+
+    index_.resize(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t off = get_le(p + index_off + 16 * i, 8), n = get_le(p + index_off + 16 * i + 8, 8);
+        if (off < kHeaderSize || off > size || n > size - off) fail("tile outside the file");
+        if (info_.compression == TileCompression::None) {
+            const TileRect r = tile_rect(info_, static_cast<int>(i / info_.tiles_x), static_cast<int>(i % info_.tiles_x));
+            if (n != static_cast<uint64_t>(r.h) * r.w * info_.c) fail("raw tile has the wrong size");
+        }
+        index_[i] = {off, n};
+    }
+}
+
+ImageU8 TiledReader::hand_out(ImageU8 img) const {
+    if (map_->map) return img;  // MAP_PRIVATE：寫入本來就是 copy-on-write
+    // view 是 aliasing shared_ptr，ownership 跟 map_ 一樣
+    const auto& owner = img.shared();
+    if (!owner.owner_before(map_) && !map_.owner_before(owner)) return img.clone();
+    return img;
+}
+
+ImageU8 TiledReader::tile(int ty, int tx) const {
+    return hand_out(load_tile(ty, tx));
+}
+
+ImageU8 TiledReader::load_tile(int ty, int tx) const {
+    const TileRect r = tile_rect(info_, ty, tx);
+    const auto& e = index_[static_cast<std::size_t>(ty) * info_.tiles_x + tx];
+    uint8_t* p = map_->data + e.first;
+    if (info_.compression == TileCompression::None) {
+        // aliasing shared_ptr：view 撐著整個 mapping
+        return ImageU8(r.h, r.w, info_.c, std::shared_ptr<uint8_t[]>(map_, p));
+    }
+
+    ImageU8 img = info_.compression == TileCompression::Qoi
+                      ? decode_qoi(p, static_cast<std::size_t>(e.second))
+                      : decode_image_u8(p, static_cast<std::size_t>(e.second));
+    if (img.h() != r.h || img.w() != r.w) throw std::runtime_error("TiledReader: tile has the wrong size");
+    if (img.c() == info_.c) return img;
+    if (info_.c != 1) throw std::runtime_error("TiledReader: tile has the wrong channel count");
+    // QOI 沒有灰階：存的時候 R = G = B，取一個通道回來
+    ImageU8 gray(r.h, r.w, 1, Init::None);
+    for (int y = 0; y < r.h; ++y) {
+        const uint8_t* s = img.row(y);
+        uint8_t* d = gray.row(y);
+        for (int x = 0; x < r.w; ++x) d[x] = s[3 * x];
+    }
+    return gray;
+}
+
+// 影像內的 (y, x, h, w) 拼成一張：每個碰到的 tile 一個工作（壓縮的 tile 平行解）
+ImageU8 TiledReader::assemble(int y, int x, int h, int w) const {
+    const int ty0 = y / info_.tile_h, ty1 = (y + h - 1) / info_.tile_h;
+    const int tx0 = x / info_.tile_w, tx1 = (x + w - 1) / info_.tile_w;
+    if (ty0 == ty1 && tx0 == tx1 && info_.compression == TileCompression::None) {
+        const TileRect r = tile_rect(info_, ty0, tx0);
+        return load_tile(ty0, tx0).view(y - r.y, x - r.x, h, w);
+    }
+
+    ImageU8 out(h, w, info_.c, Init::None);
+    const int ntx = tx1 - tx0 + 1;
+    const long n = static_cast<long>(ty1 - ty0 + 1) * ntx;
+    ThreadPool::instance().parallel_for(0, n, 1, [&](long b, long e) {
+        for (long i = b; i < e; ++i) {
+            const int ty = ty0 + static_cast<int>(i / ntx), tx = tx0 + static_cast<int>(i % ntx);
+            const TileRect r = tile_rect(info_, ty, tx);
+            const ImageU8 t = load_tile(ty, tx);
+            const int y0 = std::max(y, r.y), y1 = std::min(y + h, r.y + r.h);
+            const int x0 = std::max(x, r.x), x1 = std::min(x + w, r.x + r.w);
+            const std::size_t bytes = static_cast<std::size_t>(x1 - x0) * info_.c;
+            for (int yy = y0; yy < y1; ++yy)
+                std::memcpy(out.row(yy - y) + static_cast<std::size_t>(x0 - x) * info_.c,
+                            t.row(yy - r.y) + static_cast<std::size_t>(x0 - r.x) * info_.c, bytes);
+        }
+    });
+    return out;
+}
+
+ImageU8 TiledReader::read_region(int y, int x, int h, int w, int halo, Border border, uint8_t border_value) const {
+    if (h <= 0 || w <= 0 || y < 0 || x < 0 || h > info_.h - y || w > info_.w - x)
+        throw std::out_of_range("TiledReader: region outside the image");
+    if (halo < 0) throw std::invalid_argument("TiledReader: halo must be >= 0");
+
+    const int ey = y - halo, ex = x - halo, eh = h + 2 * halo, ew = w + 2 * halo;
+    if (ey >= 0 && ex >= 0 && ey + eh <= info_.h && ex + ew <= info_.w) return hand_out(assemble(ey, ex, eh, ew));
+
+    // 有一部分在影像外：先算每個輸出 row / col 對到的來源，拼出用得到的範圍，再照表搬
+    std::vector<int> rows(static_cast<std::size_t>(eh)), cols(static_cast<std::size_t>(ew));
+    for (int i = 0; i < eh; ++i) rows[i] = border_fold(ey + i, info_.h, border);
+    for (int i = 0; i < ew; ++i) cols[i] = border_fold(ex + i, info_.w, border);
+    const auto bounds = [](const std::vector<int>& v, int& lo, int& hi) {
+        lo = std::numeric_limits<int>::max();
+        hi = -1;
+        for (int s : v) {
+            if (s < 0) continue;
+            lo = std::min(lo, s);
+            hi = std::max(hi, s);
+        }
+    };
+    int sy0, sy1, sx0, sx1;
+    bounds(rows, sy0, sy1);
+    bounds(cols, sx0, sx1);
+    const ImageU8 src = assemble(sy0, sx0, sy1 - sy0 + 1, sx1 - sx0 + 1);
+
+    const int c = info_.c;
+    // 中間照原順序的那一段（就是影像內的部分）整段複製
+    const int in0 = std::max(0, -ex), in1 = std::min(ew, info_.w - ex);
+    ImageU8 out(eh, ew, c, Init::None);
+    for (int oy = 0; oy < eh; ++oy) {
+        uint8_t* d = out.row(oy);
+        if (rows[oy] < 0) {
+            std::memset(d, border_value, static_cast<std::size_t>(ew) * c);
+            continue;
+        }
+        const uint8_t* s = src.row(rows[oy] - sy0);
+        for (int ox = 0; ox < ew; ++ox) {
+            if (ox == in0 && in1 > in0) {
+                std::memcpy(d + static_cast<std::size_t>(ox) * c,
+                            s + static_cast<std::size_t>(ex + ox - sx0) * c,
+                            static_cast<std::size_t>(in1 - in0) * c);
+                ox = in1 - 1;
+                continue;
+            }
+            uint8_t* dp = d + static_cast<std::size_t>(ox) * c;
+            if (cols[ox] < 0) {
+                std::memset(dp, border_value, static_cast<std::size_t>(c));
+            } else {
+                std::memcpy(dp, s + static_cast<std::size_t>(cols[ox] - sx0) * c, static_cast<std::size_t>(c));
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace pf
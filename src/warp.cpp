@@ -0,0 +1,806 @@
+#include "pixfoundry/warp.hpp"
+#include "pixfoundry/autotune.hpp"
+#include "pixfoundry/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace pf {
+
+// ============================================================
+// 座標格式
+// ============================================================
+//
+// 來源座標用 Q24 fixed-point（int64）累加：整數部分 = 讀哪個 pixel，
+// 小數取最高 8 bits 當內插權重（1/256 pixel）。
+// 每個輸出 pixel 展開成 (ix, iy, frac) 放進 buffer，之後的取樣只看這三個值。
+
+static constexpr int     kCoordShift = 24;
+static constexpr double  kCoordScale = static_cast<double>(int64_t(1) << kCoordShift);
+static constexpr int     kFracBits   = 8;
+static constexpr int     kFracOne    = 1 << kFracBits;
+static constexpr double  kCoordLimit = 1073741824.0;  // 2^30：超過就飽和（反正一定在影像外）
+
+static constexpr int kTileH = 32;
+static constexpr int kTileW = 256;
+
+static inline int64_t to_fixed(double v) {
+    v = std::clamp(v, -kCoordLimit, kCoordLimit);
+    return static_cast<int64_t>(v * kCoordScale);
+}
+
+// 每種內插法讀的 taps 範圍（相對於 ix / iy）
+struct TapRange {
+    int lo, hi;
+};
+
+static TapRange tap_range(Interp interp) {
+    switch (interp) {
+    case Interp::Nearest: return {0, 0};
+    case Interp::Bicubic: return {-1, 2};
+    default:              return {0, 1};
+    }
+}
+
+// ============================================================
+// Bicubic 權重表（Keys a = -0.5，跟 resize 一樣），Q10，每列總和 1024
+// ============================================================
+
+static constexpr int kCubicShift = 10;
+
+struct CubicTable {
+    int16_t w[kFracOne][4];
+
+    CubicTable() {
+        const double a = -0.5;
+        for (int f = 0; f < kFracOne; ++f) {
+            const double t = static_cast<double>(f) / kFracOne;
+            const double d[4] = {1.0 + t, t, 1.0 - t, 2.0 - t};
+            int sum = 0;
+            for (int k = 0; k < 4; ++k) {
+                const double x = d[k];
+                double v;
+                if (x < 1.0) v = ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+                else         v = (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+                w[f][k] = static_cast<int16_t>(std::lround(v * (1 << kCubicShift)));
+                sum += w[f][k];
+            }
+            // 誤差補到中間兩個權重比較大的那個
+            const int kmax = (t < 0.5) ? 1 : 2;
+            w[f][kmax] = static_cast<int16_t>(w[f][kmax] + ((1 << kCubicShift) - sum));
+        }
+    }
+};
+
+static const CubicTable& cubic_table() {
+    static const CubicTable table;
+    return table;
+}
+
+// ============================================================
+// 取樣：快路徑（所有 taps 都在影像內，不做任何檢查）
+// ============================================================
+
+template <int C, Interp I>
+static void sample_interior(const uint8_t* in, std::size_t stride,
+                            const int32_t* bx, const int32_t* by, const uint16_t* bf,
+                            int n, uint8_t* out) {
+    for (int k = 0; k < n; ++k) {
+        uint8_t* o = out + static_cast<std::size_t>(k) * C;
+        const uint8_t* p = in + static_cast<std::size_t>(by[k]) * stride
+                              + static_cast<std::size_t>(bx[k]) * C;
+
+        if (I == Interp::Nearest) {
+            for (int c = 0; c < C; ++c) o[c] = p[c];
+        } else if (I == Interp::Bilinear) {
+            const int fx = bf[k] & (kFracOne - 1);
+            const int fy = bf[k] >> kFracBits;
+            for (int c = 0; c < C; ++c) {
+                const int top = p[c] * (kFracOne - fx) + p[c + C] * fx;
+                const int bot = p[stride + c] * (kFracOne - fx) + p[stride + c + C] * fx;
+                o[c] = static_cast<uint8_t>((top * (kFracOne - fy) + bot * fy + (1 << 15)) >> 16);
+            }
+        } else {
+            const int16_t* wx = cubic_table().w[bf[k] & (kFracOne - 1)];
+            const int16_t* wy = cubic_table().w[bf[k] >> kFracBits];
+            const uint8_t* p0 = p - stride - C;
+            for (int c = 0; c < C; ++c) {
+                int acc = 0;
+                for (int j = 0; j < 4; ++j) {
+                    const uint8_t* r = p0 + j * stride + c;
+                    const int row = wx[0] * r[0] + wx[1] * r[C] + wx[2] * r[2 * C] + wx[3] * r[3 * C];
+                    acc += wy[j] * row;
+                }
+                acc = (acc + (1 << (2 * kCubicShift - 1))) >> (2 * kCubicShift);
+                o[c] = static_cast<uint8_t>(std::clamp(acc, 0, 255));
+            }
+        }
+    }
+}
+
+// ============================================================
+// 取樣：慢路徑（逐 tap 處理邊界）
+// ============================================================
+
+template <int C, Interp I>
+static void sample_border(const uint8_t* in, std::size_t stride, int H, int W,
+                          const int32_t* bx, const int32_t* by, const uint16_t* bf,
+                          int n, uint8_t* out,
+                          Border border, uint8_t border_value) {
+    constexpr int T = (I == Interp::Nearest) ? 1 : (I == Interp::Bilinear) ? 2 : 4;
+    constexpr int off = (I == Interp::Bicubic) ? -1 : 0;
+
+    for (int k = 0; k < n; ++k) {
+        uint8_t* o = out + static_cast<std::size_t>(k) * C;
+
+        int wx[T], wy[T], xs[T], ys[T];
+        int shift = 0;
+        if (I == Interp::Nearest) {
+            wx[0] = wy[0] = 1;
+        } else if (I == Interp::Bilinear) {
+            const int fx = bf[k] & (kFracOne - 1);
+            const int fy = bf[k] >> kFracBits;
+            wx[0] = kFracOne - fx; wx[1] = fx;
+            wy[0] = kFracOne - fy; wy[1] = fy;
+            shift = 2 * kFracBits;
+        } else {
+            const int16_t* cx = cubic_table().w[bf[k] & (kFracOne - 1)];
+            const int16_t* cy = cubic_table().w[bf[k] >> kFracBits];
+            for (int t = 0; t < T; ++t) { wx[t] = cx[t]; wy[t] = cy[t]; }
+            shift = 2 * kCubicShift;
+        }
+        // taps 可能離影像很遠：reflect / wrap 要能繞好幾圈，Constant 的影像外是 -1
+        for (int t = 0; t < T; ++t) {
+            xs[t] = border_fold(bx[k] + off + t, W, border);
+            ys[t] = border_fold(by[k] + off + t, H, border);
+        }
+
+        for (int c = 0; c < C; ++c) {
+            int acc = 0;
+            for (int j = 0; j < T; ++j) {
+                int row = 0;
+                for (int i = 0; i < T; ++i) {
+                    const int v = (xs[i] < 0 || ys[j] < 0)
+                        ? border_value
+                        : in[static_cast<std::size_t>(ys[j]) * stride + static_cast<std::size_t>(xs[i]) * C + c];
+                    row += wx[i] * v;
+                }
+                acc += wy[j] * row;
+            }
+            if (shift > 0) acc = (acc + (1 << (shift - 1))) >> shift;
+            o[c] = static_cast<uint8_t>(std::clamp(acc, 0, 255));
+        }
+    }
+}
+
+// ============================================================
+// 座標產生：dst → src 的 3x3 矩陣（仿射時第三列是 0 0 1）
+// ============================================================
+
+struct WarpMatrix {
+    double m[9];
+    bool perspective;
+};
+
+// 一列輸出 [x0, x1) 的來源座標寫進 buffer
+static void fill_coords(const WarpMatrix& M, int y, int x0, int x1, bool nearest,
+                        int32_t* bx, int32_t* by, uint16_t* bf) {
+    const int n = x1 - x0;
+    const int64_t round = nearest ? (int64_t(1) << (kCoordShift - 1)) : 0;
+    const int frac_shift = kCoordShift - kFracBits;
+
+    if (!M.perspective) {
+        // 仿射：沿著 row 只要整數加法
+        int64_t X = to_fixed(M.m[0] * x0 + M.m[1] * y + M.m[2]) + round;
+        int64_t Y = to_fixed(M.m[3] * x0 + M.m[4] * y + M.m[5]) + round;
+        const int64_t DX = to_fixed(std::clamp(M.m[0], -2097152.0, 2097152.0));
+        const int64_t DY = to_fixed(std::clamp(M.m[3], -2097152.0, 2097152.0));
+        for (int k = 0; k < n; ++k) {
+            bx[k] = static_cast<int32_t>(X >> kCoordShift);
+            by[k] = static_cast<int32_t>(Y >> kCoordShift);
+            bf[k] = static_cast<uint16_t>((((Y >> frac_shift) & (kFracOne - 1)) << kFracBits)
+                                          | ((X >> frac_shift) & (kFracOne - 1)));
+            X += DX;
+            Y += DY;
+        }
+        return;
+    }
+
+    // 透視：分子、分母沿著 row 累加，每點一次除法
+    double nx = M.m[0] * x0 + M.m[1] * y + M.m[2];
+    double ny = M.m[3] * x0 + M.m[4] * y + M.m[5];
+    double nw = M.m[6] * x0 + M.m[7] * y + M.m[8];
+    for (int k = 0; k < n; ++k) {
+        int64_t X, Y;
+        if (nw > 1e-12) {
+            const double inv = 1.0 / nw;
+            X = to_fixed(nx * inv) + round;
+            Y = to_fixed(ny * inv) + round;
+        } else {
+            // 在相機後面：當成影像外
+            X = Y = to_fixed(-kCoordLimit);
+        }
+        bx[k] = static_cast<int32_t>(X >> kCoordShift);
+        by[k] = static_cast<int32_t>(Y >> kCoordShift);
+        bf[k] = static_cast<uint16_t>((((Y >> frac_shift) & (kFracOne - 1)) << kFracBits)
+                                      | ((X >> frac_shift) & (kFracOne - 1)));
+        nx += M.m[0];
+        ny += M.m[3];
+        nw += M.m[6];
+    }
+}
+
+// A x + B >= 0 → 收緊 [lo, hi]
+static void clip_linear(double A, double B, double& lo, double& hi) {
+    if (A > 0.0)      lo = std::max(lo, -B / A);
+    else if (A < 0.0) hi = std::min(hi, -B / A);
+    else if (B < 0.0) { lo = 1.0; hi = 0.0; }
+}
+
+// 直接解出一列裡「所有 taps 都在影像內」的 x 區間（可能是空的），再跟 [x0, x1) 取交集
+// sx = (a x + b) / (c x + d)，在 w > 0 時 L <= sx < U 都是 x 的一次不等式
+static void interior_span(const WarpMatrix& M, int y, int x0, int x1,
+                          double Lx, double Ux, double Ly, double Uy,
+                          int& xa, int& xb) {
+    const double eps = 1e-3;  // 留一點餘量給 fixed-point 捨入，端點之後會再用實際座標確認
+    Lx += eps; Ux -= eps; Ly += eps; Uy -= eps;
+
+    const double ax = M.m[0], bxv = M.m[1] * y + M.m[2];
+    const double ay = M.m[3], byv = M.m[4] * y + M.m[5];
+    const double c  = M.m[6], d   = M.m[7] * y + M.m[8];
+
+    double lo = x0, hi = x1 - 1;
+    if (Lx > Ux || Ly > Uy) { xa = xb = x0; return; }
+    clip_linear(c, d - 1e-9, lo, hi);               // w > 0
+    clip_linear(ax - Lx * c, bxv - Lx * d, lo, hi); // sx >= Lx
+    clip_linear(Ux * c - ax, Ux * d - bxv, lo, hi); // sx <= Ux
+    clip_linear(ay - Ly * c, byv - Ly * d, lo, hi);
+    clip_linear(Uy * c - ay, Uy * d - byv, lo, hi);
+
+    if (!(lo <= hi)) { xa = xb = x0; return; }
+    xa = static_cast<int>(std::ceil(std::max(lo, static_cast<double>(x0))));
+    xb = static_cast<int>(std::floor(std::min(hi, static_cast<double>(x1 - 1)))) + 1;
+    if (xb < xa) xb = xa;
+}
+
+template <int C, Interp I>
+static void warp_run(const ImageU8& src, ImageU8& dst, const WarpMatrix& M,
+                     Border border, uint8_t border_value, Backend exec) {
+    const int H = src.h(), W = src.w();
+    const int Ho = dst.h(), Wo = dst.w();
+    const std::size_t in_stride  = src.stride();
+    const std::size_t out_stride = dst.stride();
+    const uint8_t* in = src.data();
+    uint8_t* out = dst.data();
+
+    const TapRange r = tap_range(I);
+    // 來源座標的安全範圍（nearest 是四捨五入，所以多半個 pixel）
+    const double half = (I == Interp::Nearest) ? 0.5 : 0.0;
+    const double Lx = -r.lo - half, Ux = (W - 1) - r.hi + half + (I == Interp::Nearest ? 0.0 : 1.0);
+    const double Ly = -r.lo - half, Uy = (H - 1) - r.hi + half + (I == Interp::Nearest ? 0.0 : 1.0);
+
+    auto inside = [&](int32_t x, int32_t y) {
+        return x + r.lo >= 0 && x + r.hi <= W - 1 && y + r.lo >= 0 && y + r.hi <= H - 1;
+    };
+
+    const int tiles_y = (Ho + kTileH - 1) / kTileH;
+    const int tiles_x = (Wo + kTileW - 1) / kTileW;
+    const int tiles   = tiles_y * tiles_x;
+
+    // 平行的單位是 tile（不是 row）：每塊各自有座標暫存
+    const std::size_t tile_bytes = static_cast<std::size_t>(kTileH) * kTileW * (C + 10);
+    parallel_rows(tiles, exec, tile_bytes, [&](int t0, int t1) {
+        std::vector<int32_t>  bx(kTileW), by(kTileW);
+        std::vector<uint16_t> bf(kTileW);
+
+        for (int t = t0; t < t1; ++t) {
+            const int ty0 = (t / tiles_x) * kTileH;
+            const int tx0 = (t % tiles_x) * kTileW;
+            const int ty1 = std::min(ty0 + kTileH, Ho);
+            const int tx1 = std::min(tx0 + kTileW, Wo);
+
+            for (int y = ty0; y < ty1; ++y) {
+                fill_coords(M, y, tx0, tx1, I == Interp::Nearest, bx.data(), by.data(), bf.data());
+
+                int xa, xb;
+                interior_span(M, y, tx0, tx1, Lx, Ux, Ly, Uy, xa, xb);
+                while (xa < xb && !inside(bx[xa - tx0], by[xa - tx0])) ++xa;
+                while (xb > xa && !inside(bx[xb - 1 - tx0], by[xb - 1 - tx0])) --xb;
+
+                uint8_t* orow = out + static_cast<std::size_t>(y) * out_stride;
+                auto slow = [&](int a, int b) {
+                    if (b <= a) return;
+                    const int k = a - tx0;
+                    sample_border<C, I>(in, in_stride, H, W, bx.data() + k, by.data() + k, bf.data() + k,
+                                        b - a, orow + static_cast<std::size_t>(a) * C,
+                                        border, border_value);
+                };
+                slow(tx0, xa);
+                if (xb > xa) {
+                    const int k = xa - tx0;
+                    sample_interior<C, I>(in, in_stride, bx.data() + k, by.data() + k, bf.data() + k,
+                                          xb - xa, orow + static_cast<std::size_t>(xa) * C);
+                }
+                slow(xb, tx1);
+            }
+        }
+    });
+}
+
+template <int C>
+static void warp_dispatch_interp(const ImageU8& src, ImageU8& dst, const WarpMatrix& M,
+                                 Interp interp, Border border, uint8_t border_value, Backend exec) {
+    switch (interp) {
+    case Interp::Nearest:
+        warp_run<C, Interp::Nearest>(src, dst, M, border, border_value, exec);
+        break;
+    case Interp::Bilinear:
+        warp_run<C, Interp::Bilinear>(src, dst, M, border, border_value, exec);
+        break;
+    case Interp::Bicubic:
+        warp_run<C, Interp::Bicubic>(src, dst, M, border, border_value, exec);
+        break;
+    default:
+        throw std::invalid_argument("warp: interpolation must be nearest, bilinear or bicubic");
+    }
+}
+
+// 每個輸出 pixel-channel 的成本（bytes 比較高：來源存取不是連續的）
+OpCost warp_cost(Interp interp, bool perspective) {
+    float ops = (interp == Interp::Nearest) ? 1.0f : (interp == Interp::Bicubic) ? 12.0f : 4.0f;
+    if (perspective) ops += 3.0f;
+    return {3.0f, ops, 1};
+}
+
+// dst 決定輸出大小
+static void warp_impl(const ImageU8& src, ImageU8& dst, const WarpMatrix& M,
+                      Interp interp, Border border, Backend backend, uint8_t border_value,
+                      const char* name) {
+    if (src.empty()) throw std::invalid_argument(std::string(name) + ": empty image");
+    if (dst.empty()) throw std::invalid_argument(std::string(name) + ": invalid output size");
+    check_output(dst, dst.h(), dst.w(), src.c(), name);
+    check_no_overlap(src, dst, name);
+    if (interp != Interp::Nearest && interp != Interp::Bilinear && interp != Interp::Bicubic) {
+        throw std::invalid_argument(std::string(name) + ": interpolation must be nearest, bilinear or bicubic");
+    }
+    for (double v : M.m) {
+        if (!std::isfinite(v)) throw std::invalid_argument(std::string(name) + ": matrix must be finite");
+    }
+
+    ExecPlan plan = plan_execution(backend, warp_cost(interp, M.perspective),
+                                         static_cast<std::size_t>(dst.h()) * dst.w() * src.c());
+    ThreadScope threads(plan);
+    const Backend exec = plan.backend;
+
+    if (src.c() == 1) warp_dispatch_interp<1>(src, dst, M, interp, border, border_value, exec);
+    else              warp_dispatch_interp<3>(src, dst, M, interp, border, border_value, exec);
+}
+
+static ImageU8 warp_alloc(const ImageU8& src, const WarpMatrix& M, int out_h, int out_w,
+                          Interp interp, Border border, Backend backend, uint8_t border_value,
+                          const char* name) {
+    if (src.empty()) throw std::invalid_argument(std::string(name) + ": empty image");
+    if (out_h <= 0 || out_w <= 0) throw std::invalid_argument(std::string(name) + ": invalid output size");
+    ImageU8 dst(out_h, out_w, src.c(), Init::None);
+    warp_impl(src, dst, M, interp, border, backend, border_value, name);
+    return dst;
+}
+
+// ============================================================
+// 對外 API
+// ============================================================
+
+// 統一轉成 dst → src 的矩陣
+static WarpMatrix affine_matrix(const std::array<double, 6>& M, bool inverse_map) {
+    WarpMatrix W{{M[0], M[1], M[2], M[3], M[4], M[5], 0.0, 0.0, 1.0}, false};
+    if (!inverse_map) {
+        // src → dst 轉成 dst → src
+        const double det = M[0] * M[4] - M[1] * M[3];
+        if (std::fabs(det) < 1e-12) throw std::invalid_argument("warp_affine: matrix is singular");
+        const double a =  M[4] / det, b = -M[1] / det;
+        const double d = -M[3] / det, e =  M[0] / det;
+        W.m[0] = a; W.m[1] = b; W.m[2] = -(a * M[2] + b * M[5]);
+        W.m[3] = d; W.m[4] = e; W.m[5] = -(d * M[2] + e * M[5]);
+    }
+    return W;
+}
+
+static WarpMatrix perspective_matrix(const std::array<double, 9>& M, bool inverse_map) {
+    WarpMatrix W{{M[0], M[1], M[2], M[3], M[4], M[5], M[6], M[7], M[8]}, true};
+    if (!inverse_map) {
+        // 3x3 反矩陣（adjugate / det）
+        const double* m = M.data();
+        const double c00 = m[4] * m[8] - m[5] * m[7];
+        const double c01 = m[5] * m[6] - m[3] * m[8];
+        const double c02 = m[3] * m[7] - m[4] * m[6];
+        const double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+        if (std::fabs(det) < 1e-12) throw std::invalid_argument("warp_perspective: matrix is singular");
+        const double inv = 1.0 / det;
+        W.m[0] = c00 * inv;
+        W.m[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+        W.m[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+        W.m[3] = c01 * inv;
+        W.m[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+        W.m[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+        W.m[6] = c02 * inv;
+        W.m[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+        W.m[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+    }
+    return W;
+}
+
+ImageU8 warp_affine(const ImageU8& src,
+                    const std::array<double, 6>& M,
+                    int out_h,
+                    int out_w,
+                    Interp interp,
+                    Border border,
+                    Backend backend,
+                    uint8_t border_value,
+                    bool inverse_map) {
+    return warp_alloc(src, affine_matrix(M, inverse_map), out_h, out_w,
+                      interp, border, backend, border_value, "warp_affine");
+}
+
+void warp_affine(const ImageU8& src,
+                 ImageU8& dst,
+                 const std::array<double, 6>& M,
+                 Interp interp,
+                 Border border,
+                 Backend backend,
+                 uint8_t border_value,
+                 bool inverse_map) {
+    warp_impl(src, dst, affine_matrix(M, inverse_map),
+              interp, border, backend, border_value, "warp_affine");
+}
+
+ImageU8 warp_perspective(const ImageU8& src,
+                         const std::array<double, 9>& M,
+                         int out_h,
+                         int out_w,
+                         Interp interp,
+                         Border border,
+                         Backend backend,
+                         uint8_t border_value,
+                         bool inverse_map) {
+    return warp_alloc(src, perspective_matrix(M, inverse_map), out_h, out_w,
+                      interp, border, backend, border_value, "warp_perspective");
+}
+
+void warp_perspective(const ImageU8& src,
+                      ImageU8& dst,
+                      const std::array<double, 9>& M,
+                      Interp interp,
+                      Border border,
+                      Backend backend,
+                      uint8_t border_value,
+                      bool inverse_map) {
+    warp_impl(src, dst, perspective_matrix(M, inverse_map),
+              interp, border, backend, border_value, "warp_perspective");
+}
+
+// ============================================================
+// remap
+// ============================================================
+
+static constexpr int kMapLimit = 32767;
+
+RemapMap make_remap_map(const float* map_x,
+                        const float* map_y,
+                        int h,
+                        int w) {
+    if (!map_x || !map_y || h <= 0 || w <= 0) {
+        throw std::invalid_argument("make_remap_map: invalid map");
+    }
+    RemapMap m;
+    m.h = h;
+    m.w = w;
+    const std::size_t n = static_cast<std::size_t>(h) * w;
+    m.xy.resize(2 * n);
+    m.frac.resize(n);
+
+    // 四捨五入到 1/256 pixel；NaN 或太遠的座標一律飽和到 int16 邊界（一定在影像外）
+    const double lim = static_cast<double>(kMapLimit) - 1.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double vx = map_x[i], vy = map_y[i];
+        if (!std::isfinite(vx)) vx = -lim;
+        if (!std::isfinite(vy)) vy = -lim;
+        const int X = static_cast<int>(std::floor(std::clamp(vx, -lim, lim) * kFracOne + 0.5));
+        const int Y = static_cast<int>(std::floor(std::clamp(vy, -lim, lim) * kFracOne + 0.5));
+        m.xy[2 * i]     = static_cast<int16_t>(X >> kFracBits);
+        m.xy[2 * i + 1] = static_cast<int16_t>(Y >> kFracBits);
+        m.frac[i] = static_cast<uint16_t>(((Y & (kFracOne - 1)) << kFracBits) | (X & (kFracOne - 1)));
+    }
+    return m;
+}
+
+// 一段已經展開的座標：把連續「全部 taps 在內」的 run 丟給快路徑，其他走慢路徑
+template <int C, Interp I>
+static void sample_runs(const uint8_t* in, std::size_t stride, int H, int W,
+                        const int32_t* bx, const int32_t* by, const uint16_t* bf,
+                        int n, uint8_t* out, Border border, uint8_t border_value) {
+    const TapRange r = tap_range(I);
+    auto inside = [&](int k) {
+        return bx[k] + r.lo >= 0 && bx[k] + r.hi <= W - 1 && by[k] + r.lo >= 0 && by[k] + r.hi <= H - 1;
+    };
+
+    int k = 0;
+    while (k < n) {
+        const bool in_run = inside(k);
+        int e = k + 1;
+        while (e < n && inside(e) == in_run) ++e;
+        uint8_t* o = out + static_cast<std::size_t>(k) * C;
+        if (in_run) {
+            sample_interior<C, I>(in, stride, bx + k, by + k, bf + k, e - k, o);
+        } else {
+            sample_border<C, I>(in, stride, H, W, bx + k, by + k, bf + k, e - k, o, border, border_value);
+        }
+        k = e;
+    }
+}
+
+template <int C, Interp I>
+static void remap_run(const ImageU8& src, ImageU8& dst, const RemapMap& map,
+                      Border border, uint8_t border_value, Backend exec) {
+    const int H = src.h(), W = src.w();
+    const int Ho = dst.h(), Wo = dst.w();
+    const std::size_t in_stride  = src.stride();
+    const std::size_t out_stride = dst.stride();
+    const uint8_t* in = src.data();
+    uint8_t* out = dst.data();
+
+    const int tiles_y = (Ho + kTileH - 1) / kTileH;
+    const int tiles_x = (Wo + kTileW - 1) / kTileW;
+    const int tiles   = tiles_y * tiles_x;
+
+    // 平行的單位是 tile（不是 row）：每塊各自有座標暫存
+    const std::size_t tile_bytes = static_cast<std::size_t>(kTileH) * kTileW * (C + 10);
+    parallel_rows(tiles, exec, tile_bytes, [&](int t0, int t1) {
+        std::vector<int32_t>  bx(kTileW), by(kTileW);
+        std::vector<uint16_t> bf(kTileW);
+
+        for (int t = t0; t < t1; ++t) {
+            const int ty0 = (t / tiles_x) * kTileH;
+            const int tx0 = (t % tiles_x) * kTileW;
+            const int ty1 = std::min(ty0 + kTileH, Ho);
+            const int tx1 = std::min(tx0 + kTileW, Wo);
+            const int n = tx1 - tx0;
+
+            for (int y = ty0; y < ty1; ++y) {
+                const std::size_t base = static_cast<std::size_t>(y) * Wo + tx0;
+                const int16_t*  mxy = map.xy.data() + 2 * base;
+                const uint16_t* mf  = map.frac.data() + base;
+                for (int k = 0; k < n; ++k) {
+                    bx[k] = mxy[2 * k];
+                    by[k] = mxy[2 * k + 1];
+                    bf[k] = mf[k];
+                    if (I == Interp::Nearest) {
+                        // 小數 >= 0.5 就進位
+                        bx[k] += (mf[k] >> (kFracBits - 1)) & 1;
+                        by[k] += mf[k] >> (2 * kFracBits - 1);
+                    }
+                }
+                sample_runs<C, I>(in, in_stride, H, W, bx.data(), by.data(), bf.data(), n,
+                                  out + static_cast<std::size_t>(y) * out_stride + static_cast<std::size_t>(tx0) * C,
+                                  border, border_value);
+            }
+        }
+    });
+}
+
+template <int C>
+static void remap_dispatch_interp(const ImageU8& src, ImageU8& dst, const RemapMap& map,
+                                  Interp interp, Border border, uint8_t border_value, Backend exec) {
+    switch (interp) {
+    case Interp::Nearest:
+        remap_run<C, Interp::Nearest>(src, dst, map, border, border_value, exec);
+        break;
+    case Interp::Bilinear:
+        remap_run<C, Interp::Bilinear>(src, dst, map, border, border_value, exec);
+        break;
+    case Interp::Bicubic:
+        remap_run<C, Interp::Bicubic>(src, dst, map, border, border_value, exec);
+        break;
+    default:
+        throw std::invalid_argument("remap: interpolation must be nearest, bilinear or bicubic");
+    }
+}
+
+static void check_remap_map(const RemapMap& map) {
+    if (map.h <= 0 || map.w <= 0 ||
+        map.xy.size() != 2 * static_cast<std::size_t>(map.h) * map.w ||
+        map.frac.size() != static_cast<std::size_t>(map.h) * map.w) {
+        throw std::invalid_argument("remap: invalid map");
+    }
+}
+
+void remap(const ImageU8& src,
+           ImageU8& dst,
+           const RemapMap& map,
+           Interp interp,
+           Border border,
+           Backend backend,
+           uint8_t border_value) {
+    if (src.empty()) throw std::invalid_argument("remap: empty image");
+    check_remap_map(map);
+    check_output(dst, map.h, map.w, src.c(), "remap");
+    check_no_overlap(src, dst, "remap");
+    if (src.h() >= kMapLimit || src.w() >= kMapLimit) {
+        throw std::invalid_argument("remap: source must be smaller than 32767 x 32767");
+    }
+    if (interp != Interp::Nearest && interp != Interp::Bilinear && interp != Interp::Bicubic) {
+        throw std::invalid_argument("remap: interpolation must be nearest, bilinear or bicubic");
+    }
+
+    // 比 warp 少了座標計算，多讀一次 map（6 bytes / pixel）
+    OpCost cost = warp_cost(interp, false);
+    cost.bytes_per_elem += 6.0f / src.c();
+    ExecPlan plan = plan_execution(backend, cost, static_cast<std::size_t>(map.h) * map.w * src.c());
+    ThreadScope threads(plan);
+    const Backend exec = plan.backend;
+
+    if (src.c() == 1) remap_dispatch_interp<1>(src, dst, map, interp, border, border_value, exec);
+    else              remap_dispatch_interp<3>(src, dst, map, interp, border, border_value, exec);
+}
+
+ImageU8 remap(const ImageU8& src,
+              const RemapMap& map,
+              Interp interp,
+              Border border,
+              Backend backend,
+              uint8_t border_value) {
+    if (src.empty()) throw std::invalid_argument("remap: empty image");
+    check_remap_map(map);
+    ImageU8 dst(map.h, map.w, src.c(), Init::None);
+    remap(src, dst, map, interp, border, backend, border_value);
+    return dst;
+}
+
+// ============================================================
+// Brown–Conrady 去畸變表（依參數 hash 快取）
+// ============================================================
+
+struct UndistortKey {
+    LensModel lens;
+    int h = 0, w = 0;
+
+    bool operator==(const UndistortKey& o) const {
+        const LensModel& a = lens;
+        const LensModel& b = o.lens;
+        return a.fx == b.fx && a.fy == b.fy && a.cx == b.cx && a.cy == b.cy &&
+               a.k1 == b.k1 && a.k2 == b.k2 && a.k3 == b.k3 && a.p1 == b.p1 && a.p2 == b.p2 &&
+               h == o.h && w == o.w;
+    }
+};
+
+static std::size_t hash_key(const UndistortKey& k) {
+    const double v[9] = {k.lens.fx, k.lens.fy, k.lens.cx, k.lens.cy,
+                         k.lens.k1, k.lens.k2, k.lens.k3, k.lens.p1, k.lens.p2};
+    std::size_t h = std::hash<int>()(k.h) * 31 + std::hash<int>()(k.w);
+    for (double d : v) {
+        h ^= std::hash<double>()(d) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+struct UndistortEntry {
+    std::size_t hash;
+    UndistortKey key;
+    std::shared_ptr<const RemapMap> map;
+};
+
+static constexpr std::size_t kUndistortCacheCap = 8;
+static std::mutex                  g_undistort_mutex;
+static std::vector<UndistortEntry> g_undistort_cache;  // 最近用過的放最後面
+
+static std::shared_ptr<RemapMap> build_undistort_map(const LensModel& L, int h, int w) {
+    auto m = std::make_shared<RemapMap>();
+    m->h = h;
+    m->w = w;
+    const std::size_t n = static_cast<std::size_t>(h) * w;
+    m->xy.resize(2 * n);
+    m->frac.resize(n);
+
+    const double lim = static_cast<double>(kMapLimit) - 1.0;
+
+    // 對每個輸出（無畸變）pixel：正規化 → 套畸變模型 → 回到 pixel 座標
+    // 這裡沒有 backend 參數，team 大小至少不超過全行程的 thread 預算
+#ifdef PF_HAS_OPENMP
+#pragma omp parallel for schedule(static) num_threads(max_threads())
+#endif
+    for (int y = 0; y < h; ++y) {
+        const double yn = (y - L.cy) / L.fy;
+        for (int x = 0; x < w; ++x) {
+            const double xn = (x - L.cx) / L.fx;
+            const double r2 = xn * xn + yn * yn;
+            const double radial = 1.0 + r2 * (L.k1 + r2 * (L.k2 + r2 * L.k3));
+            const double xd = xn * radial + 2.0 * L.p1 * xn * yn + L.p2 * (r2 + 2.0 * xn * xn);
+            const double yd = yn * radial + L.p1 * (r2 + 2.0 * yn * yn) + 2.0 * L.p2 * xn * yn;
+
+            double sx = L.fx * xd + L.cx;
+            double sy = L.fy * yd + L.cy;
+            if (!std::isfinite(sx)) sx = -lim;
+            if (!std::isfinite(sy)) sy = -lim;
+            const int X = static_cast<int>(std::floor(std::clamp(sx, -lim, lim) * kFracOne + 0.5));
+            const int Y = static_cast<int>(std::floor(std::clamp(sy, -lim, lim) * kFracOne + 0.5));
+
+            const std::size_t i = static_cast<std::size_t>(y) * w + x;
+            m->xy[2 * i]     = static_cast<int16_t>(X >> kFracBits);
+            m->xy[2 * i + 1] = static_cast<int16_t>(Y >> kFracBits);
+            m->frac[i] = static_cast<uint16_t>(((Y & (kFracOne - 1)) << kFracBits) | (X & (kFracOne - 1)));
+        }
+    }
+    return m;
+}
+
+std::shared_ptr<const RemapMap> undistort_map(const LensModel& lens,
+                                              int h,
+                                              int w) {
+    if (h <= 0 || w <= 0) throw std::invalid_argument("undistort_map: invalid size");
+    if (!(lens.fx != 0.0 && lens.fy != 0.0) || !std::isfinite(lens.fx) || !std::isfinite(lens.fy)) {
+        throw std::invalid_argument("undistort_map: focal length must be non-zero");
+    }
+
+    UndistortKey key;
+    key.lens = lens;
+    key.h = h;
+    key.w = w;
+    const std::size_t hv = hash_key(key);
+
+    {
+        std::lock_guard<std::mutex> lock(g_undistort_mutex);
+        for (std::size_t i = 0; i < g_undistort_cache.size(); ++i) {
+            if (g_undistort_cache[i].hash == hv && g_undistort_cache[i].key == key) {
+                UndistortEntry e = g_undistort_cache[i];
+                g_undistort_cache.erase(g_undistort_cache.begin() + static_cast<std::ptrdiff_t>(i));
+                g_undistort_cache.push_back(e);
+                return e.map;
+            }
+        }
+    }
+
+    // 在鎖外面建表（可能花一點時間）；兩個 thread 同時建同一張也只是多算一次
+    std::shared_ptr<const RemapMap> map = build_undistort_map(lens, h, w);
+
+    std::lock_guard<std::mutex> lock(g_undistort_mutex);
+    if (g_undistort_cache.size() >= kUndistortCacheCap) {
+        g_undistort_cache.erase(g_undistort_cache.begin());
+    }
+    g_undistort_cache.push_back({hv, key, map});
+    return map;
+}
+
+ImageU8 undistort(const ImageU8& src,
+                  const LensModel& lens,
+                  Interp interp,
+                  Border border,
+                  Backend backend,
+                  uint8_t border_value) {
+    if (src.empty()) throw std::invalid_argument("undistort: empty image");
+    std::shared_ptr<const RemapMap> map = undistort_map(lens, src.h(), src.w());
+    return remap(src, *map, interp, border, backend, border_value);
+}
+
+void undistort(const ImageU8& src,
+               ImageU8& dst,
+               const LensModel& lens,
+               Interp interp,
+               Border border,
+               Backend backend,
+               uint8_t border_value) {
+    if (src.empty()) throw std::invalid_argument("undistort: empty image");
+    std::shared_ptr<const RemapMap> map = undistort_map(lens, src.h(), src.w());
+    remap(src, dst, *map, interp, border, backend, border_value);
+}
+
+void clear_undistort_cache() {
+    std::lock_guard<std::mutex> lock(g_undistort_mutex);
+    g_undistort_cache.clear();
+}
+
+} // namespace pf
@@ -40,6 +40,7 @@ def backends(pf):
     b = ["single"]
     if _has_openmp_backend(pf):
         b.append("openmp")
+    b.append("threadpool")  # 不依賴 OpenMP，一定有
     return b
 
 
@@ -171,6 +171,20 @@ def test_resize_bilinear_against_opencv(pf, backends):
     _assert_close_u8(out_pf, out_cv, atol=2, msg="resize bilinear")
 
 
+def test_resize_area_against_opencv(pf, backends):
+    rng = np.random.default_rng(6)
+    src = rng.integers(0, 256, size=(96, 120, 3), dtype=np.uint8)
+
+    for (new_h, new_w) in [(24, 30), (31, 47)]:
+        out_pf = pf.resize(src, height=new_h, width=new_w, backend=backends[0], interpolation="area")
+        for b in backends[1:]:
+            out_pf_omp = pf.resize(src, height=new_h, width=new_w, backend=b, interpolation="area")
+            assert np.array_equal(out_pf_omp, out_pf), f"single vs {b} mismatch (resize area)"
+
+        out_cv = cv2.resize(src, (new_w, new_h), interpolation=cv2.INTER_AREA)
+        _assert_close_u8(out_pf, out_cv, atol=1, msg="resize area")
+
+
 def test_rotate_against_opencv(pf, backends):
     rng = np.random.default_rng(5)
     src = rng.integers(0, 256, size=(32, 33, 3), dtype=np.uint8)
@@ -210,3 +224,70 @@ def test_rotate_against_opencv(pf, backends):
     assert best["mae"] <= 3.0, f"rotate MAE too large: {best}"
     assert best["p99"] <= 12.0, f"rotate p99 too large: {best}"
     assert best["max"] <= 30, f"rotate max diff too large: {best}"
+
+
+# -------------------------
+# pyramid: pyr_down / pyr_up
+# -------------------------
+def test_pyramid_against_opencv(pf, backends):
+    rng = np.random.default_rng(7)
+    for shape in [(47, 62, 3), (33, 21)]:
+        src = rng.integers(0, 256, size=shape, dtype=np.uint8)
+        h, w = shape[:2]
+
+        down = pf.pyr_down(src, backend=backends[0])
+        up = pf.pyr_up(src, backend=backends[0])
+        up_odd = pf.pyr_up(src, height=2 * h - 1, width=2 * w - 1, backend=backends[0])
+        for b in backends[1:]:
+            assert np.array_equal(pf.pyr_down(src, backend=b), down), f"single vs {b} mismatch (pyr_down)"
+            assert np.array_equal(pf.pyr_up(src, backend=b), up), f"single vs {b} mismatch (pyr_up)"
+
+        # 同樣的整數算法與 reflect-101 邊界，結果應該完全一樣
+        _assert_close_u8(down, cv2.pyrDown(src), atol=0, msg="pyr_down")
+        _assert_close_u8(up, cv2.pyrUp(src), atol=0, msg="pyr_up")
+        _assert_close_u8(up_odd, cv2.pyrUp(src, dstsize=(2 * w - 1, 2 * h - 1)), atol=0, msg="pyr_up odd")
+
+
+# -------------------------
+# warp: affine / perspective
+# -------------------------
+def test_warp_against_opencv(pf, backends):
+    rng = np.random.default_rng(8)
+    src = cv2.GaussianBlur(rng.integers(0, 256, size=(60, 75, 3), dtype=np.uint8), (0, 0), 1.0)
+    A = cv2.getRotationMatrix2D((30.0, 25.0), 17.0, 0.9)
+    P = np.array([[0.95, 0.08, 4.0], [-0.04, 1.05, -3.0], [0.0009, 0.0006, 1.0]])
+
+    cases = [("nearest", cv2.INTER_NEAREST, 0), ("bilinear", cv2.INTER_LINEAR, 1)]
+    for name, flag, atol in cases:
+        for border, cv_border in [("constant", cv2.BORDER_CONSTANT), ("replicate", cv2.BORDER_REPLICATE)]:
+            out_pf = pf.warp_affine(src, A, 64, 80, interpolation=name, border=border, backend=backends[0])
+            out_cv = cv2.warpAffine(src, A, (80, 64), flags=flag, borderMode=cv_border)
+            _assert_close_u8(out_pf, out_cv, atol=atol, msg=f"warp_affine {name} {border}")
+
+    out_pf = pf.warp_perspective(src, P, 64, 80, interpolation="bilinear", backend=backends[0])
+    out_cv = cv2.warpPerspective(src, P, (80, 64), flags=cv2.INTER_LINEAR, borderMode=cv2.BORDER_CONSTANT)
+    _assert_close_u8(out_pf, out_cv, atol=1, msg="warp_perspective bilinear")
+
+
+# -------------------------
+# remap / undistort
+# -------------------------
+def test_remap_against_opencv(pf, backends):
+    rng = np.random.default_rng(9)
+    src = cv2.GaussianBlur(rng.integers(0, 256, size=(50, 70, 3), dtype=np.uint8), (0, 0), 1.0)
+    yy, xx = np.mgrid[0:45, 0:66].astype(np.float32)
+    mx = xx * 1.05 + np.sin(yy / 6.0) * 4.0 - 2.0
+    my = yy * 0.97 + np.cos(xx / 9.0) * 3.0 + 1.0
+
+    m = pf.make_remap_map(mx, my)
+    for border, cv_border in [("constant", cv2.BORDER_CONSTANT), ("replicate", cv2.BORDER_REPLICATE)]:
+        out_pf = pf.remap(src, m, interpolation="bilinear", border=border, backend=backends[0])
+        out_cv = cv2.remap(src, mx, my, cv2.INTER_LINEAR, borderMode=cv_border)
+        _assert_close_u8(out_pf, out_cv, atol=1, msg=f"remap bilinear {border}")
+
+    K = np.array([[60.0, 0.0, 34.5], [0.0, 62.0, 24.5], [0.0, 0.0, 1.0]])
+    D = np.array([-0.25, 0.08, 0.002, -0.001, -0.01])  # k1, k2, p1, p2, k3
+    out_pf = pf.undistort(src, fx=60.0, fy=62.0, cx=34.5, cy=24.5,
+                          k1=D[0], k2=D[1], p1=D[2], p2=D[3], k3=D[4], backend=backends[0])
+    out_cv = cv2.undistort(src, K, D)
+    _assert_close_u8(out_pf, out_cv, atol=1, msg="undistort")
@@ -0,0 +1,30 @@
+import numpy as np
+
+
+def test_auto_matches_single(pf, test_images, assert_equal):
+    rgb, gray = test_images
+    # auto 只會挑 single / openmp，結果必須跟 single bit-exact
+    for img in [gray, rgb]:
+        assert_equal(pf.invert(img, backend="auto"), pf.invert(img, backend="single"))
+        assert_equal(pf.gaussian_filter(img, 1.2, backend="auto"),
+                     pf.gaussian_filter(img, 1.2, backend="single"))
+        assert_equal(pf.resize(img, height=32, width=40, backend="auto"),
+                     pf.resize(img, height=32, width=40, backend="single"))
+
+    assert_equal(pf.cartoonize(rgb, backend="auto"), pf.cartoonize(rgb, backend="single"))
+
+
+def test_auto_params_cache_roundtrip(pf, tmp_path):
+    path = tmp_path / "pf_tune.txt"
+    params = pf.calibrate_auto(str(path))
+    assert path.exists()
+    assert params["calibrated"]
+    assert params["max_threads"] >= 1
+    assert params["ns_per_byte"] > 0 and params["ns_per_op"] > 0
+
+    assert pf.load_auto_cache(str(path))
+    loaded = pf.get_auto_params()
+    assert loaded["max_threads"] == params["max_threads"]
+    assert np.isclose(loaded["ns_per_op"], params["ns_per_op"], rtol=1e-4)
+
+    assert not pf.load_auto_cache(str(tmp_path / "missing.txt"))
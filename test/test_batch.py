@@ -0,0 +1,102 @@
+import numpy as np
+import pytest
+
+
+# (批次函式, 對應的單張呼叫)
+OPS = [
+    ("resize",          lambda pf, x, **kw: pf.resize_batch(x, 21, 17, **kw),
+                        lambda pf, img: pf.resize(img, 21, 17)),
+    ("mean_filter",     lambda pf, x, **kw: pf.mean_filter_batch(x, 5, **kw),
+                        lambda pf, img: pf.mean_filter(img, 5)),
+    ("gaussian_filter", lambda pf, x, **kw: pf.gaussian_filter_batch(x, 1.5, **kw),
+                        lambda pf, img: pf.gaussian_filter(img, 1.5)),
+    ("median_filter",   lambda pf, x, **kw: pf.median_filter_batch(x, 3, **kw),
+                        lambda pf, img: pf.median_filter(img, 3)),
+    ("to_grayscale",    lambda pf, x, **kw: pf.to_grayscale_batch(x, **kw),
+                        lambda pf, img: pf.to_grayscale(img)),
+    ("flip_horizontal", lambda pf, x, **kw: pf.flip_horizontal_batch(x, **kw),
+                        lambda pf, img: pf.flip_horizontal(img)),
+]
+IDS = [n for n, _, _ in OPS]
+
+
+def _stack(n, h, w, c):
+    rng = np.random.default_rng(n)
+    shape = (n, h, w) if c == 1 else (n, h, w, c)
+    return rng.integers(0, 256, shape, dtype=np.uint8)
+
+
+def _mixed_list():
+    # 大小、通道數都不一樣，含比 kernel 還窄的小圖
+    rng = np.random.default_rng(1)
+    imgs = []
+    for i in range(23):
+        h, w = int(rng.integers(3, 70)), int(rng.integers(3, 90))
+        shape = (h, w) if i % 3 == 0 else (h, w, 3)
+        imgs.append(rng.integers(0, 256, shape, dtype=np.uint8))
+    return imgs
+
+
+@pytest.mark.parametrize("name,batch,single", OPS, ids=IDS)
+def test_stacked_matches_single(pf, assert_equal, backends, name, batch, single):
+    for c in (1, 3):
+        x = _stack(9, 24, 31, c)
+        for be in backends + ["auto"]:
+            res = batch(pf, x, backend=be)
+            assert isinstance(res, np.ndarray)
+            assert_equal(res, np.stack([single(pf, img) for img in x]))
+
+
+@pytest.mark.parametrize("name,batch,single", OPS, ids=IDS)
+def test_list_matches_single(pf, assert_equal, backends, name, batch, single):
+    imgs = _mixed_list()
+    for be in backends + ["auto"]:
+        res = batch(pf, imgs, backend=be)
+        assert isinstance(res, list) and len(res) == len(imgs)
+        for r, img in zip(res, imgs):
+            assert_equal(r, single(pf, img))
+
+
+def test_stacked_out(pf, assert_equal):
+    x = _stack(6, 20, 30, 3)
+    out = np.empty((6, 11, 13, 3), np.uint8)
+    res = pf.resize_batch(x, 11, 13, out=out)
+    assert res is out
+    assert_equal(out, np.stack([pf.resize(img, 11, 13) for img in x]))
+
+
+def test_list_out_and_in_place(pf, assert_equal):
+    imgs = _mixed_list()
+    ref = [pf.gaussian_filter(img, 1.5) for img in imgs]
+    work = [img.copy() for img in imgs]
+    res = pf.gaussian_filter_batch(work, 1.5, out=work)
+    assert res is work
+    for w, r in zip(work, ref):
+        assert_equal(w, r)
+
+    # median 不能原地做：out 就是輸入時那幾張先算到暫存
+    ref = [pf.median_filter(img, 3) for img in imgs]
+    work = [img.copy() for img in imgs]
+    pf.median_filter_batch(work, 3, out=work)
+    for w, r in zip(work, ref):
+        assert_equal(w, r)
+
+
+def test_batch_validation(pf):
+    x = _stack(4, 16, 16, 3)
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.resize_batch(x, 0, 8)                                      # 尺寸不合法
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.median_filter_batch(x, 4)                                  # ksize 偶數
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.gaussian_filter_batch(x[0, :, :, 0], 1.0)                  # 2D array 不是 batch
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.gaussian_filter_batch(x, 1.0, out=np.empty((3, 16, 16, 3), np.uint8))   # 張數不對
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.gaussian_filter_batch(list(x), 1.0, out=np.empty_like(x))  # list 對 array
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.gaussian_filter_batch([x[0], np.zeros((4, 4), np.float32)], 1.0)
+
+
+def test_empty_list(pf):
+    assert pf.resize_batch([], 8, 8) == []
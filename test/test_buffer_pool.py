@@ -0,0 +1,70 @@
+import threading
+
+import numpy as np
+
+
+def test_pool_reuses_buffers_and_matches(pf, test_images, assert_equal):
+    rgb, gray = test_images
+    ref = [pf.gaussian_filter(img, 1.3, backend="single") for img in (rgb, gray)]
+
+    pf.enable_buffer_pool(True, max_bytes=64 << 20)
+    try:
+        pf.trim_buffer_pool()
+        before = pf.buffer_pool_stats()
+        for _ in range(5):
+            for img, r in zip((rgb, gray), ref):
+                assert_equal(pf.gaussian_filter(img, 1.3, backend="single"), r)
+        after = pf.buffer_pool_stats()
+        assert after["enabled"]
+        assert after["hits"] > before["hits"]
+        assert after["cached_bytes"] <= after["max_bytes"]
+    finally:
+        pf.enable_buffer_pool(False)
+
+    stats = pf.buffer_pool_stats()
+    assert not stats["enabled"]
+    assert stats["cached_bytes"] == 0
+
+
+def test_pool_limit_and_trim(pf):
+    img = np.full((256, 256, 3), 7, dtype=np.uint8)
+    pf.enable_buffer_pool(True, max_bytes=1 << 30)
+    try:
+        outs = [pf.invert(img, backend="single") for _ in range(8)]
+        del outs
+        assert pf.buffer_pool_stats()["cached_bytes"] > 0
+
+        pf.set_buffer_pool_limit(0)
+        assert pf.buffer_pool_stats()["cached_bytes"] == 0
+
+        pf.set_buffer_pool_limit(1 << 30)
+        pf.invert(img)
+        pf.trim_buffer_pool(0)
+        assert pf.buffer_pool_stats()["cached_bytes"] == 0
+    finally:
+        pf.enable_buffer_pool(False)
+
+
+def test_pool_outputs_outlive_pool_and_threads(pf):
+    rng = np.random.default_rng(3)
+    imgs = [rng.integers(0, 256, size=(64 + i, 80, 3), dtype=np.uint8) for i in range(8)]
+    expected = [255 - im for im in imgs]
+    results = [None] * len(imgs)
+
+    pf.enable_buffer_pool(True)
+    try:
+        def work(i):
+            for _ in range(20):
+                results[i] = pf.invert(imgs[i], backend="single")
+
+        threads = [threading.Thread(target=work, args=(i,)) for i in range(len(imgs))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    finally:
+        pf.enable_buffer_pool(False)
+
+    # pool 關掉、thread 結束之後，借出去的 buffer 仍然有效
+    for r, e in zip(results, expected):
+        assert np.array_equal(r, e)
@@ -60,3 +60,11 @@ def test_bilateral_filter_basic(pf, test_images, backends, assert_equal):
                 backend="openmp", border="reflect", border_value=0
             )
             assert_equal(out_s, out_o)
+
+
+def test_reflect_border_narrower_than_kernel(pf, assert_equal):
+    # kernel 比影像寬：reflect 要一直對稱摺下去，等於先用 symmetric 補邊再濾波
+    img = np.random.default_rng(2).integers(0, 256, (12, 3, 3), dtype=np.uint8)
+    padded = np.pad(img, ((8, 8), (8, 8), (0, 0)), mode="symmetric")
+    for f in (lambda x: pf.gaussian_filter(x, 1.5), lambda x: pf.mean_filter(x, 7)):
+        assert_equal(f(img), np.ascontiguousarray(f(padded)[8:-8, 8:-8]))
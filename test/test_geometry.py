@@ -1,4 +1,5 @@
 import numpy as np
+import pytest
 
 
 def test_resize(pf, test_images, backends, assert_equal):
@@ -14,6 +15,41 @@ def test_resize(pf, test_images, backends, assert_equal):
             assert_equal(out_s, out_o)
 
 
+INTERPS = ["nearest", "bilinear", "bicubic", "lanczos3", "area"]
+
+
+def test_resize_interpolations(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    for img in [gray, rgb]:
+        for interp in INTERPS:
+            for (nh, nw) in [(17, 23), (64, 80), (150, 121)]:
+                out_s = pf.resize(img, height=nh, width=nw, backend="single", interpolation=interp)
+                assert out_s.dtype == np.uint8
+                assert out_s.shape[:2] == (nh, nw)
+                assert out_s.shape[2:] == img.shape[2:]
+
+                if "openmp" in backends:
+                    out_o = pf.resize(img, height=nh, width=nw, backend="openmp", interpolation=interp)
+                    assert_equal(out_s, out_o)
+
+
+def test_resize_constant_and_antialias(pf):
+    const = np.full((31, 45, 3), 77, dtype=np.uint8)
+    for interp in INTERPS:
+        for (nh, nw) in [(1, 1), (7, 90), (62, 11)]:
+            out = pf.resize(const, height=nh, width=nw, interpolation=interp)
+            assert (out == 77).all(), interp
+
+    # 棋盤格縮小 1/10：有 antialias 的模式應該接近均勻灰
+    checker = ((np.indices((400, 400)).sum(axis=0) % 2) * 255).astype(np.uint8)
+    for interp in ["bilinear", "bicubic", "lanczos3", "area"]:
+        out = pf.resize(checker, height=40, width=40, interpolation=interp)
+        assert int(out.max()) - int(out.min()) <= 8, interp
+
+    with pytest.raises(Exception):
+        pf.resize(const, height=4, width=4, interpolation="bogus")
+
+
 def test_flip(pf, test_images, backends, assert_equal):
     rgb, gray = test_images
     for img in [gray, rgb]:
@@ -52,3 +88,18 @@ def test_rotate(pf, test_images, backends, assert_equal):
         if "openmp" in backends:
             out_o = pf.rotate(img, angle_deg=30.0, backend="openmp")
             assert_equal(out_s, out_o)
+
+
+def test_quarter_turns(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    rng = np.random.default_rng(11)
+    odd = rng.integers(0, 256, size=(37, 53, 3), dtype=np.uint8)
+    for img in [gray, rgb, odd, gray[:17, :50].copy()]:
+        for b in backends:
+            # 順時針，跟 rotate 同方向；np.rot90 是逆時針
+            assert_equal(pf.rotate90(img, backend=b), np.rot90(img, -1))
+            assert_equal(pf.rotate180(img, backend=b), np.rot90(img, 2))
+            assert_equal(pf.rotate270(img, backend=b), np.rot90(img, 1))
+            assert_equal(pf.transpose(img, backend=b), np.swapaxes(img, 0, 1))
+
+    assert_equal(pf.rotate90(pf.rotate270(odd)), odd)
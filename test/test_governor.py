@@ -0,0 +1,99 @@
+import os
+import subprocess
+import sys
+import threading
+
+import numpy as np
+
+
+def _image(h, w, c, seed=0):
+    return np.random.default_rng(seed).integers(0, 256, (h, w, c), dtype=np.uint8)
+
+
+def test_budget_defaults_and_reset(pf):
+    stats = pf.concurrency_stats()
+    assert 1 <= stats["available_cpus"] <= (os.cpu_count() or 1)
+    default = pf.get_max_threads()
+    assert default >= 1
+
+    pf.set_max_threads(3)
+    try:
+        assert pf.get_max_threads() == 3
+        assert pf.concurrency_stats()["max_threads"] == 3
+    finally:
+        pf.set_max_threads(None)
+    assert pf.get_max_threads() == default
+
+
+def _default_budget(**env):
+    # 預算在第一次用到時決定，要在新的 process 裡看
+    full = {k: v for k, v in os.environ.items() if k not in ("OMP_NUM_THREADS", "PF_MAX_THREADS")}
+    full.update(env)
+    full["PYTHONPATH"] = os.pathsep.join(sys.path)
+    code = "import pixfoundry as pf; print(pf.get_max_threads())"
+    return int(subprocess.check_output([sys.executable, "-c", code], env=full, text=True))
+
+
+def test_budget_respects_omp_num_threads(pf):
+    free = _default_budget()
+    capped = _default_budget(OMP_NUM_THREADS="1")
+    # 有 OpenMP 的 build 跟 OMP_NUM_THREADS 取小；沒有的話不看它
+    assert capped == 1 or capped == free
+    # PF_MAX_THREADS 明確指定時照它
+    assert _default_budget(OMP_NUM_THREADS="1", PF_MAX_THREADS="3") == 3
+
+
+def test_budget_of_one_runs_serial(pf, assert_equal, backends):
+    img = _image(120, 140, 3)
+    ref = pf.gaussian_filter(img, 1.5, backend="single")
+
+    pf.set_max_threads(1)
+    try:
+        pf.reset_concurrency_stats()
+        for be in backends + ["auto"]:
+            assert_equal(pf.gaussian_filter(img, 1.5, backend=be), ref)
+        stats = pf.concurrency_stats()
+        # 預算只有一條：沒有任何呼叫能平行
+        assert stats["parallel_calls"] == 0
+        assert stats["serial_calls"] + stats["throttled_calls"] == len(backends) + 1
+    finally:
+        pf.set_max_threads(0)
+
+
+def test_concurrent_callers_are_counted(pf, assert_equal):
+    imgs = [_image(150 + 9 * i, 130 + 7 * i, 3, seed=i) for i in range(4)]
+    refs = [pf.cartoonize(x, 1.2, 40, backend="single") for x in imgs]
+    errors = []
+    calls = 6
+
+    def worker(i):
+        try:
+            for _ in range(calls):
+                assert_equal(pf.cartoonize(imgs[i], 1.2, 40, backend="openmp"), refs[i])
+        except Exception as e:  # pragma: no cover - 失敗時才會進來
+            errors.append(e)
+
+    pf.reset_concurrency_stats()
+    ts = [threading.Thread(target=worker, args=(i,)) for i in range(len(imgs))]
+    for t in ts:
+        t.start()
+    for t in ts:
+        t.join()
+    assert not errors, errors
+
+    stats = pf.concurrency_stats()
+    assert stats["in_flight"] == 0
+    assert 1 <= stats["peak_in_flight"] <= len(imgs)
+    # 巢狀的 gaussian_filter / to_grayscale 不另外算一次
+    done = stats["parallel_calls"] + stats["throttled_calls"] + stats["serial_calls"]
+    assert done == calls * len(imgs)
+
+
+def test_batch_counts_as_one_call(pf, assert_equal):
+    imgs = [_image(40 + 5 * i, 30 + 3 * i, 3, seed=i) for i in range(6)]
+    pf.reset_concurrency_stats()
+    out = pf.gaussian_filter_batch(imgs, 1.1, backend="threadpool")
+    stats = pf.concurrency_stats()
+    assert stats["parallel_calls"] + stats["throttled_calls"] + stats["serial_calls"] == 1
+    for x, o in zip(imgs, out):
+        assert_equal(o, pf.gaussian_filter(x, 1.1))
@@ -1,4 +1,5 @@
 import numpy as np
+import pytest
 
 
 def test_io_roundtrip_png(pf, tmp_path):
@@ -14,3 +15,209 @@ def test_io_roundtrip_png(pf, tmp_path):
     # 讀回來如果是彩色，應該是 3 channel
     if img2.ndim == 3:
         assert img2.shape[2] == 3
+
+
+def test_bytes_roundtrip_png(pf, test_images, assert_equal):
+    rgb, gray = test_images
+    for img in (rgb, gray):
+        data = pf.save_image_to_bytes(img, "png")
+        assert isinstance(data, bytes) and data[:8] == b"\x89PNG\r\n\x1a\n"
+        assert_equal(pf.load_image_from_bytes(data), img)
+        # bytearray / memoryview / numpy 都能直接解
+        assert_equal(pf.load_image_from_bytes(bytearray(data)), img)
+        assert_equal(pf.load_image_from_bytes(memoryview(data)), img)
+        assert_equal(pf.load_image_from_bytes(np.frombuffer(data, np.uint8)), img)
+
+
+def test_bytes_match_file(pf, test_images, assert_equal, tmp_path):
+    rgb, _ = test_images
+    p = tmp_path / "x.jpg"
+    pf.save_image(str(p), rgb)
+    from_file = pf.load_image(str(p))
+    assert_equal(pf.load_image_from_bytes(p.read_bytes()), from_file)
+    assert pf.save_image_to_bytes(rgb, "jpg") == p.read_bytes()
+
+
+def test_bytes_errors(pf, test_images):
+    rgb, _ = test_images
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.load_image_from_bytes(b"not an image")
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.load_image_from_bytes(b"")
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.save_image_to_bytes(rgb, "gif")
+
+
+@pytest.mark.parametrize("channels", [1, 3])
+@pytest.mark.parametrize("max_size", [37, 70, 150, 400])
+def test_load_max_size(pf, tmp_path, channels, max_size):
+    h, w = 203, 297
+    yy, xx = np.mgrid[0:h, 0:w]
+    rgb = np.stack([xx * 255 // w, yy * 255 // h, (xx + yy) * 255 // (h + w)], axis=-1).astype(np.uint8)
+    img = rgb if channels == 3 else np.ascontiguousarray(rgb[..., 0])
+    p = tmp_path / "x.jpg"
+    pf.save_image(str(p), img)
+
+    full = pf.load_image(str(p))
+    small = pf.load_image(str(p), max_size=max_size)
+    if max_size >= w:
+        assert small.shape == full.shape
+        return
+    th, tw = round(h * max_size / w), max_size
+    assert small.shape == (th, tw) + full.shape[2:]
+    # 縮小解碼（JPEG 走 1/2、1/4、1/8 的 IDCT）跟「全解再縮」只差在四捨五入
+    ref = pf.resize(full, th, tw, interpolation="area")
+    diff = np.abs(small.astype(np.int16) - ref.astype(np.int16))
+    assert diff.mean() < 2
+
+    data = pf.save_image_to_bytes(img, "png")
+    assert pf.load_image_from_bytes(data, max_size=max_size).shape == small.shape
+
+
+def test_load_max_size_errors(pf, tmp_path, test_images):
+    rgb, _ = test_images
+    p = tmp_path / "x.jpg"
+    pf.save_image(str(p), rgb)
+    with pytest.raises(ValueError):
+        pf.load_image(str(p), max_size=0)
+
+
+def _smooth(h=67, w=91):
+    yy, xx = np.mgrid[0:h, 0:w]
+    return np.stack([xx * 255 // w, yy * 255 // h, (xx + yy) * 255 // (h + w)], axis=-1).astype(np.uint8)
+
+
+def test_qoi_roundtrip(pf, test_images, assert_equal, tmp_path):
+    rgb, gray = test_images
+    data = pf.save_image_to_bytes(rgb, "qoi")
+    assert data[:4] == b"qoif"
+    assert_equal(pf.load_image_from_bytes(data), rgb)
+    # QOI 沒有灰階：讀回來是三個通道都一樣的 RGB
+    back = pf.load_image_from_bytes(pf.save_image_to_bytes(gray, "qoi"))
+    assert_equal(back, np.repeat(gray[..., None], 3, axis=2))
+
+    smooth = _smooth()
+    p = tmp_path / "x.qoi"
+    pf.save_image(str(p), smooth)
+    assert_equal(pf.load_image(str(p)), smooth)
+    assert p.stat().st_size < smooth.nbytes // 2
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.load_image_from_bytes(data[:40])
+
+
+@pytest.mark.parametrize("compression", [0, 1, 3, 6, 9])
+@pytest.mark.parametrize("png_filter", ["none", "sub", "up", "average", "paeth", "adaptive", "fast"])
+def test_png_compression_options(pf, test_images, assert_equal, compression, png_filter):
+    for img in (*test_images, _smooth(), np.ascontiguousarray(_smooth()[..., 1])):
+        data = pf.save_image_to_bytes(img, "png", compression=compression, png_filter=png_filter)
+        assert_equal(pf.load_image_from_bytes(data), img)
+    smooth = _smooth()
+    stored = pf.save_image_to_bytes(smooth, "png", compression=0)
+    assert len(pf.save_image_to_bytes(smooth, "png", compression=max(compression, 1))) < len(stored)
+
+
+@pytest.mark.parametrize("subsampling", ["auto", "444", "422", "420"])
+def test_jpeg_quality_subsampling(pf, subsampling):
+    img = _smooth()
+    sizes = []
+    for quality in (30, 75, 95):
+        data = pf.save_image_to_bytes(img, "jpg", quality=quality, subsampling=subsampling)
+        back = pf.load_image_from_bytes(data)
+        assert back.shape == img.shape
+        assert np.abs(back.astype(np.int16) - img.astype(np.int16)).mean() < 4
+        sizes.append(len(data))
+    assert sizes[0] < sizes[1] < sizes[2]
+
+    gray = np.ascontiguousarray(img[..., 0])
+    back = pf.load_image_from_bytes(pf.save_image_to_bytes(gray, "jpg", quality=90, subsampling=subsampling))
+    assert back.shape == gray.shape
+
+
+def test_encode_options_batch_and_errors(pf, tmp_path, assert_equal):
+    img = _smooth()
+    paths = [tmp_path / "a.png", tmp_path / "b.qoi"]
+    pf.save_images(paths, [img, img], compression=1, png_filter="fast")
+    for p in paths:
+        assert_equal(pf.load_image(str(p)), img)
+    with pf.ImageWriter(quality=50, subsampling="420") as w:
+        w.write(str(tmp_path / "c.jpg"), img)
+    assert (tmp_path / "c.jpg").stat().st_size == len(pf.save_image_to_bytes(img, "jpg", quality=50, subsampling="420"))
+
+    with pytest.raises(ValueError):
+        pf.save_image_to_bytes(img, "jpg", quality=0)
+    with pytest.raises(ValueError):
+        pf.save_image_to_bytes(img, "png", compression=10)
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.save_image_to_bytes(img, "jpg", subsampling="411")
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.save_image(str(tmp_path / "x.png"), img, png_filter="best")
+
+
+def _write_set(pf, tmp_path, n=7):
+    rng = np.random.default_rng(0)
+    imgs = [rng.integers(0, 256, (20 + i, 30 + 3 * i, 3) if i % 2 else (20 + i, 30 + 3 * i),
+                         dtype=np.uint8) for i in range(n)]
+    paths = [tmp_path / f"im{i}.png" for i in range(n)]
+    pf.save_images(paths, imgs)
+    return paths, imgs
+
+
+def test_load_save_images(pf, tmp_path, assert_equal):
+    paths, imgs = _write_set(pf, tmp_path)
+    for a, b in zip(pf.load_images(paths), imgs):
+        assert_equal(a, b)
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.save_images(paths[:2], imgs)
+    with pytest.raises((ValueError, RuntimeError), match="missing"):
+        pf.load_images([str(paths[0]), str(tmp_path / "missing.png")])
+
+
+def test_load_save_images_stay_inside_pool_work(pf, tmp_path):
+    if pf.concurrency_stats()["available_cpus"] < 2:
+        pytest.skip("pool has no workers on one CPU: everything runs on the caller")
+    paths, _ = _write_set(pf, tmp_path)
+    pf.reset_concurrency_stats()
+    # max_size 會在解碼的工作裡跑 Auto 的 resize：呼叫端自己做的那幾張也算 pool 的工作，
+    # 不能再當成新的頂層呼叫向 governor 多要 thread
+    small = pf.load_images(paths, max_size=12)
+    pf.save_images([tmp_path / f"s{i}.png" for i in range(len(small))], small)
+    stats = pf.concurrency_stats()
+    assert stats["peak_in_flight"] == 0
+    assert stats["parallel_calls"] + stats["throttled_calls"] + stats["serial_calls"] == 0
+
+
+def test_image_reader_prefetch(pf, tmp_path, assert_equal):
+    paths, imgs = _write_set(pf, tmp_path)
+    reader = pf.ImageReader(paths, prefetch=2)
+    assert len(reader) == len(paths)
+    got = list(reader)
+    assert len(got) == len(imgs)
+    for a, b in zip(got, imgs):
+        assert_equal(a, b)
+
+    # 讀不了的那一張在輪到它時丟錯，後面的照常
+    bad = [paths[0], tmp_path / "missing.png", paths[2]]
+    it = iter(pf.ImageReader(bad, prefetch=3))
+    assert_equal(next(it), imgs[0])
+    with pytest.raises((ValueError, RuntimeError)):
+        next(it)
+    assert_equal(next(it), imgs[2])
+    with pytest.raises(StopIteration):
+        next(it)
+
+
+def test_image_writer_write_behind(pf, tmp_path, assert_equal):
+    _, imgs = _write_set(pf, tmp_path)
+    buf = np.empty_like(imgs[1])
+    with pf.ImageWriter(queue=2) as w:
+        for i in range(5):
+            buf[...] = imgs[1] + i      # write() 收的是複本，馬上改 buf 不影響
+            w.write(str(tmp_path / f"out{i}.png"), buf)
+    assert w.written == 5 and w.pending == 0
+    for i in range(5):
+        assert_equal(pf.load_image(str(tmp_path / f"out{i}.png")), imgs[1] + i)
+
+    w = pf.ImageWriter()
+    w.write(str(tmp_path / "no_such_dir" / "x.png"), imgs[0])
+    with pytest.raises((ValueError, RuntimeError)):
+        w.close()
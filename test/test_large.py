@@ -0,0 +1,72 @@
+import os
+
+import numpy as np
+import pytest
+
+
+# 超過 2^31 bytes：以前用 int 算 offset 的地方在這裡會溢位
+LARGE_SHAPE = (1 << 16, (1 << 15) + 7)
+
+
+def _available_bytes():
+    try:
+        return os.sysconf("SC_AVPHYS_PAGES") * os.sysconf("SC_PAGE_SIZE")
+    except (ValueError, OSError, AttributeError):
+        return 0
+
+
+# 要好幾 GB 記憶體、跑一兩分鐘：PF_LARGE_TESTS=1 才跑
+large = pytest.mark.skipif(
+    os.environ.get("PF_LARGE_TESTS") != "1" or _available_bytes() < 8 * LARGE_SHAPE[0] * LARGE_SHAPE[1],
+    reason="set PF_LARGE_TESTS=1 (needs ~20 GB free memory)",
+)
+
+
+def test_dimension_beyond_int_is_rejected(pf):
+    # stride 0 的 broadcast view：不佔記憶體。高 2^32 + 4 截成 int 會變成 4，不能默默只做 4 個 row
+    tall = np.broadcast_to(np.zeros((1, 4), dtype=np.uint8), ((1 << 32) + 4, 4))
+    with pytest.raises(ValueError):
+        pf.invert(tall)
+
+
+@pytest.fixture(scope="module")
+def huge():
+    img = np.zeros(LARGE_SHAPE, dtype=np.uint8)
+    img[0, 0] = 1
+    img[-1, 0] = 3
+    img[-1, -1] = 7
+    img[-3:, -5:] = np.arange(15, dtype=np.uint8).reshape(3, 5) + 100
+    return img
+
+
+@large
+def test_large_pointwise_and_flip(pf, huge):
+    out = pf.invert(huge)
+    assert out.shape == huge.shape
+    assert out[0, 0] == 254 and out[-1, 0] == 252 and out[-1, -1] == 255 - 114
+    assert out[LARGE_SHAPE[0] // 2, 12345] == 255
+    del out
+
+    flipped = pf.flip_horizontal(huge, backend="openmp")
+    assert flipped[-1, 0] == huge[-1, -1] and flipped[-1, -1] == 3
+    del flipped
+
+
+@large
+def test_large_view_offsets(pf, huge, assert_equal):
+    # view 的起點在 2^31 bytes 之後
+    tail = huge[-16:, -40:]
+    assert_equal(pf.gaussian_filter(tail, 1.0), pf.gaussian_filter(tail.copy(), 1.0))
+    assert_equal(pf.crop(huge, LARGE_SHAPE[0] - 3, LARGE_SHAPE[1] - 5, 3, 5), huge[-3:, -5:])
+
+
+@large
+def test_large_png_round_trip(pf, huge, tmp_path):
+    # 大的 PNG 逐段壓縮寫出；讀回時超過 stb 的 int 上限，改用逐 row 的 decoder
+    path = str(tmp_path / "huge.png")
+    pf.save_image(path, huge, compression=1)
+    back = pf.load_image(path)
+    assert back.shape == huge.shape
+    assert back[0, 0] == 1 and back[-1, 0] == 3
+    assert np.array_equal(back[-3:, -5:], huge[-3:, -5:])
+    assert not back[1:-3].any()
@@ -0,0 +1,69 @@
+import threading
+
+import numpy as np
+import pytest
+
+
+def _image(h, w, c, seed=0):
+    return np.random.default_rng(seed).integers(0, 256, (h, w, c), dtype=np.uint8)
+
+
+OPS = [
+    ("gaussian",   lambda pf, x, be: pf.gaussian_filter(x, 2.0, backend=be)),
+    ("median",     lambda pf, x, be: pf.median_filter(x, 5, backend=be)),
+    ("cartoonize", lambda pf, x, be: pf.cartoonize(x, 1.5, 40, backend=be)),
+    ("resize",     lambda pf, x, be: pf.resize(x, 97, 211, interpolation="bicubic", backend=be)),
+    ("rotate90",   lambda pf, x, be: pf.rotate90(x, backend=be)),
+]
+
+
+def test_numa_info(pf):
+    info = pf.numa_info()
+    assert info["nodes"] == len(info["cpus_per_node"]) >= 1
+    assert all(n >= 1 for n in info["cpus_per_node"])
+    assert sum(info["cpus_per_node"]) >= pf.concurrency_stats()["available_cpus"]
+
+
+@pytest.mark.parametrize("pinned", [False, True])
+@pytest.mark.parametrize("name,fn", OPS, ids=[o[0] for o in OPS])
+def test_numa_aware_matches_single(pf, assert_equal, backends, name, fn, pinned):
+    img = _image(301, 257, 3)
+    ref = fn(pf, img, "single")
+    was = pf.numa_info()["numa_aware"]
+    pf.set_numa_aware(True)
+    pf.set_thread_pinning(pinned)
+    try:
+        assert pf.numa_info()["pinned"] == pinned
+        for be in backends + ["auto"]:
+            assert_equal(fn(pf, img, be), ref)
+    finally:
+        pf.set_thread_pinning(False)
+        pf.set_numa_aware(was)
+
+
+def test_concurrent_pinned_calls_use_disjoint_cpus(pf):
+    cpus = pf.concurrency_stats()["available_cpus"]
+    if not hasattr(pf, "_debug_pinned_cpus") or cpus < 4:
+        pytest.skip("needs OpenMP on Linux and >= 4 CPUs")
+    team = cpus // 2
+    results = [None, None]
+    start = threading.Barrier(2)
+
+    def call(i):
+        start.wait()
+        results[i] = pf._debug_pinned_cpus(team, hold_ms=30)
+
+    pf.set_max_threads(cpus)
+    pf.set_thread_pinning(True)
+    try:
+        workers = [threading.Thread(target=call, args=(i,)) for i in range(2)]
+        for w in workers:
+            w.start()
+        for w in workers:
+            w.join()
+    finally:
+        pf.set_thread_pinning(False)
+        pf.set_max_threads(0)
+    # 兩個同時的呼叫各分到一段 CPU，不會綁到同一顆
+    assert results[0] or results[1]
+    assert not set(results[0]) & set(results[1])
@@ -0,0 +1,95 @@
+import numpy as np
+import pytest
+
+
+# (名稱, 呼叫方式)：每個都跟不給 out 的結果比
+OPS = [
+    ("mean_filter",      lambda pf, img, **kw: pf.mean_filter(img, 5, **kw)),
+    ("gaussian_filter",  lambda pf, img, **kw: pf.gaussian_filter(img, 1.2, **kw)),
+    ("median_filter",    lambda pf, img, **kw: pf.median_filter(img, 3, **kw)),
+    ("bilateral_filter", lambda pf, img, **kw: pf.bilateral_filter(img, 5, 30.0, 2.0, **kw)),
+    ("invert",           lambda pf, img, **kw: pf.invert(img, **kw)),
+    ("gamma_correct",    lambda pf, img, **kw: pf.gamma_correct(img, 0.7, **kw)),
+    ("brightness",       lambda pf, img, **kw: pf.adjust_brightness_contrast(img, 1.2, 5.0, **kw)),
+    ("sharpen",          lambda pf, img, **kw: pf.sharpen(img, 0.8, **kw)),
+    ("emboss",           lambda pf, img, **kw: pf.emboss(img, **kw)),
+    ("cartoonize",       lambda pf, img, **kw: pf.cartoonize(img, 1.0, **kw)),
+    ("resize",           lambda pf, img, **kw: pf.resize(img, 31, 47, **kw)),
+    ("flip_horizontal",  lambda pf, img, **kw: pf.flip_horizontal(img, **kw)),
+    ("flip_vertical",    lambda pf, img, **kw: pf.flip_vertical(img, **kw)),
+    ("crop",             lambda pf, img, **kw: pf.crop(img, 3, 4, 20, 30, **kw)),
+    ("rotate",           lambda pf, img, **kw: pf.rotate(img, 17.0, **kw)),
+    ("rotate90",         lambda pf, img, **kw: pf.rotate90(img, **kw)),
+    ("rotate180",        lambda pf, img, **kw: pf.rotate180(img, **kw)),
+    ("transpose",        lambda pf, img, **kw: pf.transpose(img, **kw)),
+    ("warp_affine",      lambda pf, img, **kw: pf.warp_affine(
+        img, np.array([[0.9, 0.1, 3.0], [-0.1, 0.95, 2.0]]), 50, 60, **kw)),
+    ("pyr_down",         lambda pf, img, **kw: pf.pyr_down(img, **kw)),
+    ("pyr_up",           lambda pf, img, **kw: pf.pyr_up(img, **kw)),
+    ("downscale_box",    lambda pf, img, **kw: pf.downscale_box(img, 2, **kw)),
+]
+
+
+@pytest.mark.parametrize("name,op", OPS, ids=[n for n, _ in OPS])
+def test_out_writes_into_given_array(pf, test_images, assert_equal, name, op):
+    for img in test_images:
+        ref = op(pf, img)
+        out = np.empty_like(np.ascontiguousarray(ref))
+        res = op(pf, img, out=out)
+        assert res is out
+        assert_equal(out, ref)
+
+
+@pytest.mark.parametrize("name", ["invert", "gamma_correct", "brightness",
+                                  "flip_horizontal", "flip_vertical", "gaussian_filter"])
+def test_in_place(pf, test_images, assert_equal, backends, name):
+    op = dict(OPS)[name]
+    for img in test_images:
+        for be in backends:
+            ref = op(pf, img, backend=be)
+            work = img.copy()
+            res = op(pf, work, backend=be, out=work)
+            assert res is work
+            assert_equal(work, ref)
+
+
+def test_sepia_in_place(pf, test_images, assert_equal):
+    rgb, _ = test_images
+    ref = pf.sepia(rgb)
+    work = rgb.copy()
+    pf.sepia(work, out=work)
+    assert_equal(work, ref)
+
+
+def test_flip_in_place_odd_sizes(pf, assert_equal):
+    img = np.arange(7 * 9 * 3, dtype=np.uint32).astype(np.uint8).reshape(7, 9, 3)
+    for flip, ref in ((pf.flip_horizontal, img[:, ::-1]), (pf.flip_vertical, img[::-1])):
+        work = img.copy()
+        flip(work, out=work)
+        assert_equal(work, np.ascontiguousarray(ref))
+
+
+def test_out_overlapping_input_falls_back_to_copy(pf, test_images, assert_equal):
+    # median 不能原地做：out 就是輸入時先算到暫存，結果還是要對
+    rgb, _ = test_images
+    ref = pf.median_filter(rgb, 3)
+    work = rgb.copy()
+    pf.median_filter(work, 3, out=work)
+    assert_equal(work, ref)
+
+
+def test_out_validation(pf, test_images):
+    rgb, _ = test_images
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.invert(rgb, out=np.empty((10, 10, 3), np.uint8))      # 尺寸不對
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.invert(rgb, out=np.empty(rgb.shape, np.float32))      # dtype 不對
+    ro = np.empty_like(rgb)
+    ro.setflags(write=False)
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.invert(rgb, out=ro)                                   # 唯讀
+    big = np.empty((rgb.shape[0], rgb.shape[1] + 4, 3), np.uint8)
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.invert(rgb, out=big[:, :rgb.shape[1]])                # 不是 C-contiguous
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.resize(rgb, 20, 30, out=np.empty((30, 20, 3), np.uint8))
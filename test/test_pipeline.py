@@ -0,0 +1,115 @@
+import numpy as np
+import pytest
+
+
+def _build(pf):
+    return (pf.Pipeline()
+            .gaussian_filter(1.2)
+            .invert()
+            .gamma_correct(0.8)
+            .resize(40, 50, interpolation="bicubic")
+            .sharpen(0.7)
+            .flip_horizontal()
+            .crop(3, 4, 30, 100)
+            .rotate90()
+            .to_grayscale()
+            .pyr_down())
+
+
+def _reference(pf, img):
+    x = pf.gaussian_filter(img, 1.2)
+    x = pf.invert(x)
+    x = pf.gamma_correct(x, 0.8)
+    x = pf.resize(x, 40, 50, interpolation="bicubic")
+    x = pf.sharpen(x, 0.7)
+    x = pf.flip_horizontal(x)
+    x = pf.crop(x, 3, 4, 30, 100)
+    x = pf.rotate90(x)
+    x = pf.to_grayscale(x)
+    return pf.pyr_down(x)
+
+
+def test_pipeline_matches_step_by_step(pf, test_images, assert_equal, backends):
+    p = _build(pf)
+    assert len(p) == 10
+    assert p.steps[0] == "gaussian_filter" and p.steps[-1] == "pyr_down"
+    rgb, _ = test_images
+    for be in backends + ["auto"]:
+        assert_equal(p(rgb, backend=be), _reference(pf, rgb))
+
+
+def test_pipeline_reuses_buffers(pf, assert_equal):
+    p = _build(pf)
+    rng = np.random.default_rng(0)
+    frames = [rng.integers(0, 256, (64, 80, 3), dtype=np.uint8) for _ in range(4)]
+    out = np.empty(p.output_shape(64, 80)[:2], np.uint8)
+
+    p(frames[0], out=out)
+    held = p.buffer_bytes
+    for f in frames[1:]:
+        res = p(f, out=out)
+        assert res is out
+        assert_equal(out, _reference(pf, f))
+        assert p.buffer_bytes == held   # 同樣大小的 frame 不會再配置中間 buffer
+
+    # 換尺寸會重新規劃，結果一樣要對
+    big = rng.integers(0, 256, (90, 120, 3), dtype=np.uint8)
+    assert_equal(p(big), _reference(pf, big))
+
+
+def test_pipeline_reuses_outputs(pf, assert_equal):
+    p = _build(pf)
+    rng = np.random.default_rng(1)
+    frames = [rng.integers(0, 256, (64, 80, 3), dtype=np.uint8) for _ in range(3)]
+
+    ptrs = set()
+    res = None
+    for f in frames * 3:
+        res = p(f)   # 上一張 res 還在手上：寫另一塊
+        assert_equal(res, _reference(pf, f))
+        ptrs.add(res.__array_interface__["data"][0])
+    assert len(ptrs) == 2  # 兩塊輪流用，之後不再配置
+
+    # 還拿著的結果不會被改；回傳的結果是呼叫端的，可以寫
+    kept = p(frames[0])
+    kept_ref = kept.copy()
+    for f in frames * 2:
+        p(f)[0, 0] = 1
+    assert_equal(kept, kept_ref)
+    assert_equal(p(frames[1]), _reference(pf, frames[1]))
+
+
+def test_pipeline_in_place(pf, test_images, assert_equal):
+    rgb, _ = test_images
+    p = pf.Pipeline().gaussian_filter(1.0).invert().flip_vertical().sepia()
+    ref = pf.sepia(pf.flip_vertical(pf.invert(pf.gaussian_filter(rgb, 1.0))))
+    work = rgb.copy()
+    assert p(work, out=work) is work
+    assert_equal(work, ref)
+
+    # 只有一步、又不能原地做：先算到暫存再複製
+    work = rgb.copy()
+    pf.Pipeline().median_filter(3)(work, out=work)
+    assert_equal(work, pf.median_filter(rgb, 3))
+
+
+def test_pipeline_validation(pf, test_images):
+    rgb, gray = test_images
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.Pipeline().resize(0, 10)                     # 參數在加進去時就檢查
+    with pytest.raises((ValueError, RuntimeError)):
+        pf.Pipeline().median_filter(4)
+    p = pf.Pipeline().to_grayscale().sepia()            # sepia 要 RGB
+    with pytest.raises((ValueError, RuntimeError)):
+        p(rgb)
+    with pytest.raises((ValueError, RuntimeError)):
+        p.output_shape(64, 80, 3)
+    with pytest.raises((ValueError, RuntimeError)):
+        _build(pf)(rgb, out=np.empty((5, 5), np.uint8))
+
+
+def test_empty_pipeline_copies(pf, test_images, assert_equal):
+    rgb, _ = test_images
+    res = pf.Pipeline()(rgb)
+    assert_equal(res, rgb)
+    assert not np.shares_memory(res, rgb)
@@ -0,0 +1,92 @@
+import numpy as np
+import pytest
+
+
+def test_pyr_shapes(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    for img in [gray, rgb[:63, :79]]:
+        h, w = img.shape[:2]
+        for b in backends:
+            down = pf.pyr_down(img, backend=b)
+            assert down.shape[:2] == ((h + 1) // 2, (w + 1) // 2)
+            assert down.shape[2:] == img.shape[2:]
+
+            up = pf.pyr_up(down, backend=b)
+            assert up.shape[:2] == (2 * down.shape[0], 2 * down.shape[1])
+            up = pf.pyr_up(down, height=h, width=w, backend=b)
+            assert up.shape == img.shape
+
+        if "openmp" in backends:
+            assert_equal(pf.pyr_down(img, backend="single"), pf.pyr_down(img, backend="openmp"))
+            assert_equal(pf.pyr_up(img, backend="single"), pf.pyr_up(img, backend="openmp"))
+
+    with pytest.raises(Exception):
+        pf.pyr_up(gray, height=gray.shape[0] * 2 + 1)
+
+
+def test_gaussian_pyramid(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    for img in [gray, rgb]:
+        pyr = pf.gaussian_pyramid(img, 4, backend="single")
+        assert len(pyr) == 4
+        assert_equal(pyr[0], img)
+        for i in range(1, len(pyr)):
+            assert_equal(pyr[i], pf.pyr_down(pyr[i - 1], backend="single"))
+
+        if "openmp" in backends:
+            pyr_o = pf.gaussian_pyramid(img, 4, backend="openmp")
+            for a, b in zip(pyr, pyr_o):
+                assert_equal(a, b)
+
+    # 縮到 1x1 就停
+    pyr = pf.gaussian_pyramid(gray, 100)
+    assert pyr[-1].shape == (1, 1)
+    assert len(pyr) == 8  # 64x80 → 32x40 → ... → 1x2 → 1x1
+
+
+def test_laplacian_roundtrip(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    rng = np.random.default_rng(3)
+    # 平滑的影像：差值不會超過 ±127，還原必須完全一樣
+    smooth = np.cumsum(rng.integers(0, 3, size=(45, 61, 3)), axis=1).clip(0, 255).astype(np.uint8)
+
+    for img in [smooth, smooth[..., 0].copy()]:
+        for levels in [1, 3, 6]:
+            lap = pf.laplacian_pyramid(img, levels, backend="single")
+            assert len(lap) == levels
+            g = pf.gaussian_pyramid(img, levels, backend="single")
+            assert_equal(lap[-1], g[-1])
+
+            out = pf.collapse_laplacian_pyramid(lap, backend="single")
+            assert_equal(out, img)
+
+            if "openmp" in backends:
+                lap_o = pf.laplacian_pyramid(img, levels, backend="openmp")
+                for a, b in zip(lap, lap_o):
+                    assert_equal(a, b)
+                assert_equal(pf.collapse_laplacian_pyramid(lap_o, backend="openmp"), img)
+
+    # 第 0 層 = G0 - pyr_up(G1) + 128
+    lap = pf.laplacian_pyramid(smooth, 2)
+    g1 = pf.pyr_down(smooth)
+    expect = (smooth.astype(np.int16) - pf.pyr_up(g1, height=45, width=61) + 128).clip(0, 255)
+    assert_equal(lap[0], expect.astype(np.uint8))
+
+
+def test_downscale_box(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    for img in [gray, rgb[:63, :78]]:
+        h, w = img.shape[:2]
+        for f in [2, 4]:
+            out = pf.downscale_box(img, f, backend="single")
+            hh, ww = h // f, w // f
+            block = img[:hh * f, :ww * f].astype(np.int32)
+            block = block.reshape((hh, f, ww, f) + img.shape[2:]).sum(axis=(1, 3))
+            expect = ((block + f * f // 2) // (f * f)).astype(np.uint8)
+            assert_equal(out, expect)
+
+            if "openmp" in backends:
+                assert_equal(out, pf.downscale_box(img, f, backend="openmp"))
+
+    with pytest.raises(Exception):
+        pf.downscale_box(gray, 3)
@@ -0,0 +1,64 @@
+import numpy as np
+import pytest
+
+INTERPS = ["nearest", "bilinear", "bicubic"]
+
+
+def _grid(h, w):
+    yy, xx = np.mgrid[0:h, 0:w].astype(np.float32)
+    return xx, yy
+
+
+def test_remap_identity_and_shift(pf, test_images):
+    rgb, gray = test_images
+    for img in [gray, rgb]:
+        h, w = img.shape[:2]
+        xx, yy = _grid(h, w)
+        m = pf.make_remap_map(xx, yy)
+        assert (m.height, m.width) == (h, w)
+        for interp in INTERPS:
+            assert np.array_equal(pf.remap(img, m, interpolation=interp), img), interp
+
+        # 整數位移 + 外面補 border_value
+        m = pf.make_remap_map(xx + 4, yy - 2)
+        out = pf.remap(img, m, border_value=7)
+        assert np.array_equal(out[2:, :w - 4], img[:h - 2, 4:])
+        assert (out[:2] == 7).all() and (out[:, w - 4:] == 7).all()
+
+
+def test_remap_output_shape_and_backends(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    xx, yy = _grid(40, 90)
+    mx = xx * 0.85 + np.sin(yy / 5.0) * 3.0
+    my = yy * 1.4 + np.cos(xx / 7.0) * 2.0 - 1.0
+    m = pf.make_remap_map(mx, my)
+    for img in [gray, rgb]:
+        for interp in INTERPS:
+            for border in ["constant", "replicate", "reflect", "wrap"]:
+                out_s = pf.remap(img, m, interpolation=interp, border=border, backend="single")
+                assert out_s.shape[:2] == (40, 90)
+                assert out_s.shape[2:] == img.shape[2:]
+                if "openmp" in backends:
+                    assert_equal(out_s, pf.remap(img, m, interpolation=interp, border=border, backend="openmp"))
+
+    with pytest.raises(Exception):
+        pf.make_remap_map(mx, my[:, :10])
+
+
+def test_undistort(pf, test_images, assert_equal):
+    rgb, _ = test_images
+    h, w = rgb.shape[:2]
+    lens = dict(fx=70.0, fy=72.0, cx=39.5, cy=31.5)
+
+    # 沒有畸變 → 原圖
+    assert_equal(pf.undistort(rgb, **lens), rgb)
+
+    pf.clear_undistort_cache()
+    m1 = pf.undistort_map(h, w, k1=-0.2, k2=0.05, p1=0.001, **lens)
+    m2 = pf.undistort_map(h, w, k1=-0.2, k2=0.05, p1=0.001, **lens)
+    assert m1 is m2  # 同樣的參數拿到同一張快取的表
+    out = pf.undistort(rgb, k1=-0.2, k2=0.05, p1=0.001, **lens)
+    assert_equal(out, pf.remap(rgb, m1))
+
+    # 主點附近幾乎沒有位移
+    assert_equal(out[31:33, 39:41], rgb[31:33, 39:41])
@@ -0,0 +1,174 @@
+import struct
+import zlib
+
+import numpy as np
+import pytest
+
+
+def _image(shape, seed=0):
+    rng = np.random.default_rng(seed)
+    h, w = shape[:2]
+    base = (np.add.outer(np.arange(h) * 2, np.arange(w) * 3) // 3).astype(np.int32)
+    if len(shape) == 3:
+        base = base[..., None] + np.arange(shape[2]) * 40
+    return ((base + rng.integers(0, 40, shape)) % 256).astype(np.uint8)
+
+
+def _write(pf, path, img):
+    if path.endswith(".pft"):
+        pf.save_tiled(path, img, tile_height=16, tile_width=24, compression="qoi")
+    elif path.endswith(".png"):
+        pf.save_image(path, img)
+    else:
+        with pf.StripWriter(path, img.shape[0], img.shape[1], 1 if img.ndim == 2 else 3) as w:
+            w.write(img)
+
+
+def _read(pf, path):
+    if path.endswith(".pft"):
+        return pf.TiledReader(path).read()
+    return np.concatenate(list(pf.StripReader(path, strip_rows=1000)))
+
+
+def _chain(pf):
+    return (pf.Pipeline()
+            .gaussian_filter(1.7)
+            .mean_filter(5, border="constant", border_value=9)
+            .median_filter(3, border="replicate")
+            .sharpen(0.8)
+            .invert())
+
+
+@pytest.mark.parametrize("src_ext", [".png", ".ppm", ".pft"])
+@pytest.mark.parametrize("dst_ext", [".png", ".ppm", ".pft"])
+@pytest.mark.parametrize("strip_rows", [1, 7, 256])
+def test_stream_matches_whole_image(pf, tmp_path, assert_equal, src_ext, dst_ext, strip_rows):
+    img = _image((97, 61, 3))
+    src, dst = str(tmp_path / ("in" + src_ext)), str(tmp_path / ("out" + dst_ext))
+    _write(pf, src, img)
+
+    stats = pf.process_stream(src, dst, _chain(pf), strip_rows=strip_rows)
+    assert stats["rows"] == 97
+    assert stats["strips"] == -(-97 // strip_rows)
+    assert_equal(_read(pf, dst), _chain(pf)(img))
+
+
+@pytest.mark.parametrize("shape", [(40, 33), (40, 33, 3)])
+def test_stream_effects_and_channel_change(pf, tmp_path, assert_equal, shape):
+    img = _image(shape, seed=1)
+    src, dst = str(tmp_path / "in.png"), str(tmp_path / "out.png")
+    pf.save_image(src, img)
+
+    p = pf.Pipeline().cartoonize().emboss(1.5).flip_horizontal().bilateral_filter(5, 30.0, 3.0)
+    if len(shape) == 3:
+        p = p.sepia().to_grayscale()
+    p = p.gaussian_filter(3.0)
+    pf.process_stream(src, dst, p, strip_rows=5)
+    assert_equal(pf.load_image(dst), p(img))
+
+
+def test_stream_memory_is_bounded(pf, tmp_path, assert_equal):
+    img = _image((6000, 200, 3), seed=2)
+    src, dst = str(tmp_path / "in.ppm"), str(tmp_path / "out.png")
+    _write(pf, src, img)
+
+    p = pf.Pipeline().gaussian_filter(2.0).mean_filter(7)
+    stats = pf.process_stream(src, dst, p, strip_rows=64, compression=1)
+    # 只跟 strip 高（加上 halo）成比例，跟影像高度無關
+    assert stats["buffer_bytes"] < img.nbytes // 10
+    assert_equal(pf.load_image(dst), p(img))
+
+
+def test_stream_copy_without_pipeline(pf, tmp_path, assert_equal):
+    img = _image((50, 40))
+    src, dst = str(tmp_path / "in.pgm"), str(tmp_path / "out.png")
+    _write(pf, src, img)
+    stats = pf.process_stream(src, dst, strip_rows=16)
+    assert stats["strips"] == 4
+    assert_equal(pf.load_image(dst), img)
+
+
+def _png(width, height, color_type, depth, rows, extra=b""):
+    def chunk(tag, data):
+        return struct.pack(">I", len(data)) + tag + data + struct.pack(">I", zlib.crc32(tag + data))
+
+    raw = b"".join(b"\x02" + bytes(r) for r in rows)  # filter Up：第一個 row 的上面當 0
+    ihdr = struct.pack(">IIBBBBB", width, height, depth, color_type, 0, 0, 0)
+    z = zlib.compress(raw, 9)
+    return (b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", ihdr) + extra +
+            chunk(b"IDAT", z[:5]) + chunk(b"IDAT", z[5:]) + chunk(b"IEND", b""))
+
+
+def _up_filtered(rows):
+    prev = np.zeros_like(rows[0])
+    out = []
+    for r in rows:
+        out.append((r.astype(np.int16) - prev).astype(np.uint8))
+        prev = r
+    return out
+
+
+@pytest.mark.parametrize("case", ["gray16", "palette4", "rgba", "gray_alpha"])
+def test_strip_reader_png_formats(pf, tmp_path, assert_equal, case):
+    rng = np.random.default_rng(3)
+    h, w = 9, 13
+    if case == "gray16":
+        px = rng.integers(0, 65536, (h, w), dtype=np.uint16)
+        rows = _up_filtered([r.astype(">u2").view(np.uint8) for r in px])
+        data = _png(w, h, 0, 16, rows)
+    elif case == "palette4":
+        idx = rng.integers(0, 16, (h, w), dtype=np.uint8)
+        packed = [(r[0::2] << 4) | np.append(r[1::2], 0) for r in idx]
+        rows = _up_filtered(packed)
+        palette = rng.integers(0, 256, (16, 3), dtype=np.uint8)
+        data = _png(w, h, 3, 4, rows, extra=struct.pack(">I", 48) + b"PLTE" + palette.tobytes() +
+                    struct.pack(">I", zlib.crc32(b"PLTE" + palette.tobytes())))
+    elif case == "rgba":
+        px = rng.integers(0, 256, (h, w, 4), dtype=np.uint8)
+        data = _png(w, h, 6, 8, _up_filtered([r.reshape(-1) for r in px]))
+    else:
+        px = rng.integers(0, 256, (h, w, 2), dtype=np.uint8)
+        data = _png(w, h, 4, 8, _up_filtered([r.reshape(-1) for r in px]))
+
+    p = tmp_path / "x.png"
+    p.write_bytes(data)
+    reader = pf.StripReader(str(p), strip_rows=4)
+    strips = list(reader)
+    assert [s.shape[0] for s in strips] == [4, 4, 1]
+    # 跟整張解碼（stb）一樣
+    assert_equal(np.concatenate(strips), pf.load_image(str(p)))
+
+
+def test_stream_errors(pf, tmp_path):
+    img = _image((20, 20, 3))
+    src = str(tmp_path / "in.png")
+    pf.save_image(src, img)
+
+    with pytest.raises(ValueError):
+        pf.process_stream(src, str(tmp_path / "o.png"), pf.Pipeline().rotate90())  # 尺寸會變
+    with pytest.raises(ValueError):
+        pf.process_stream(src, str(tmp_path / "o.png"), pf.Pipeline().mean_filter(3, border="wrap"))
+    with pytest.raises(ValueError):
+        pf.process_stream(src, str(tmp_path / "o.jpg"))  # JPEG 不能逐段寫
+    with pytest.raises(ValueError):
+        pf.process_stream(src, str(tmp_path / "o.png"), strip_rows=0)
+
+    # interlaced PNG 不能逐 row 解
+    data = bytearray(pf.save_image_to_bytes(img, "png"))
+    data[28] = 1
+    (tmp_path / "inter.png").write_bytes(bytes(data))
+    with pytest.raises(RuntimeError):
+        pf.StripReader(str(tmp_path / "inter.png"))
+
+    # 檔案被截斷：讀到一半丟例外
+    good = (tmp_path / "in.png").read_bytes()
+    (tmp_path / "short.png").write_bytes(good[: len(good) // 2])
+    with pytest.raises(RuntimeError):
+        pf.process_stream(str(tmp_path / "short.png"), str(tmp_path / "o.png"))
+
+    w = pf.StripWriter(str(tmp_path / "o.png"), 20, 20)
+    w.write(img[:10])
+    with pytest.raises(ValueError):
+        w.write(img[:, :10])
+    with pytest.raises(RuntimeError):
+        w.close()  # 少了 10 個 row
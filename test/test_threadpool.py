@@ -0,0 +1,76 @@
+import threading
+
+import numpy as np
+import pytest
+
+
+def _image(h, w, c, seed=0):
+    shape = (h, w, c) if c > 1 else (h, w)
+    return np.random.default_rng(seed).integers(0, 256, shape, dtype=np.uint8)
+
+
+OPS = [
+    ("invert",        lambda pf, x, be: pf.invert(x, backend=be)),
+    ("gamma",         lambda pf, x, be: pf.gamma_correct(x, 0.7, backend=be)),
+    ("gaussian",      lambda pf, x, be: pf.gaussian_filter(x, 2.0, backend=be)),
+    ("median",        lambda pf, x, be: pf.median_filter(x, 5, backend=be)),
+    ("bilateral",     lambda pf, x, be: pf.bilateral_filter(x, 5, 30.0, 2.0, backend=be)),
+    ("sharpen",       lambda pf, x, be: pf.sharpen(x, 0.8, backend=be)),
+    ("emboss",        lambda pf, x, be: pf.emboss(x, 1.0, backend=be)),
+    ("cartoonize",    lambda pf, x, be: pf.cartoonize(x, 1.5, 40, backend=be)),
+    ("resize",        lambda pf, x, be: pf.resize(x, 97, 211, interpolation="bicubic", backend=be)),
+    ("flip_v",        lambda pf, x, be: pf.flip_vertical(x, backend=be)),
+    ("rotate90",      lambda pf, x, be: pf.rotate90(x, backend=be)),
+    ("rotate",        lambda pf, x, be: pf.rotate(x, 23.0, backend=be)),
+    ("pyr_down",      lambda pf, x, be: pf.pyr_down(x, backend=be)),
+    ("downscale_box", lambda pf, x, be: pf.downscale_box(x, 2, backend=be)),
+]
+
+
+@pytest.mark.parametrize("c", [1, 3])
+@pytest.mark.parametrize("name,fn", OPS, ids=[o[0] for o in OPS])
+def test_threadpool_matches_single(pf, assert_equal, name, fn, c):
+    img = _image(301, 257, c)
+    assert_equal(fn(pf, img, "threadpool"), fn(pf, img, "single"))
+
+
+def test_threadpool_in_place(pf, assert_equal):
+    img = _image(300, 200, 3)
+    ref = pf.flip_vertical(pf.invert(img))
+    work = img.copy()
+    pf.invert(work, backend="pool", out=work)
+    pf.flip_vertical(work, backend="pool", out=work)
+    assert_equal(work, ref)
+
+
+def test_threadpool_concurrent_callers(pf, assert_equal):
+    # 多條 Python thread 同時用同一個 pool（cartoonize 裡面還有巢狀的 gaussian_filter）
+    imgs = [_image(180 + 17 * i, 150 + 11 * i, 3, seed=i) for i in range(4)]
+    refs = [pf.cartoonize(x, 1.2, 40, backend="single") for x in imgs]
+    errors = []
+
+    def worker(i):
+        try:
+            for _ in range(5):
+                assert_equal(pf.cartoonize(imgs[i], 1.2, 40, backend="threadpool"), refs[i])
+        except Exception as e:  # pragma: no cover - 失敗時才會進來
+            errors.append(e)
+
+    ts = [threading.Thread(target=worker, args=(i,)) for i in range(len(imgs))]
+    for t in ts:
+        t.start()
+    for t in ts:
+        t.join()
+    assert not errors, errors
+
+
+def test_threadpool_batch(pf, assert_equal):
+    imgs = [_image(20 + 13 * i, 30 + 7 * i, 3, seed=i) for i in range(9)]
+    out = pf.gaussian_filter_batch(imgs, 1.5, backend="threadpool")
+    for x, o in zip(imgs, out):
+        assert_equal(o, pf.gaussian_filter(x, 1.5))
+
+
+def test_unknown_backend_lists_threadpool(pf):
+    with pytest.raises((ValueError, RuntimeError), match="threadpool"):
+        pf.invert(_image(8, 8, 3), backend="tbb")
@@ -0,0 +1,75 @@
+import os
+import threading
+import time
+
+import numpy as np
+import pytest
+
+
+def _cpus():
+    try:
+        return len(os.sched_getaffinity(0))
+    except AttributeError:
+        return os.cpu_count() or 1
+
+
+def _run_threads(n, fn):
+    errors = []
+
+    def worker(i):
+        try:
+            fn(i)
+        except Exception as e:  # pragma: no cover - 失敗時才會進來
+            errors.append(e)
+
+    ts = [threading.Thread(target=worker, args=(i,)) for i in range(n)]
+    for t in ts:
+        t.start()
+    for t in ts:
+        t.join()
+    assert not errors, errors
+
+
+def test_concurrent_calls_match_serial(pf, test_images, assert_equal):
+    rgb, gray = test_images
+    ref = {
+        "gauss": pf.gaussian_filter(rgb, 1.5, backend="single"),
+        "resize": pf.resize(gray, 40, 50, backend="single"),
+        "median": pf.median_filter(rgb, 3, backend="single"),
+    }
+
+    def fn(i):
+        for _ in range(20):
+            assert_equal(pf.gaussian_filter(rgb, 1.5, backend="single"), ref["gauss"])
+            assert_equal(pf.resize(gray, 40, 50, backend="single"), ref["resize"])
+            assert_equal(pf.median_filter(rgb, 3, backend="single"), ref["median"])
+
+    _run_threads(4, fn)
+
+
+def test_threads_scale(pf):
+    # C++ 計算期間放掉 GIL：N 條 thread 同時跑 single backend 應該接近 N 倍吞吐量
+    n = min(4, _cpus())
+    if n < 2:
+        pytest.skip("needs at least 2 CPUs")
+
+    img = np.random.default_rng(0).integers(0, 256, (256, 256, 3), dtype=np.uint8)
+    calls = 12
+
+    def work(_):
+        for _ in range(calls):
+            pf.gaussian_filter(img, 2.0, backend="single")
+
+    work(0)  # 暖機（配置、page fault）
+    t0 = time.perf_counter()
+    for i in range(n):
+        work(i)
+    serial = time.perf_counter() - t0
+
+    t0 = time.perf_counter()
+    _run_threads(n, work)
+    parallel = time.perf_counter() - t0
+
+    speedup = serial / parallel
+    # 留一點餘裕給 CI 上的雜訊；拿著 GIL 的話 speedup 只會在 1 附近
+    assert speedup > 0.6 * n, f"speedup {speedup:.2f} with {n} threads"
@@ -0,0 +1,130 @@
+import numpy as np
+import pytest
+
+
+_PAD_MODE = {"reflect": "symmetric", "replicate": "edge", "wrap": "wrap"}
+
+
+def _random(shape, seed=0):
+    return np.random.default_rng(seed).integers(0, 256, shape, dtype=np.uint8)
+
+
+@pytest.mark.parametrize("compression", ["none", "qoi", "png"])
+@pytest.mark.parametrize("shape", [(75, 101), (75, 101, 3)])
+def test_tiled_roundtrip(pf, tmp_path, assert_equal, compression, shape):
+    img = _random(shape)
+    p = str(tmp_path / "x.pft")
+    pf.save_tiled(p, img, tile_height=32, tile_width=24, compression=compression)
+
+    r = pf.TiledReader(p)
+    assert r.shape == shape
+    assert r.tile_shape == (32, 24)
+    assert r.grid == (3, 5)
+    assert r.compression == compression
+    assert_equal(r.read(), img)
+    # 右下角不滿一個 tile 的就是實際大小
+    assert_equal(r.tile(2, 4), img[64:, 96:])
+    assert_equal(r.read_region(10, 20, 40, 50), img[10:50, 20:70])
+
+
+@pytest.mark.parametrize("compression", ["none", "qoi"])
+@pytest.mark.parametrize("border", ["reflect", "replicate", "wrap", "constant"])
+def test_read_region_halo_matches_pad(pf, tmp_path, assert_equal, compression, border):
+    img = _random((40, 52, 3), seed=1)
+    p = str(tmp_path / "x.pft")
+    pf.save_tiled(p, img, tile_height=16, tile_width=16, compression=compression)
+    r = pf.TiledReader(p)
+
+    halo = 7
+    if border == "constant":
+        padded = np.pad(img, ((halo, halo), (halo, halo), (0, 0)), mode="constant", constant_values=9)
+    else:
+        padded = np.pad(img, ((halo, halo), (halo, halo), (0, 0)), mode=_PAD_MODE[border])
+    for y, x, h, w in [(0, 0, 40, 52), (0, 0, 5, 5), (30, 45, 10, 7), (12, 3, 20, 30), (17, 17, 1, 1)]:
+        got = r.read_region(y, x, h, w, halo=halo, border=border, border_value=9)
+        assert_equal(got, padded[y : y + h + 2 * halo, x : x + w + 2 * halo])
+
+
+def test_stencil_on_region_equals_full_image(pf, tmp_path, assert_equal):
+    img = _random((96, 80), seed=2)
+    p = str(tmp_path / "x.pft")
+    pf.save_tiled(p, img, tile_height=32, tile_width=32)
+    r = pf.TiledReader(p)
+
+    full = pf.mean_filter(img, 5)
+    for y, x in [(0, 0), (32, 16), (64, 48)]:
+        part = pf.mean_filter(r.read_region(y, x, 32, 32, halo=2), 5)[2:-2, 2:-2]
+        assert_equal(part, full[y : y + 32, x : x + 32])
+
+
+def test_uncompressed_tiles_are_zero_copy(pf, tmp_path, assert_equal):
+    img = _random((64, 64, 3), seed=3)
+    p = str(tmp_path / "x.pft")
+    pf.save_tiled(p, img, tile_height=32, tile_width=32)
+
+    r = pf.TiledReader(p)
+    a = r.tile(1, 1)
+    b = r.read_region(36, 36, 20, 20, halo=2)  # 含 halo 仍在同一個 tile 裡
+    assert np.shares_memory(a, b)
+    del r
+    # reader 不在了，view 仍然有效；改 view 不會改到檔案（copy-on-write）
+    assert_equal(b, img[34:58, 34:58])
+    a[:] = 0
+    assert_equal(pf.TiledReader(p).tile(1, 1), img[32:, 32:])
+
+
+@pytest.mark.parametrize("compression", ["none", "png"])
+def test_append_rows_matches_write_image(pf, tmp_path, compression):
+    img = _random((70, 45), seed=4)
+    whole, strips = str(tmp_path / "a.pft"), str(tmp_path / "b.pft")
+    pf.save_tiled(whole, img, tile_height=16, tile_width=20, compression=compression)
+
+    with pf.TiledWriter(strips, 70, 45, channels=1, tile_height=16, tile_width=20, compression=compression) as w:
+        for y0, y1 in [(0, 3), (3, 40), (40, 41), (41, 70)]:
+            w.append_rows(img[y0:y1])
+        assert w.rows_appended == 70
+    np.testing.assert_array_equal(pf.TiledReader(strips).read(), pf.TiledReader(whole).read())
+
+
+def test_write_tile_any_order(pf, tmp_path, assert_equal):
+    img = _random((50, 50, 3), seed=5)
+    p = str(tmp_path / "x.pft")
+    w = pf.TiledWriter(p, 50, 50, tile_height=32, tile_width=32)
+    for ty, tx in [(1, 1), (0, 1), (1, 0), (0, 0)]:
+        w.write_tile(ty, tx, img[32 * ty : 32 * ty + 32, 32 * tx : 32 * tx + 32])
+    w.close()
+    assert_equal(pf.TiledReader(p).read(), img)
+
+
+def test_tiled_errors(pf, tmp_path):
+    p = str(tmp_path / "x.pft")
+    with pytest.raises(ValueError):
+        pf.TiledWriter(p, 0, 10)
+    with pytest.raises(RuntimeError):
+        pf.save_tiled(p, _random((8, 8)), compression="zip")
+
+    w = pf.TiledWriter(p, 40, 40, channels=1, tile_height=32, tile_width=32)
+    with pytest.raises(ValueError):
+        w.write_tile(0, 0, _random((32, 31)))  # 尺寸不對
+    with pytest.raises(IndexError):
+        w.write_tile(2, 0, _random((8, 32)))
+    w.write_tile(0, 0, _random((32, 32)))
+    with pytest.raises(ValueError):
+        w.write_tile(0, 0, _random((32, 32)))  # 同一個 tile 寫兩次
+    with pytest.raises(RuntimeError):
+        w.close()  # 還有 tile 沒寫
+
+    with pytest.raises(RuntimeError):
+        pf.TiledReader(p)  # 沒寫完的檔不能讀
+    (tmp_path / "junk.pft").write_bytes(b"not a tiled file" * 8)
+    with pytest.raises(RuntimeError):
+        pf.TiledReader(str(tmp_path / "junk.pft"))
+
+    pf.save_tiled(p, _random((20, 20)))
+    r = pf.TiledReader(p)
+    with pytest.raises(IndexError):
+        r.read_region(10, 10, 11, 5)
+    with pytest.raises(ValueError):
+        r.read_region(0, 0, 5, 5, halo=-1)
+    with pytest.raises(IndexError):
+        r.tile(1, 0)
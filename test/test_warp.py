@@ -0,0 +1,62 @@
+import numpy as np
+import pytest
+
+INTERPS = ["nearest", "bilinear", "bicubic"]
+BORDERS = ["constant", "replicate", "reflect", "wrap"]
+
+
+def test_warp_identity(pf, test_images):
+    rgb, gray = test_images
+    eye = np.array([[1.0, 0.0, 0.0], [0.0, 1.0, 0.0]])
+    for img in [gray, rgb]:
+        h, w = img.shape[:2]
+        for interp in INTERPS:
+            out = pf.warp_affine(img, eye, h, w, interpolation=interp)
+            assert np.array_equal(out, img), interp
+            out = pf.warp_perspective(img, np.eye(3), h, w, interpolation=interp)
+            assert np.array_equal(out, img), interp
+
+
+def test_warp_integer_translation(pf, test_images):
+    rgb, _ = test_images
+    h, w = rgb.shape[:2]
+    M = np.array([[1.0, 0.0, 5.0], [0.0, 1.0, -3.0]])  # src → dst
+    for interp in INTERPS:
+        out = pf.warp_affine(rgb, M, h, w, interpolation=interp, border_value=9)
+        assert np.array_equal(out[:h - 3, 5:], rgb[3:, :w - 5]), interp
+        assert (out[:, :5] == 9).all() and (out[h - 3:] == 9).all()
+
+    # inverse_map：同一個位移反過來給
+    Minv = np.array([[1.0, 0.0, -5.0], [0.0, 1.0, 3.0]])
+    out = pf.warp_affine(rgb, Minv, h, w, inverse_map=True)
+    assert np.array_equal(out, pf.warp_affine(rgb, M, h, w))
+
+
+def test_warp_backends_match(pf, test_images, backends, assert_equal):
+    rgb, gray = test_images
+    A = np.array([[0.9, 0.3, -4.0], [-0.25, 1.1, 6.5]])
+    P = np.array([[1.0, 0.1, 3.0], [0.05, 0.95, -2.0], [0.001, 0.0015, 1.0]])
+    for img in [gray, rgb]:
+        for interp in INTERPS:
+            for border in BORDERS:
+                out_s = pf.warp_affine(img, A, 70, 90, interpolation=interp, border=border,
+                                       border_value=17, backend="single")
+                assert out_s.shape[:2] == (70, 90)
+                assert out_s.shape[2:] == img.shape[2:]
+                ps = pf.warp_perspective(img, P, 50, 60, interpolation=interp, border=border,
+                                         backend="single")
+                if "openmp" in backends:
+                    assert_equal(out_s, pf.warp_affine(img, A, 70, 90, interpolation=interp, border=border,
+                                                       border_value=17, backend="openmp"))
+                    assert_equal(ps, pf.warp_perspective(img, P, 50, 60, interpolation=interp,
+                                                         border=border, backend="openmp"))
+
+
+def test_warp_errors(pf, test_images):
+    _, gray = test_images
+    with pytest.raises(Exception):
+        pf.warp_affine(gray, np.zeros((2, 3)), 10, 10)           # singular
+    with pytest.raises(Exception):
+        pf.warp_affine(gray, np.eye(3), 10, 10)                  # 9 個元素
+    with pytest.raises(Exception):
+        pf.warp_affine(gray, np.eye(3)[:2], 10, 10, interpolation="area")
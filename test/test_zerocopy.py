@@ -1,4 +1,5 @@
 import numpy as np
+import pytest
 
 def _ptr(a: np.ndarray) -> int:
     return int(a.__array_interface__["data"][0])
@@ -30,3 +31,96 @@ def test_zerocopy_requires_contiguous(pf):
     import pytest
     with pytest.raises(Exception):
         pf._debug_zerocopy_roundtrip_u8(view)
+
+def test_zerocopy_accepts_row_strided_views(pf):
+    # 只切 row / column 範圍：pixel 仍然緊密，只有 row pitch 變大
+    arr = np.arange(20 * 30 * 3, dtype=np.uint32).astype(np.uint8).reshape(20, 30, 3)
+    view = arr[2:15, 5:21]
+    assert not view.flags.c_contiguous
+
+    out = pf._debug_zerocopy_roundtrip_u8(view)
+    assert _ptr(out) == _ptr(view)
+    assert out.strides == view.strides
+    assert np.array_equal(out, view)
+
+    gray = arr[::2, :, 0]  # 2D、row 間隔兩倍
+    out = pf._debug_zerocopy_roundtrip_u8(gray)
+    assert _ptr(out) == _ptr(gray)
+    assert np.array_equal(out, gray)
+
+def test_zerocopy_rejects_negative_row_stride(pf):
+    import pytest
+    arr = np.zeros((10, 10, 3), dtype=np.uint8)
+    with pytest.raises(Exception):
+        pf._debug_zerocopy_roundtrip_u8(arr[::-1])
+
+def test_kernels_on_views_match_contiguous(pf, backends):
+    rng = np.random.default_rng(7)
+    big = rng.integers(0, 256, size=(70, 90, 3), dtype=np.uint8)
+    view = big[5:61, 7:80]
+    dense = np.ascontiguousarray(view)
+
+    ops = [
+        lambda im, b: pf.invert(im, backend=b),
+        lambda im, b: pf.to_grayscale(im, backend=b),
+        lambda im, b: pf.gamma_correct(im, 0.7, backend=b),
+        lambda im, b: pf.sharpen(im, 0.8, backend=b),
+        lambda im, b: pf.gaussian_filter(im, 1.5, backend=b),
+        lambda im, b: pf.flip_horizontal(im, backend=b),
+        lambda im, b: pf.resize(im, 31, 47, backend=b),
+        lambda im, b: pf.rotate90(im, backend=b),
+        lambda im, b: pf.rotate180(im, backend=b),
+        lambda im, b: pf.pyr_down(im, backend=b),
+    ]
+    for b in backends:
+        for op in ops:
+            assert np.array_equal(op(view, b), op(dense, b))
+
+def test_crop_is_view(pf):
+    arr = np.zeros((40, 50, 3), dtype=np.uint8)
+    out = pf.crop(arr, y=10, x=12, height=20, width=25)
+    assert out.shape == (20, 25, 3)
+    assert np.shares_memory(out, arr)
+    assert _ptr(out) == _ptr(arr[10:, 12:])
+
+    # crop 的結果可以再丟回任何 kernel
+    arr[15, 20] = 200
+    assert pf.invert(out)[5, 8, 0] == 55
+
+def test_crop_keeps_readonly(pf, test_images):
+    rgb, gray = test_images
+    frozen = rgb.copy()
+    frozen.flags.writeable = False
+    shared = pf.to_grayscale(gray)  # copy-on-write 的結果本身就是唯讀
+    raw = np.frombuffer(bytes(gray.tobytes()), dtype=np.uint8).reshape(gray.shape)
+    for ro in (frozen, shared, raw):
+        region = pf.crop(ro, y=1, x=2, height=5, width=6)
+        assert np.shares_memory(region, ro)
+        assert not region.flags.writeable
+        with pytest.raises(ValueError):
+            region[...] = 0
+
+    assert pf.crop(rgb, y=1, x=2, height=5, width=6).flags.writeable
+
+def test_outputs_are_aligned_and_packed(pf):
+    img = np.zeros((33, 47, 3), dtype=np.uint8)
+    for out in (pf.invert(img), pf.resize(img, 21, 35), pf.rotate90(img), pf.to_grayscale(img)):
+        assert _ptr(out) % 64 == 0
+        assert out.flags.c_contiguous
+
+def test_noop_paths_share_input_buffer(pf, test_images, backends):
+    rgb, gray = test_images
+    for b in backends:
+        for out, src in ((pf.to_grayscale(gray, backend=b), gray),
+                         (pf.sharpen(rgb, amount=0.0, backend=b), rgb),
+                         (pf.sharpen(gray, amount=-1.0, backend=b), gray)):
+            assert _ptr(out) == _ptr(src)
+            assert np.array_equal(out, src)
+            # copy-on-write：共用的結果是唯讀的，要改就自己 copy
+            assert not out.flags.writeable
+            mine = out.copy()
+            mine[0, 0] = 255 - mine[0, 0]
+            assert not np.array_equal(mine, src)
+
+    full = pf.crop(rgb, y=0, x=0, height=rgb.shape[0], width=rgb.shape[1])
+    assert _ptr(full) == _ptr(rgb)